@@ -61,7 +61,7 @@ enum maxavro_codec
 {
     MAXAVRO_CODEC_NULL,
     MAXAVRO_CODEC_DEFLATE,
-    MAXAVRO_CODEC_SNAPPY,   /**< Not yet implemented */
+    MAXAVRO_CODEC_SNAPPY,
 };
 
 enum maxavro_error
@@ -98,6 +98,7 @@ typedef struct
                                      * to know when to read it and when not to.  */
     enum maxavro_error last_error;  /*< Last error */
     uint8_t            sync[SYNC_MARKER_SIZE];
+    uint64_t*          integers;    /*< The integer fields of the record last read as text */
 } MAXAVRO_FILE;
 
 /** A record field value */
@@ -127,6 +128,14 @@ typedef struct
     MAXAVRO_FILE* avrofile;     /*< The current open file */
 } MAXAVRO_DATABLOCK;
 
+/** A growing buffer of text */
+typedef struct
+{
+    char*  data;    /*< The text, not null-terminated */
+    size_t length;  /*< Length of the text */
+    size_t size;    /*< Size of the allocated memory, free it with MXS_FREE */
+} MAXAVRO_TEXT;
+
 typedef struct avro_map_value
 {
     char*                  key;
@@ -144,6 +153,33 @@ void          maxavro_file_close(MAXAVRO_FILE* file);
 json_t* maxavro_record_read_json(MAXAVRO_FILE* file);
 GWBUF*  maxavro_record_read_binary(MAXAVRO_FILE* file);
 
+/**
+ * Read a record as JSON text
+ *
+ * The record is appended to @c text as one line of JSON, terminated by a
+ * newline. The JSON is identical to what json_dumps() with JSON_PRESERVE_ORDER
+ * produces for the object that maxavro_record_read_json() returns, but no JSON
+ * objects are created.
+ *
+ * @param file File to read from
+ * @param text The text to append to
+ *
+ * @return True if a record was read, false if there are no more records in the
+ *         current block or an error occurred
+ */
+bool maxavro_record_read_json_text(MAXAVRO_FILE* file, MAXAVRO_TEXT* text);
+
+/**
+ * Get an integer field of the record last read with maxavro_record_read_json_text()
+ *
+ * @param file File that was read
+ * @param name Name of the field
+ * @param dest Where the value is stored
+ *
+ * @return True if the record has an integer field with the given name
+ */
+bool maxavro_record_get_integer(MAXAVRO_FILE* file, const char* name, uint64_t* dest);
+
 /** Navigation of the file */
 bool maxavro_record_seek(MAXAVRO_FILE* file, uint64_t offset);
 bool maxavro_record_set_pos(MAXAVRO_FILE* file, long pos);
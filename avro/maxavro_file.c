@@ -155,7 +155,14 @@ static uint8_t* read_block_data(MAXAVRO_FILE* file, long deflate_size)
             break;
 
         case MAXAVRO_CODEC_SNAPPY:
-            // TODO: implement snappy compression
+            {
+                size_t size;
+
+                if ((buffer = maxavro_snappy_uncompress(temp_buffer, deflate_size, &size)))
+                {
+                    file->buffer_size = size;
+                }
+            }
             break;
 
         default:
@@ -395,6 +402,7 @@ void maxavro_file_close(MAXAVRO_FILE* file)
     {
         fclose(file->file);
         MXS_FREE(file->buffer);
+        MXS_FREE(file->integers);
         MXS_FREE(file->filename);
         maxavro_schema_free(file->schema);
         MXS_FREE(file);
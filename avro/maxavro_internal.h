@@ -55,6 +55,18 @@ bool maxavro_datablock_add_string(MAXAVRO_DATABLOCK *file, const char* str);
 bool maxavro_datablock_add_float(MAXAVRO_DATABLOCK *file, float val);
 bool maxavro_datablock_add_double(MAXAVRO_DATABLOCK *file, double val);
 
+/**
+ * Uncompress an Avro data block compressed with Snappy
+ *
+ * @param data      The compressed data, including the trailing CRC32 checksum
+ * @param size      Size of @p data
+ * @param dest_size Where the size of the uncompressed data is stored
+ *
+ * @return The uncompressed data or NULL if the data is malformed or if memory
+ *         allocation failed. The caller must free the data with MXS_FREE().
+ */
+uint8_t* maxavro_snappy_uncompress(const uint8_t* data, size_t size, size_t* dest_size);
+
 bool maxavro_read_datablock_start(MAXAVRO_FILE *file);
 bool maxavro_verify_block(MAXAVRO_FILE *file);
 const char* type_to_string(enum maxavro_value_type type);
@@ -13,6 +13,7 @@
 
 #include <maxscale/cdefs.h>
 #include "maxavro_internal.h"
+#include <math.h>
 #include <string.h>
 #include <maxbase/assert.h>
 #include <maxscale/log.h>
@@ -214,6 +215,495 @@ json_t* maxavro_record_read_json(MAXAVRO_FILE* file)
     return object;
 }
 
+/** Initial size of the buffer for JSON text */
+#define TEXT_INITIAL_SIZE 4096
+
+static bool text_reserve(MAXAVRO_TEXT* text, size_t len)
+{
+    bool rval = true;
+
+    if (text->size - text->length < len)
+    {
+        size_t size = text->size ? text->size : TEXT_INITIAL_SIZE;
+
+        while (size - text->length < len)
+        {
+            size *= 2;
+        }
+
+        char* data = MXS_REALLOC(text->data, size);
+
+        if (data)
+        {
+            text->data = data;
+            text->size = size;
+        }
+        else
+        {
+            rval = false;
+        }
+    }
+
+    return rval;
+}
+
+static bool text_append(MAXAVRO_TEXT* text, const char* str, size_t len)
+{
+    bool rval = text_reserve(text, len);
+
+    if (rval)
+    {
+        memcpy(text->data + text->length, str, len);
+        text->length += len;
+    }
+
+    return rval;
+}
+
+/**
+ * @brief Get the length of a valid UTF-8 character
+ *
+ * The rules are the same that jansson uses to validate strings.
+ *
+ * @return Length of the character or 0 if it is not valid UTF-8
+ */
+static size_t utf8_length(const uint8_t* ptr, size_t avail)
+{
+    uint8_t c = *ptr;
+    uint32_t codepoint;
+    size_t len;
+
+    if (c < 0x80)
+    {
+        return 1;
+    }
+    else if (c < 0xc2)
+    {
+        return 0;
+    }
+    else if (c < 0xe0)
+    {
+        len = 2;
+        codepoint = c & 0x1f;
+    }
+    else if (c < 0xf0)
+    {
+        len = 3;
+        codepoint = c & 0x0f;
+    }
+    else if (c < 0xf5)
+    {
+        len = 4;
+        codepoint = c & 0x07;
+    }
+    else
+    {
+        return 0;
+    }
+
+    if (avail < len)
+    {
+        return 0;
+    }
+
+    for (size_t i = 1; i < len; i++)
+    {
+        if ((ptr[i] & 0xc0) != 0x80)
+        {
+            return 0;
+        }
+
+        codepoint = (codepoint << 6) | (ptr[i] & 0x3f);
+    }
+
+    if ((len == 3 && codepoint < 0x800) || (len == 4 && codepoint < 0x10000)
+        || codepoint > 0x10ffff || (codepoint >= 0xd800 && codepoint <= 0xdfff))
+    {
+        return 0;
+    }
+
+    return len;
+}
+
+/**
+ * @brief Append a string as a quoted and escaped JSON string
+ *
+ * @return False if the string is not valid UTF-8 or if memory allocation failed
+ */
+static bool text_append_string(MAXAVRO_TEXT* text, const char* str, size_t len)
+{
+    const uint8_t* ptr = (const uint8_t*)str;
+    const uint8_t* end = ptr + len;
+
+    // The worst case is that every byte is escaped as \uXXXX
+    if (!text_reserve(text, len * 6 + 2))
+    {
+        return false;
+    }
+
+    char* dest = text->data + text->length;
+    *dest++ = '"';
+
+    while (ptr < end)
+    {
+        size_t n = utf8_length(ptr, end - ptr);
+
+        if (n == 0)
+        {
+            return false;
+        }
+        else if (n > 1)
+        {
+            memcpy(dest, ptr, n);
+            dest += n;
+            ptr += n;
+            continue;
+        }
+
+        uint8_t c = *ptr++;
+
+        switch (c)
+        {
+        case '\\':
+            *dest++ = '\\';
+            *dest++ = '\\';
+            break;
+
+        case '"':
+            *dest++ = '\\';
+            *dest++ = '"';
+            break;
+
+        case '\b':
+            *dest++ = '\\';
+            *dest++ = 'b';
+            break;
+
+        case '\f':
+            *dest++ = '\\';
+            *dest++ = 'f';
+            break;
+
+        case '\n':
+            *dest++ = '\\';
+            *dest++ = 'n';
+            break;
+
+        case '\r':
+            *dest++ = '\\';
+            *dest++ = 'r';
+            break;
+
+        case '\t':
+            *dest++ = '\\';
+            *dest++ = 't';
+            break;
+
+        default:
+            if (c < 0x20)
+            {
+                dest += sprintf(dest, "\\u%04X", c);
+            }
+            else
+            {
+                *dest++ = c;
+            }
+            break;
+        }
+    }
+
+    *dest++ = '"';
+    text->length = dest - text->data;
+
+    return true;
+}
+
+static bool text_append_integer(MAXAVRO_TEXT* text, int64_t value)
+{
+    char buf[24];
+    char* ptr = buf + sizeof(buf);
+    uint64_t abs_value = value < 0 ? -(uint64_t)value : (uint64_t)value;
+
+    do
+    {
+        *--ptr = '0' + abs_value % 10;
+        abs_value /= 10;
+    }
+    while (abs_value);
+
+    if (value < 0)
+    {
+        *--ptr = '-';
+    }
+
+    return text_append(text, ptr, buf + sizeof(buf) - ptr);
+}
+
+/**
+ * @brief Append a floating point value the way jansson formats it
+ *
+ * @return False if the value is not finite or if memory allocation failed
+ */
+static bool text_append_real(MAXAVRO_TEXT* text, double value)
+{
+    if (!isfinite(value))
+    {
+        return false;
+    }
+
+    char buf[32];
+    size_t len = snprintf(buf, sizeof(buf) - 2, "%.17g", value);
+
+    // A real must not look like an integer
+    if (!strchr(buf, '.') && !strchr(buf, 'e'))
+    {
+        buf[len++] = '.';
+        buf[len++] = '0';
+        buf[len] = '\0';
+    }
+
+    // Remove the plus sign and the leading zeros from the exponent
+    char* start = strchr(buf, 'e');
+
+    if (start)
+    {
+        start++;
+        char* end = start + 1;
+
+        if (*start == '-')
+        {
+            start++;
+        }
+
+        while (*end == '0')
+        {
+            end++;
+        }
+
+        if (end != start)
+        {
+            memmove(start, end, len - (end - buf));
+            len -= end - start;
+        }
+    }
+
+    return text_append(text, buf, len);
+}
+
+/**
+ * @brief Read a single value and append it as JSON text
+ *
+ * This is the counterpart of read_and_pack_value() and accepts and rejects the
+ * same values.
+ *
+ * @param file    File to read from
+ * @param field   The field being read
+ * @param type    Type of the value
+ * @param text    The text to append to
+ * @param integer Where the value is stored if it is an integer, may be NULL
+ *
+ * @return True if the value was read and appended
+ */
+static bool read_value_as_text(MAXAVRO_FILE* file,
+                               MAXAVRO_SCHEMA_FIELD* field,
+                               enum maxavro_value_type type,
+                               MAXAVRO_TEXT* text,
+                               uint64_t* integer)
+{
+    bool rval = false;
+
+    switch (type)
+    {
+    case MAXAVRO_TYPE_BOOL:
+        if (file->buffer_ptr < file->buffer_end)
+        {
+            rval = *file->buffer_ptr++ ? text_append(text, "true", 4) : text_append(text, "false", 5);
+        }
+        break;
+
+    case MAXAVRO_TYPE_INT:
+    case MAXAVRO_TYPE_LONG:
+        {
+            uint64_t val = 0;
+            if (maxavro_read_integer(file, &val))
+            {
+                rval = text_append_integer(text, (int64_t)val);
+
+                if (integer)
+                {
+                    *integer = val;
+                }
+            }
+        }
+        break;
+
+    case MAXAVRO_TYPE_ENUM:
+        {
+            uint64_t val = 0;
+            maxavro_read_integer(file, &val);
+
+            json_t* arr = field->extra;
+            mxb_assert(arr);
+            mxb_assert(json_is_array(arr));
+
+            const char* symbol = json_string_value(json_array_get(arr, val));
+
+            if (symbol)
+            {
+                rval = text_append_string(text, symbol, strlen(symbol));
+            }
+        }
+        break;
+
+    case MAXAVRO_TYPE_FLOAT:
+        {
+            float f = 0;
+            if (maxavro_read_float(file, &f))
+            {
+                rval = text_append_real(text, f);
+            }
+        }
+        break;
+
+    case MAXAVRO_TYPE_DOUBLE:
+        {
+            double d = 0;
+            if (maxavro_read_double(file, &d))
+            {
+                rval = text_append_real(text, d);
+            }
+        }
+        break;
+
+    case MAXAVRO_TYPE_BYTES:
+    case MAXAVRO_TYPE_STRING:
+        {
+            uint64_t len;
+            if (maxavro_read_integer(file, &len)
+                && len <= (uint64_t)(file->buffer_end - file->buffer_ptr))
+            {
+                // The string is escaped directly from the data block
+                rval = text_append_string(text, (const char*)file->buffer_ptr, len);
+                file->buffer_ptr += len;
+            }
+        }
+        break;
+
+    case MAXAVRO_TYPE_UNION:
+        {
+            json_t* arr = field->extra;
+            uint64_t val = 0;
+
+            if (maxavro_read_integer(file, &val) && val < json_array_size(arr))
+            {
+                json_t* union_type = json_object_get(json_array_get(arr, val), "type");
+                rval = read_value_as_text(file,
+                                          field,
+                                          string_to_type(json_string_value(union_type)),
+                                          text,
+                                          NULL);
+            }
+        }
+        break;
+
+    case MAXAVRO_TYPE_NULL:
+        rval = text_append(text, "null", 4);
+        break;
+
+    default:
+        MXS_ERROR("Unimplemented type: %d", field->type);
+        break;
+    }
+
+    return rval;
+}
+
+bool maxavro_record_read_json_text(MAXAVRO_FILE* file, MAXAVRO_TEXT* text)
+{
+    if (!file->metadata_read && !maxavro_read_datablock_start(file))
+    {
+        return false;
+    }
+
+    bool rval = false;
+
+    if (file->records_read_from_block < file->records_in_block)
+    {
+        size_t num_fields = file->schema->num_fields;
+        size_t start = text->length;
+        uint64_t integers[num_fields ? num_fields : 1];
+        rval = true;
+
+        if (!file->integers && !(file->integers = MXS_CALLOC(num_fields ? num_fields : 1, sizeof(uint64_t))))
+        {
+            rval = false;
+        }
+
+        rval = rval && text_append(text, "{", 1);
+
+        for (size_t i = 0; rval && i < num_fields; i++)
+        {
+            MAXAVRO_SCHEMA_FIELD* field = &file->schema->fields[i];
+            integers[i] = 0;
+
+            if (!((i == 0 || text_append(text, ", ", 2))
+                  && text_append_string(text, field->name, strlen(field->name))
+                  && text_append(text, ": ", 2)))
+            {
+                rval = false;
+            }
+            else if (!read_value_as_text(file, field, field->type, text, &integers[i]))
+            {
+                long pos = ftell(file->file);
+                MXS_ERROR("Failed to read field value '%s', type '%s' at "
+                          "file offset %ld, record number %lu.",
+                          field->name,
+                          type_to_string(field->type),
+                          pos,
+                          file->records_read);
+                rval = false;
+            }
+        }
+
+        if (rval && text_append(text, "}\n", 2))
+        {
+            memcpy(file->integers, integers, num_fields * sizeof(uint64_t));
+            file->records_read_from_block++;
+            file->records_read++;
+        }
+        else
+        {
+            text->length = start;
+            rval = false;
+        }
+    }
+
+    return rval;
+}
+
+bool maxavro_record_get_integer(MAXAVRO_FILE* file, const char* name, uint64_t* dest)
+{
+    bool rval = false;
+
+    if (file->integers)
+    {
+        for (size_t i = 0; i < file->schema->num_fields; i++)
+        {
+            MAXAVRO_SCHEMA_FIELD* field = &file->schema->fields[i];
+
+            if ((field->type == MAXAVRO_TYPE_INT || field->type == MAXAVRO_TYPE_LONG)
+                && strcmp(field->name, name) == 0)
+            {
+                *dest = file->integers[i];
+                rval = true;
+                break;
+            }
+        }
+    }
+
+    return rval;
+}
+
 static void skip_record(MAXAVRO_FILE* file)
 {
     for (size_t i = 0; i < file->schema->num_fields; i++)
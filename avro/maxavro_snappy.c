@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+/**
+ * @file maxavro_snappy.c - Decompression of Snappy compressed data blocks
+ *
+ * A Snappy compressed stream starts with the uncompressed length as a varint
+ * followed by a sequence of elements. An element is either a literal, a run of
+ * bytes copied as-is to the output, or a copy of earlier output. The type of the
+ * element is stored in the lowest two bits of the tag byte that starts it.
+ *
+ * Avro stores a big-endian CRC32 of the uncompressed data after the compressed
+ * data of each block.
+ */
+
+#include "maxavro_internal.h"
+#include <string.h>
+#include <maxscale/log.h>
+#include <zlib.h>
+
+enum
+{
+    SNAPPY_LITERAL     = 0,
+    SNAPPY_COPY_1_BYTE = 1,
+    SNAPPY_COPY_2_BYTE = 2,
+    SNAPPY_COPY_4_BYTE = 3
+};
+
+/** Size of the CRC32 checksum stored after the compressed data */
+#define SNAPPY_CRC_SIZE 4
+
+static bool read_varint(const uint8_t** pptr, const uint8_t* end, uint64_t* dest)
+{
+    const uint8_t* ptr = *pptr;
+    uint64_t value = 0;
+    int shift = 0;
+    bool more = true;
+
+    while (more && ptr < end && shift < 35)
+    {
+        value |= (uint64_t)(*ptr & 0x7f) << shift;
+        more = *ptr & 0x80;
+        shift += 7;
+        ptr++;
+    }
+
+    *pptr = ptr;
+    *dest = value;
+
+    return !more;
+}
+
+static uint32_t read_le(const uint8_t* ptr, int bytes)
+{
+    uint32_t value = 0;
+
+    for (int i = 0; i < bytes; i++)
+    {
+        value |= (uint32_t)ptr[i] << (8 * i);
+    }
+
+    return value;
+}
+
+static bool snappy_uncompress(const uint8_t* ptr, const uint8_t* end, uint8_t* dest, size_t dest_len)
+{
+    size_t pos = 0;
+
+    while (ptr < end)
+    {
+        uint8_t tag = *ptr++;
+        size_t len;
+        size_t offset;
+
+        if ((tag & 3) == SNAPPY_LITERAL)
+        {
+            len = tag >> 2;
+
+            if (len >= 60)
+            {
+                // The length, minus one, is stored in the following 1-4 bytes
+                int bytes = len - 59;
+
+                if (end - ptr < bytes)
+                {
+                    return false;
+                }
+
+                len = read_le(ptr, bytes);
+                ptr += bytes;
+            }
+
+            len += 1;
+
+            if ((size_t)(end - ptr) < len || dest_len - pos < len)
+            {
+                return false;
+            }
+
+            memcpy(dest + pos, ptr, len);
+            ptr += len;
+            pos += len;
+        }
+        else
+        {
+            switch (tag & 3)
+            {
+            case SNAPPY_COPY_1_BYTE:
+                if (end - ptr < 1)
+                {
+                    return false;
+                }
+
+                len = ((tag >> 2) & 7) + 4;
+                offset = ((size_t)(tag >> 5) << 8) | *ptr++;
+                break;
+
+            case SNAPPY_COPY_2_BYTE:
+                if (end - ptr < 2)
+                {
+                    return false;
+                }
+
+                len = (tag >> 2) + 1;
+                offset = read_le(ptr, 2);
+                ptr += 2;
+                break;
+
+            default:
+                if (end - ptr < 4)
+                {
+                    return false;
+                }
+
+                len = (tag >> 2) + 1;
+                offset = read_le(ptr, 4);
+                ptr += 4;
+                break;
+            }
+
+            if (offset == 0 || offset > pos || dest_len - pos < len)
+            {
+                return false;
+            }
+
+            // The source and the destination may overlap, which repeats the data
+            for (size_t i = 0; i < len; i++)
+            {
+                dest[pos + i] = dest[pos - offset + i];
+            }
+
+            pos += len;
+        }
+    }
+
+    return pos == dest_len;
+}
+
+uint8_t* maxavro_snappy_uncompress(const uint8_t* data, size_t size, size_t* dest_size)
+{
+    uint8_t* rval = NULL;
+
+    if (size >= SNAPPY_CRC_SIZE)
+    {
+        const uint8_t* ptr = data;
+        const uint8_t* end = data + size - SNAPPY_CRC_SIZE;
+        uint64_t len;
+
+        if (read_varint(&ptr, end, &len) && len <= UINT32_MAX)
+        {
+            // Allocate at least one byte, an empty block is still a valid block
+            uint8_t* buffer = MXS_MALLOC(len ? len : 1);
+
+            if (buffer && snappy_uncompress(ptr, end, buffer, len))
+            {
+                uint32_t crc = ((uint32_t)end[0] << 24) | ((uint32_t)end[1] << 16)
+                    | ((uint32_t)end[2] << 8) | end[3];
+
+                if (crc == crc32(0, buffer, len))
+                {
+                    rval = buffer;
+                    buffer = NULL;
+                    *dest_size = len;
+                }
+                else
+                {
+                    MXS_ERROR("Checksum mismatch in Snappy compressed data block.");
+                }
+            }
+            else if (buffer)
+            {
+                MXS_ERROR("Malformed Snappy compressed data block.");
+            }
+
+            MXS_FREE(buffer);
+        }
+        else
+        {
+            MXS_ERROR("Malformed Snappy compressed data block length.");
+        }
+    }
+    else
+    {
+        MXS_ERROR("Snappy compressed data block is too short.");
+    }
+
+    return rval;
+}
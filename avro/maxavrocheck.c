@@ -23,13 +23,17 @@
 #include <errno.h>
 #include <limits.h>
 #include <getopt.h>
+#include <time.h>
+#include <zlib.h>
 
+#include <maxscale/alloc.h>
 #include <maxscale/log.h>
 
 static int verbose = 0;
 static uint64_t seekto = 0;
 static int64_t num_rows = -1;
 static bool dump = false;
+static bool benchmark = false;
 
 int check_file(const char* filename)
 {
@@ -66,25 +70,20 @@ int check_file(const char* filename)
 
         if (verbose > 1 || dump)
         {
-            json_t* row;
-            while (num_rows != 0 && (row = maxavro_record_read_json(file)))
+            MAXAVRO_TEXT text = {NULL, 0, 0};
+
+            while (num_rows != 0 && maxavro_record_read_json_text(file, &text))
             {
-                char* json = json_dumps(row, JSON_PRESERVE_ORDER);
-                if (json)
-                {
-                    printf("%s\n", json);
-                    json_decref(row);
-                    if (num_rows > 0)
-                    {
-                        num_rows--;
-                    }
-                }
-                else
+                fwrite(text.data, 1, text.length, stdout);
+                text.length = 0;
+
+                if (num_rows > 0)
                 {
-                    printf("Failed to read JSON value.\n");
-                    return 1;
+                    num_rows--;
                 }
             }
+
+            MXS_FREE(text.data);
         }
 
         if (verbose && !dump)
@@ -120,13 +119,136 @@ int check_file(const char* filename)
     return rval;
 }
 
+/**
+ * Read all records of a file as JSON
+ *
+ * @param filename File to read
+ * @param use_text Whether to use maxavro_record_read_json_text() instead of
+ *                 creating a JSON object of each record and serializing it
+ * @param records  Where the number of records is stored
+ * @param checksum Where the CRC32 of the JSON is stored
+ *
+ * @return Time it took to read the file in seconds or a negative value on error
+ */
+static double read_all_records(const char* filename, bool use_text, uint64_t* records, uLong* checksum)
+{
+    MAXAVRO_FILE* file = maxavro_file_open(filename);
+
+    if (!file)
+    {
+        return -1;
+    }
+
+    struct timespec start;
+    struct timespec end;
+    MAXAVRO_TEXT text = {NULL, 0, 0};
+    uLong crc = crc32(0, NULL, 0);
+    bool ok = true;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    do
+    {
+        if (use_text)
+        {
+            text.length = 0;
+
+            while (maxavro_record_read_json_text(file, &text))
+            {
+                // Read all records of the block
+            }
+
+            crc = crc32(crc, (uint8_t*)text.data, text.length);
+        }
+        else
+        {
+            json_t* row;
+
+            while (ok && (row = maxavro_record_read_json(file)))
+            {
+                char* json = json_dumps(row, JSON_PRESERVE_ORDER);
+
+                if (json)
+                {
+                    crc = crc32(crc, (uint8_t*)json, strlen(json));
+                    crc = crc32(crc, (uint8_t*)"\n", 1);
+                    MXS_FREE(json);
+                }
+                else
+                {
+                    ok = false;
+                }
+
+                json_decref(row);
+            }
+        }
+    }
+    while (ok && maxavro_next_block(file));
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *records = file->records_read;
+    *checksum = crc;
+
+    if (maxavro_get_error(file) != MAXAVRO_ERR_NONE)
+    {
+        ok = false;
+    }
+
+    MXS_FREE(text.data);
+    maxavro_file_close(file);
+
+    return ok ? (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1000000000.0 : -1;
+}
+
+/**
+ * Compare the speed of the two ways of converting records into JSON
+ *
+ * @param filename File to read
+ *
+ * @return 0 if both produced the same JSON, 1 on error
+ */
+int benchmark_file(const char* filename)
+{
+    uint64_t object_records;
+    uint64_t text_records;
+    uLong object_crc;
+    uLong text_crc;
+    double object_time = read_all_records(filename, false, &object_records, &object_crc);
+    double text_time = read_all_records(filename, true, &text_records, &text_crc);
+    int rval = 1;
+
+    if (object_time < 0 || text_time < 0)
+    {
+        printf("%s: Failed to read records.\n", filename);
+    }
+    else if (object_records != text_records || object_crc != text_crc)
+    {
+        printf("%s: JSON objects and JSON text differ: %lu records (CRC32 %08lx) "
+               "and %lu records (CRC32 %08lx).\n",
+               filename, object_records, object_crc, text_records, text_crc);
+    }
+    else
+    {
+        printf("%s: %lu records, JSON objects: %.0f rows/s, JSON text: %.0f rows/s\n",
+               filename,
+               text_records,
+               object_time > 0 ? object_records / object_time : 0,
+               text_time > 0 ? text_records / text_time : 0);
+        rval = 0;
+    }
+
+    return rval;
+}
+
 static struct option long_options[] =
 {
-    {"verbose", no_argument, 0, 'v'},
-    {"dump",    no_argument, 0, 'd'},
-    {"from",    no_argument, 0, 'f'},
-    {"count",   no_argument, 0, 'c'},
-    {0,         0,           0, 0  }
+    {"verbose",   no_argument, 0, 'v'},
+    {"dump",      no_argument, 0, 'd'},
+    {"from",      no_argument, 0, 'f'},
+    {"count",     no_argument, 0, 'c'},
+    {"benchmark", no_argument, 0, 'b'},
+    {0,           0,           0, 0  }
 };
 
 int main(int argc, char** argv)
@@ -147,10 +269,14 @@ int main(int argc, char** argv)
     char c;
     int option_index;
 
-    while ((c = getopt_long(argc, argv, "vdf:c:", long_options, &option_index)) >= 0)
+    while ((c = getopt_long(argc, argv, "vdbf:c:", long_options, &option_index)) >= 0)
     {
         switch (c)
         {
+        case 'b':
+            benchmark = true;
+            break;
+
         case 'v':
             verbose++;
             break;
@@ -173,7 +299,9 @@ int main(int argc, char** argv)
     char pathbuf[PATH_MAX + 1];
     for (int i = optind; i < argc; i++)
     {
-        if (check_file(realpath(argv[i], pathbuf)))
+        const char* path = realpath(argv[i], pathbuf);
+
+        if (benchmark ? benchmark_file(path) : check_file(path))
         {
             fprintf(stderr, "Failed to process file: %s\n", argv[i]);
             rval = 1;
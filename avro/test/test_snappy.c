@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include <maxavro.h>
+#include <maxavro_internal.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <zlib.h>
+
+#include <maxscale/alloc.h>
+#include <maxscale/log.h>
+
+const char* testfile = "test_snappy.avro";
+
+const char* testschema =
+    "{\"namespace\": \"MaxScaleChangeDataSchema.avro\", \"type\": \"record\", \"name\": \"ChangeRecord\","
+    " \"fields\": [{\"name\": \"domain\", \"type\": {\"type\": \"int\"}},"
+    " {\"name\": \"sequence\", \"type\": {\"type\": \"long\"}},"
+    " {\"name\": \"event_type\", \"type\": {\"type\": \"enum\", \"name\": \"EVENT_TYPES\","
+    " \"symbols\": [\"insert\", \"update_before\", \"update_after\", \"delete\"]}},"
+    " {\"name\": \"name\", \"type\": {\"type\": \"string\"}},"
+    " {\"name\": \"price\", \"type\": {\"type\": \"double\"}},"
+    " {\"name\": \"weight\", \"type\": {\"type\": \"float\"}},"
+    " {\"name\": \"active\", \"type\": {\"type\": \"bool\"}},"
+    " {\"name\": \"comment\", \"type\": [{\"type\": \"null\"}, {\"type\": \"string\"}]}]}";
+
+const uint8_t sync_marker[SYNC_MARKER_SIZE] =
+{
+    0x10, 0x21, 0x32, 0x43, 0x54, 0x65, 0x76, 0x87, 0x98, 0xa9, 0xba, 0xcb, 0xdc, 0xed, 0xfe, 0x0f
+};
+
+typedef struct
+{
+    uint8_t data[4096];
+    size_t  len;
+} BUFFER;
+
+static void add_bytes(BUFFER* buf, const void* data, size_t len)
+{
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+}
+
+static void add_byte(BUFFER* buf, uint8_t byte)
+{
+    add_bytes(buf, &byte, 1);
+}
+
+static void add_varint(BUFFER* buf, uint64_t n)
+{
+    while (n & ~0x7fUL)
+    {
+        add_byte(buf, (n & 0x7f) | 0x80);
+        n >>= 7;
+    }
+
+    add_byte(buf, n);
+}
+
+static void add_long(BUFFER* buf, int64_t value)
+{
+    add_varint(buf, (value << 1) ^ (value >> 63));
+}
+
+static void add_string(BUFFER* buf, const char* str)
+{
+    add_long(buf, strlen(str));
+    add_bytes(buf, str, strlen(str));
+}
+
+static void add_crc(BUFFER* buf, const uint8_t* data, size_t len)
+{
+    uint32_t crc = crc32(0, data, len);
+    add_byte(buf, crc >> 24);
+    add_byte(buf, crc >> 16);
+    add_byte(buf, crc >> 8);
+    add_byte(buf, crc);
+}
+
+/**
+ * Compress data as one Snappy literal with a four byte length
+ */
+static void add_snappy(BUFFER* buf, const uint8_t* data, size_t len)
+{
+    add_varint(buf, len);
+    add_byte(buf, 63 << 2);
+    add_byte(buf, (len - 1));
+    add_byte(buf, (len - 1) >> 8);
+    add_byte(buf, (len - 1) >> 16);
+    add_byte(buf, (len - 1) >> 24);
+    add_bytes(buf, data, len);
+    add_crc(buf, data, len);
+}
+
+/**
+ * Uncompress a Snappy block and compare it to the expected result
+ *
+ * @param name     Name of the test
+ * @param data     Compressed data without the checksum
+ * @param len      Length of the compressed data
+ * @param expected Expected result or NULL if the data should be rejected
+ * @param bad_crc  Store a bad checksum after the data
+ *
+ * @return 0 on success, 1 on failure
+ */
+static int test_uncompress(const char* name, const uint8_t* data, size_t len, const char* expected,
+                           bool bad_crc)
+{
+    BUFFER buf = {.len = 0};
+    add_bytes(&buf, data, len);
+
+    if (expected)
+    {
+        add_crc(&buf, (const uint8_t*)expected, strlen(expected));
+    }
+    else
+    {
+        add_crc(&buf, data, len);
+    }
+
+    if (bad_crc)
+    {
+        buf.data[buf.len - 1] ^= 0xff;
+    }
+
+    size_t size = 0;
+    uint8_t* result = maxavro_snappy_uncompress(buf.data, buf.len, &size);
+    int rval = 0;
+
+    if (expected && !bad_crc)
+    {
+        if (!result || size != strlen(expected) || memcmp(result, expected, size) != 0)
+        {
+            printf("%s: expected '%s', got '%.*s'\n", name, expected, (int)size, result ? (char*)result : "");
+            rval = 1;
+        }
+    }
+    else if (result)
+    {
+        printf("%s: malformed data was accepted.\n", name);
+        rval = 1;
+    }
+
+    MXS_FREE(result);
+    return rval;
+}
+
+static int test_snappy_elements()
+{
+    int rval = 0;
+
+    // Literal "abc" followed by a one byte offset copy that overlaps itself
+    const uint8_t copy1[] = {14, 2 << 2, 'a', 'b', 'c', ((11 - 4) << 2) | 1, 3};
+    rval += test_uncompress("copy1", copy1, sizeof(copy1), "abcabcabcabcab", false);
+
+    // Two byte offset copy
+    const uint8_t copy2[] = {15, 4 << 2, '0', '1', '2', '3', '4', ((10 - 1) << 2) | 2, 5, 0};
+    rval += test_uncompress("copy2", copy2, sizeof(copy2), "012340123401234", false);
+
+    // Four byte offset copy
+    const uint8_t copy4[] = {7, 1 << 2, 'x', 'y', ((5 - 1) << 2) | 3, 2, 0, 0, 0};
+    rval += test_uncompress("copy4", copy4, sizeof(copy4), "xyxyxyx", false);
+
+    // Literal with a one byte length
+    char long_str[101];
+    memset(long_str, 'q', 100);
+    long_str[100] = '\0';
+    uint8_t long_literal[103] = {100, 60 << 2, 99};
+    memcpy(long_literal + 3, long_str, 100);
+    rval += test_uncompress("long literal", long_literal, sizeof(long_literal), long_str, false);
+
+    // Empty block
+    const uint8_t empty[] = {0};
+    rval += test_uncompress("empty", empty, sizeof(empty), "", false);
+
+    // Malformed data
+    rval += test_uncompress("bad checksum", copy1, sizeof(copy1), "abcabcabcabcab", true);
+    rval += test_uncompress("truncated", copy2, sizeof(copy2) - 1, NULL, false);
+    rval += test_uncompress("truncated literal", long_literal, 50, NULL, false);
+
+    const uint8_t bad_offset[] = {14, 2 << 2, 'a', 'b', 'c', ((11 - 4) << 2) | 1, 4};
+    rval += test_uncompress("bad offset", bad_offset, sizeof(bad_offset), NULL, false);
+
+    const uint8_t zero_offset[] = {14, 2 << 2, 'a', 'b', 'c', ((11 - 4) << 2) | 1, 0};
+    rval += test_uncompress("zero offset", zero_offset, sizeof(zero_offset), NULL, false);
+
+    const uint8_t too_long[] = {13, 2 << 2, 'a', 'b', 'c', ((11 - 4) << 2) | 1, 3};
+    rval += test_uncompress("too long", too_long, sizeof(too_long), NULL, false);
+
+    const uint8_t too_short[] = {15, 2 << 2, 'a', 'b', 'c', ((11 - 4) << 2) | 1, 3};
+    rval += test_uncompress("too short", too_short, sizeof(too_short), NULL, false);
+
+    return rval;
+}
+
+static void add_record(BUFFER* buf, int domain, int64_t seq, int event, const char* name,
+                       double price, float weight, bool active, const char* comment)
+{
+    add_long(buf, domain);
+    add_long(buf, seq);
+    add_long(buf, event);
+    add_string(buf, name);
+    add_bytes(buf, &price, sizeof(price));
+    add_bytes(buf, &weight, sizeof(weight));
+    add_byte(buf, active);
+
+    if (comment)
+    {
+        add_long(buf, 1);
+        add_string(buf, comment);
+    }
+    else
+    {
+        add_long(buf, 0);
+    }
+}
+
+static bool write_file()
+{
+    FILE* file = fopen(testfile, "wb");
+
+    if (!file)
+    {
+        return false;
+    }
+
+    BUFFER buf = {.len = 0};
+    add_bytes(&buf, avro_magic, AVRO_MAGIC_SIZE);
+    add_long(&buf, 2);
+    add_string(&buf, "avro.schema");
+    add_string(&buf, testschema);
+    add_string(&buf, "avro.codec");
+    add_string(&buf, "snappy");
+    add_long(&buf, 0);
+    add_bytes(&buf, sync_marker, SYNC_MARKER_SIZE);
+    fwrite(buf.data, 1, buf.len, file);
+
+    BUFFER records[2] = {{.len = 0}, {.len = 0}};
+    add_record(&records[0], 0, 1, 0, "plain", 1.5, 2.25f, true, NULL);
+    add_record(&records[0], 0, 2, 1, "\"quoted\" \\ and\ttabs\n", -0.1, 1e-10f, false, "comment");
+    add_record(&records[0], 0, 2, 2, "utf-8: \xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80", 1e300, 3.0f, true, "");
+    add_record(&records[1], 1, 12345678901234LL, 3, "control \x01\x1f\x7f", -123456789.0, -0.5f, false,
+               "last");
+
+    for (int i = 0; i < 2; i++)
+    {
+        BUFFER block = {.len = 0};
+        BUFFER compressed = {.len = 0};
+        add_snappy(&compressed, records[i].data, records[i].len);
+        add_long(&block, i == 0 ? 3 : 1);
+        add_long(&block, compressed.len);
+        add_bytes(&block, compressed.data, compressed.len);
+        add_bytes(&block, sync_marker, SYNC_MARKER_SIZE);
+        fwrite(block.data, 1, block.len, file);
+    }
+
+    fclose(file);
+    return true;
+}
+
+/**
+ * Read the file as JSON objects and as JSON text and check that the results
+ * are identical
+ */
+static int test_read_file()
+{
+    MAXAVRO_FILE* objects = maxavro_file_open(testfile);
+    MAXAVRO_FILE* texts = maxavro_file_open(testfile);
+    MAXAVRO_TEXT text = {NULL, 0, 0};
+    int records = 0;
+    int rval = 0;
+
+    if (!objects || !texts)
+    {
+        printf("Failed to open file.\n");
+        rval = 1;
+    }
+    else
+    {
+        do
+        {
+            json_t* row;
+
+            while ((row = maxavro_record_read_json(objects)))
+            {
+                char* json = json_dumps(row, JSON_PRESERVE_ORDER);
+                text.length = 0;
+
+                if (!maxavro_record_read_json_text(texts, &text))
+                {
+                    printf("Failed to read record %d as text.\n", records);
+                    rval = 1;
+                }
+                else if (text.length != strlen(json) + 1
+                         || memcmp(text.data, json, strlen(json)) != 0
+                         || text.data[text.length - 1] != '\n')
+                {
+                    printf("Record %d differs:\n%s\n%.*s", records, json, (int)text.length, text.data);
+                    rval = 1;
+                }
+                else
+                {
+                    uint64_t seq = 0;
+
+                    if (!maxavro_record_get_integer(texts, "sequence", &seq)
+                        || (int64_t)seq != json_integer_value(json_object_get(row, "sequence")))
+                    {
+                        printf("Wrong sequence number in record %d.\n", records);
+                        rval = 1;
+                    }
+                }
+
+                MXS_FREE(json);
+                json_decref(row);
+                records++;
+            }
+
+            text.length = 0;
+
+            if (maxavro_record_read_json_text(texts, &text))
+            {
+                printf("More records read as text than as objects.\n");
+                rval = 1;
+            }
+        }
+        while (maxavro_next_block(objects) && maxavro_next_block(texts));
+
+        if (records != 4 || maxavro_get_error(objects) != MAXAVRO_ERR_NONE
+            || maxavro_get_error(texts) != MAXAVRO_ERR_NONE)
+        {
+            printf("Read %d records: %s, %s\n", records,
+                   maxavro_get_error_string(objects), maxavro_get_error_string(texts));
+            rval = 1;
+        }
+    }
+
+    MXS_FREE(text.data);
+    maxavro_file_close(objects);
+    maxavro_file_close(texts);
+
+    return rval;
+}
+
+int main(int argc, char** argv)
+{
+    if (!mxs_log_init(NULL, NULL, MXS_LOG_TARGET_STDOUT))
+    {
+        fprintf(stderr, "Failed to initialize log.\n");
+        return 1;
+    }
+
+    int rval = test_snappy_elements();
+
+    if (write_file())
+    {
+        rval += test_read_file();
+    }
+    else
+    {
+        printf("Failed to write file.\n");
+        rval++;
+    }
+
+    remove(testfile);
+    mxs_log_finish();
+
+    return rval;
+}
@@ -105,10 +105,22 @@ typedef struct
 {
     buffer_object_t* bufobj;    /*< List of objects referred to by GWBUF */
     int32_t          refcount;  /*< Reference count on the buffer */
-    uint32_t         info;      /*< Info bits */
+    uint16_t         info;      /*< Info bits */
+    uint16_t         pool_class;/*< Size class of the buffer pool, GWBUF_POOL_NONE if not pooled */
     unsigned char    data[1];   /*< Actual memory that was allocated */
 } SHARED_BUF;
 
+#define GWBUF_POOL_NONE UINT16_MAX
+
+/**
+ * Statistics of the buffer pool of a thread.
+ */
+typedef struct gwbuf_pool_stats
+{
+    int64_t n_hits;     /*< Allocations served from the pool */
+    int64_t n_misses;   /*< Allocations that had to be made with malloc */
+} GWBUF_POOL_STATS;
+
 /**
  * The buffer structure used by the descriptor control blocks.
  *
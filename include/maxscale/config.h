@@ -112,6 +112,8 @@ extern const char CN_AUTH_WRITE_TIMEOUT[];
 extern const char CN_AUTO[];
 extern const char CN_CACHE_SIZE[];
 extern const char CN_CLASSIFY[];
+extern const char CN_CLIENT_PLACEMENT[];
+extern const char CN_COMPRESSION[];
 extern const char CN_CONNECTION_TIMEOUT[];
 extern const char CN_DUMP_LAST_STATEMENTS[];
 extern const char CN_DATA[];
@@ -159,12 +161,15 @@ extern const char CN_EXTRA_PORT[];
 extern const char CN_PROTOCOL[];
 extern const char CN_QUERY_CLASSIFIER[];
 extern const char CN_QUERY_CLASSIFIER_ARGS[];
+extern const char CN_QUERY_CLASSIFIER_CACHE_EVICTION[];
+extern const char CN_QUERY_CLASSIFIER_CACHE_MODE[];
 extern const char CN_QUERY_CLASSIFIER_CACHE_SIZE[];
 extern const char CN_QUERY_RETRIES[];
 extern const char CN_QUERY_RETRY_TIMEOUT[];
 extern const char CN_RELATIONSHIPS[];
 extern const char CN_LINKS[];
 extern const char CN_REQUIRED[];
+extern const char CN_REBALANCE_THRESHOLD[];
 extern const char CN_RETAIN_LAST_STATEMENTS[];
 extern const char CN_RETRY_ON_FAILURE[];
 extern const char CN_ROUTER[];
@@ -50,6 +50,12 @@ typedef struct dcbstats
     int n_buffered;     /*< Number of buffered writes */
     int n_high_water;   /*< Number of crosses of high water mark */
     int n_low_water;    /*< Number of crosses of low water mark */
+
+    uint64_t n_encoded_in;  /*< Bytes read and passed to the codec */
+    uint64_t n_decoded_in;  /*< Bytes the codec decoded them into */
+    uint64_t n_decoded_out; /*< Bytes passed to the codec for writing */
+    uint64_t n_encoded_out; /*< Bytes the codec encoded them into */
+    uint64_t codec_time;    /*< Time spent in the codec in microseconds */
 } DCBSTATS;
 
 #define DCBSTATS_INIT {0}
@@ -145,6 +151,36 @@ typedef struct dcb_callback
     struct dcb_callback* next;          /*< Next callback for this DCB */
 } DCB_CALLBACK;
 
+/**
+ * A codec transforms all data read from and written to the descriptor of a DCB.
+ * It is installed by the protocol module, e.g. to implement compression once
+ * the peers have agreed upon it. Both functions take the ownership of the data.
+ */
+typedef struct dcb_codec
+{
+    /**
+     * Decode data read from the descriptor
+     *
+     * @param dcb      The DCB the data was read from
+     * @param data     The data that was read
+     * @param decoded  Set to the decoded data, or NULL if no complete unit
+     *                 has been read yet
+     *
+     * @return True on success, false if the data could not be decoded
+     */
+    bool (* decode)(struct dcb* dcb, GWBUF* data, GWBUF** decoded);
+
+    /**
+     * Encode data to be written to the descriptor
+     *
+     * @param dcb   The DCB the data is written to
+     * @param data  The data to write
+     *
+     * @return The encoded data or NULL on error
+     */
+    GWBUF* (* encode)(struct dcb* dcb, GWBUF* data);
+} DCB_CODEC;
+
 /**
  * State of SSL connection
  */
@@ -218,6 +254,7 @@ typedef struct dcb
     bool            ssl_read_want_write;    /*< Flag */
     bool            ssl_write_want_read;    /*< Flag */
     bool            ssl_write_want_write;   /*< Flag */
+    const DCB_CODEC* codec;                 /**< Codec of the data, or NULL if none */
     bool            was_persistent;         /**< Whether this DCB was in the persistent pool */
     bool            high_water_reached;     /** High water mark reached, to determine whether need release
                                              * throttle */
@@ -455,6 +492,7 @@ json_t* dcb_to_json(DCB* dcb);
  */
 #define DCBF_HUNG    0x0002     /*< Hangup has been dispatched */
 #define DCBF_REPLIED 0x0004     /*< DCB was written to */
+#define DCBF_PENDING 0x0008     /*< Counted as pending by the worker picked for it */
 
 #define DCB_REPLIED(d) ((d)->flags & DCBF_REPLIED)
 
@@ -43,6 +43,7 @@ typedef struct servlistener
     void*          auth_instance;   /**< Authenticator instance created in MXS_AUTHENTICATOR::initialize()
                                      * */
     SSL_LISTENER*         ssl;      /**< Structure of SSL data or NULL */
+    bool                  compression; /**< Whether clients may use a compressed protocol */
     struct dcb*           listener; /**< The DCB for the listener */
     struct users*         users;    /**< The user data for this listener */
     struct service*       service;  /**< The service which used by this listener */
@@ -84,7 +85,8 @@ SERV_LISTENER* listener_alloc(struct service* service,
                               unsigned short port,
                               const char* authenticator,
                               const char* auth_options,
-                              SSL_LISTENER* ssl);
+                              SSL_LISTENER* ssl,
+                              bool compression);
 void listener_free(SERV_LISTENER* listener);
 int  listener_set_ssl_version(SSL_LISTENER* ssl_listener, const char* version);
 void listener_set_certificates(SSL_LISTENER* ssl_listener, char* cert, char* key, char* ca_cert);
@@ -27,4 +27,41 @@ namespace maxscale
 std::string extract_sql(GWBUF* buffer, size_t len = -1);
 
 std::string get_canonical(GWBUF* querybuf);
+
+/**
+ * A canonical statement and its hash, as returned by canonicalize().
+ */
+struct Canonical
+{
+    const char* pStmt;  /**< The canonical statement, not NUL-terminated. */
+    size_t      len;    /**< The length of the canonical statement. */
+    uint64_t    hash;   /**< A 64-bit hash of the canonical statement. */
+
+    std::string str() const
+    {
+        return std::string(pStmt, len);
+    }
+};
+
+/**
+ * Canonicalize a statement and compute a hash of the canonical statement,
+ * in one pass over the statement.
+ *
+ * @param querybuf  A COM_QUERY or COM_STMT_PREPARE packet.
+ *
+ * @return The canonical statement and its hash. The statement is stored in
+ *         a buffer owned by the calling thread and remains valid only until
+ *         the next call to canonicalize() in the same thread.
+ */
+Canonical canonicalize(GWBUF* querybuf);
+
+/**
+ * Canonicalize an SQL statement that is not in a packet.
+ *
+ * @param pSql  The statement, need not be NUL-terminated.
+ * @param len   The length of the statement.
+ *
+ * @return The canonical statement and its hash, as with the packet version.
+ */
+Canonical canonicalize(const char* pSql, size_t len);
 }
@@ -178,6 +178,17 @@ typedef struct mxs_protocol
      * @return JSON representation of the DCB
      */
     json_t* (*diagnostics_json)(struct dcb* dcb);
+
+    /**
+     * Check if the protocol holds no data of the connection, used when moving
+     * sessions between routing workers
+     *
+     * @param dcb DCB to check
+     *
+     * @return True if no partial packets or stored queries are held by the
+     *         protocol. If the entry point is NULL, the protocol is considered idle.
+     */
+    bool (* is_idle)(struct dcb* dcb);
 } MXS_PROTOCOL;
 
 /**
@@ -185,7 +196,7 @@ typedef struct mxs_protocol
  * the MXS_PROTOCOL structure is changed. See the rules defined in modinfo.h
  * that define how these numbers should change.
  */
-#define MXS_PROTOCOL_VERSION {2, 0, 0}
+#define MXS_PROTOCOL_VERSION {2, 1, 0}
 
 /**
  * Specifies capabilities specific for protocol.
@@ -342,6 +342,9 @@ typedef struct
                                              * packet type */
     bool large_query;                       /*< Whether to ignore the command byte of the next
                                              * packet*/
+    bool    compress;                       /*< Whether the compressed protocol was agreed upon */
+    uint8_t compressed_seq;                 /*< Sequence number of the next compressed packet */
+    GWBUF*  compressed_readq;               /*< Incomplete compressed packets */
 } MySQLProtocol;
 
 typedef struct
@@ -504,6 +507,20 @@ bool gw_read_backend_handshake(DCB* dcb, GWBUF* buffer);
 /** Send the server handshake response packet to the backend server */
 mxs_auth_state_t gw_send_backend_auth(DCB* dcb);
 
+/**
+ * Start using the compressed protocol on a connection
+ *
+ * All data read from and written to the DCB after this is decompressed and
+ * compressed, so this must be called once the OK packet that completes the
+ * authentication has been sent or received. Data that is already in the read
+ * queue of the DCB is decompressed.
+ *
+ * @param dcb Client or backend DCB
+ *
+ * @return False if the data in the read queue could not be decompressed
+ */
+bool mxs_mysql_enable_compression(DCB* dcb);
+
 /** Sends a response for an AuthSwitchRequest to the default auth plugin */
 int send_mysql_native_password_response(DCB* dcb);
 
@@ -431,14 +431,45 @@ typedef struct query_classifier
      * @param info  The info to be closed.
      */
     void (* qc_info_close)(QC_STMT_INFO* info);
+
+    /**
+     * Returns the amount of memory used by an info object.
+     *
+     * @param info  The info object.
+     *
+     * @return The size of the info object, including everything it owns.
+     */
+    int64_t (* qc_info_size)(QC_STMT_INFO* info);
 } QUERY_CLASSIFIER;
 
+/**
+ * qc_cache_mode_t specifies whether the query classification cache is
+ * thread specific or shared between all threads.
+ */
+typedef enum qc_cache_mode
+{
+    QC_CACHE_MODE_THREAD,   /** Each thread has a cache of its own. */
+    QC_CACHE_MODE_SHARED    /** All threads share the same cache. */
+} qc_cache_mode_t;
+
+/**
+ * qc_cache_eviction_t specifies how entries are chosen for eviction when
+ * the query classification cache is full.
+ */
+typedef enum qc_cache_eviction
+{
+    QC_CACHE_EVICTION_LRU,  /** The least recently used entry is evicted. */
+    QC_CACHE_EVICTION_CLOCK /** An entry not used since the clock hand last passed it is evicted. */
+} qc_cache_eviction_t;
+
 /**
  * QC_CACHE_PROPERTIES specifies the limits of the query classification cache.
  */
 typedef struct QC_CACHE_PROPERTIES
 {
-    int64_t max_size;   /** The maximum size of the cache. */
+    int64_t             max_size;   /** The maximum size of the cache. */
+    qc_cache_mode_t     mode;       /** Whether the cache is thread specific or shared. */
+    qc_cache_eviction_t eviction;   /** The eviction policy of the cache. */
 } QC_CACHE_PROPERTIES;
 
 /**
@@ -828,6 +859,17 @@ bool qc_is_drop_table_query(GWBUF* stmt);
  */
 const char* qc_op_to_string(qc_query_op_t op);
 
+/**
+ * Returns the string representation of a cache eviction policy.
+ *
+ * @param eviction  An eviction policy.
+ *
+ * @return The corresponding string.
+ *
+ * @note The returned string is statically allocated and must *not* be freed.
+ */
+const char* qc_cache_eviction_to_string(qc_cache_eviction_t eviction);
+
 /**
  * Returns whether the typemask contains a particular type.
  *
@@ -909,7 +951,9 @@ void qc_get_cache_properties(QC_CACHE_PROPERTIES* properties);
 /**
  * Set the cache properties.
  *
- * @param properties  Cache properties.
+ * @param properties  Cache properties. The mode and the eviction policy of
+ *                    the cache can only be specified at setup and are
+ *                    ignored here.
  *
  * @return True, if the properties could be set, false if at least
  *         one property is invalid or if the combination of property
@@ -920,6 +964,9 @@ bool qc_set_cache_properties(const QC_CACHE_PROPERTIES* properties);
 /**
  * Get cache statistics for the calling thread.
  *
+ * If the cache is shared, the size is that of the shared cache and the
+ * other values tell how the calling thread has used the shared cache.
+ *
  * @param stats[out]  Cache statistics.
  *
  * @return True, if caching is enabled, false otherwise.
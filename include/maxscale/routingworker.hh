@@ -45,6 +45,15 @@ public:
         MAIN = -1
     };
 
+    /**
+     * The worker statistics extended with routing worker specific values.
+     */
+    struct STATISTICS : public Worker::STATISTICS
+    {
+        int64_t n_buffer_pool_hits = 0;     /*< Buffer allocations served from the buffer pool */
+        int64_t n_buffer_pool_misses = 0;   /*< Buffer allocations that had to use malloc */
+    };
+
     typedef Registry<MXS_SESSION> SessionsById;
     typedef std::vector<DCB*>     Zombies;
 
@@ -320,13 +329,131 @@ public:
      */
     static int64_t get_one_statistic(POLL_STAT what);
 
+    /**
+     * Return the statistics of the buffer pool of this worker.
+     *
+     * @return The buffer pool statistics.
+     *
+     * @attention The values are updated by the worker thread without
+     *            synchronization and may be slightly out of date.
+     */
+    const GWBUF_POOL_STATS& buffer_pool_statistics() const
+    {
+        return m_buffer_pool_stats;
+    }
+
+    /**
+     * How pick_worker() chooses the worker of a new client connection.
+     */
+    enum client_placement_t
+    {
+        PLACEMENT_ROUND_ROBIN,      /*< The workers are picked in turn. */
+        PLACEMENT_LEAST_LOADED      /*< The worker with the fewest clients is picked. */
+    };
+
+    /**
+     * Set how the worker of a new client connection is chosen.
+     *
+     * @param placement  The placement strategy.
+     */
+    static void set_client_placement(client_placement_t placement);
+
+    /**
+     * @return How the worker of a new client connection is chosen.
+     */
+    static client_placement_t get_client_placement();
+
     /**
      * Get next worker
      *
+     * The returned worker counts the connection as pending until it has been
+     * added to the worker with poll_add_dcb(). That way a burst of connections
+     * accepted before any of them have been added is still spread evenly when
+     * the least loaded worker is picked.
+     *
      * @return The worker where work should be assigned
      */
     static RoutingWorker* pick_worker();
 
+    /**
+     * Book-keeping of the client connections of the worker. Called by
+     * poll_add_dcb() when a new client DCB is added to the worker and
+     * by dcb_final_close() when it is closed.
+     */
+    void client_added();
+    void client_removed();
+
+    /**
+     * Release a connection counted as pending by pick_worker(). The DCB of
+     * the connection is marked with DCBF_PENDING, and poll_add_dcb() calls
+     * this in the picked worker when the DCB has been added or its adding
+     * has failed. If the DCB could not be handed to the picked worker, the
+     * caller of pick_worker() must clear the flag and call this itself.
+     */
+    void pending_client_done();
+
+    /**
+     * @return The number of client connections of the worker.
+     */
+    int32_t client_count() const
+    {
+        return mxb::atomic::load(&m_nClients, mxb::atomic::RELAXED);
+    }
+
+    /**
+     * @return The number of client connections picked for the worker but not yet added.
+     */
+    int32_t pending_client_count() const
+    {
+        return mxb::atomic::load(&m_nPending_clients, mxb::atomic::RELAXED);
+    }
+
+    /**
+     * Set the load difference at which sessions are moved between workers.
+     *
+     * Once a second, the main worker compares the loads of the workers
+     * during the last second. If the difference between the most and the
+     * least loaded worker is at least @c threshold percentage points, idle
+     * sessions are moved from the former to the latter.
+     *
+     * @param threshold  The difference in percentage points, 0 disables the moving.
+     */
+    static void set_rebalance_threshold(int threshold);
+
+    /**
+     * @return The load difference at which sessions are moved between workers.
+     */
+    static int get_rebalance_threshold();
+
+    /**
+     * Move idle sessions of this worker to another worker.
+     *
+     * Only sessions for which Session::can_be_moved() returns true are
+     * moved. Must be called in this worker.
+     *
+     * @param pTarget  The worker the sessions are moved to.
+     * @param n        The maximum number of sessions to move.
+     *
+     * @return The number of sessions that were moved.
+     */
+    int move_sessions(RoutingWorker* pTarget, int n);
+
+    /**
+     * @return The number of sessions moved to this worker.
+     */
+    uint64_t sessions_moved_in() const
+    {
+        return m_nSessions_moved_in;
+    }
+
+    /**
+     * @return The number of sessions moved away from this worker.
+     */
+    uint64_t sessions_moved_out() const
+    {
+        return m_nSessions_moved_out;
+    }
+
     /**
      * Worker local storage
      */
@@ -489,15 +616,20 @@ private:
     class WatchdogNotifier;
     friend WatchdogNotifier;
 
-    const int    m_id;              /*< The id of the worker. */
-    SessionsById m_sessions;        /*< A mapping of session_id->MXS_SESSION. The map
-                                     *  should contain sessions exclusive to this
-                                     *  worker and not e.g. listener sessions. For now,
-                                     *  it's up to the protocol to decide whether a new
-                                     *  session is added to the map. */
-    Zombies      m_zombies;         /*< DCBs to be deleted. */
-    LocalData    m_local_data;      /*< Data local to this worker */
-    DataDeleters m_data_deleters;   /*< Delete functions for the local data */
+    const int        m_id;                   /*< The id of the worker. */
+    SessionsById     m_sessions;             /*< A mapping of session_id->MXS_SESSION. The map
+                                              *  should contain sessions exclusive to this
+                                              *  worker and not e.g. listener sessions. For now,
+                                              *  it's up to the protocol to decide whether a new
+                                              *  session is added to the map. */
+    Zombies          m_zombies;              /*< DCBs to be deleted. */
+    LocalData        m_local_data;           /*< Data local to this worker */
+    DataDeleters     m_data_deleters;        /*< Delete functions for the local data */
+    GWBUF_POOL_STATS m_buffer_pool_stats;    /*< Statistics of the buffer pool of this worker */
+    int32_t          m_nClients;             /*< Client connections added to this worker. */
+    int32_t          m_nPending_clients;     /*< Client connections picked but not yet added. */
+    uint64_t         m_nSessions_moved_in;   /*< Sessions moved to this worker. */
+    uint64_t         m_nSessions_moved_out;  /*< Sessions moved away from this worker. */
 
     RoutingWorker();
     virtual ~RoutingWorker();
@@ -509,6 +641,9 @@ private:
     void epoll_tick();  // override
 
     void delete_zombies();
+    bool move_session(MXS_SESSION* pSession, RoutingWorker* pTarget);
+    void adopt_session(MXS_SESSION* pSession, const std::vector<DCB*>& dcbs, bool registered);
+    bool balance_workers(Worker::Call::action_t action);
     void check_systemd_watchdog();
     void start_watchdog_workaround();
     void stop_watchdog_workaround();
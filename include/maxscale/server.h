@@ -139,6 +139,7 @@ typedef struct server
     long persistmaxtime;                    /**< Maximum number of seconds connection can live */
     bool proxy_protocol;                    /**< Send proxy-protocol header to backends when connecting
                                              *   routing sessions. */
+    bool compression;                       /**< Use a compressed protocol if the server supports it */
     SERVER_PARAM* parameters;               /**< Additional custom parameters which may affect routing
                                              * decisions. */
     // Base variables
@@ -343,6 +343,8 @@ class Registry
 public:
     typedef typename RegistryTraits<EntryType>::id_type    id_type;
     typedef typename RegistryTraits<EntryType>::entry_type entry_type;
+    typedef typename std::unordered_map<id_type, entry_type> ContainerType;
+    typedef typename ContainerType::const_iterator           const_iterator;
 
     Registry()
     {
@@ -393,8 +395,31 @@ public:
         return rval;
     }
 
+    /**
+     * Number of entries in the registry.
+     *
+     * @return The number of entries
+     */
+    size_t size() const
+    {
+        return m_registry.size();
+    }
+
+    /**
+     * Iteration over the id-entry pairs of the registry. Adding or removing
+     * entries invalidates the iterators.
+     */
+    const_iterator begin() const
+    {
+        return m_registry.begin();
+    }
+
+    const_iterator end() const
+    {
+        return m_registry.end();
+    }
+
 private:
-    typedef typename std::unordered_map<id_type, entry_type> ContainerType;
     ContainerType m_registry;
 };
 
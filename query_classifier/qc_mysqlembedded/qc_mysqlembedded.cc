@@ -3537,6 +3537,7 @@ extern "C"
             qc_mysql_set_sql_mode,
             nullptr,    // qc_info_dup not supported.
             nullptr,    // qc_info_close not supported.
+            nullptr,    // qc_info_size not supported.
         };
 
         static MXS_MODULE info =
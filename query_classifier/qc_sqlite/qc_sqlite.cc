@@ -28,6 +28,7 @@
 #include <vector>
 #include <mutex>
 
+#include <maxbase/atomic.hh>
 #include <maxscale/alloc.h>
 #include <maxscale/log.h>
 #include <maxscale/modinfo.h>
@@ -242,16 +243,18 @@ class QcSqliteInfo : public QC_STMT_INFO
     QcSqliteInfo& operator=(const QcSqliteInfo&);
 
 public:
+    // The reference count is manipulated atomically, as an info object may
+    // be shared between threads by the query classification cache.
     void inc_ref()
     {
         mxb_assert(m_refs > 0);
-        ++m_refs;
+        mxb::atomic::add(&m_refs, 1, mxb::atomic::RELAXED);
     }
 
     void dec_ref()
     {
         mxb_assert(m_refs > 0);
-        if (--m_refs == 0)
+        if (mxb::atomic::add(&m_refs, -1, mxb::atomic::ACQ_REL) == 1)
         {
             delete this;
         }
@@ -296,6 +299,48 @@ public:
         return m_status != QC_QUERY_INVALID;
     }
 
+    /**
+     * Returns the amount of memory used by this object, including the
+     * strings and arrays it owns.
+     */
+    int64_t size() const
+    {
+        int64_t size = sizeof(*this);
+
+        size += names_size(m_table_names);
+        size += names_size(m_table_fullnames);
+        size += names_size(m_database_names);
+        size += string_size(m_zCreated_table_name);
+        size += string_size(m_zPrepare_name);
+
+        if (m_pPreparable_stmt)
+        {
+            size += sizeof(GWBUF) + gwbuf_length(m_pPreparable_stmt);
+        }
+
+        size += m_field_infos.capacity() * sizeof(QC_FIELD_INFO);
+        std::for_each(m_field_infos.begin(), m_field_infos.end(), [&size](const QC_FIELD_INFO& info) {
+                          size += field_info_size(info);
+                      });
+
+        size += m_function_infos.capacity() * sizeof(QC_FUNCTION_INFO);
+        std::for_each(m_function_infos.begin(), m_function_infos.end(), [&size](const QC_FUNCTION_INFO& info) {
+                          size += string_size(info.name);
+                      });
+
+        // The fields referred to from m_function_infos are stored here.
+        size += m_function_field_usage.capacity() * sizeof(vector<QC_FIELD_INFO>);
+        for (const auto& fields : m_function_field_usage)
+        {
+            size += fields.capacity() * sizeof(QC_FIELD_INFO);
+            std::for_each(fields.begin(), fields.end(), [&size](const QC_FIELD_INFO& info) {
+                              size += field_info_size(info);
+                          });
+        }
+
+        return size;
+    }
+
     bool get_type_mask(uint32_t* pType_mask) const
     {
         bool rv = false;
@@ -3096,6 +3141,28 @@ private:
     }
 
 private:
+    static int64_t string_size(const char* z)
+    {
+        return z ? strlen(z) + 1 : 0;
+    }
+
+    static int64_t names_size(const vector<char*>& names)
+    {
+        int64_t size = names.capacity() * sizeof(char*);
+
+        for (const char* zName : names)
+        {
+            size += string_size(zName);
+        }
+
+        return size;
+    }
+
+    static int64_t field_info_size(const QC_FIELD_INFO& info)
+    {
+        return string_size(info.database) + string_size(info.table) + string_size(info.column);
+    }
+
     bool should_collect(qc_collect_info_t collect) const
     {
         return (m_collect & collect) && !(m_collected & collect);
@@ -4436,6 +4503,7 @@ static int32_t       qc_sqlite_get_sql_mode(qc_sql_mode_t* sql_mode);
 static int32_t       qc_sqlite_set_sql_mode(qc_sql_mode_t sql_mode);
 static QC_STMT_INFO* qc_sqlite_info_dup(QC_STMT_INFO* info);
 static void          qc_sqlite_info_close(QC_STMT_INFO* info);
+static int64_t       qc_sqlite_info_size(QC_STMT_INFO* info);
 
 static bool get_key_and_value(char* arg, const char** pkey, const char** pvalue)
 {
@@ -5118,6 +5186,11 @@ void qc_sqlite_info_close(QC_STMT_INFO* info)
     static_cast<QcSqliteInfo*>(info)->dec_ref();
 }
 
+int64_t qc_sqlite_info_size(QC_STMT_INFO* info)
+{
+    return static_cast<QcSqliteInfo*>(info)->size();
+}
+
 /**
  * EXPORTS
  */
@@ -5153,6 +5226,7 @@ extern "C"
             qc_sqlite_set_sql_mode,
             qc_sqlite_info_dup,
             qc_sqlite_info_close,
+            qc_sqlite_info_size,
         };
 
         static MXS_MODULE info =
@@ -11,9 +11,15 @@
  * Public License.
  */
 
+#include <sys/wait.h>
 #include <unistd.h>
 #include <chrono>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <string>
+#include <vector>
+#include <maxscale/config.h>
 #include <maxscale/log.h>
 #include <maxscale/paths.h>
 #include <maxscale/query_classifier.h>
@@ -24,6 +30,17 @@ using namespace std;
 namespace
 {
 
+const char USAGE[] =
+    "usage: qc_cache [-(c|n)] [-S cache size] [-p policy[,policy...]] (-s statement -# iterations | -t trace)\n"
+    "\n"
+    "-c  use the query classification cache\n"
+    "-n  do not use the query classification cache (default)\n"
+    "-S  the size of the cache in bytes, default 10485760\n"
+    "-p  comma separated list of eviction policies to compare, lru and/or clock, default lru\n"
+    "-s  the statement to classify\n"
+    "-#  how many times the statement should be classified\n"
+    "-t  a file containing statements, one per line, that are classified in order\n";
+
 GWBUF* create_gwbuf(const char* z, size_t len)
 {
     size_t payload_len = len + 1;
@@ -62,6 +79,7 @@ int run(const char* zStatement, int n)
 
         if (rc != QC_QUERY_PARSED)
         {
+            cerr << "error: Could not parse '" << zStatement << "'." << endl;
             return EXIT_FAILURE;
         }
 
@@ -72,30 +90,191 @@ int run(const char* zStatement, int n)
 
     return EXIT_SUCCESS;
 }
+
+/**
+ * Classifies the statements of a trace in order, as a router would, and reports
+ * how well the cache performed.
+ */
+int run(const vector<string>& trace, const char* zPolicy)
+{
+    std::chrono::duration<double> diff;
+
+    for (const auto& statement : trace)
+    {
+        GWBUF* pStatement = create_gwbuf(statement.c_str(), statement.length());
+
+        auto start = std::chrono::steady_clock::now();
+        qc_parse(pStatement, QC_COLLECT_ESSENTIALS);
+        auto end = std::chrono::steady_clock::now();
+
+        gwbuf_free(pStatement);
+
+        diff += (end - start);
+    }
+
+    QC_CACHE_STATS stats = {};
+    qc_get_cache_stats(&stats);
+
+    int64_t lookups = stats.hits + stats.misses;
+
+    cout << setw(6) << zPolicy
+         << " hits: " << setw(10) << stats.hits
+         << " misses: " << setw(10) << stats.misses
+         << " hit ratio: " << setw(6) << fixed << setprecision(4)
+         << (lookups ? (double)stats.hits / lookups : 0)
+         << " evictions: " << setw(10) << stats.evictions
+         << " size: " << setw(10) << stats.size
+         << " time: " << setprecision(3) << diff.count() << " s"
+         << endl;
+
+    return EXIT_SUCCESS;
+}
+
+bool read_trace(const char* zTrace, vector<string>* pTrace)
+{
+    ifstream in(zTrace);
+
+    if (!in)
+    {
+        cerr << "error: Could not open '" << zTrace << "'." << endl;
+        return false;
+    }
+
+    string line;
+    while (getline(in, line))
+    {
+        if (!line.empty())
+        {
+            pTrace->push_back(line);
+        }
+    }
+
+    return true;
+}
+
+bool get_policies(const char* zPolicies, vector<qc_cache_eviction_t>* pPolicies)
+{
+    string policies(zPolicies);
+    size_t pos = 0;
+
+    while (pos <= policies.length())
+    {
+        size_t end = policies.find(',', pos);
+
+        if (end == string::npos)
+        {
+            end = policies.length();
+        }
+
+        string policy = policies.substr(pos, end - pos);
+
+        if (policy == "lru")
+        {
+            pPolicies->push_back(QC_CACHE_EVICTION_LRU);
+        }
+        else if (policy == "clock")
+        {
+            pPolicies->push_back(QC_CACHE_EVICTION_CLOCK);
+        }
+        else
+        {
+            cerr << "error: Unknown eviction policy '" << policy << "'." << endl;
+            return false;
+        }
+
+        pos = end + 1;
+    }
+
+    return true;
+}
+
+int test(QC_CACHE_PROPERTIES* pCache_properties,
+         const char* zStatement, int n,
+         const vector<string>& trace)
+{
+    int rv = EXIT_FAILURE;
+
+    set_datadir(strdup("/tmp"));
+    set_langdir(strdup("."));
+    set_process_datadir(strdup("/tmp"));
+
+    // The per thread cache size is derived from the number of threads.
+    config_get_global_options()->n_threads = 1;
+
+    if (mxs_log_init(NULL, ".", MXS_LOG_TARGET_DEFAULT))
+    {
+        if (qc_setup(pCache_properties, QC_SQL_MODE_DEFAULT, "qc_sqlite", NULL)
+            && qc_process_init(QC_INIT_BOTH)
+            && qc_thread_init(QC_INIT_BOTH))
+        {
+            if (zStatement)
+            {
+                cout << n
+                     << " iterations, while "
+                     << (pCache_properties ? "using " : "NOT using ")
+                     << "the query classification cache." << endl;
+
+                rv = run(zStatement, n);
+            }
+            else
+            {
+                const char* zPolicy = pCache_properties ?
+                    qc_cache_eviction_to_string(pCache_properties->eviction) : "none";
+
+                rv = run(trace, zPolicy);
+            }
+
+            qc_thread_end(QC_INIT_BOTH);
+            qc_process_end(QC_INIT_BOTH);
+        }
+        else
+        {
+            cerr << "error: Could not initialize qc_sqlite." << endl;
+        }
+
+        mxs_log_finish();
+    }
+    else
+    {
+        cerr << "error: Could not initialize log." << endl;
+    }
+
+    return rv;
+}
 }
 
 int main(int argc, char* argv[])
 {
     int rv = EXIT_SUCCESS;
 
-    QC_CACHE_PROPERTIES* pCache_properties = nullptr;
+    QC_CACHE_PROPERTIES cache_properties = {};
+    cache_properties.max_size = 10 * 1024 * 1024;
+
+    bool use_cache = false;
+    const char* zPolicies = "lru";
     const char* zStatement = nullptr;
+    const char* zTrace = nullptr;
     int n = 0;
 
     int c;
-    while ((c = getopt(argc, argv, "cns:#:")) != -1)
+    while ((c = getopt(argc, argv, "cnS:p:s:#:t:")) != -1)
     {
         switch (c)
         {
         case 'c':
-            {
-                static QC_CACHE_PROPERTIES cache_properties;
-                pCache_properties = &cache_properties;
-            }
+            use_cache = true;
             break;
 
         case 'n':
-            pCache_properties = nullptr;
+            use_cache = false;
+            break;
+
+        case 'S':
+            cache_properties.max_size = atoll(optarg);
+            break;
+
+        case 'p':
+            zPolicies = optarg;
             break;
 
         case 's':
@@ -106,52 +285,61 @@ int main(int argc, char* argv[])
             n = atoi(optarg);
             break;
 
+        case 't':
+            zTrace = optarg;
+            break;
+
         default:
             rv = EXIT_FAILURE;
         }
     }
 
-    if ((rv == EXIT_SUCCESS) && zStatement && (n > 0))
-    {
-        rv = EXIT_FAILURE;
-
-        set_datadir(strdup("/tmp"));
-        set_langdir(strdup("."));
-        set_process_datadir(strdup("/tmp"));
+    vector<qc_cache_eviction_t> policies;
+    vector<string> trace;
 
-        if (mxs_log_init(NULL, ".", MXS_LOG_TARGET_DEFAULT))
+    if ((rv == EXIT_SUCCESS)
+        && (cache_properties.max_size > 0)
+        && ((zStatement && (n > 0)) || (zTrace && !zStatement))
+        && get_policies(zPolicies, &policies))
+    {
+        if (zTrace && !read_trace(zTrace, &trace))
+        {
+            rv = EXIT_FAILURE;
+        }
+        else if (!use_cache)
+        {
+            rv = test(nullptr, zStatement, n, trace);
+        }
+        else
         {
-            cout << n
-                 << " iterations, while "
-                 << (pCache_properties ? "using " : "NOT using ")
-                 << "the query classification cache." << endl;
-
-            if (qc_setup(pCache_properties, QC_SQL_MODE_DEFAULT, "qc_sqlite", NULL)
-                && qc_process_init(QC_INIT_BOTH)
-                && qc_thread_init(QC_INIT_BOTH))
+            // The query classifier can be set up only once per process, so each
+            // policy is measured in a process of its own.
+            for (auto policy : policies)
             {
-                rv = run(zStatement, n);
+                cache_properties.eviction = policy;
 
-                if (rv != EXIT_SUCCESS)
+                pid_t pid = fork();
+
+                if (pid == 0)
                 {
-                    cerr << "error: Could not parse '" << zStatement << "'." << endl;
+                    exit(test(&cache_properties, zStatement, n, trace));
                 }
-            }
-            else
-            {
-                cerr << "error: Could not initialize qc_sqlite." << endl;
-            }
 
-            mxs_log_finish();
-        }
-        else
-        {
-            cerr << "error: Could not initialize log." << endl;
+                int status;
+                if ((pid == -1)
+                    || (waitpid(pid, &status, 0) == -1)
+                    || !WIFEXITED(status)
+                    || (WEXITSTATUS(status) != EXIT_SUCCESS))
+                {
+                    rv = EXIT_FAILURE;
+                }
+            }
         }
     }
     else
     {
-        cerr << "usage: qc_cache [-(c|n)] -s statement -# iterations" << endl;
+        cerr << USAGE << endl;
+        rv = EXIT_FAILURE;
     }
 
     return rv;
@@ -11,7 +11,7 @@
  * Public License.
  */
 
-#include <maxscale/buffer.h>
+#include "internal/buffer.h"
 
 #include <errno.h>
 #include <stdlib.h>
@@ -30,12 +30,207 @@ static void             gwbuf_free_one(GWBUF* buf);
 static buffer_object_t* gwbuf_remove_buffer_object(GWBUF* buf,
                                                    buffer_object_t* bufobj);
 
+namespace
+{
+
+/**
+ * The buffer pool is a thread specific cache of freed GWBUF structures and
+ * small SHARED_BUFs. Each pooled object is a separate heap allocation, so
+ * an object allocated in one thread can be freed in any other; it simply
+ * ends up in the pool of the freeing thread, or back in the heap if that
+ * thread has no pool or its pool is full.
+ */
+
+/**
+ * The data capacities of the pooled shared buffer size classes. Buffers such as the
+ * session command history can live long, so the classes are powers of two to keep
+ * the unused capacity of a buffer below its size.
+ */
+const size_t POOL_CLASS_CAPACITY[] =
+{
+    128, 256, 512, 1024, 2 * 1024, 4 * 1024, 8 * 1024, 16 * 1024
+};
+/** The maximum number of free shared buffers kept per size class, 256KiB of each. */
+const size_t POOL_CLASS_MAX_FREE[] =
+{
+    2048, 1024, 512, 256, 128, 64, 32, 16
+};
+/** The maximum number of free GWBUF structures kept. */
+const size_t POOL_MAX_FREE_GWBUFS = 4096;
+
+const uint16_t N_POOL_CLASSES = sizeof(POOL_CLASS_CAPACITY) / sizeof(POOL_CLASS_CAPACITY[0]);
+
+static_assert(sizeof(POOL_CLASS_MAX_FREE) / sizeof(POOL_CLASS_MAX_FREE[0]) == N_POOL_CLASSES,
+              "Every size class must have a maximum number of free buffers.");
+
+struct FreeNode
+{
+    FreeNode* next;
+};
+
+struct FreeList
+{
+    FreeNode* head = nullptr;
+    size_t    count = 0;
+
+    void* pop()
+    {
+        FreeNode* node = head;
+
+        if (node)
+        {
+            head = node->next;
+            --count;
+        }
+
+        return node;
+    }
+
+    void push(void* p)
+    {
+        FreeNode* node = static_cast<FreeNode*>(p);
+        node->next = head;
+        head = node;
+        ++count;
+    }
+
+    void clear()
+    {
+        while (void* p = pop())
+        {
+            MXS_FREE(p);
+        }
+    }
+};
+
+thread_local struct
+{
+    GWBUF_POOL_STATS* stats;                    /*< Non-null if the pool of the thread is enabled */
+    FreeList          gwbufs;                   /*< Free GWBUF structures */
+    FreeList          sbufs[N_POOL_CLASSES];    /*< Free shared buffers of each size class */
+} this_thread;
+
+inline uint16_t pool_class_of(size_t size)
+{
+    for (uint16_t i = 0; i < N_POOL_CLASSES; ++i)
+    {
+        if (size <= POOL_CLASS_CAPACITY[i])
+        {
+            return i;
+        }
+    }
+
+    return GWBUF_POOL_NONE;
+}
+
+inline void* pool_get(FreeList& free_list, size_t size)
+{
+    void* p = nullptr;
+
+    if (this_thread.stats)
+    {
+        if ((p = free_list.pop()))
+        {
+            ++this_thread.stats->n_hits;
+        }
+        else
+        {
+            ++this_thread.stats->n_misses;
+        }
+    }
+
+    return p ? p : MXS_MALLOC(size);
+}
+
+inline void pool_put(FreeList& free_list, size_t max_free, void* p)
+{
+    if (this_thread.stats && free_list.count < max_free)
+    {
+        free_list.push(p);
+    }
+    else
+    {
+        MXS_FREE(p);
+    }
+}
+
+inline GWBUF* gwbuf_alloc_struct()
+{
+    return static_cast<GWBUF*>(pool_get(this_thread.gwbufs, sizeof(GWBUF)));
+}
+
+inline void gwbuf_free_struct(GWBUF* buf)
+{
+    if (buf)
+    {
+        pool_put(this_thread.gwbufs, POOL_MAX_FREE_GWBUFS, buf);
+    }
+}
+
+SHARED_BUF* sbuf_alloc(size_t size)
+{
+    uint16_t pool_class = pool_class_of(size);
+    SHARED_BUF* sbuf;
+
+    if (pool_class != GWBUF_POOL_NONE)
+    {
+        // Always allocate the full capacity so that the buffer can be pooled
+        // by whichever thread happens to free it.
+        size_t sbuf_size = sizeof(SHARED_BUF) + POOL_CLASS_CAPACITY[pool_class] - 1;
+        sbuf = static_cast<SHARED_BUF*>(pool_get(this_thread.sbufs[pool_class], sbuf_size));
+    }
+    else
+    {
+        sbuf = static_cast<SHARED_BUF*>(MXS_MALLOC(sizeof(SHARED_BUF) + size - 1));
+    }
+
+    if (sbuf)
+    {
+        sbuf->pool_class = pool_class;
+    }
+
+    return sbuf;
+}
+
+void sbuf_free(SHARED_BUF* sbuf)
+{
+    if (sbuf)
+    {
+        if (sbuf->pool_class != GWBUF_POOL_NONE)
+        {
+            mxb_assert(sbuf->pool_class < N_POOL_CLASSES);
+            pool_put(this_thread.sbufs[sbuf->pool_class], POOL_CLASS_MAX_FREE[sbuf->pool_class], sbuf);
+        }
+        else
+        {
+            MXS_FREE(sbuf);
+        }
+    }
+}
+}
+
+void gwbuf_pool_thread_init(GWBUF_POOL_STATS* stats)
+{
+    mxb_assert(stats);
+    this_thread.stats = stats;
+}
+
+void gwbuf_pool_thread_finish()
+{
+    this_thread.stats = nullptr;
+    this_thread.gwbufs.clear();
+
+    for (auto& free_list : this_thread.sbufs)
+    {
+        free_list.clear();
+    }
+}
+
 /**
  * Allocate a new gateway buffer structure of size bytes.
  *
- * For now we allocate memory directly from malloc for buffer the management
- * structure and the actual data buffer itself. We may swap at a future date
- * to a more efficient mechanism.
+ * The buffer management structure and small data buffers are taken from the
+ * buffer pool of the thread, if it has one, and otherwise allocated with malloc.
  *
  * @param       size The size in bytes of the data area required
  * @return      Pointer to the buffer structure or NULL if memory could not
@@ -43,14 +238,13 @@ static buffer_object_t* gwbuf_remove_buffer_object(GWBUF* buf,
  */
 GWBUF* gwbuf_alloc(unsigned int size)
 {
-    size_t sbuf_size = sizeof(SHARED_BUF) + (size ? size - 1 : 0);
-    GWBUF* rval = (GWBUF*)MXS_MALLOC(sizeof(GWBUF));
-    SHARED_BUF* sbuf = (SHARED_BUF*)MXS_MALLOC(sbuf_size);
+    GWBUF* rval = gwbuf_alloc_struct();
+    SHARED_BUF* sbuf = sbuf_alloc(size);
 
     if (rval == NULL || sbuf == NULL)
     {
-        MXS_FREE(rval);
-        MXS_FREE(sbuf);
+        gwbuf_free_struct(rval);
+        sbuf_free(sbuf);
         return NULL;
     }
 
@@ -128,7 +322,7 @@ static void gwbuf_free_one(GWBUF* buf)
             bo = gwbuf_remove_buffer_object(buf, bo);
         }
 
-        MXS_FREE(buf->sbuf);
+        sbuf_free(buf->sbuf);
     }
 
     while (buf->properties)
@@ -147,7 +341,7 @@ static void gwbuf_free_one(GWBUF* buf)
         hint_free(h);
     }
 
-    MXS_FREE(buf);
+    gwbuf_free_struct(buf);
 }
 
 /**
@@ -162,7 +356,7 @@ static void gwbuf_free_one(GWBUF* buf)
  */
 static GWBUF* gwbuf_clone_one(GWBUF* buf)
 {
-    GWBUF* rval = (GWBUF*)MXS_CALLOC(1, sizeof(GWBUF));
+    GWBUF* rval = gwbuf_alloc_struct();
 
     if (rval == NULL)
     {
@@ -179,6 +373,8 @@ static GWBUF* gwbuf_clone_one(GWBUF* buf)
     rval->start = buf->start;
     rval->end = buf->end;
     rval->gwbuf_type = buf->gwbuf_type;
+    rval->hint = NULL;
+    rval->properties = NULL;
     rval->tail = rval;
     rval->next = NULL;
 
@@ -250,7 +446,7 @@ static GWBUF* gwbuf_clone_portion(GWBUF* buf,
     mxb_assert(buf->owner == RoutingWorker::get_current_id());
     mxb_assert(start_offset + length <= GWBUF_LENGTH(buf));
 
-    GWBUF* clonebuf = (GWBUF*)MXS_MALLOC(sizeof(GWBUF));
+    GWBUF* clonebuf = gwbuf_alloc_struct();
 
     if (clonebuf == NULL)
     {
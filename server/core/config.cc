@@ -54,6 +54,7 @@
 #include <maxscale/paths.h>
 #include <maxscale/pcre2.h>
 #include <maxscale/router.h>
+#include <maxscale/routingworker.hh>
 #include <maxscale/secrets.h>
 #include <maxscale/utils.h>
 #include <maxscale/utils.hh>
@@ -93,6 +94,8 @@ const char CN_AUTH_WRITE_TIMEOUT[] = "auth_write_timeout";
 const char CN_AUTO[] = "auto";
 const char CN_CACHE_SIZE[] = "cache_size";
 const char CN_CLASSIFY[] = "classify";
+const char CN_CLIENT_PLACEMENT[] = "client_placement";
+const char CN_COMPRESSION[] = "compression";
 const char CN_CONNECTION_TIMEOUT[] = "connection_timeout";
 const char CN_DATA[] = "data";
 const char CN_DEFAULT[] = "default";
@@ -140,6 +143,8 @@ const char CN_EXTRA_PORT[] = "extra_port";
 const char CN_PROTOCOL[] = "protocol";
 const char CN_QUERY_CLASSIFIER[] = "query_classifier";
 const char CN_QUERY_CLASSIFIER_ARGS[] = "query_classifier_args";
+const char CN_QUERY_CLASSIFIER_CACHE_EVICTION[] = "query_classifier_cache_eviction";
+const char CN_QUERY_CLASSIFIER_CACHE_MODE[] = "query_classifier_cache_mode";
 const char CN_QUERY_CLASSIFIER_CACHE_SIZE[] = "query_classifier_cache_size";
 const char CN_QUERY_RETRIES[] = "query_retries";
 const char CN_QUERY_RETRY_TIMEOUT[] = "query_retry_timeout";
@@ -147,6 +152,7 @@ const char CN_RELATIONSHIPS[] = "relationships";
 const char CN_LINKS[] = "links";
 const char CN_LOCAL_ADDRESS[] = "local_address";
 const char CN_REQUIRED[] = "required";
+const char CN_REBALANCE_THRESHOLD[] = "rebalance_threshold";
 const char CN_RETAIN_LAST_STATEMENTS[] = "retain_last_statements";
 const char CN_RETRY_ON_FAILURE[] = "retry_on_failure";
 const char CN_ROUTER[] = "router";
@@ -331,6 +337,7 @@ const MXS_MODULE_PARAM config_listener_params[] =
     {CN_AUTHENTICATOR_OPTIONS,       MXS_MODULE_PARAM_STRING},
     {CN_ADDRESS,                     MXS_MODULE_PARAM_STRING,  "::"},
     {CN_AUTHENTICATOR,               MXS_MODULE_PARAM_STRING},
+    {CN_COMPRESSION,                 MXS_MODULE_PARAM_BOOL,    "false"},
     {CN_SSL,                         MXS_MODULE_PARAM_ENUM,    "false",
      MXS_MODULE_OPT_ENUM_UNIQUE,
      ssl_values},
@@ -410,6 +417,7 @@ const MXS_MODULE_PARAM config_server_params[] =
     {CN_PERSISTPOOLMAX,              MXS_MODULE_PARAM_COUNT,  "0"},
     {CN_PERSISTMAXTIME,              MXS_MODULE_PARAM_COUNT,  "0"},
     {CN_PROXY_PROTOCOL,              MXS_MODULE_PARAM_BOOL,   "false"},
+    {CN_COMPRESSION,                 MXS_MODULE_PARAM_BOOL,   "false"},
     {CN_SSL,                         MXS_MODULE_PARAM_ENUM,   "false",
      MXS_MODULE_OPT_ENUM_UNIQUE,
      ssl_values},
@@ -2322,6 +2330,40 @@ static int handle_global_item(const char* name, const char* value)
     {
         gateway.qc_args = MXS_STRDUP_A(value);
     }
+    else if (strcmp(name, CN_QUERY_CLASSIFIER_CACHE_EVICTION) == 0)
+    {
+        if (strcasecmp(value, "lru") == 0)
+        {
+            gateway.qc_cache_properties.eviction = QC_CACHE_EVICTION_LRU;
+        }
+        else if (strcasecmp(value, "clock") == 0)
+        {
+            gateway.qc_cache_properties.eviction = QC_CACHE_EVICTION_CLOCK;
+        }
+        else
+        {
+            MXS_ERROR("'%s' is not a valid value for '%s'. Allowed values are 'lru' and 'clock'.",
+                      value, name);
+            return 0;
+        }
+    }
+    else if (strcmp(name, CN_QUERY_CLASSIFIER_CACHE_MODE) == 0)
+    {
+        if (strcasecmp(value, "thread") == 0)
+        {
+            gateway.qc_cache_properties.mode = QC_CACHE_MODE_THREAD;
+        }
+        else if (strcasecmp(value, "shared") == 0)
+        {
+            gateway.qc_cache_properties.mode = QC_CACHE_MODE_SHARED;
+        }
+        else
+        {
+            MXS_ERROR("'%s' is not a valid value for '%s'. Allowed values are 'thread' and 'shared'.",
+                      value, name);
+            return 0;
+        }
+    }
     else if (strcmp(name, CN_QUERY_CLASSIFIER_CACHE_SIZE) == 0)
     {
         uint64_t int_value;
@@ -2585,6 +2627,23 @@ static int handle_global_item(const char* name, const char* value)
             return 0;
         }
     }
+    else if (strcmp(name, CN_CLIENT_PLACEMENT) == 0)
+    {
+        if (!config_set_client_placement(value))
+        {
+            MXS_ERROR("%s can have the values 'round_robin' or 'least_loaded'.", CN_CLIENT_PLACEMENT);
+            return 0;
+        }
+    }
+    else if (strcmp(name, CN_REBALANCE_THRESHOLD) == 0)
+    {
+        if (!config_set_rebalance_threshold(value))
+        {
+            MXS_ERROR("Invalid value for '%s', expected an integer between 0 and 100: %s",
+                      CN_REBALANCE_THRESHOLD, value);
+            return 0;
+        }
+    }
     else if (strcmp(name, CN_DUMP_LAST_STATEMENTS) == 0)
     {
         if (strcmp(value, "on_close") == 0)
@@ -2669,6 +2728,40 @@ static int handle_global_item(const char* name, const char* value)
     return processed ? 1 : 0;
 }
 
+bool config_set_client_placement(const char* value)
+{
+    bool rval = true;
+
+    if (strcmp(value, "round_robin") == 0)
+    {
+        mxs::RoutingWorker::set_client_placement(mxs::RoutingWorker::PLACEMENT_ROUND_ROBIN);
+    }
+    else if (strcmp(value, "least_loaded") == 0)
+    {
+        mxs::RoutingWorker::set_client_placement(mxs::RoutingWorker::PLACEMENT_LEAST_LOADED);
+    }
+    else
+    {
+        rval = false;
+    }
+
+    return rval;
+}
+
+bool config_set_rebalance_threshold(const char* value)
+{
+    char* endptr;
+    long threshold = strtol(value, &endptr, 0);
+    bool rval = *value && *endptr == '\0' && threshold >= 0 && threshold <= 100;
+
+    if (rval)
+    {
+        mxs::RoutingWorker::set_rebalance_threshold(threshold);
+    }
+
+    return rval;
+}
+
 bool config_can_modify_at_runtime(const char* name)
 {
     for (int i = 0; config_pre_parse_global_params[i]; ++i)
@@ -2692,6 +2785,8 @@ bool config_can_modify_at_runtime(const char* name)
         "sql_mode",
         CN_QUERY_CLASSIFIER_ARGS,
         CN_QUERY_CLASSIFIER,
+        CN_QUERY_CLASSIFIER_CACHE_MODE,
+        CN_QUERY_CLASSIFIER_CACHE_EVICTION,
         CN_POLL_SLEEP,
         CN_NON_BLOCKING_POLLS,
         CN_THREAD_STACK_SIZE,
@@ -2831,6 +2926,7 @@ void config_set_global_defaults()
     gateway.log_target = MXB_LOG_TARGET_DEFAULT;
 
     gateway.qc_cache_properties.max_size = get_total_memory() * 0.4;
+    gateway.qc_cache_properties.mode = QC_CACHE_MODE_THREAD;
 
     if (gateway.qc_cache_properties.max_size == 0)
     {
@@ -3957,6 +4053,7 @@ int create_new_listener(CONFIG_CONTEXT* obj)
         // authenticators that are specific to each protocol module
         char* authenticator = config_get_value(obj->parameters, CN_AUTHENTICATOR);
         char* authenticator_options = config_get_value(obj->parameters, CN_AUTHENTICATOR_OPTIONS);
+        bool compression = config_get_bool(obj->parameters, CN_COMPRESSION);
 
         if (socket)
         {
@@ -3967,7 +4064,8 @@ int create_new_listener(CONFIG_CONTEXT* obj)
                                   0,
                                   authenticator,
                                   authenticator_options,
-                                  ssl_info);
+                                  ssl_info,
+                                  compression);
         }
         else if (port)
         {
@@ -3978,7 +4076,8 @@ int create_new_listener(CONFIG_CONTEXT* obj)
                                   atoi(port),
                                   authenticator,
                                   authenticator_options,
-                                  ssl_info);
+                                  ssl_info,
+                                  compression);
         }
     }
 
@@ -4502,6 +4601,14 @@ json_t* config_maxscale_to_json(const char* host)
     json_object_set_new(param, CN_THREAD_STACK_SIZE, json_integer(config_thread_stack_size()));
     json_object_set_new(param, CN_WRITEQ_HIGH_WATER, json_integer(config_writeq_high_water()));
     json_object_set_new(param, CN_WRITEQ_LOW_WATER, json_integer(config_writeq_low_water()));
+    json_object_set_new(param,
+                        CN_CLIENT_PLACEMENT,
+                        json_string(mxs::RoutingWorker::get_client_placement()
+                                    == mxs::RoutingWorker::PLACEMENT_LEAST_LOADED ?
+                                    "least_loaded" : "round_robin"));
+    json_object_set_new(param,
+                        CN_REBALANCE_THRESHOLD,
+                        json_integer(mxs::RoutingWorker::get_rebalance_threshold()));
 
     MXS_CONFIG* cnf = config_get_global_options();
 
@@ -4530,6 +4637,15 @@ json_t* config_maxscale_to_json(const char* host)
                         CN_QUERY_CLASSIFIER_CACHE_SIZE,
                         json_integer(cnf->qc_cache_properties.max_size));
 
+    json_object_set_new(param,
+                        CN_QUERY_CLASSIFIER_CACHE_MODE,
+                        json_string(cnf->qc_cache_properties.mode == QC_CACHE_MODE_SHARED ?
+                                    "shared" : "thread"));
+
+    json_object_set_new(param,
+                        CN_QUERY_CLASSIFIER_CACHE_EVICTION,
+                        json_string(qc_cache_eviction_to_string(cnf->qc_cache_properties.eviction)));
+
     json_t* attr = json_object();
     time_t started = maxscale_started();
     time_t activated = started + MXS_CLOCK_TO_SEC(cnf->promoted_at);
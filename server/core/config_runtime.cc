@@ -986,6 +986,32 @@ bool runtime_alter_maxscale(const char* name, const char* value)
             config_runtime_error("Invalid value for '%s': %s", CN_RETAIN_LAST_STATEMENTS, value);
         }
     }
+    else if (key == CN_CLIENT_PLACEMENT)
+    {
+        if (config_set_client_placement(value))
+        {
+            MXS_NOTICE("'%s' set to: %s", CN_CLIENT_PLACEMENT, value);
+            rval = true;
+        }
+        else
+        {
+            config_runtime_error("%s can have the values 'round_robin' or 'least_loaded'.",
+                                 CN_CLIENT_PLACEMENT);
+        }
+    }
+    else if (key == CN_REBALANCE_THRESHOLD)
+    {
+        if (config_set_rebalance_threshold(value))
+        {
+            MXS_NOTICE("'%s' set to: %s", CN_REBALANCE_THRESHOLD, value);
+            rval = true;
+        }
+        else
+        {
+            config_runtime_error("Invalid value for '%s', expected an integer between 0 and 100: %s",
+                                 CN_REBALANCE_THRESHOLD, value);
+        }
+    }
     else if (key == CN_DUMP_LAST_STATEMENTS)
     {
         rval = true;
@@ -1097,7 +1123,8 @@ bool runtime_create_listener(Service* service,
                                                             u_port,
                                                             auth,
                                                             auth_opt,
-                                                            ssl);
+                                                            ssl,
+                                                            false);
 
             if (listener && listener_serialize(listener))
             {
@@ -25,6 +25,7 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <netinet/tcp.h>
 #include <signal.h>
 #include <stdarg.h>
@@ -32,15 +33,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/epoll.h>
-#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 #include <time.h>
 
 #include <maxscale/alloc.h>
 #include <maxbase/atomic.h>
 #include <maxbase/atomic.hh>
+#include <maxbase/stopwatch.hh>
 #include <maxscale/clock.h>
 #include <maxscale/limits.h>
 #include <maxscale/listener.h>
@@ -71,6 +73,16 @@ constexpr uint32_t poll_events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLHUP | EP
 constexpr uint32_t poll_events = EPOLLIN | EPOLLOUT | EPOLLHUP | EPOLLET;
 #endif
 
+/** The size of the per-thread buffer that socket reads are done into. */
+constexpr int DCB_READ_BUFFER_SIZE = 16 * 1024;
+/** Reads at least this large hand over the read buffer instead of copying the data. */
+constexpr int DCB_READ_HANDOVER_SIZE = DCB_READ_BUFFER_SIZE / 2;
+
+/** The maximum number of buffers gathered into one writev() call. */
+constexpr int DCB_WRITEV_MAX_IOV = IOV_MAX;
+/** The maximum number of bytes gathered into one writev() call, the return value is an int. */
+constexpr size_t DCB_WRITEV_MAX_BYTES = INT_MAX;
+
 namespace
 {
 
@@ -83,8 +95,9 @@ static struct
 
 static thread_local struct
 {
-    long next_timeout_check;/** When to next check for idle sessions. */
-    DCB* current_dcb;       /** The DCB currently being handled by event handlers. */
+    long   next_timeout_check;/** When to next check for idle sessions. */
+    DCB*   current_dcb;       /** The DCB currently being handled by event handlers. */
+    GWBUF* read_buffer;       /** Preallocated buffer socket reads are done into. */
 } this_thread;
 }
 
@@ -97,15 +110,12 @@ static inline DCB* dcb_find_in_list(DCB* dcb);
 static void        dcb_stop_polling_and_shutdown(DCB* dcb);
 static bool        dcb_maybe_add_persistent(DCB*);
 static inline bool dcb_write_parameter_check(DCB* dcb, GWBUF* queue);
-static int         dcb_bytes_readable(DCB* dcb);
 static int         dcb_read_no_bytes_available(DCB* dcb, int nreadtotal);
 static int         dcb_create_SSL(DCB* dcb, SSL_LISTENER* ssl);
 static int         dcb_read_SSL(DCB* dcb, GWBUF** head);
-static GWBUF*      dcb_basic_read(DCB* dcb,
-                                  int bytesavailable,
-                                  int maxbytes,
-                                  int nreadtotal,
-                                  int* nsingleread);
+static int         dcb_read_socket(DCB* dcb, GWBUF** head, int maxbytes, int nreadtotal);
+static int         dcb_read_decoded(DCB* dcb, GWBUF** head, int maxbytes, int nreadtotal);
+static GWBUF*      dcb_basic_read(DCB* dcb, int maxbytes, int nreadtotal, int* nsingleread);
 static GWBUF* dcb_basic_read_SSL(DCB* dcb, int* nsingleread);
 static void   dcb_log_write_failure(DCB* dcb, GWBUF* queue, int eno);
 static int    gw_write(DCB* dcb, GWBUF* writeq, bool* stop_writing);
@@ -151,6 +161,12 @@ void dcb_finish()
     // TODO: Free all resources.
 }
 
+void dcb_thread_finish()
+{
+    gwbuf_free(this_thread.read_buffer);
+    this_thread.read_buffer = NULL;
+}
+
 uint64_t dcb_get_session_id(DCB* dcb)
 {
     return (dcb && dcb->session) ? dcb->session->ses_id : 0;
@@ -562,7 +578,6 @@ int dcb_read(DCB* dcb,
              GWBUF** head,
              int maxbytes)
 {
-    int nsingleread = 0;
     int nreadtotal = 0;
 
     if (dcb->readq)
@@ -578,6 +593,24 @@ int dcb_read(DCB* dcb,
         nreadtotal = gwbuf_length(*head);
     }
 
+    return dcb->codec ? dcb_read_decoded(dcb, head, maxbytes, nreadtotal) :
+           dcb_read_socket(dcb, head, maxbytes, nreadtotal);
+}
+
+/**
+ * Read data from the socket of a DCB, through SSL if it is in use
+ *
+ * @param dcb         The DCB to read from
+ * @param head        Pointer to linked list to append data to
+ * @param maxbytes    Maximum bytes to read (0 = no limit)
+ * @param nreadtotal  Number of bytes already in @c head
+ *
+ * @return -1 on error, otherwise the total number of bytes read
+ */
+static int dcb_read_socket(DCB* dcb, GWBUF** head, int maxbytes, int nreadtotal)
+{
+    int nsingleread = 0;
+
     if (SSL_HANDSHAKE_DONE == dcb->ssl_state || SSL_ESTABLISHED == dcb->ssl_state)
     {
         return dcb_read_SSL(dcb, head);
@@ -591,69 +624,102 @@ int dcb_read(DCB* dcb,
 
     while (0 == maxbytes || nreadtotal < maxbytes)
     {
-        int bytes_available;
+        GWBUF* buffer = dcb_basic_read(dcb, maxbytes, nreadtotal, &nsingleread);
 
-        bytes_available = dcb_bytes_readable(dcb);
-        if (bytes_available <= 0)
-        {
-            return bytes_available < 0 ? -1
-                                       :/** Handle closed client socket */
-                   dcb_read_no_bytes_available(dcb, nreadtotal);
-        }
-        else
+        if (buffer)
         {
-            GWBUF* buffer;
             dcb->last_read = mxs_clock();
+            nreadtotal += nsingleread;
+            MXS_DEBUG("Read %d bytes from dcb %p in state %s fd %d.",
+                      nsingleread,
+                      dcb,
+                      STRDCBSTATE(dcb->state),
+                      dcb->fd);
 
-            buffer = dcb_basic_read(dcb, bytes_available, maxbytes, nreadtotal, &nsingleread);
-            if (buffer)
-            {
-                nreadtotal += nsingleread;
-                MXS_DEBUG("Read %d bytes from dcb %p in state %s fd %d.",
-                          nsingleread,
-                          dcb,
-                          STRDCBSTATE(dcb->state),
-                          dcb->fd);
+            /*< Assign the target server for the gwbuf */
+            buffer->server = dcb->server;
+            /*< Append read data to the gwbuf */
+            *head = gwbuf_append(*head, buffer);
 
-                /*< Assign the target server for the gwbuf */
-                buffer->server = dcb->server;
-                /*< Append read data to the gwbuf */
-                *head = gwbuf_append(*head, buffer);
-            }
-            else
+            if (nsingleread < DCB_READ_BUFFER_SIZE)
             {
+                /**
+                 * A short read means that the socket was drained. The sockets are
+                 * edge-triggered, so any data arriving after this will generate
+                 * a new event and there is no need to read until EAGAIN.
+                 */
                 break;
             }
         }
+        else if (nsingleread == 0)
+        {
+            /** Handle closed client socket */
+            return dcb_read_no_bytes_available(dcb, nreadtotal);
+        }
+        else
+        {
+            break;
+        }
     }   /*< while (0 == maxbytes || nreadtotal < maxbytes) */
 
     return nreadtotal;
 }
 
 /**
- * Find the number of bytes available for the DCB's socket
+ * Read data from the socket of a DCB and decode it with the codec of the DCB
  *
- * @param dcb       The DCB to read from
- * @return          -1 on error, otherwise the total number of bytes available
+ * Only the complete units decoded by the codec are appended to @c head, the
+ * codec keeps the rest until more data has been read.
+ *
+ * @param dcb         The DCB to read from
+ * @param head        Pointer to linked list to append data to
+ * @param maxbytes    Maximum bytes to read from the socket (0 = no limit)
+ * @param nreadtotal  Number of bytes already in @c head
+ *
+ * @return -1 on error, otherwise the total number of bytes in @c head
  */
-static int dcb_bytes_readable(DCB* dcb)
+static int dcb_read_decoded(DCB* dcb, GWBUF** head, int maxbytes, int nreadtotal)
 {
-    int bytesavailable;
+    GWBUF* encoded = NULL;
+    int rc = dcb_read_socket(dcb, &encoded, maxbytes, nreadtotal);
 
-    if (-1 == ioctl(dcb->fd, FIONREAD, &bytesavailable))
+    if (encoded)
     {
-        MXS_ERROR("ioctl FIONREAD for dcb %p in state %s fd %d failed: %d, %s",
-                  dcb,
-                  STRDCBSTATE(dcb->state),
-                  dcb->fd,
-                  errno,
-                  mxs_strerror(errno));
-        return -1;
-    }
-    else
-    {
-        return bytesavailable;
+        size_t nencoded = gwbuf_length(encoded);
+        GWBUF* decoded = NULL;
+
+        mxb::StopWatch sw;
+        bool decoded_ok = dcb->codec->decode(dcb, encoded, &decoded);
+        dcb->stats.codec_time += std::chrono::duration_cast<std::chrono::microseconds>(sw.split()).count();
+        dcb->stats.n_encoded_in += nencoded;
+
+        if (!decoded_ok)
+        {
+            MXS_ERROR("Failed to decode the data read from dcb %p in state %s fd %d.",
+                      dcb,
+                      STRDCBSTATE(dcb->state),
+                      dcb->fd);
+            gwbuf_free(decoded);
+            rc = -1;
+        }
+        else if (rc >= 0)
+        {
+            for (GWBUF* buffer = decoded; buffer; buffer = buffer->next)
+            {
+                buffer->server = dcb->server;
+            }
+
+            nreadtotal += gwbuf_length(decoded);
+            dcb->stats.n_decoded_in += gwbuf_length(decoded);
+            *head = gwbuf_append(*head, decoded);
+        }
+        else
+        {
+            gwbuf_free(decoded);
+        }
     }
+
+    return rc < 0 ? rc : nreadtotal;
 }
 
 /**
@@ -690,42 +756,65 @@ static int dcb_read_no_bytes_available(DCB* dcb, int nreadtotal)
 /**
  * Basic read function to carry out a single read operation on the DCB socket.
  *
+ * The data is read into a buffer preallocated for the thread, without first
+ * checking how much data is available. A large read hands over the buffer
+ * itself, a small one is copied into a buffer of the exact size so that the
+ * preallocated buffer can be reused.
+ *
  * @param dcb               The DCB to read from
- * @param bytesavailable    Pointer to linked list to append data to
  * @param maxbytes          Maximum bytes to read (0 = no limit)
  * @param nreadtotal        Total number of bytes already read
- * @param nsingleread       To be set as the number of bytes read this time
+ * @param nsingleread       Set to the number of bytes read this time, 0 if no data
+ *                          was available or the peer closed the socket, and -1 on error
  * @return                  GWBUF* buffer containing new data, or null.
  */
-static GWBUF* dcb_basic_read(DCB* dcb, int bytesavailable, int maxbytes, int nreadtotal, int* nsingleread)
+static GWBUF* dcb_basic_read(DCB* dcb, int maxbytes, int nreadtotal, int* nsingleread)
 {
-    GWBUF* buffer;
-    int bufsize = maxbytes == 0 ? bytesavailable : MXS_MIN(bytesavailable, maxbytes - nreadtotal);
+    GWBUF* buffer = NULL;
+    int bufsize = maxbytes == 0 ? DCB_READ_BUFFER_SIZE : MXS_MIN(DCB_READ_BUFFER_SIZE, maxbytes - nreadtotal);
 
-    if ((buffer = gwbuf_alloc(bufsize)) == NULL)
+    if (!this_thread.read_buffer
+        && (this_thread.read_buffer = gwbuf_alloc(DCB_READ_BUFFER_SIZE)) == NULL)
     {
         *nsingleread = -1;
+        return NULL;
     }
-    else
-    {
-        *nsingleread = read(dcb->fd, GWBUF_DATA(buffer), bufsize);
-        dcb->stats.n_reads++;
 
-        if (*nsingleread <= 0)
+    GWBUF* read_buffer = this_thread.read_buffer;
+    errno = 0;
+    *nsingleread = read(dcb->fd, GWBUF_DATA(read_buffer), bufsize);
+    dcb->stats.n_reads++;
+
+    if (*nsingleread > 0)
+    {
+        if (*nsingleread >= DCB_READ_HANDOVER_SIZE)
         {
-            if (errno != 0 && errno != EAGAIN && errno != EWOULDBLOCK)
-            {
-                MXS_ERROR("Read failed, dcb %p in state %s fd %d: %d, %s",
-                          dcb,
-                          STRDCBSTATE(dcb->state),
-                          dcb->fd,
-                          errno,
-                          mxs_strerror(errno));
-            }
-            gwbuf_free(buffer);
-            buffer = NULL;
+            GWBUF_RTRIM(read_buffer, DCB_READ_BUFFER_SIZE - *nsingleread);
+            buffer = read_buffer;
+            this_thread.read_buffer = NULL;
+        }
+        else if ((buffer = gwbuf_alloc_and_load(*nsingleread, GWBUF_DATA(read_buffer))) == NULL)
+        {
+            *nsingleread = -1;
         }
     }
+    else if (*nsingleread < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            *nsingleread = 0;
+        }
+        else
+        {
+            MXS_ERROR("Read failed, dcb %p in state %s fd %d: %d, %s",
+                      dcb,
+                      STRDCBSTATE(dcb->state),
+                      dcb->fd,
+                      errno,
+                      mxs_strerror(errno));
+        }
+    }
+
     return buffer;
 }
 
@@ -900,6 +989,27 @@ static int dcb_log_errors_SSL(DCB* dcb, int ret)
  */
 int dcb_write(DCB* dcb, GWBUF* queue)
 {
+    if (dcb->codec && queue)
+    {
+        size_t nplain = gwbuf_length(queue);
+
+        mxb::StopWatch sw;
+        queue = dcb->codec->encode(dcb, queue);
+        dcb->stats.codec_time += std::chrono::duration_cast<std::chrono::microseconds>(sw.split()).count();
+
+        if (!queue)
+        {
+            MXS_ERROR("Failed to encode the data written to dcb %p in state %s fd %d.",
+                      dcb,
+                      STRDCBSTATE(dcb->state),
+                      dcb->fd);
+            return 0;
+        }
+
+        dcb->stats.n_decoded_out += nplain;
+        dcb->stats.n_encoded_out += gwbuf_length(queue);
+    }
+
     dcb->writeqlen += gwbuf_length(queue);
     // The following guarantees that queue is not NULL
     if (!dcb_write_parameter_check(dcb, queue))
@@ -1238,6 +1348,13 @@ void dcb_final_close(DCB* dcb)
 
     if (dcb->n_close != 0)
     {
+        if (dcb->dcb_role == DCB_ROLE_CLIENT_HANDLER
+            && (dcb->state == DCB_STATE_POLLING || dcb->state == DCB_STATE_NOPOLLING))
+        {
+            // The DCB was counted by poll_add_dcb() when it was added to its worker.
+            static_cast<RoutingWorker*>(dcb->poll.owner)->client_removed();
+        }
+
         if (dcb->state == DCB_STATE_POLLING)
         {
             dcb_stop_polling_and_shutdown(dcb);
@@ -1451,6 +1568,27 @@ void printAllDCBs()
     dcb_foreach(printAllDCBs_cb, NULL);
 }
 
+/**
+ * Print the statistics of the codec of a DCB, if it has one
+ *
+ * @param pdcb DCB to print results to
+ * @param dcb  DCB whose statistics are printed
+ */
+static void dcb_print_codec_stats(DCB* pdcb, DCB* dcb)
+{
+    if (dcb->codec)
+    {
+        const DCBSTATS& stats = dcb->stats;
+        dcb_printf(pdcb, "\t\tBytes In Encoded/Decoded:  %" PRIu64 "/%" PRIu64 " (%.2f)\n",
+                   stats.n_encoded_in, stats.n_decoded_in,
+                   stats.n_decoded_in ? (double)stats.n_encoded_in / stats.n_decoded_in : 1.0);
+        dcb_printf(pdcb, "\t\tBytes Out Encoded/Decoded: %" PRIu64 "/%" PRIu64 " (%.2f)\n",
+                   stats.n_encoded_out, stats.n_decoded_out,
+                   stats.n_decoded_out ? (double)stats.n_encoded_out / stats.n_decoded_out : 1.0);
+        dcb_printf(pdcb, "\t\tTime in Codec:             %" PRIu64 " us\n", stats.codec_time);
+    }
+}
+
 /**
  * Diagnostic to print one DCB in the system
  *
@@ -1530,6 +1668,7 @@ void dprintOneDCB(DCB* pdcb, DCB* dcb)
     dcb_printf(pdcb, "\t\tNo. of Accepts:           %d\n", dcb->stats.n_accepts);
     dcb_printf(pdcb, "\t\tNo. of High Water Events: %d\n", dcb->stats.n_high_water);
     dcb_printf(pdcb, "\t\tNo. of Low Water Events:  %d\n", dcb->stats.n_low_water);
+    dcb_print_codec_stats(pdcb, dcb);
 
     if (dcb->persistentstart)
     {
@@ -1708,6 +1847,7 @@ void dprintDCB(DCB* pdcb, DCB* dcb)
     dcb_printf(pdcb,
                "\t\tNo. of Low Water Events:  %d\n",
                dcb->stats.n_low_water);
+    dcb_print_codec_stats(pdcb, dcb);
 
     if (dcb->persistentstart)
     {
@@ -1847,6 +1987,10 @@ static int gw_write_SSL(DCB* dcb, GWBUF* writeq, bool* stop_writing)
 /**
  * Write data to a DCB. The data is taken from the DCB's write queue.
  *
+ * As many links of the buffer chain as fit into one iovec array are written
+ * with a single writev() call. The caller is expected to consume exactly the
+ * returned number of bytes from the chain, which may end in the middle of a link.
+ *
  * @param dcb           The DCB to write buffer
  * @param writeq        A buffer list containing the data to be written
  * @param stop_writing  Set to true if the caller should stop writing, false otherwise
@@ -1854,17 +1998,38 @@ static int gw_write_SSL(DCB* dcb, GWBUF* writeq, bool* stop_writing)
  */
 static int gw_write(DCB* dcb, GWBUF* writeq, bool* stop_writing)
 {
-    int written = 0;
+    ssize_t written = 0;
     int fd = dcb->fd;
-    size_t nbytes = GWBUF_LENGTH(writeq);
-    void* buf = GWBUF_DATA(writeq);
+    struct iovec iov[DCB_WRITEV_MAX_IOV];
+    int iovcnt = 0;
+    size_t nbytes = 0;
     int saved_errno;
 
+    for (GWBUF* buf = writeq; buf && iovcnt < DCB_WRITEV_MAX_IOV; buf = buf->next)
+    {
+        size_t len = GWBUF_LENGTH(buf);
+
+        if (len > 0)
+        {
+            /** A single call can't write more than this, the rest goes to the next round */
+            if (nbytes + len > DCB_WRITEV_MAX_BYTES && iovcnt > 0)
+            {
+                break;
+            }
+
+            iov[iovcnt].iov_base = GWBUF_DATA(buf);
+            iov[iovcnt].iov_len = len;
+            nbytes += len;
+            ++iovcnt;
+        }
+    }
+
     errno = 0;
 
     if (fd > 0)
     {
-        written = write(fd, buf, nbytes);
+        written = writev(fd, iov, iovcnt);
+        dcb->stats.n_writes++;
     }
 
     saved_errno = errno;
@@ -3650,6 +3815,17 @@ int poll_add_dcb(DCB* dcb)
         dcb->poll.owner = RoutingWorker::get_current();
         rc = -1;
     }
+    else if (dcb->dcb_role == DCB_ROLE_CLIENT_HANDLER && old_state == DCB_STATE_ALLOC)
+    {
+        owner->client_added();
+    }
+
+    if (dcb->flags & DCBF_PENDING)
+    {
+        // A new client DCB is added in the worker that was picked for it.
+        dcb->flags &= ~DCBF_PENDING;
+        RoutingWorker::get_current()->pending_client_done();
+    }
 
     return rc;
 }
@@ -3709,6 +3885,51 @@ int poll_remove_dcb(DCB* dcb)
     return rc;
 }
 
+bool dcb_detach_from_worker(DCB* dcb)
+{
+    RoutingWorker* owner = static_cast<RoutingWorker*>(dcb->poll.owner);
+    mxb_assert(owner == RoutingWorker::get_current());
+    mxb_assert(dcb->state == DCB_STATE_POLLING && dcb->dcb_role != DCB_ROLE_SERVICE_LISTENER);
+
+    bool rv = owner->remove_fd(dcb->fd);
+
+    if (rv)
+    {
+        dcb_remove_from_list(dcb);
+
+        if (dcb->dcb_role == DCB_ROLE_CLIENT_HANDLER)
+        {
+            owner->client_removed();
+        }
+    }
+
+    return rv;
+}
+
+bool dcb_attach_to_worker(DCB* dcb)
+{
+    RoutingWorker* worker = RoutingWorker::get_current();
+    mxb_assert(worker && dcb->state == DCB_STATE_POLLING);
+
+    dcb->poll.owner = worker;
+    dcb_add_to_list(dcb);
+
+    if (dcb->dcb_role == DCB_ROLE_CLIENT_HANDLER)
+    {
+        worker->client_added();
+    }
+
+    bool rv = worker->add_fd(dcb->fd, poll_events, (MXB_POLL_DATA*)dcb);
+
+    if (!rv)
+    {
+        // Not in the epoll instance, so it must not be removed from it when closed.
+        dcb->state = DCB_STATE_NOPOLLING;
+    }
+
+    return rv;
+}
+
 DCB* dcb_get_current()
 {
     return this_thread.current_dcb;
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/buffer.h>
+
+MXS_BEGIN_DECLS
+
+/**
+ * Enable the buffer pool of the calling thread
+ *
+ * After this, GWBUF structures and small shared buffers freed in the calling
+ * thread are kept in a thread specific pool and reused by later allocations
+ * made in the same thread.
+ *
+ * @param stats  Where the statistics of the pool are stored. Must remain valid
+ *               until @c gwbuf_pool_thread_finish has been called.
+ */
+void gwbuf_pool_thread_init(GWBUF_POOL_STATS* stats);
+
+/**
+ * Disable the buffer pool of the calling thread and free all pooled memory
+ */
+void gwbuf_pool_thread_finish();
+
+MXS_END_DECLS
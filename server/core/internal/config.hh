@@ -236,3 +236,21 @@ void dump_param_list(int file,
  * @return True if the parameter can be modified at runtime
  */
 bool config_can_modify_at_runtime(const char* name);
+
+/**
+ * Set how the routing worker of a new client connection is chosen
+ *
+ * @param value Either "round_robin" or "least_loaded"
+ *
+ * @return True if the value was valid and was taken into use
+ */
+bool config_set_client_placement(const char* value);
+
+/**
+ * Set the load difference at which sessions are moved between routing workers
+ *
+ * @param value The difference in percentage points, between 0 and 100
+ *
+ * @return True if the value was valid and was taken into use
+ */
+bool config_set_rebalance_threshold(const char* value);
@@ -19,4 +19,36 @@ MXS_BEGIN_DECLS
 void dcb_free_all_memory(DCB* dcb);
 void dcb_final_close(DCB* dcb);
 
+/**
+ * Free the thread specific resources of the DCB module
+ *
+ * Must be called in the thread whose resources are freed.
+ */
+void dcb_thread_finish();
+
+/**
+ * Detach a DCB from its routing worker
+ *
+ * The descriptor of the DCB is removed from the epoll instance of the worker
+ * and the DCB is removed from the DCBs of the worker. Must be called in the
+ * owning worker, for a DCB that is being polled.
+ *
+ * @param dcb  The DCB to detach
+ *
+ * @return True, if the DCB was detached
+ */
+bool dcb_detach_from_worker(DCB* dcb);
+
+/**
+ * Attach a DCB detached with dcb_detach_from_worker() to the calling worker
+ *
+ * The DCB is added to the DCBs of the worker even if adding the descriptor
+ * to the epoll instance fails, so that it will be closed normally.
+ *
+ * @param dcb  The DCB to attach
+ *
+ * @return True, if the descriptor could be added to the epoll instance
+ */
+bool dcb_attach_to_worker(DCB* dcb);
+
 MXS_END_DECLS
@@ -218,7 +218,8 @@ SERV_LISTENER* serviceCreateListener(Service* service,
                                      unsigned short port,
                                      const char* authenticator,
                                      const char* options,
-                                     SSL_LISTENER* ssl);
+                                     SSL_LISTENER* ssl,
+                                     bool compression);
 
 /**
  * @brief Remove a listener from use
@@ -141,6 +141,19 @@ public:
         return m_dcb_set;
     }
 
+    /**
+     * Check whether the session can be moved to another routing worker
+     *
+     * A session can be moved if its router allows it, it has no filters and
+     * it is idle: nothing is buffered in or queued for any of its DCBs, their
+     * protocols hold no partial packets or stored queries, no data has been
+     * read from them during the last clock tick and nothing else holds a
+     * reference to the session.
+     *
+     * @return True, if the session can be moved
+     */
+    bool can_be_moved() const;
+
 private:
     FilterList        m_filters;
     SessionVarsByName m_variables;
@@ -56,6 +56,7 @@ static RSA* tmp_rsa_callback(SSL* s, int is_export, int keylength);
  * @param authenticator Name of the authenticator to be used
  * @param options       Authenticator options
  * @param ssl           SSL configuration
+ * @param compression   Whether clients may use a compressed protocol
  * @return      New listener object or NULL if unable to allocate
  */
 SERV_LISTENER* listener_alloc(struct service* service,
@@ -65,7 +66,8 @@ SERV_LISTENER* listener_alloc(struct service* service,
                               unsigned short port,
                               const char* authenticator,
                               const char* auth_options,
-                              SSL_LISTENER* ssl)
+                              SSL_LISTENER* ssl,
+                              bool compression)
 {
     char* my_address = NULL;
     if (address)
@@ -139,6 +141,7 @@ SERV_LISTENER* listener_alloc(struct service* service,
     proto->authenticator = my_authenticator;
     proto->auth_options = my_auth_options;
     proto->ssl = ssl;
+    proto->compression = compression;
     proto->users = NULL;
     proto->next = NULL;
     proto->auth_instance = auth_instance;
@@ -505,6 +508,11 @@ static bool create_listener_config(const SERV_LISTENER* listener, const char* fi
         write_ssl_config(file, listener->ssl);
     }
 
+    if (listener->compression)
+    {
+        dprintf(file, "%s=true\n", CN_COMPRESSION);
+    }
+
     close(file);
 
     return true;
@@ -560,6 +568,7 @@ json_t* listener_to_json(const SERV_LISTENER* listener)
     json_object_set_new(param, "protocol", json_string(listener->protocol));
     json_object_set_new(param, "authenticator", json_string(listener->authenticator));
     json_object_set_new(param, "auth_options", json_string(listener->auth_options));
+    json_object_set_new(param, CN_COMPRESSION, json_boolean(listener->compression));
 
     if (listener->ssl)
     {
@@ -20,14 +20,20 @@
 
 #include <array>
 #include <iterator>
+#include <memory>
 #include <mutex>
 #include <functional>
 #include <cctype>
 
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include <maxscale/alloc.h>
 #include <maxscale/buffer.h>
 #include <maxscale/buffer.hh>
 #include <maxscale/modutil.h>
+#include <maxscale/modutil.hh>
 #include <maxscale/poll.h>
 #include <maxscale/protocol/mysql.h>
 #include <maxscale/utils.h>
@@ -638,6 +644,56 @@ GWBUF* modutil_get_complete_packets(GWBUF** p_readbuf)
     return complete;
 }
 
+namespace
+{
+
+/**
+ * Skip over the packets that can't affect the result of modutil_count_signal_packets.
+ *
+ * Only the header and the first payload byte of each packet are inspected and the
+ * packets are not copied. The scan stops at the first packet that can be an OK, ERR
+ * or EOF packet, that is a part of a large packet or whose first five bytes are not
+ * in the contiguous range. The last skipped packet can extend past @c end.
+ *
+ * @param it          Start of a packet
+ * @param end         End of the contiguous memory area
+ * @param num_packets Incremented by the number of skipped packets
+ *
+ * @return Start of the first packet that was not skipped
+ */
+inline const uint8_t* skip_row_packets(const uint8_t* it, const uint8_t* end, uint64_t* num_packets)
+{
+    uint64_t n = 0;
+
+    while (end - it >= MYSQL_HEADER_LEN + 1)
+    {
+        uint32_t payloadlen = gw_mysql_get_byte3(it);
+        uint8_t command = it[MYSQL_HEADER_LEN];
+
+        // A zero length payload has no command byte and a maximum length one is
+        // followed by a continuation packet, both are left for the caller.
+        if (payloadlen - 1 >= GW_MYSQL_MAX_PACKET_LEN - 1
+            || command == MYSQL_REPLY_OK
+            || command == MYSQL_REPLY_EOF
+            || command == MYSQL_REPLY_ERR)
+        {
+            break;
+        }
+
+        it += payloadlen + MYSQL_HEADER_LEN;
+        ++n;
+
+        // Rows are usually small and the walk is a chain of dependent loads, so
+        // start loading the data of the packets that follow this one.
+        __builtin_prefetch(it + 256);
+    }
+
+    *num_packets += n;
+    return it;
+}
+
+}
+
 int modutil_count_signal_packets(GWBUF* reply, int n_found, bool* more_out, modutil_state* state)
 {
     enum
@@ -657,10 +713,40 @@ int modutil_count_signal_packets(GWBUF* reply, int n_found, bool* more_out, modu
 
     while (offset < len)
     {
+        const uint8_t* data = GWBUF_DATA(reply) + offset;
+        const uint8_t* end = GWBUF_DATA(reply) + GWBUF_LENGTH(reply);
+
+        if ((internal_state & SKIP_NEXT) == 0)
+        {
+            const uint8_t* next = skip_row_packets(data, end, &num_packets);
+
+            if (next != data)
+            {
+                only_ok = false;
+                offset += next - data;
+
+                while (offset >= GWBUF_LENGTH(reply) && reply->next)
+                {
+                    len -= GWBUF_LENGTH(reply);
+                    offset -= GWBUF_LENGTH(reply);
+                    reply = reply->next;
+                }
+
+                continue;
+            }
+        }
+
         num_packets++;
         uint8_t header[MYSQL_HEADER_LEN + 5];   // Maximum size of an EOF packet
 
-        gwbuf_copy_data(reply, offset, MYSQL_HEADER_LEN + 1, header);
+        if (end - data >= (ptrdiff_t)sizeof(header))
+        {
+            memcpy(header, data, sizeof(header));
+        }
+        else
+        {
+            gwbuf_copy_data(reply, offset, sizeof(header), header);
+        }
 
         unsigned int payloadlen = MYSQL_GET_PAYLOAD_LEN(header);
         unsigned int pktlen = payloadlen + MYSQL_HEADER_LEN;
@@ -692,9 +778,9 @@ int modutil_count_signal_packets(GWBUF* reply, int n_found, bool* more_out, modu
                 eof++;
                 only_ok = false;
 
-                uint8_t status[2];      // Two byte server status
-                gwbuf_copy_data(reply, offset + MYSQL_HEADER_LEN + 1 + 2, sizeof(status), status);
-                more = gw_mysql_get_byte2(status) & SERVER_MORE_RESULTS_EXIST;
+                // Two byte server status, the EOF packet is always wholly in the header
+                uint16_t status = gw_mysql_get_byte2(header + MYSQL_HEADER_LEN + 1 + 2);
+                more = status & SERVER_MORE_RESULTS_EXIST;
 
                 /**
                  * MySQL 5.6 and 5.7 have a "feature" that doesn't set
@@ -704,7 +790,7 @@ int modutil_count_signal_packets(GWBUF* reply, int n_found, bool* more_out, modu
                  * the information from the first EOF packet until we process
                  * the second EOF packet.
                  */
-                if (gw_mysql_get_byte2(status) & SERVER_PS_OUT_PARAMS)
+                if (status & SERVER_PS_OUT_PARAMS)
                 {
                     internal_state |= PS_OUT_PARAM;
                 }
@@ -718,15 +804,19 @@ int modutil_count_signal_packets(GWBUF* reply, int n_found, bool* more_out, modu
                      && (eof + n_found) % 2 == 0)
             {
                 // An OK packet that is not in the middle of a resultset stream
-                uint8_t data[payloadlen - 1];
-                gwbuf_copy_data(reply, offset + MYSQL_HEADER_LEN + 1, sizeof(data), data);
+                uint8_t buf[payloadlen - 1];
+                const uint8_t* ptr = data + MYSQL_HEADER_LEN + 1;
+
+                if (end - data < (ptrdiff_t)pktlen)
+                {
+                    gwbuf_copy_data(reply, offset + MYSQL_HEADER_LEN + 1, sizeof(buf), buf);
+                    ptr = buf;
+                }
 
-                uint8_t* ptr = data;
                 ptr += mxs_leint_bytes(ptr);
                 ptr += mxs_leint_bytes(ptr);
 
-                uint16_t* status = (uint16_t*)ptr;
-                more = (*status) & SERVER_MORE_RESULTS_EXIST;
+                more = gw_mysql_get_byte2(ptr) & SERVER_MORE_RESULTS_EXIST;
             }
             else
             {
@@ -736,7 +826,7 @@ int modutil_count_signal_packets(GWBUF* reply, int n_found, bool* more_out, modu
 
         offset += pktlen;
 
-        if (offset >= GWBUF_LENGTH(reply) && reply->next)
+        while (offset >= GWBUF_LENGTH(reply) && reply->next)
         {
             len -= GWBUF_LENGTH(reply);
             offset -= GWBUF_LENGTH(reply);
@@ -1250,12 +1340,12 @@ mxs_pcre2_result_t modutil_mysql_wildcard_match(const char* pattern, const char*
     return rval;
 }
 
-static inline bool is_next(mxs::Buffer::iterator it, mxs::Buffer::iterator end, const std::string& str)
+static inline bool is_next(const uint8_t* it, const uint8_t* end, const char* str)
 {
     mxb_assert(it != end);
-    for (auto s_it = str.begin(); s_it != str.end(); ++s_it, ++it)
+    for (; *str; ++str, ++it)
     {
-        if (it == end || *it != *s_it)
+        if (it == end || *it != (uint8_t)*str)
         {
             return false;
         }
@@ -1307,12 +1397,11 @@ static const LUT is_special([](uint8_t c) {
                                     c) != std::string::npos;
                             });
 
-static std::pair<bool, mxs::Buffer::iterator> probe_number(mxs::Buffer::iterator it,
-                                                           mxs::Buffer::iterator end)
+static std::pair<bool, const uint8_t*> probe_number(const uint8_t* it, const uint8_t* end)
 {
     mxb_assert(it != end);
     mxb_assert(is_digit(*it));
-    std::pair<bool, mxs::Buffer::iterator> rval = std::make_pair(true, it);
+    std::pair<bool, const uint8_t*> rval = std::make_pair(true, it);
     bool is_hex = *it == '0';
     bool allow_hex = false;
 
@@ -1339,7 +1428,7 @@ static std::pair<bool, mxs::Buffer::iterator> probe_number(mxs::Buffer::iterator
             else if (*it == 'e')
             {
                 // Possible scientific notation number
-                auto next_it = std::next(it);
+                auto next_it = it + 1;
 
                 if (next_it == end || (!is_digit(*next_it) && *next_it != '-'))
                 {
@@ -1356,7 +1445,7 @@ static std::pair<bool, mxs::Buffer::iterator> probe_number(mxs::Buffer::iterator
             else if (*it == '.')
             {
                 // Possible decimal number
-                auto next_it = std::next(it);
+                auto next_it = it + 1;
 
                 if (next_it != end && !is_digit(*next_it))
                 {
@@ -1365,7 +1454,7 @@ static std::pair<bool, mxs::Buffer::iterator> probe_number(mxs::Buffer::iterator
                     rval.first = false;
                     break;
                 }
-                mxb_assert(is_digit(*next_it));
+                mxb_assert(next_it == end || is_digit(*next_it));
             }
             else
             {
@@ -1383,7 +1472,7 @@ static std::pair<bool, mxs::Buffer::iterator> probe_number(mxs::Buffer::iterator
     return rval;
 }
 
-static inline bool is_negation(const std::string& str, int i)
+static inline bool is_negation(const char* str, int i)
 {
     bool rval = false;
 
@@ -1406,7 +1495,7 @@ static inline bool is_negation(const std::string& str, int i)
     return rval;
 }
 
-mxs::Buffer::iterator find_char(mxs::Buffer::iterator it, const mxs::Buffer::iterator& end, char c)
+static const uint8_t* find_char(const uint8_t* it, const uint8_t* end, char c)
 {
     for (; it != end; ++it)
     {
@@ -1426,30 +1515,249 @@ mxs::Buffer::iterator find_char(mxs::Buffer::iterator it, const mxs::Buffer::ite
     return it;
 }
 
+/**
+ * Returns the number of ordinary characters, that is, characters for which
+ * is_special() is false, at the beginning of a range.
+ */
+static inline size_t ordinary_prefix(const uint8_t* it, const uint8_t* end)
+{
+    const uint8_t* start = it;
+
+#if defined (__SSE2__)
+    const __m128i digit_base = _mm_set1_epi8('0');
+    const __m128i digit_span = _mm_set1_epi8(9);
+    const __m128i ctrl_base = _mm_set1_epi8('\t');
+    const __m128i ctrl_span = _mm_set1_epi8('\r' - '\t');
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i dquote = _mm_set1_epi8('"');
+    const __m128i squote = _mm_set1_epi8('\'');
+    const __m128i bquote = _mm_set1_epi8('`');
+    const __m128i hash = _mm_set1_epi8('#');
+    const __m128i minus = _mm_set1_epi8('-');
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i bslash = _mm_set1_epi8('\\');
+
+    while (end - it >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+
+        // A byte b is in [base, base + span] if the unsigned (b - base) does not
+        // change when limited to span.
+        __m128i d = _mm_sub_epi8(v, digit_base);
+        __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(d, digit_span), d);
+        __m128i c = _mm_sub_epi8(v, ctrl_base);
+        __m128i is_ctrl_space = _mm_cmpeq_epi8(_mm_min_epu8(c, ctrl_span), c);
+
+        __m128i special = _mm_or_si128(is_digit, is_ctrl_space);
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(v, space));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(v, dquote));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(v, squote));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(v, bquote));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(v, hash));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(v, minus));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(v, slash));
+        special = _mm_or_si128(special, _mm_cmpeq_epi8(v, bslash));
+
+        int mask = _mm_movemask_epi8(special);
+
+        if (mask)
+        {
+            return (it - start) + __builtin_ctz(mask);
+        }
+
+        it += 16;
+    }
+#endif
+
+    while (it != end && !is_special(*it))
+    {
+        ++it;
+    }
+
+    return it - start;
+}
+
+/**
+ * Computes a 64-bit hash of data that is provided in pieces. The data is
+ * consumed eight bytes at a time, so the result does not depend upon how
+ * the data is split into pieces.
+ */
+class CanonicalHash
+{
+public:
+    void update(const char* pData, size_t len)
+    {
+        m_len += len;
+
+        if (m_nTail)
+        {
+            size_t n = std::min(len, sizeof(m_tail) - m_nTail);
+            memcpy(m_tail + m_nTail, pData, n);
+            m_nTail += n;
+            pData += n;
+            len -= n;
+
+            if (m_nTail < sizeof(m_tail))
+            {
+                return;
+            }
+
+            mix(m_tail);
+            m_nTail = 0;
+        }
+
+        while (len >= sizeof(m_tail))
+        {
+            mix(pData);
+            pData += sizeof(m_tail);
+            len -= sizeof(m_tail);
+        }
+
+        memcpy(m_tail, pData, len);
+        m_nTail = len;
+    }
+
+    uint64_t finish()
+    {
+        memset(m_tail + m_nTail, 0, sizeof(m_tail) - m_nTail);
+        mix(m_tail);
+
+        uint64_t h = m_h ^ m_len;
+
+        // The finalizer of MurmurHash3.
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+
+        return h;
+    }
+
+private:
+    void mix(const char* p)
+    {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+
+        m_h ^= w * 0x87c37b91114253d5ULL;
+        m_h = ((m_h << 27) | (m_h >> 37)) * 0x4cf5ad432745937fULL + 0x52dce729;
+    }
+
+    uint64_t m_h = 0;
+    uint64_t m_len = 0;
+    char     m_tail[8];
+    size_t   m_nTail = 0;
+};
+
+/**
+ * A buffer that is reused between calls, so that memory is allocated only
+ * if more is needed than ever before. If an exceptionally large amount has
+ * been needed, the memory is released once a normal amount again suffices.
+ */
+class ScratchBuffer
+{
+public:
+    char* get(size_t size)
+    {
+        if (size > m_size || (m_size > KEEP_SIZE && size <= KEEP_SIZE))
+        {
+            m_size = std::max(size, (size_t)KEEP_SIZE);
+            m_sData.reset(new char[m_size]);
+        }
+
+        return m_sData.get();
+    }
+
+private:
+    enum
+    {
+        KEEP_SIZE = 16 * 1024
+    };
+
+    std::unique_ptr<char[]> m_sData;
+    size_t                  m_size = 0;
+};
+
+static thread_local struct
+{
+    ScratchBuffer input;    // For statements that are not in contiguous memory.
+    ScratchBuffer output;   // For the canonical statement.
+} canonical_scratch;
+
 namespace maxscale
 {
 
-std::string get_canonical(GWBUF* querybuf)
+Canonical canonicalize(GWBUF* querybuf)
 {
-    std::string rval;
+    size_t len = gwbuf_length(querybuf);
+
+    if (len <= MYSQL_HEADER_LEN + 1)
+    {
+        return Canonical {"", 0, CanonicalHash().finish()};
+    }
+
+    const uint8_t* data;
+
+    if (querybuf->next == NULL)
+    {
+        data = GWBUF_DATA(querybuf);
+    }
+    else
+    {
+        uint8_t* copy = reinterpret_cast<uint8_t*>(canonical_scratch.input.get(len));
+        gwbuf_copy_data(querybuf, 0, len, copy);
+        data = copy;
+    }
+
+    // Skip packet header and command
+    return canonicalize(reinterpret_cast<const char*>(data) + MYSQL_HEADER_LEN + 1,
+                        len - MYSQL_HEADER_LEN - 1);
+}
+
+Canonical canonicalize(const char* pSql, size_t len)
+{
+    if (len == 0)
+    {
+        return Canonical {"", 0, CanonicalHash().finish()};
+    }
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(pSql);
+
+    // The canonical statement is never longer than the statement.
+    char* rval = canonical_scratch.output.get(len);
     int i = 0;
-    rval.resize(gwbuf_length(querybuf) - MYSQL_HEADER_LEN + 1);
-    mxs::Buffer buf(querybuf);
+    int hashed = 0;
+    CanonicalHash hash;
+
+    const uint8_t* end = data + len;
 
-    for (auto it = std::next(buf.begin(), MYSQL_HEADER_LEN + 1);    // Skip packet header and command
-         it != buf.end(); ++it)
+    for (auto it = data; it != end; ++it)
     {
+        // The last character written may still be removed, so it is hashed
+        // only when something has been written after it. The hash is updated
+        // in whole words, which keeps the cost per iteration low.
+        if (i - hashed > 8)
+        {
+            int n = (i - 1 - hashed) & ~7;
+            hash.update(rval + hashed, n);
+            hashed += n;
+        }
+
         if (!is_special(*it))
         {
-            // Normal character, no special handling required
-            rval[i++] = *it;
+            // Normal characters, no special handling required
+            size_t n = ordinary_prefix(it, end);
+            memcpy(rval + i, it, n);
+            i += n;
+            it += n - 1;
         }
         else if (*it == '\\')
         {
             // Jump over any escaped values
-            rval[i++] += *it++;
+            rval[i++] = *it++;
 
-            if (it != buf.end())
+            if (it != end)
             {
                 rval[i++] = *it;
             }
@@ -1463,19 +1771,19 @@ std::string get_canonical(GWBUF* querybuf)
         {
             // Repeating space, skip it
         }
-        else if (*it == '/' && is_next(it, buf.end(), "/*"))
+        else if (*it == '/' && is_next(it, end, "/*"))
         {
-            auto comment_start = std::next(it, 2);
-            if (comment_start == buf.end())
+            auto comment_start = it + 2;
+            if (comment_start == end)
             {
                 break;
             }
             else if (*comment_start != '!' && *comment_start != 'M')
             {
                 // Non-executable comment
-                while (it != buf.end())
+                while (it != end)
                 {
-                    if (is_next(it, buf.end(), "*/"))
+                    if (is_next(it, end, "*/"))
                     {
                         // Comment end marker, return to normal parsing
                         ++it;
@@ -1484,7 +1792,7 @@ std::string get_canonical(GWBUF* querybuf)
                     ++it;
                 }
 
-                if (it == buf.end())
+                if (it == end)
                 {
                     break;
                 }
@@ -1496,10 +1804,10 @@ std::string get_canonical(GWBUF* querybuf)
             }
         }
         else if ((*it == '#' || *it == '-')
-                 && (is_next(it, buf.end(), "# ") || is_next(it, buf.end(), "-- ")))
+                 && (is_next(it, end, "# ") || is_next(it, end, "-- ")))
         {
             // End-of-line comment, jump to the next line if one exists
-            while (it != buf.end())
+            while (it != end)
             {
                 if (*it == '\n')
                 {
@@ -1507,7 +1815,7 @@ std::string get_canonical(GWBUF* querybuf)
                 }
                 else if (*it == '\r')
                 {
-                    if ((is_next(it, buf.end(), "\r\n")))
+                    if ((is_next(it, end, "\r\n")))
                     {
                         ++it;
                     }
@@ -1517,14 +1825,14 @@ std::string get_canonical(GWBUF* querybuf)
                 ++it;
             }
 
-            if (it == buf.end())
+            if (it == end)
             {
                 break;
             }
         }
         else if (is_digit(*it) && (i == 0 || (!is_alnum(rval[i - 1]) && rval[i - 1] != '_')))
         {
-            auto num_end = probe_number(it, buf.end());
+            auto num_end = probe_number(it, end);
 
             if (num_end.first)
             {
@@ -1540,7 +1848,7 @@ std::string get_canonical(GWBUF* querybuf)
         else if (*it == '\'' || *it == '"')
         {
             char c = *it;
-            if ((it = find_char(std::next(it), buf.end(), c)) == buf.end())
+            if ((it = find_char(it + 1, end, c)) == end)
             {
                 break;
             }
@@ -1549,11 +1857,11 @@ std::string get_canonical(GWBUF* querybuf)
         else if (*it == '`')
         {
             auto start = it;
-            if ((it = find_char(std::next(it), buf.end(), '`')) == buf.end())
+            if ((it = find_char(it + 1, end, '`')) == end)
             {
                 break;
             }
-            std::copy(start, it, &rval[i]);
+            std::copy(start, it, rval + i);
             i += std::distance(start, it);
             rval[i++] = '`';
         }
@@ -1562,15 +1870,17 @@ std::string get_canonical(GWBUF* querybuf)
             rval[i++] = *it;
         }
 
-        mxb_assert(it != buf.end());
+        mxb_assert(it != end);
     }
 
-    // Shrink the buffer so that the internal bookkeeping of std::string remains up to date
-    rval.resize(i);
+    hash.update(rval + hashed, i - hashed);
 
-    buf.release();
+    return Canonical {rval, (size_t)i, hash.finish()};
+}
 
-    return rval;
+std::string get_canonical(GWBUF* querybuf)
+{
+    return canonicalize(querybuf).str();
 }
 }
 
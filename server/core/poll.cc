@@ -100,7 +100,7 @@ void dprintPollStats(DCB* dcb)
 {
     int i;
 
-    Worker::STATISTICS s = RoutingWorker::get_statistics();
+    RoutingWorker::STATISTICS s = RoutingWorker::get_statistics();
 
     dcb_printf(dcb, "\nPoll Statistics.\n\n");
     dcb_printf(dcb, "No. of epoll cycles:                           %" PRId64 "\n", s.n_polls);
@@ -112,6 +112,8 @@ void dprintPollStats(DCB* dcb)
     dcb_printf(dcb, "No. of accept events:                          %" PRId64 "\n", s.n_accept);
     dcb_printf(dcb, "Average event queue length:                    %" PRId64 "\n", s.evq_avg);
     dcb_printf(dcb, "Maximum event queue length:                    %" PRId64 "\n", s.evq_max);
+    dcb_printf(dcb, "No. of buffer pool hits:                       %" PRId64 "\n", s.n_buffer_pool_hits);
+    dcb_printf(dcb, "No. of buffer pool misses:                     %" PRId64 "\n", s.n_buffer_pool_misses);
 
     dcb_printf(dcb, "No of poll completions with descriptors\n");
     dcb_printf(dcb, "\tNo. of descriptors\tNo. of poll completions.\n");
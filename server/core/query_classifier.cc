@@ -15,7 +15,8 @@
 #include <inttypes.h>
 #include <algorithm>
 #include <atomic>
-#include <random>
+#include <list>
+#include <mutex>
 #include <unordered_map>
 #include <maxscale/alloc.h>
 #include <maxbase/atomic.h>
@@ -54,6 +55,9 @@ struct type_name_info
 const char DEFAULT_QC_NAME[] = "qc_sqlite";
 const char QC_TRX_PARSE_USING[] = "QC_TRX_PARSE_USING";
 
+class QCInfoCache;
+class QCSharedInfoCache;
+
 class ThisUnit
 {
 public:
@@ -61,6 +65,9 @@ public:
         : classifier(nullptr)
         , qc_trx_parse_using(QC_TRX_PARSE_USING_PARSER)
         , qc_sql_mode(QC_SQL_MODE_DEFAULT)
+        , cache_mode(QC_CACHE_MODE_THREAD)
+        , cache_eviction(QC_CACHE_EVICTION_LRU)
+        , pShared_cache(nullptr)
         , m_cache_max_size(std::numeric_limits<int64_t>::max())
     {
     }
@@ -71,6 +78,9 @@ public:
     QUERY_CLASSIFIER*    classifier;
     qc_trx_parse_using_t qc_trx_parse_using;
     qc_sql_mode_t        qc_sql_mode;
+    qc_cache_mode_t      cache_mode;
+    qc_cache_eviction_t  cache_eviction;
+    QCSharedInfoCache*   pShared_cache;
 
     int64_t cache_max_size() const
     {
@@ -91,22 +101,57 @@ private:
 
 static ThisUnit this_unit;
 
-class QCInfoCache;
-
 static thread_local struct
 {
-    QCInfoCache* pInfo_cache;
+    QCInfoCache*   pInfo_cache;
+    QC_CACHE_STATS shared_stats;    // How this thread has used the shared cache.
 } this_thread =
 {
-    nullptr
+    nullptr,
+    {}
 };
 
 
+/**
+ * The key of the query classification cache; a canonical statement and its
+ * hash. The hash is computed when the statement is canonicalized, so the
+ * statement need not be hashed again by the cache.
+ */
+struct QCCacheKey
+{
+    std::string canonical_stmt;
+    uint64_t    hash;
+
+    bool operator==(const QCCacheKey& rhs) const
+    {
+        return hash == rhs.hash && canonical_stmt == rhs.canonical_stmt;
+    }
+
+    struct Hasher
+    {
+        size_t operator()(const QCCacheKey& key) const
+        {
+            return key.hash;
+        }
+    };
+};
+
 /**
  * @class QCInfoCache
  *
  * An instance of this class maintains a mapping from a canonical statement to
  * the QC_STMT_INFO object created by the actual query classifier.
+ *
+ * The size of an entry is the memory used by the canonical statement, the
+ * classification result and the bookkeeping of the cache. When the cache is
+ * full, entries are evicted according to the eviction policy of the cache:
+ *
+ * - LRU: The entries are kept in order of use and the least recently used
+ *   entry is evicted.
+ * - CLOCK: The entries are kept in order of insertion and a hit only marks
+ *   the entry as referenced. The clock hand sweeps over the entries, clearing
+ *   the mark of referenced entries and evicting the first unreferenced one.
+ *   An approximation of LRU that leaves the order untouched on a hit.
  */
 class QCInfoCache
 {
@@ -114,8 +159,9 @@ public:
     QCInfoCache(const QCInfoCache&) = delete;
     QCInfoCache& operator=(const QCInfoCache&) = delete;
 
-    QCInfoCache()
-        : m_reng(m_rdev())
+    QCInfoCache(qc_cache_eviction_t eviction)
+        : m_eviction(eviction)
+        , m_hand(m_order.end())
     {
         memset(&m_stats, 0, sizeof(m_stats));
     }
@@ -130,22 +176,22 @@ public:
         }
     }
 
-    QC_STMT_INFO* peek(const std::string& canonical_stmt) const
+    QC_STMT_INFO* peek(const QCCacheKey& key) const
     {
-        auto i = m_infos.find(canonical_stmt);
+        auto i = m_infos.find(key);
 
         return i != m_infos.end() ? i->second.pInfo : nullptr;
     }
 
-    QC_STMT_INFO* get(const std::string& canonical_stmt)
+    QC_STMT_INFO* get(const QCCacheKey& key)
     {
         QC_STMT_INFO* pInfo = nullptr;
 
-        auto i = m_infos.find(canonical_stmt);
+        auto i = m_infos.find(key);
 
         if (i != m_infos.end())
         {
-            const Entry& entry = i->second;
+            Entry& entry = i->second;
 
             if (entry.sql_mode == this_unit.qc_sql_mode)
             {
@@ -153,6 +199,8 @@ public:
                 this_unit.classifier->qc_info_dup(entry.pInfo);
                 pInfo = entry.pInfo;
 
+                touch(entry);
+
                 ++m_stats.hits;
             }
             else
@@ -171,13 +219,17 @@ public:
         return pInfo;
     }
 
-    void insert(const std::string& canonical_stmt, QC_STMT_INFO* pInfo)
+    void insert(const QCCacheKey& key, QC_STMT_INFO* pInfo)
     {
-        mxb_assert(peek(canonical_stmt) == nullptr);
+        insert(key, pInfo, this_unit.cache_max_size() / config_get_global_options()->n_threads);
+    }
+
+    void insert(const QCCacheKey& key, QC_STMT_INFO* pInfo, int64_t cache_max_size)
+    {
+        mxb_assert(peek(key) == nullptr);
         mxb_assert(this_unit.classifier);
 
-        int64_t cache_max_size = this_unit.cache_max_size() / config_get_global_options()->n_threads;
-        int64_t size = canonical_stmt.size();
+        int64_t size = entry_size(key, pInfo);
 
         if (size <= cache_max_size)
         {
@@ -192,7 +244,23 @@ public:
             {
                 this_unit.classifier->qc_info_dup(pInfo);
 
-                m_infos.emplace(canonical_stmt, Entry(pInfo, this_unit.qc_sql_mode));
+                auto i = m_infos.emplace(key, Entry(pInfo, this_unit.qc_sql_mode, size)).first;
+                Entry& entry = i->second;
+
+                // Pointers to the elements of an unordered_map remain valid even if
+                // the map is rehashed, so they can be stored in the order list.
+                Slot slot { &i->first, &entry };
+
+                if (m_eviction == QC_CACHE_EVICTION_LRU)
+                {
+                    // Most recently used first.
+                    entry.pos = m_order.insert(m_order.begin(), slot);
+                }
+                else
+                {
+                    // Just behind the hand, so that it is the last one to be considered.
+                    entry.pos = m_order.insert(m_hand, slot);
+                }
 
                 ++m_stats.inserts;
                 m_stats.size += size;
@@ -206,88 +274,255 @@ public:
     }
 
 private:
+    struct Entry;
+
+    struct Slot
+    {
+        const QCCacheKey* pKey;
+        Entry*            pEntry;
+    };
+
+    typedef std::list<Slot> Order;
+
     struct Entry
     {
-        Entry(QC_STMT_INFO* pInfo, qc_sql_mode_t sql_mode)
+        Entry(QC_STMT_INFO* pInfo, qc_sql_mode_t sql_mode, int64_t size)
             : pInfo(pInfo)
             , sql_mode(sql_mode)
+            , size(size)
+            , referenced(false)
         {
         }
 
-        QC_STMT_INFO* pInfo;
-        qc_sql_mode_t sql_mode;
+        QC_STMT_INFO*   pInfo;
+        qc_sql_mode_t   sql_mode;
+        int64_t         size;       // The memory used by the entry.
+        bool            referenced; // CLOCK: Used since the hand last passed.
+        Order::iterator pos;        // The position of the entry in the order list.
     };
 
-    typedef std::unordered_map<std::string, Entry> InfosByStmt;
+    typedef std::unordered_map<QCCacheKey, Entry, QCCacheKey::Hasher> InfosByStmt;
 
-    void erase(InfosByStmt::iterator& i)
+    enum
+    {
+        // An approximation of what the map and the order list use per entry.
+        ENTRY_OVERHEAD = sizeof(InfosByStmt::value_type) + 2 * sizeof(void*) // The map node.
+            + sizeof(Slot) + 2 * sizeof(void*)                               // The list node.
+    };
+
+    static int64_t entry_size(const QCCacheKey& key, QC_STMT_INFO* pInfo)
+    {
+        // Note that the size of the classification result is that at the time
+        // it is inserted. If the statement is later parsed again in order to
+        // collect more information, the growth is not accounted for.
+        int64_t size = ENTRY_OVERHEAD + key.canonical_stmt.size();
+
+        if (this_unit.classifier->qc_info_size)
+        {
+            size += this_unit.classifier->qc_info_size(pInfo);
+        }
+
+        return size;
+    }
+
+    void touch(Entry& entry)
+    {
+        if (m_eviction == QC_CACHE_EVICTION_LRU)
+        {
+            m_order.splice(m_order.begin(), m_order, entry.pos);
+        }
+        else
+        {
+            entry.referenced = true;
+        }
+    }
+
+    void erase(InfosByStmt::iterator i)
     {
         mxb_assert(i != m_infos.end());
 
-        m_stats.size -= i->first.size();
+        Entry& entry = i->second;
+
+        if (m_hand == entry.pos)
+        {
+            ++m_hand;
+        }
+
+        m_order.erase(entry.pos);
+
+        m_stats.size -= entry.size;
 
         mxb_assert(this_unit.classifier);
-        this_unit.classifier->qc_info_close(i->second.pInfo);
+        this_unit.classifier->qc_info_close(entry.pInfo);
 
         m_infos.erase(i);
 
         ++m_stats.evictions;
     }
 
-    bool erase(const std::string& canonical_stmt)
+    Order::iterator select_victim()
     {
-        bool erased = false;
+        mxb_assert(!m_order.empty());
 
-        auto i = m_infos.find(canonical_stmt);
-        mxb_assert(i != m_infos.end());
+        Order::iterator victim;
 
-        if (i != m_infos.end())
+        if (m_eviction == QC_CACHE_EVICTION_LRU)
         {
-            erase(i);
-            erased = true;
+            victim = --m_order.end();
+        }
+        else
+        {
+            // Terminates at the latest after one full sweep, as the
+            // references are cleared on the way.
+            while (true)
+            {
+                if (m_hand == m_order.end())
+                {
+                    m_hand = m_order.begin();
+                }
+
+                Entry* pEntry = m_hand->pEntry;
+
+                if (pEntry->referenced)
+                {
+                    pEntry->referenced = false;
+                    ++m_hand;
+                }
+                else
+                {
+                    victim = m_hand;
+                    break;
+                }
+            }
         }
 
-        return erased;
+        return victim;
     }
 
     void make_space(int64_t required_space)
     {
         int64_t freed_space = 0;
 
-        std::uniform_int_distribution<> dis(0, m_infos.bucket_count() - 1);
-
         while ((freed_space < required_space) && !m_infos.empty())
         {
-            freed_space += evict(dis);
+            Order::iterator victim = select_victim();
+
+            freed_space += victim->pEntry->size;
+
+            auto i = m_infos.find(*victim->pKey);
+            mxb_assert(i != m_infos.end());
+
+            erase(i);
+        }
+    }
+
+    InfosByStmt         m_infos;
+    Order               m_order;    // LRU: Most recently used first, CLOCK: Order of insertion.
+    qc_cache_eviction_t m_eviction;
+    Order::iterator     m_hand;     // CLOCK: The next entry to consider for eviction.
+    QC_CACHE_STATS      m_stats;
+};
+
+/**
+ * @class QCSharedInfoCache
+ *
+ * A query classification cache shared by all threads. The statements are
+ * distributed over a number of shards, each of which is a QCInfoCache
+ * protected by a lock of its own, so concurrent lookups seldom contend.
+ * The total size limit of the cache is divided evenly between the shards.
+ */
+class QCSharedInfoCache
+{
+public:
+    QCSharedInfoCache(const QCSharedInfoCache&) = delete;
+    QCSharedInfoCache& operator=(const QCSharedInfoCache&) = delete;
+
+    QCSharedInfoCache()
+    {
+    }
+
+    QC_STMT_INFO* get(const QCCacheKey& key)
+    {
+        Shard& shard = shard_of(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
+
+        QC_STMT_INFO* pInfo = shard.cache.get(key);
+
+        if (pInfo)
+        {
+            ++this_thread.shared_stats.hits;
         }
+        else
+        {
+            ++this_thread.shared_stats.misses;
+        }
+
+        return pInfo;
     }
 
-    int64_t evict(std::uniform_int_distribution<>& dis)
+    void insert(const QCCacheKey& key, QC_STMT_INFO* pInfo)
     {
-        int64_t freed_space = 0;
+        Shard& shard = shard_of(key);
+        std::lock_guard<std::mutex> guard(shard.lock);
 
-        int bucket = dis(m_reng);
-        mxb_assert((bucket >= 0) && (bucket < static_cast<int>(m_infos.bucket_count())));
+        // Another thread may have classified and inserted the same statement
+        // after this thread looked for it.
+        if (!shard.cache.peek(key))
+        {
+            QC_CACHE_STATS before;
+            shard.cache.get_stats(&before);
+
+            shard.cache.insert(key, pInfo, this_unit.cache_max_size() / N_SHARDS);
+
+            QC_CACHE_STATS after;
+            shard.cache.get_stats(&after);
 
-        auto i = m_infos.begin(bucket);
+            this_thread.shared_stats.inserts += after.inserts - before.inserts;
+            this_thread.shared_stats.evictions += after.evictions - before.evictions;
+        }
+    }
 
-        // We just remove the first entry in the bucket. In the general case
-        // there will be just one.
-        if (i != m_infos.end(bucket))
+    int64_t size()
+    {
+        int64_t size = 0;
+
+        for (auto& shard : m_shards)
         {
-            freed_space += i->first.size();
+            std::lock_guard<std::mutex> guard(shard.lock);
 
-            MXB_AT_DEBUG(bool erased = ) erase(i->first);
-            mxb_assert(erased);
+            QC_CACHE_STATS stats;
+            shard.cache.get_stats(&stats);
+            size += stats.size;
         }
 
-        return freed_space;
+        return size;
     }
 
-    InfosByStmt        m_infos;
-    QC_CACHE_STATS     m_stats;
-    std::random_device m_rdev;
-    std::mt19937       m_reng;
+private:
+    enum
+    {
+        N_SHARDS = 64
+    };
+
+    struct Shard
+    {
+        Shard()
+            : cache(this_unit.cache_eviction)
+        {
+        }
+
+        std::mutex  lock;
+        QCInfoCache cache;
+    };
+
+    Shard& shard_of(const QCCacheKey& key)
+    {
+        // The low bits select the bucket within the shard, so the shard is
+        // selected using the high bits.
+        return m_shards[(key.hash >> 32) % N_SHARDS];
+    }
+
+    Shard m_shards[N_SHARDS];
 };
 
 bool use_cached_result()
@@ -331,40 +566,81 @@ public:
     {
         if (use_cached_result() && has_not_been_parsed(m_pStmt))
         {
-            m_canonical = mxs::get_canonical(m_pStmt);
+            mxs::Canonical canonical = mxs::canonicalize(m_pStmt);
+
+            m_key.canonical_stmt.assign(canonical.pStmt, canonical.len);
+            m_key.hash = canonical.hash;
 
             if (modutil_is_SQL_prepare(pStmt))
             {
                 // P as in prepare, and appended so as not to cause a
                 // need for copying the data.
-                m_canonical += ":P";
+                m_key.canonical_stmt += ":P";
+                m_key.hash = ~m_key.hash;
             }
 
-            QC_STMT_INFO* pInfo = this_thread.pInfo_cache->get(m_canonical);
+            if (this_unit.pShared_cache)
+            {
+                if (modutil_is_SQL_prepare(pStmt))
+                {
+                    // The preparable statement of the classification result is a
+                    // GWBUF that must not be accessed from several threads.
+                    m_key.canonical_stmt.clear();
+                }
+                else
+                {
+                    QC_STMT_INFO* pInfo = this_unit.pShared_cache->get(m_key);
 
-            if (pInfo)
+                    if (pInfo)
+                    {
+                        gwbuf_add_buffer_object(m_pStmt, GWBUF_PARSING_INFO, pInfo, info_object_close);
+                        m_key.canonical_stmt.clear();
+                    }
+                    else
+                    {
+                        // A result in the shared cache must never be modified, so the
+                        // statement is parsed completely before it is cached. Otherwise
+                        // the classifier could later parse it again to collect more.
+                        int32_t result;
+                        this_unit.classifier->qc_parse(m_pStmt, QC_COLLECT_ALL, &result);
+                    }
+                }
+            }
+            else
             {
-                gwbuf_add_buffer_object(m_pStmt, GWBUF_PARSING_INFO, pInfo, info_object_close);
-                m_canonical.clear();    // Signals that nothing needs to be added in the destructor.
+                QC_STMT_INFO* pInfo = this_thread.pInfo_cache->get(m_key);
+
+                if (pInfo)
+                {
+                    gwbuf_add_buffer_object(m_pStmt, GWBUF_PARSING_INFO, pInfo, info_object_close);
+                    m_key.canonical_stmt.clear();    // Signals that nothing needs to be added in the destructor.
+                }
             }
         }
     }
 
     ~QCInfoCacheScope()
     {
-        if (!m_canonical.empty())
+        if (!m_key.canonical_stmt.empty())
         {
             void* pData = gwbuf_get_buffer_object_data(m_pStmt, GWBUF_PARSING_INFO);
             mxb_assert(pData);
             QC_STMT_INFO* pInfo = static_cast<QC_STMT_INFO*>(pData);
 
-            this_thread.pInfo_cache->insert(m_canonical, pInfo);
+            if (this_unit.pShared_cache)
+            {
+                this_unit.pShared_cache->insert(m_key, pInfo);
+            }
+            else
+            {
+                this_thread.pInfo_cache->insert(m_key, pInfo);
+            }
         }
     }
 
 private:
     GWBUF*      m_pStmt;
-    std::string m_canonical;
+    QCCacheKey  m_key;
 };
 }
 
@@ -397,7 +673,16 @@ bool qc_setup(const QC_CACHE_PROPERTIES* cache_properties,
             int64_t cache_max_size = (cache_properties ? cache_properties->max_size : 0);
             mxb_assert(cache_max_size >= 0);
 
-            if (cache_max_size)
+            this_unit.cache_mode = (cache_properties ? cache_properties->mode : QC_CACHE_MODE_THREAD);
+            this_unit.cache_eviction = (cache_properties ? cache_properties->eviction : QC_CACHE_EVICTION_LRU);
+
+            if (cache_max_size && this_unit.cache_mode == QC_CACHE_MODE_SHARED)
+            {
+                MXS_NOTICE("Query classification results are cached and reused. "
+                           "Memory used by the cache shared by all threads: %s",
+                           mxb::to_binary_size(cache_max_size).c_str());
+            }
+            else if (cache_max_size)
             {
                 int64_t size_per_thr = cache_max_size / config_get_global_options()->n_threads;
                 MXS_NOTICE("Query classification results are cached and reused. "
@@ -481,9 +766,22 @@ bool qc_process_init(uint32_t kind)
 
     bool rc = true;
 
-    if (kind & QC_INIT_PLUGIN)
+    if ((kind & QC_INIT_SELF) && (this_unit.cache_mode == QC_CACHE_MODE_SHARED))
+    {
+        mxb_assert(!this_unit.pShared_cache);
+        this_unit.pShared_cache = new(std::nothrow) QCSharedInfoCache;
+        rc = this_unit.pShared_cache != nullptr;
+    }
+
+    if (rc && (kind & QC_INIT_PLUGIN))
     {
         rc = this_unit.classifier->qc_process_init() == 0;
+
+        if (!rc && (kind & QC_INIT_SELF))
+        {
+            delete this_unit.pShared_cache;
+            this_unit.pShared_cache = nullptr;
+        }
     }
 
     return rc;
@@ -494,6 +792,14 @@ void qc_process_end(uint32_t kind)
     QC_TRACE();
     mxb_assert(this_unit.classifier);
 
+    if (kind & QC_INIT_SELF)
+    {
+        // Must be deleted before the classifier is finalized, as the
+        // cached results are closed using the classifier.
+        delete this_unit.pShared_cache;
+        this_unit.pShared_cache = nullptr;
+    }
+
     if (kind & QC_INIT_PLUGIN)
     {
         this_unit.classifier->qc_process_end();
@@ -533,7 +839,7 @@ bool qc_thread_init(uint32_t kind)
     if (kind & QC_INIT_SELF)
     {
         mxb_assert(!this_thread.pInfo_cache);
-        this_thread.pInfo_cache = new(std::nothrow) QCInfoCache;
+        this_thread.pInfo_cache = new(std::nothrow) QCInfoCache(this_unit.cache_eviction);
         rc = true;
     }
     else
@@ -859,6 +1165,22 @@ const char* qc_op_to_string(qc_query_op_t op)
     }
 }
 
+const char* qc_cache_eviction_to_string(qc_cache_eviction_t eviction)
+{
+    switch (eviction)
+    {
+    case QC_CACHE_EVICTION_LRU:
+        return "lru";
+
+    case QC_CACHE_EVICTION_CLOCK:
+        return "clock";
+
+    default:
+        mxb_assert(!true);
+        return "unknown";
+    }
+}
+
 struct type_name_info type_to_type_name_info(qc_query_type_t type)
 {
     struct type_name_info info;
@@ -1280,6 +1602,8 @@ void qc_set_sql_mode(qc_sql_mode_t sql_mode)
 void qc_get_cache_properties(QC_CACHE_PROPERTIES* properties)
 {
     properties->max_size = this_unit.cache_max_size();
+    properties->mode = this_unit.cache_mode;
+    properties->eviction = this_unit.cache_eviction;
 }
 
 bool qc_set_cache_properties(const QC_CACHE_PROPERTIES* properties)
@@ -1309,7 +1633,13 @@ bool qc_get_cache_stats(QC_CACHE_STATS* pStats)
 
     QCInfoCache* pInfo_cache = this_thread.pInfo_cache;
 
-    if (pInfo_cache && use_cached_result())
+    if (this_unit.pShared_cache && use_cached_result())
+    {
+        *pStats = this_thread.shared_stats;
+        pStats->size = this_unit.pShared_cache->size();
+        rv = true;
+    }
+    else if (pInfo_cache && use_cached_result())
     {
         pInfo_cache->get_stats(pStats);
         rv = true;
@@ -1329,6 +1659,10 @@ json_t* qc_get_cache_stats_as_json()
     json_object_set_new(pStats, "hits", json_integer(stats.hits));
     json_object_set_new(pStats, "misses", json_integer(stats.misses));
     json_object_set_new(pStats, "evictions", json_integer(stats.evictions));
+    json_object_set_new(pStats, "eviction", json_string(qc_cache_eviction_to_string(this_unit.cache_eviction)));
+
+    int64_t lookups = stats.hits + stats.misses;
+    json_object_set_new(pStats, "hit_ratio", json_real(lookups ? (double)stats.hits / lookups : 0));
 
     return pStats;
 }
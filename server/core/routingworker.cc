@@ -21,6 +21,7 @@
 #ifdef HAVE_SYSTEMD
 #include <systemd/sd-daemon.h>
 #endif
+#include <algorithm>
 #include <vector>
 #include <sstream>
 
@@ -34,10 +35,12 @@
 #include <maxscale/utils.hh>
 #include <maxscale/statistics.hh>
 
+#include "internal/buffer.h"
 #include "internal/dcb.h"
 #include "internal/modules.h"
 #include "internal/poll.hh"
 #include "internal/service.hh"
+#include "internal/session.hh"
 
 #define WORKER_ABSENT_ID -1
 
@@ -69,6 +72,8 @@ struct this_unit
     int id_main_worker;     // The id of the worker running in the main thread.
     int id_min_worker;      // The smallest routing worker id.
     int id_max_worker;      // The largest routing worker id.
+    int client_placement;   // How the worker of a new client is picked.
+    int rebalance_threshold;// Load difference at which sessions are moved, 0 if never.
 } this_unit =
 {
     false,              // initialized
@@ -81,6 +86,8 @@ struct this_unit
     WORKER_ABSENT_ID,   // id_main_worker
     WORKER_ABSENT_ID,   // id_min_worker
     WORKER_ABSENT_ID,   // id_max_worker
+    RoutingWorker::PLACEMENT_ROUND_ROBIN,   // client_placement
+    0,                                      // rebalance_threshold
 };
 
 int next_worker_id()
@@ -252,6 +259,11 @@ private:
 
 RoutingWorker::RoutingWorker()
     : m_id(next_worker_id())
+    , m_buffer_pool_stats{}
+    , m_nClients(0)
+    , m_nPending_clients(0)
+    , m_nSessions_moved_in(0)
+    , m_nSessions_moved_out(0)
     , m_alive(true)
     , m_pWatchdog_notifier(nullptr)
 {
@@ -557,14 +569,20 @@ void RoutingWorker::delete_zombies()
 bool RoutingWorker::pre_run()
 {
     this_thread.current_worker_id = m_id;
+    gwbuf_pool_thread_init(&m_buffer_pool_stats);
 
     bool rv = modules_thread_init() && service_thread_init() && qc_thread_init(QC_INIT_SELF);
 
     if (!rv)
     {
         MXS_ERROR("Could not perform thread initialization for all modules. Thread exits.");
+        gwbuf_pool_thread_finish();
         this_thread.current_worker_id = WORKER_ABSENT_ID;
     }
+    else if (m_id == this_unit.id_main_worker)
+    {
+        delayed_call(1000, &RoutingWorker::balance_workers, this);
+    }
 
     return rv;
 }
@@ -573,6 +591,8 @@ void RoutingWorker::post_run()
 {
     modules_thread_finish();
     qc_thread_end(QC_INIT_SELF);
+    dcb_thread_finish();
+    gwbuf_pool_thread_finish();
     // TODO: Add service_thread_finish().
     this_thread.current_worker_id = WORKER_ABSENT_ID;
 }
@@ -850,7 +870,7 @@ std::vector<Worker::STATISTICS> get_stats()
 }
 
 // static
-Worker::STATISTICS RoutingWorker::get_statistics()
+RoutingWorker::STATISTICS RoutingWorker::get_statistics()
 {
     auto s = get_stats();
 
@@ -873,6 +893,15 @@ Worker::STATISTICS RoutingWorker::get_statistics()
     cs.qtimes = mxs::avg_element(s, &STATISTICS::qtimes);
     cs.exectimes = mxs::avg_element(s, &STATISTICS::exectimes);
 
+    int nWorkers = this_unit.next_worker_id;
+
+    for (int i = 0; i < nWorkers; ++i)
+    {
+        const GWBUF_POOL_STATS& ps = RoutingWorker::get(i)->buffer_pool_statistics();
+        cs.n_buffer_pool_hits += ps.n_hits;
+        cs.n_buffer_pool_misses += ps.n_misses;
+    }
+
     return cs;
 }
 
@@ -1003,6 +1032,13 @@ json_t* qc_stats_to_json(const char* zHost, int id, const QC_CACHE_STATS& stats)
     json_object_set_new(pStats, "misses", json_integer(stats.misses));
     json_object_set_new(pStats, "evictions", json_integer(stats.evictions));
 
+    QC_CACHE_PROPERTIES properties;
+    qc_get_cache_properties(&properties);
+    json_object_set_new(pStats, "eviction", json_string(qc_cache_eviction_to_string(properties.eviction)));
+
+    int64_t lookups = stats.hits + stats.misses;
+    json_object_set_new(pStats, "hit_ratio", json_real(lookups ? (double)stats.hits / lookups : 0));
+
     json_t* pAttributes = json_object();
     json_object_set_new(pAttributes, "stats", pStats);
 
@@ -1059,13 +1095,246 @@ std::unique_ptr<json_t> RoutingWorker::get_qc_stats_as_json(const char* zHost)
     return std::unique_ptr<json_t>(mxs_json_resource(zHost, MXS_JSON_API_QC_STATS, sAll_stats.release()));
 }
 
+// static
+void RoutingWorker::set_client_placement(client_placement_t placement)
+{
+    mxb::atomic::store(&this_unit.client_placement, placement, mxb::atomic::RELAXED);
+}
+
+// static
+RoutingWorker::client_placement_t RoutingWorker::get_client_placement()
+{
+    return static_cast<client_placement_t>(mxb::atomic::load(&this_unit.client_placement,
+                                                             mxb::atomic::RELAXED));
+}
+
 // static
 RoutingWorker* RoutingWorker::pick_worker()
 {
     static int id_generator = 0;
-    int id = this_unit.id_min_worker
-        + (mxb::atomic::add(&id_generator, 1, mxb::atomic::RELAXED) % this_unit.nWorkers);
-    return get(id);
+    int offset = mxb::atomic::add(&id_generator, 1, mxb::atomic::RELAXED) % this_unit.nWorkers;
+    RoutingWorker* pWorker = get(this_unit.id_min_worker + offset);
+
+    if (get_client_placement() == PLACEMENT_LEAST_LOADED)
+    {
+        // The search starts from the worker that would be picked in turn, so that
+        // the clients are still spread evenly if all workers are equally loaded.
+        int32_t min_clients = pWorker->client_count() + pWorker->pending_client_count();
+        int min_load = pWorker->load(Load::ONE_SECOND);
+
+        for (int i = 1; i < this_unit.nWorkers; ++i)
+        {
+            RoutingWorker* pCandidate = get(this_unit.id_min_worker + (offset + i) % this_unit.nWorkers);
+            int32_t clients = pCandidate->client_count() + pCandidate->pending_client_count();
+
+            if (clients <= min_clients)
+            {
+                int load = pCandidate->load(Load::ONE_SECOND);
+
+                if (clients < min_clients || load < min_load)
+                {
+                    pWorker = pCandidate;
+                    min_clients = clients;
+                    min_load = load;
+                }
+            }
+        }
+    }
+
+    mxb::atomic::add(&pWorker->m_nPending_clients, 1, mxb::atomic::RELAXED);
+
+    return pWorker;
+}
+
+void RoutingWorker::client_added()
+{
+    mxb::atomic::add(&m_nClients, 1, mxb::atomic::RELAXED);
+}
+
+void RoutingWorker::client_removed()
+{
+    mxb_assert(client_count() > 0);
+    mxb::atomic::add(&m_nClients, -1, mxb::atomic::RELAXED);
+}
+
+// static
+void RoutingWorker::set_rebalance_threshold(int threshold)
+{
+    mxb::atomic::store(&this_unit.rebalance_threshold, threshold, mxb::atomic::RELAXED);
+}
+
+// static
+int RoutingWorker::get_rebalance_threshold()
+{
+    return mxb::atomic::load(&this_unit.rebalance_threshold, mxb::atomic::RELAXED);
+}
+
+bool RoutingWorker::balance_workers(Worker::Call::action_t action)
+{
+    int threshold = get_rebalance_threshold();
+
+    if (action == Worker::Call::EXECUTE && threshold > 0 && this_unit.nWorkers > 1)
+    {
+        RoutingWorker* pBusiest = nullptr;
+        RoutingWorker* pIdlest = nullptr;
+        int max_load = -1;
+        int min_load = INT_MAX;
+
+        for (int i = this_unit.id_min_worker; i <= this_unit.id_max_worker; ++i)
+        {
+            RoutingWorker* pWorker = get(i);
+            int load = pWorker->load(Load::ONE_SECOND);
+
+            if (load > max_load)
+            {
+                max_load = load;
+                pBusiest = pWorker;
+            }
+
+            if (load < min_load)
+            {
+                min_load = load;
+                pIdlest = pWorker;
+            }
+        }
+
+        if (max_load - min_load >= threshold)
+        {
+            // Assuming that the load of a worker is evenly spread over its clients,
+            // moving this many clients evens out the loads of the two workers.
+            int n = pBusiest->client_count() * (max_load - min_load) / (2 * max_load);
+            n = std::max(n, 1);
+
+            MXS_INFO("Load of worker %d is %d%% and of worker %d %d%%, moving at most %d sessions.",
+                     pBusiest->id(), max_load, pIdlest->id(), min_load, n);
+
+            pBusiest->execute([pBusiest, pIdlest, n]() {
+                                  pBusiest->move_sessions(pIdlest, n);
+                              }, Worker::EXECUTE_QUEUED);
+        }
+    }
+
+    return action == Worker::Call::EXECUTE;
+}
+
+int RoutingWorker::move_sessions(RoutingWorker* pTarget, int n)
+{
+    mxb_assert(this == get_current() && pTarget != this);
+
+    std::vector<MXS_SESSION*> candidates;
+
+    for (auto it = m_sessions.begin(); it != m_sessions.end() && (int)candidates.size() < n; ++it)
+    {
+        if (static_cast<Session*>(it->second)->can_be_moved())
+        {
+            candidates.push_back(it->second);
+        }
+    }
+
+    int nMoved = 0;
+
+    for (MXS_SESSION* pSession : candidates)
+    {
+        if (move_session(pSession, pTarget))
+        {
+            ++nMoved;
+        }
+    }
+
+    return nMoved;
+}
+
+bool RoutingWorker::move_session(MXS_SESSION* pSession, RoutingWorker* pTarget)
+{
+    Session* pSes = static_cast<Session*>(pSession);
+    std::vector<DCB*> dcbs {pSession->client_dcb};
+    dcbs.insert(dcbs.end(), pSes->dcb_set().begin(), pSes->dcb_set().end());
+
+    bool detached = true;
+    auto end = dcbs.begin();
+
+    while (detached && end != dcbs.end())
+    {
+        if ((detached = dcb_detach_from_worker(*end)))
+        {
+            ++end;
+        }
+    }
+
+    bool registered = false;
+
+    if (detached)
+    {
+        registered = m_sessions.remove(pSession->ses_id);
+
+        // The target adds the descriptors to its epoll instance only after it
+        // has processed the task, so no events are handled for the session
+        // before that and none after this in the current worker.
+        detached = pTarget->execute([pTarget, pSession, dcbs, registered]() {
+                                        pTarget->adopt_session(pSession, dcbs, registered);
+                                    }, Worker::EXECUTE_QUEUED);
+
+        if (detached)
+        {
+            ++m_nSessions_moved_out;
+            MXS_INFO("Moved session %lu to worker %d.", pSession->ses_id, pTarget->id());
+        }
+    }
+
+    if (!detached)
+    {
+        // Return whatever was detached to this worker.
+        if (registered)
+        {
+            m_sessions.add(pSession);
+        }
+
+        bool attached = true;
+
+        for (auto it = dcbs.begin(); it != end; ++it)
+        {
+            attached = dcb_attach_to_worker(*it) && attached;
+        }
+
+        if (!attached)
+        {
+            poll_fake_hangup_event(pSession->client_dcb);
+        }
+    }
+
+    return detached;
+}
+
+void RoutingWorker::adopt_session(MXS_SESSION* pSession, const std::vector<DCB*>& dcbs, bool registered)
+{
+    mxb_assert(this == get_current());
+
+    bool attached = true;
+
+    for (DCB* pDcb : dcbs)
+    {
+        attached = dcb_attach_to_worker(pDcb) && attached;
+    }
+
+    if (registered)
+    {
+        m_sessions.add(pSession);
+    }
+
+    ++m_nSessions_moved_in;
+
+    if (!attached)
+    {
+        MXS_ERROR("Could not add all connections of moved session %lu to worker %d, "
+                  "closing the session.", pSession->ses_id, id());
+        poll_fake_hangup_event(pSession->client_dcb);
+    }
+}
+
+void RoutingWorker::pending_client_done()
+{
+    mxb_assert(pending_client_count() > 0);
+    mxb::atomic::add(&m_nPending_clients, -1, mxb::atomic::RELAXED);
 }
 
 // static
@@ -1212,6 +1481,17 @@ public:
         json_object_set_new(pStats, "max_event_queue_length", json_integer(s.evq_max));
         json_object_set_new(pStats, "max_exec_time", json_integer(s.maxexectime));
         json_object_set_new(pStats, "max_queue_time", json_integer(s.maxqtime));
+        json_object_set_new(pStats, "sessions", json_integer(rworker.session_registry().size()));
+        json_object_set_new(pStats, "clients", json_integer(rworker.client_count()));
+        json_object_set_new(pStats, "pending_clients", json_integer(rworker.pending_client_count()));
+        json_object_set_new(pStats, "sessions_moved_in", json_integer(rworker.sessions_moved_in()));
+        json_object_set_new(pStats, "sessions_moved_out", json_integer(rworker.sessions_moved_out()));
+
+        const GWBUF_POOL_STATS& ps = rworker.buffer_pool_statistics();
+        json_t* pool = json_object();
+        json_object_set_new(pool, "hits", json_integer(ps.n_hits));
+        json_object_set_new(pool, "misses", json_integer(ps.n_misses));
+        json_object_set_new(pStats, "buffer_pool", pool);
 
         uint32_t nCurrent;
         uint64_t nTotal;
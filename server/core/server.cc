@@ -162,6 +162,7 @@ SERVER* server_alloc(const char* name, MXS_CONFIG_PARAMETER* params)
     server->persistpoolmax = config_get_integer(params, CN_PERSISTPOOLMAX);
     server->persistmaxtime = config_get_integer(params, CN_PERSISTMAXTIME);
     server->proxy_protocol = config_get_bool(params, CN_PROXY_PROTOCOL);
+    server->compression = config_get_bool(params, CN_COMPRESSION);
     server->parameters = NULL;
     server->is_active = true;
     server->auth_instance = auth_instance;
@@ -782,6 +782,7 @@ bool service_remove_listener(Service* service, const char* target)
  * @param port          The port to listen on
  * @param authenticator Name of the authenticator to be used
  * @param ssl           SSL configuration
+ * @param compression   Whether clients may use a compressed protocol
  *
  * @return Created listener or NULL on error
  */
@@ -792,7 +793,8 @@ SERV_LISTENER* serviceCreateListener(Service* service,
                                      unsigned short port,
                                      const char* authenticator,
                                      const char* options,
-                                     SSL_LISTENER* ssl)
+                                     SSL_LISTENER* ssl,
+                                     bool compression)
 {
     SERV_LISTENER* proto = listener_alloc(service,
                                           name,
@@ -801,7 +803,8 @@ SERV_LISTENER* serviceCreateListener(Service* service,
                                           port,
                                           authenticator,
                                           options,
-                                          ssl);
+                                          ssl,
+                                          compression);
 
     if (proto)
     {
@@ -265,6 +265,51 @@ MXS_SESSION* session_set_dummy(DCB* client_dcb)
     return session;
 }
 
+namespace
+{
+
+bool dcb_is_idle(DCB* dcb, int64_t now)
+{
+    // The protocol may hold partial packets that belong to the current worker
+    return dcb->state == DCB_STATE_POLLING
+           && dcb->fd > 0
+           && !dcb->writeq
+           && !dcb->readq
+           && !dcb->delayq
+           && !dcb->fakeq
+           && !dcb->high_water_reached
+           && now - dcb->last_read > 0
+           && (!dcb->func.is_idle || dcb->func.is_idle(dcb));
+}
+}
+
+bool Session::can_be_moved() const
+{
+    // The buffers of the retained statements belong to the current worker
+    // and the filters may keep worker specific data, so neither can be moved.
+    bool rval = state == SESSION_STATE_ROUTER_READY
+        && (service_get_capabilities(service) & RCAP_TYPE_SESSION_MIGRATION)
+        && m_filters.empty()
+        && m_last_queries.empty()
+        && !load_active
+        && !response.buffer
+        && mxb::atomic::load(&refcount) == 1 + (int)m_dcb_set.size();
+
+    int64_t now = mxs_clock();
+
+    if (rval && !dcb_is_idle(client_dcb, now))
+    {
+        rval = false;
+    }
+
+    for (auto it = m_dcb_set.begin(); rval && it != m_dcb_set.end(); ++it)
+    {
+        rval = dcb_is_idle(*it, now);
+    }
+
+    return rval;
+}
+
 void session_link_backend_dcb(MXS_SESSION* session, DCB* dcb)
 {
     mxb_assert(dcb->dcb_role == DCB_ROLE_BACKEND_HANDLER);
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+/**
+ * Compares the throughput of modutil_count_signal_packets() with a walk that
+ * copies the header of every packet out of the buffer chain, which is how the
+ * packets were counted before. The resultset is tested both in one contiguous
+ * buffer and split into a chain of buffers like the ones read from a socket.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <maxscale/buffer.h>
+#include <maxscale/modutil.h>
+#include <maxscale/protocol/mysql.h>
+#include "test_utils.h"
+
+using namespace std;
+
+namespace
+{
+
+char USAGE[] = "usage: profile_count_signal_packets [-r rows] [-s row size] [-c chunk size] [-n rounds]\n";
+
+double now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+void add_packet(vector<uint8_t>& data, uint8_t seq, const vector<uint8_t>& payload)
+{
+    uint8_t header[MYSQL_HEADER_LEN];
+    gw_mysql_set_byte3(header, payload.size());
+    header[3] = seq;
+    data.insert(data.end(), header, header + sizeof(header));
+    data.insert(data.end(), payload.begin(), payload.end());
+}
+
+/**
+ * A resultset with one column: the column count, the column definition, an EOF,
+ * the rows and the final EOF.
+ */
+vector<uint8_t> create_resultset(int nRows, int row_size)
+{
+    vector<uint8_t> data;
+    uint8_t seq = 0;
+    vector<uint8_t> eof = {MYSQL_REPLY_EOF, 0, 0, 0x02, 0};
+
+    add_packet(data, seq++, {1});
+    add_packet(data, seq++, vector<uint8_t>(32, 'c'));
+    add_packet(data, seq++, eof);
+
+    vector<uint8_t> row(row_size, 'a');
+    row[0] = row_size - 1;      // Length-encoded string filling the row
+
+    for (int i = 0; i < nRows; ++i)
+    {
+        add_packet(data, seq++, row);
+    }
+
+    add_packet(data, seq++, eof);
+
+    return data;
+}
+
+GWBUF* create_buffer(const vector<uint8_t>& data, size_t chunk_size)
+{
+    GWBUF* pHead = NULL;
+
+    for (size_t offset = 0; offset < data.size(); offset += chunk_size)
+    {
+        size_t len = std::min(chunk_size, data.size() - offset);
+        pHead = gwbuf_append(pHead, gwbuf_alloc_and_load(len, &data[offset]));
+    }
+
+    return pHead;
+}
+
+/**
+ * The way the packets were walked before, the header of every packet is copied
+ * with gwbuf_copy_data().
+ */
+int count_by_copying(GWBUF* reply, int n_found, bool* more_out)
+{
+    unsigned int len = gwbuf_length(reply);
+    size_t offset = 0;
+    int eof = 0;
+    bool more = false;
+
+    while (offset < len)
+    {
+        uint8_t header[MYSQL_HEADER_LEN + 5];
+        gwbuf_copy_data(reply, offset, MYSQL_HEADER_LEN + 1, header);
+
+        unsigned int pktlen = MYSQL_GET_PAYLOAD_LEN(header) + MYSQL_HEADER_LEN;
+        uint8_t command = MYSQL_GET_COMMAND(header);
+
+        if (command == MYSQL_REPLY_ERR)
+        {
+            *more_out = false;
+            return 2;
+        }
+        else if (command == MYSQL_REPLY_EOF && pktlen == MYSQL_EOF_PACKET_LEN)
+        {
+            eof++;
+            uint8_t status[2];
+            gwbuf_copy_data(reply, offset + MYSQL_HEADER_LEN + 1 + 2, sizeof(status), status);
+            more = gw_mysql_get_byte2(status) & SERVER_MORE_RESULTS_EXIST;
+        }
+
+        offset += pktlen;
+
+        if (offset >= GWBUF_LENGTH(reply) && reply->next)
+        {
+            len -= GWBUF_LENGTH(reply);
+            offset -= GWBUF_LENGTH(reply);
+            reply = reply->next;
+        }
+    }
+
+    *more_out = more;
+    return eof + n_found;
+}
+
+int count_by_scanning(GWBUF* reply, int n_found, bool* more_out)
+{
+    return modutil_count_signal_packets(reply, n_found, more_out, NULL);
+}
+
+void run(GWBUF* pBuffer, const char* zName, int (*count)(GWBUF*, int, bool*), int nRounds)
+{
+    size_t nBytes = gwbuf_length(pBuffer);
+    double start = now();
+
+    for (int i = 0; i < nRounds; ++i)
+    {
+        bool more = true;
+        int n = count(pBuffer, 0, &more);
+
+        if (n != 2 || more)
+        {
+            cerr << "error: " << zName << " found " << n << " signal packets" << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    double duration = now() - start;
+
+    cout << setw(10) << zName
+         << " ms/resultset: " << setw(8) << fixed << setprecision(2) << duration * 1000 / nRounds
+         << " MiB/s: " << setw(8) << fixed << setprecision(1)
+         << nBytes * nRounds / duration / (1024 * 1024)
+         << endl;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    int nRows = 1000000;
+    int row_size = 32;
+    int chunk_size = 16384;
+    int nRounds = 10;
+
+    int c;
+    while ((c = getopt(argc, argv, "r:s:c:n:")) != -1)
+    {
+        switch (c)
+        {
+        case 'r':
+            nRows = atoi(optarg);
+            break;
+
+        case 's':
+            row_size = atoi(optarg);
+            break;
+
+        case 'c':
+            chunk_size = atoi(optarg);
+            break;
+
+        case 'n':
+            nRounds = atoi(optarg);
+            break;
+
+        default:
+            cout << USAGE << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (nRows <= 0 || row_size <= 1 || row_size > 251 || chunk_size <= 0 || nRounds <= 0)
+    {
+        cout << USAGE << endl;
+        return EXIT_FAILURE;
+    }
+
+    init_test_env(NULL);
+
+    vector<uint8_t> data = create_resultset(nRows, row_size);
+
+    cout << nRows << " rows of " << row_size << " bytes, " << data.size() << " bytes in total" << endl;
+
+    GWBUF* pContiguous = create_buffer(data, data.size());
+    cout << "One buffer:" << endl;
+    run(pContiguous, "copy", count_by_copying, nRounds);
+    run(pContiguous, "scan", count_by_scanning, nRounds);
+    gwbuf_free(pContiguous);
+
+    GWBUF* pChain = create_buffer(data, chunk_size);
+    cout << "Chain of " << chunk_size << " byte buffers:" << endl;
+    run(pChain, "copy", count_by_copying, nRounds);
+    run(pChain, "scan", count_by_scanning, nRounds);
+    gwbuf_free(pChain);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+/**
+ * Compares the number of syscalls and the throughput of draining a DCB write
+ * queue consisting of a large resultset of small row packets, when done with
+ * one write() per buffer and when done with the vectored dcb_drain_writeq().
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../dcb.cc"
+#include "test_utils.h"
+
+using namespace std;
+
+namespace
+{
+
+char USAGE[] = "usage: profile_dcb_write [-r rows] [-s row size] [-n rounds]\n";
+
+double now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+GWBUF* create_resultset(int nRows, int row_size)
+{
+    GWBUF* pHead = NULL;
+    std::vector<uint8_t> row(row_size, 'a');
+
+    for (int i = 0; i < nRows; ++i)
+    {
+        pHead = gwbuf_append(pHead, gwbuf_alloc_and_load(row_size, row.data()));
+    }
+
+    return pHead;
+}
+
+void wait_writable(int fd)
+{
+    pollfd pfd = {fd, POLLOUT, 0};
+    poll(&pfd, 1, -1);
+}
+
+/**
+ * The way the write queue was drained before, one write() per buffer.
+ */
+int drain_one_by_one(DCB* pDcb, int* pnCalls)
+{
+    int total = 0;
+
+    while (pDcb->writeq)
+    {
+        ssize_t n = write(pDcb->fd, GWBUF_DATA(pDcb->writeq), GWBUF_LENGTH(pDcb->writeq));
+        ++*pnCalls;
+
+        if (n < 0)
+        {
+            break;
+        }
+
+        pDcb->writeq = gwbuf_consume(pDcb->writeq, n);
+        total += n;
+    }
+
+    pDcb->writeqlen -= total;
+    return total;
+}
+
+int drain_vectored(DCB* pDcb, int* pnCalls)
+{
+    int before = pDcb->stats.n_writes;
+    int total = dcb_drain_writeq(pDcb);
+    *pnCalls += pDcb->stats.n_writes - before;
+    return total;
+}
+
+void run(DCB* pDcb, const char* zName, int (*drain)(DCB*, int*), int nRows, int row_size, int nRounds)
+{
+    int nCalls = 0;
+    size_t nBytes = 0;
+    double start = now();
+
+    for (int i = 0; i < nRounds; ++i)
+    {
+        GWBUF* pResultset = create_resultset(nRows, row_size);
+        pDcb->writeqlen = gwbuf_length(pResultset);
+        pDcb->writeq = pResultset;
+
+        while (pDcb->writeq)
+        {
+            nBytes += drain(pDcb, &nCalls);
+
+            if (pDcb->writeq)
+            {
+                wait_writable(pDcb->fd);
+            }
+        }
+    }
+
+    double duration = now() - start;
+
+    cout << setw(12) << zName
+         << " syscalls: " << setw(10) << nCalls
+         << " syscalls/resultset: " << setw(8) << fixed << setprecision(1) << (double)nCalls / nRounds
+         << " MiB/s: " << setw(8) << fixed << setprecision(1) << nBytes / duration / (1024 * 1024)
+         << endl;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    int nRows = 1000;
+    int row_size = 64;
+    int nRounds = 100;
+
+    int c;
+    while ((c = getopt(argc, argv, "r:s:n:")) != -1)
+    {
+        switch (c)
+        {
+        case 'r':
+            nRows = atoi(optarg);
+            break;
+
+        case 's':
+            row_size = atoi(optarg);
+            break;
+
+        case 'n':
+            nRounds = atoi(optarg);
+            break;
+
+        default:
+            cout << USAGE << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (nRows <= 0 || row_size <= 0 || nRounds <= 0)
+    {
+        cout << USAGE << endl;
+        return EXIT_FAILURE;
+    }
+
+    init_test_env(NULL);
+
+    int fds[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+    {
+        cerr << "error: socketpair failed: " << mxs_strerror(errno) << endl;
+        return EXIT_FAILURE;
+    }
+
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+    std::thread reader([&fds]() {
+                           char buf[65536];
+
+                           while (read(fds[1], buf, sizeof(buf)) > 0)
+                           {
+                           }
+                       });
+
+    SERV_LISTENER dummy;
+    DCB* pDcb = dcb_alloc(DCB_ROLE_INTERNAL, &dummy);
+    pDcb->fd = fds[0];
+    pDcb->state = DCB_STATE_POLLING;
+
+    cout << nRounds << " resultsets of " << nRows << " rows of " << row_size << " bytes" << endl;
+
+    run(pDcb, "write", drain_one_by_one, nRows, row_size, nRounds);
+    run(pDcb, "writev", drain_vectored, nRows, row_size, nRounds);
+
+    shutdown(fds[0], SHUT_WR);
+    reader.join();
+    close(fds[0]);
+    close(fds[1]);
+
+    return EXIT_SUCCESS;
+}
@@ -34,8 +34,9 @@
 #include <string.h>
 
 #include <maxscale/alloc.h>
-#include <maxscale/modutil.h>
+#include <maxscale/modutil.hh>
 #include <maxscale/buffer.h>
+#include <maxscale/protocol/mysql.h>
 
 /**
  * test1    Allocate a service and do lots of other things
@@ -596,6 +597,46 @@ void test_large_packets()
     }
 }
 
+//
+// modutil_count_signal_packets
+//
+void test_count_signal_packets()
+{
+    /** The whole resultset in one buffer */
+    GWBUF* buffer = gwbuf_alloc_and_load(sizeof(resultset), resultset);
+    bool more = true;
+    mxb_assert_message(modutil_count_signal_packets(buffer, 0, &more, NULL) == 2,
+                       "Resultset should have two EOF packets");
+    mxb_assert_message(!more, "No more results should exist");
+    gwbuf_free(buffer);
+
+    /** The resultset split into two buffers at every possible position */
+    for (size_t i = 1; i < sizeof(resultset); i++)
+    {
+        buffer = gwbuf_append(gwbuf_alloc_and_load(i, resultset),
+                              gwbuf_alloc_and_load(sizeof(resultset) - i, resultset + i));
+        more = true;
+        mxb_assert_message(modutil_count_signal_packets(buffer, 0, &more, NULL) == 2,
+                           "Split resultset should have two EOF packets");
+        mxb_assert_message(!more, "No more results should exist");
+        gwbuf_free(buffer);
+    }
+
+    /** The resultset in one byte buffers */
+    buffer = NULL;
+
+    for (size_t i = 0; i < sizeof(resultset); i++)
+    {
+        buffer = gwbuf_append(buffer, gwbuf_alloc_and_load(1, resultset + i));
+    }
+
+    more = true;
+    mxb_assert_message(modutil_count_signal_packets(buffer, 0, &more, NULL) == 2,
+                       "Resultset in one byte buffers should have two EOF packets");
+    mxb_assert_message(!more, "No more results should exist");
+    gwbuf_free(buffer);
+}
+
 char* bypass_whitespace(const char* sql)
 {
     return modutil_MySQL_bypass_whitespace((char*)sql, strlen(sql));
@@ -633,6 +674,68 @@ void test_bypass_whitespace()
     mxb_assert_message(*sql == 'S', "9");
 }
 
+GWBUF* create_query(const char* sql)
+{
+    size_t len = strlen(sql);
+    GWBUF* buffer = create_buffer(len + 1);
+    uint8_t* data = GWBUF_DATA(buffer);
+    data[4] = MXS_COM_QUERY;
+    memcpy(data + 5, sql, len);
+    return buffer;
+}
+
+uint64_t canonical_hash(const char* sql)
+{
+    GWBUF* buffer = create_query(sql);
+    uint64_t hash = mxs::canonicalize(buffer).hash;
+    gwbuf_free(buffer);
+    return hash;
+}
+
+void test_canonicalize()
+{
+    const char* sql = "SELECT a, b FROM t WHERE id = 42 AND name = 'foo' /* comment */ LIMIT 10";
+    GWBUF* buffer = create_query(sql);
+
+    mxs::Canonical canonical = mxs::canonicalize(buffer);
+    mxb_assert_message(canonical.str() == mxs::get_canonical(buffer), "Canonical forms should be the same");
+    mxb_assert_message(canonical.str() == "SELECT a, b FROM t WHERE id = ? AND name = ? LIMIT ?",
+                       "Literals and comments should be replaced");
+    uint64_t hash = canonical.hash;
+
+    // A statement split over several buffers must produce the same result.
+    size_t len = gwbuf_length(buffer);
+    GWBUF* head = gwbuf_alloc_and_load(len / 3, GWBUF_DATA(buffer));
+    head = gwbuf_append(head, gwbuf_alloc_and_load(len / 3, GWBUF_DATA(buffer) + len / 3));
+    head = gwbuf_append(head, gwbuf_alloc_and_load(len - 2 * (len / 3), GWBUF_DATA(buffer) + 2 * (len / 3)));
+
+    canonical = mxs::canonicalize(head);
+    mxb_assert_message(canonical.str() == "SELECT a, b FROM t WHERE id = ? AND name = ? LIMIT ?",
+                       "Fragmented statement should have the same canonical form");
+    mxb_assert_message(canonical.hash == hash, "Fragmented statement should have the same hash");
+
+    // The text of a statement must produce the same result as its packet.
+    canonical = mxs::canonicalize(sql, strlen(sql));
+    mxb_assert_message(canonical.str() == "SELECT a, b FROM t WHERE id = ? AND name = ? LIMIT ?",
+                       "Statement text should have the same canonical form");
+    mxb_assert_message(canonical.hash == hash, "Statement text should have the same hash");
+
+    gwbuf_free(head);
+    gwbuf_free(buffer);
+
+    mxb_assert_message(canonical_hash("SELECT * FROM t WHERE id = 1")
+                       != canonical_hash("select * from t where id = 1"),
+                       "Case should be significant");
+    mxb_assert_message(canonical_hash("SELECT * FROM t WHERE id = 1")
+                       == canonical_hash("SELECT * FROM t   WHERE id =   12345"),
+                       "Statements differing only by literals and whitespace should have the same hash");
+    mxb_assert_message(canonical_hash("SELECT * FROM t WHERE id = -1")
+                       == canonical_hash("SELECT * FROM t WHERE id = 1"),
+                       "The sign of a number should not matter");
+    mxb_assert_message(canonical_hash("SELECT * FROM t1") != canonical_hash("SELECT * FROM t2"),
+                       "Different statements should have different hashes");
+}
+
 int main(int argc, char** argv)
 {
     int result = 0;
@@ -646,6 +749,8 @@ int main(int argc, char** argv)
     test_strnchr_esc();
     test_strnchr_esc_mysql();
     test_large_packets();
+    test_count_signal_packets();
     test_bypass_whitespace();
+    test_canonicalize();
     exit(result);
 }
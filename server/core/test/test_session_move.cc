@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+// To ensure that ss_info_assert asserts also when builing in non-debug mode.
+#if !defined (SS_DEBUG)
+#define SS_DEBUG
+#endif
+#if defined (NDEBUG)
+#undef NDEBUG
+#endif
+
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <maxscale/clock.h>
+#include <maxscale/listener.h>
+#include <maxscale/router.h>
+
+#include "../internal/dcb.h"
+#include "../internal/session.hh"
+#include "test_utils.h"
+
+using maxscale::RoutingWorker;
+using maxscale::Session;
+
+namespace
+{
+
+bool protocol_idle = true;
+
+bool test_is_idle(DCB* dcb)
+{
+    return protocol_idle;
+}
+
+DCB* create_dcb(SERV_LISTENER* listener, int fd)
+{
+    DCB* dcb = dcb_alloc(DCB_ROLE_CLIENT_HANDLER, listener);
+    dcb->fd = fd;
+    dcb->state = DCB_STATE_POLLING;
+    dcb->last_read = mxs_clock() - 1;
+    dcb->func.is_idle = test_is_idle;
+    return dcb;
+}
+
+void test_can_be_moved(int fd)
+{
+    SERVICE service = {};
+    service.retain_last_statements = 0;
+    service.capabilities = RCAP_TYPE_SESSION_MIGRATION;
+    SERV_LISTENER listener = {};
+    DCB* dcb = create_dcb(&listener, fd);
+
+    Session session(&service);
+    session.state = SESSION_STATE_ROUTER_READY;
+    session.service = &service;
+    session.client_dcb = dcb;
+    session.router_session = NULL;
+    session.refcount = 1;
+    session.load_active = false;
+    session.response.buffer = NULL;
+
+    mxb_assert_message(session.can_be_moved(), "An idle session can be moved");
+
+    protocol_idle = false;
+    mxb_assert_message(!session.can_be_moved(), "A session with a busy protocol cannot be moved");
+    protocol_idle = true;
+
+    dcb->readq = gwbuf_alloc(1);
+    mxb_assert_message(!session.can_be_moved(), "A session with a readq cannot be moved");
+    gwbuf_free(dcb->readq);
+    dcb->readq = NULL;
+
+    dcb->last_read = mxs_clock();
+    mxb_assert_message(!session.can_be_moved(), "A session that just read data cannot be moved");
+    dcb->last_read = mxs_clock() - 1;
+
+    session.refcount = 2;
+    mxb_assert_message(!session.can_be_moved(), "A session with other references cannot be moved");
+    session.refcount = 1;
+
+    session.load_active = true;
+    mxb_assert_message(!session.can_be_moved(), "A session loading data cannot be moved");
+    session.load_active = false;
+
+    service.capabilities = 0;
+    mxb_assert_message(!session.can_be_moved(), "A session of a router without migration cannot be moved");
+    service.capabilities = RCAP_TYPE_SESSION_MIGRATION;
+
+    mxb_assert_message(session.can_be_moved(), "The session can be moved once idle again");
+
+    MXS_FREE(dcb);
+}
+
+void test_detach_attach(int fd)
+{
+    SERV_LISTENER listener = {};
+    DCB* dcb = create_dcb(&listener, fd);
+    RoutingWorker* worker = RoutingWorker::get_current();
+    int clients = worker->client_count();
+
+    mxb_assert_message(dcb_attach_to_worker(dcb), "A DCB can be attached");
+    mxb_assert_message(dcb->poll.owner == worker, "The DCB is owned by the worker");
+    mxb_assert_message(worker->client_count() == clients + 1, "The worker counts the attached client");
+
+    mxb_assert_message(dcb_detach_from_worker(dcb), "An attached DCB can be detached");
+    mxb_assert_message(worker->client_count() == clients, "The worker no longer counts the detached client");
+    mxb_assert_message(!worker->remove_fd(fd), "The descriptor of a detached DCB is not polled");
+
+    mxb_assert_message(dcb_attach_to_worker(dcb), "A detached DCB can be attached again");
+    mxb_assert_message(dcb_detach_from_worker(dcb), "A DCB attached again can be detached");
+
+    MXS_FREE(dcb);
+}
+}
+
+int main(int argc, char** argv)
+{
+    int rval = 0;
+    int fds[2];
+
+    init_test_env(NULL);
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0)
+    {
+        // The DCBs must be handled in the worker that owns them
+        RoutingWorker* worker = RoutingWorker::get(RoutingWorker::MAIN);
+
+        if (worker->start())
+        {
+            worker->call([&]() {
+                             test_can_be_moved(fds[0]);
+                             test_detach_attach(fds[0]);
+                         },
+                         mxb::Worker::EXECUTE_QUEUED);
+
+            worker->shutdown();
+            worker->join();
+        }
+        else
+        {
+            rval++;
+        }
+
+        close(fds[0]);
+        close(fds[1]);
+    }
+    else
+    {
+        rval++;
+    }
+
+    return rval;
+}
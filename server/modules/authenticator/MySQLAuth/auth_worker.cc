@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "mysql_auth.h"
+#include "auth_worker.hh"
+
+#include <maxbase/worker.hh>
+#include <maxscale/maxscale.h>
+#include <maxscale/mysql_utils.h>
+
+class AuthWorker::Worker : public mxb::Worker
+{
+public:
+    Worker(const char* name, bool mysql_client)
+        : m_name(name)
+        , m_mysql_client(mysql_client)
+    {
+    }
+
+    bool pre_run() override
+    {
+        bool rval = !m_mysql_client || mysql_thread_init() == 0;
+
+        if (!rval)
+        {
+            MXS_ERROR("mysql_thread_init() failed, the %s thread cannot start.", m_name);
+        }
+
+        return rval;
+    }
+
+    void post_run() override
+    {
+        if (m_mysql_client)
+        {
+            mysql_thread_end();
+        }
+    }
+
+private:
+    const char* m_name;
+    bool        m_mysql_client;
+};
+
+AuthWorker::AuthWorker(const char* name, bool mysql_client)
+    : m_name(name)
+    , m_mysql_client(mysql_client)
+{
+}
+
+bool AuthWorker::execute(std::function<void ()> func)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    bool rval = false;
+
+    if (!m_stopped && !maxscale_is_shutting_down())
+    {
+        if (!m_worker)
+        {
+            m_worker = new(std::nothrow) Worker(m_name, m_mysql_client);
+
+            if (m_worker && !m_worker->start())
+            {
+                MXS_ERROR("Could not start the %s thread.", m_name);
+                delete m_worker;
+                m_worker = nullptr;
+                m_stopped = true;
+            }
+        }
+
+        rval = m_worker && m_worker->execute(func, mxb::Worker::EXECUTE_QUEUED);
+    }
+
+    return rval;
+}
+
+void AuthWorker::finish()
+{
+    Worker* worker;
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        worker = m_worker;
+        m_worker = nullptr;
+        m_stopped = true;
+    }
+
+    // Not joined under the lock, the running task might be waiting for a caller of execute()
+    if (worker)
+    {
+        worker->shutdown();
+        worker->join();
+        delete worker;
+    }
+}
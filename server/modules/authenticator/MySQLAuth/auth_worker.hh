@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+
+#include <functional>
+#include <mutex>
+
+/**
+ * A background thread of the authenticator
+ *
+ * The thread is started when the first task is given to it and it is stopped
+ * when the routing workers stop. The tasks are executed one at a time in the
+ * order they were given.
+ */
+class AuthWorker
+{
+public:
+    AuthWorker(const AuthWorker&) = delete;
+    AuthWorker& operator=(const AuthWorker&) = delete;
+
+    /**
+     * @param name         Name of the thread, used in error messages
+     * @param mysql_client Whether the tasks use the connector
+     */
+    AuthWorker(const char* name, bool mysql_client);
+
+    /**
+     * Execute a task in the thread
+     *
+     * @param func The task
+     *
+     * @return True if the task was queued, false if the thread could not be
+     *         started or has already been stopped
+     */
+    bool execute(std::function<void ()> func);
+
+    /**
+     * Stop the thread
+     *
+     * The tasks that have not yet been executed are discarded. No new tasks
+     * are accepted after this.
+     */
+    void finish();
+
+private:
+    class Worker;
+
+    std::mutex  m_lock;
+    const char* m_name;
+    bool        m_mysql_client;
+    Worker*     m_worker = nullptr;
+    bool        m_stopped = false;
+};
@@ -128,11 +128,10 @@ const char* mariadb_users_query
         // We only care about users that have a default role assigned
         "WHERE t.default_role = u.user %s;";
 
-static int    get_users(SERV_LISTENER* listener, bool skip_local);
+static int    get_users(SERV_LISTENER* listener, bool skip_local, UserIndex* index);
 static MYSQL* gw_mysql_init(void);
 static int    gw_mysql_set_timeouts(MYSQL* handle);
 static char*  mysql_format_user_entry(void* data);
-static bool   get_hostname(DCB* dcb, char* client_hostname, size_t size);
 
 static char* get_mariadb_102_users_query(bool include_root)
 {
@@ -184,9 +183,9 @@ static char* get_users_query(const char* server_version, int version, bool inclu
     return rval;
 }
 
-int replace_mysql_users(SERV_LISTENER* listener, bool skip_local)
+int load_mysql_users(SERV_LISTENER* listener, bool skip_local, UserIndex* index)
 {
-    int i = get_users(listener, skip_local);
+    int i = get_users(listener, skip_local, index);
     return i;
 }
 
@@ -242,37 +241,9 @@ static bool check_password(const char* output,
     return memcmp(final_step, stored_token, stored_token_len) == 0;
 }
 
-/** Callback for check_database() */
-static int database_cb(void* data, int columns, char** rows, char** row_names)
+static bool check_database(const UserIndex& index, const char* database)
 {
-    bool* rval = (bool*)data;
-    *rval = true;
-    return 0;
-}
-
-static bool check_database(sqlite3* handle, const char* database)
-{
-    bool rval = true;
-
-    if (*database)
-    {
-        rval = false;
-        size_t len = sizeof(mysqlauth_validate_database_query) + strlen(database) + 1;
-        char sql[len];
-
-        sprintf(sql, mysqlauth_validate_database_query, database);
-
-        char* err;
-
-        if (sqlite3_exec(handle, sql, database_cb, &rval, &err) != SQLITE_OK)
-        {
-            MXS_ERROR("Failed to execute auth query: %s", err);
-            sqlite3_free(err);
-            rval = false;
-        }
-    }
-
-    return rval;
+    return *database == '\0' || index.has_database(database);
 }
 
 static bool no_password_required(const char* result, size_t tok_len)
@@ -280,110 +251,59 @@ static bool no_password_required(const char* result, size_t tok_len)
     return *result == '\0' && tok_len == 0;
 }
 
-/** Used to detect empty result sets */
-struct user_query_result
-{
-    bool ok;
-    char output[SHA_DIGEST_LENGTH * 2 + 1];
-};
-
-/** @brief Callback for sqlite3_exec() */
-static int auth_cb(void* data, int columns, char** rows, char** row_names)
-{
-    struct user_query_result* res = (struct user_query_result*)data;
-    strcpy(res->output, rows[0] ? rows[0] : "");
-    res->ok = true;
-    return 0;
-}
-
 int validate_mysql_user(MYSQL_AUTH* instance,
                         DCB* dcb,
                         MYSQL_session* session,
                         uint8_t* scramble,
-                        size_t   scramble_len)
+                        size_t   scramble_len,
+                        bool     async)
 {
-    sqlite3* handle = get_handle(instance);
-    const char* validate_query = instance->lower_case_table_names ?
-        mysqlauth_validate_user_query_lower :
-        mysqlauth_validate_user_query;
-    size_t len = strlen(validate_query) + 1 + strlen(session->user) * 2
-        + strlen(session->db) * 2 + MYSQL_HOST_MAXLEN + session->auth_token_len * 4 + 1;
-    char sql[len + 1];
+    // The users of this worker are only replaced by this worker, no need to copy the pointer
+    const SUserIndex& index = instance->index;
+    const char* password;
     int rval = MXS_AUTH_FAILED;
-    char* err;
 
     if (instance->skip_auth)
     {
-        sprintf(sql, mysqlauth_skip_auth_query, session->user, session->db, session->db);
+        password = index->find(session->user, NULL, session->db);
     }
     else
     {
-        sprintf(sql,
-                validate_query,
-                session->user,
-                dcb->remote,
-                dcb->remote,
-                session->db,
-                session->db);
-    }
-
-    struct user_query_result res = {};
-
-    if (sqlite3_exec(handle, sql, auth_cb, &res, &err) != SQLITE_OK)
-    {
-        MXS_ERROR("Failed to execute auth query: %s", err);
-        sqlite3_free(err);
-    }
+        password = index->find(session->user, dcb->remote, session->db);
 
-    /** Check for IPv6 mapped IPv4 address */
-    if (!res.ok && strchr(dcb->remote, ':') && strchr(dcb->remote, '.'))
-    {
-        const char* ipv4 = strrchr(dcb->remote, ':') + 1;
-        sprintf(sql,
-                validate_query,
-                session->user,
-                ipv4,
-                ipv4,
-                session->db,
-                session->db);
-
-        if (sqlite3_exec(handle, sql, auth_cb, &res, &err) != SQLITE_OK)
+        /** Check for IPv6 mapped IPv4 address */
+        if (!password && strchr(dcb->remote, ':') && strchr(dcb->remote, '.'))
         {
-            MXS_ERROR("Failed to execute auth query: %s", err);
-            sqlite3_free(err);
+            const char* ipv4 = strrchr(dcb->remote, ':') + 1;
+            password = index->find(session->user, ipv4, session->db);
         }
-    }
 
-    if (!res.ok)
-    {
-        /**
-         * Try authentication with the hostname instead of the IP. We do this only
-         * as a last resort so we avoid the high cost of the DNS lookup.
-         */
-        char client_hostname[MYSQL_HOST_MAXLEN] = "";
-        get_hostname(dcb, client_hostname, sizeof(client_hostname) - 1);
-
-        sprintf(sql,
-                validate_query,
-                session->user,
-                client_hostname,
-                client_hostname,
-                session->db,
-                session->db);
-
-        if (sqlite3_exec(handle, sql, auth_cb, &res, &err) != SQLITE_OK)
+        if (!password && index->has_user(session->user))
         {
-            MXS_ERROR("Failed to execute auth query: %s", err);
-            sqlite3_free(err);
+            /**
+             * Try authentication with the hostname instead of the IP. We do this only
+             * as a last resort so we avoid the high cost of the DNS lookup.
+             */
+            AuthClient* client = (AuthClient*)dcb->authenticator_data;
+
+            if (!instance->resolver->resolve(client, dcb->remote, async))
+            {
+                // The client is parked until the hostname has been looked up
+                rval = MXS_AUTH_INCOMPLETE;
+            }
+            else if (!client->hostname.empty())
+            {
+                password = index->find(session->user, client->hostname.c_str(), session->db);
+            }
         }
     }
 
-    if (res.ok)
+    if (password)
     {
-        /** Found a matching row */
+        /** Found a matching grant */
 
-        if (no_password_required(res.output, session->auth_token_len)
-            || check_password(res.output,
+        if (no_password_required(password, session->auth_token_len)
+            || check_password(password,
                               session->auth_token,
                               session->auth_token_len,
                               scramble,
@@ -391,7 +311,7 @@ int validate_mysql_user(MYSQL_AUTH* instance,
                               session->client_sha1))
         {
             /** Password is OK, check that the database exists */
-            if (check_database(handle, session->db))
+            if (check_database(*index, session->db))
             {
                 rval = MXS_AUTH_SUCCEEDED;
             }
@@ -405,27 +325,6 @@ int validate_mysql_user(MYSQL_AUTH* instance,
     return rval;
 }
 
-/**
- * @brief Delete all users
- *
- * @param handle SQLite handle
- */
-static bool delete_mysql_users(sqlite3* handle)
-{
-    bool rval = true;
-    char* err;
-
-    if (sqlite3_exec(handle, delete_users_query, NULL, NULL, &err) != SQLITE_OK
-        || sqlite3_exec(handle, delete_databases_query, NULL, NULL, &err) != SQLITE_OK)
-    {
-        MXS_ERROR("Failed to delete old users: %s", err);
-        sqlite3_free(err);
-        rval = false;
-    }
-
-    return rval;
-}
-
 /**
  * If the hostname is of form a.b.c.d/e.f.g.h where e-h is 255 or 0, replace
  * the zeros in the first part with '%' and remove the second part. This does
@@ -491,28 +390,13 @@ static void merge_netmask(char* host)
     }
 }
 
-void add_mysql_user(sqlite3* handle,
+void add_mysql_user(UserIndex* index,
                     const char* user,
                     const char* host,
                     const char* db,
                     bool anydb,
                     const char* pw)
 {
-    size_t dblen = db && *db ? strlen(db) + 2 : sizeof(null_token);     /** +2 for single quotes */
-    char dbstr[dblen + 1];
-
-    if (db && *db)
-    {
-        sprintf(dbstr, "'%s'", db);
-    }
-    else
-    {
-        strcpy(dbstr, null_token);
-    }
-
-    size_t pwlen = pw && *pw ? strlen(pw) + 2 : sizeof(null_token);     /** +2 for single quotes */
-    char pwstr[pwlen + 1];
-
     if (pw && *pw)
     {
         if (strlen(pw) == 16)
@@ -530,41 +414,15 @@ void add_mysql_user(sqlite3* handle,
         {
             pw++;
         }
-        sprintf(pwstr, "'%s'", pw);
-    }
-    else
-    {
-        strcpy(pwstr, null_token);
     }
 
-    size_t len = sizeof(insert_user_query) + strlen(user) + strlen(host) + dblen + pwlen + 1;
+    index->add_user(user, host, db, anydb, pw);
 
-    char insert_sql[len + 1];
-    sprintf(insert_sql, insert_user_query, user, host, dbstr, anydb ? "1" : "0", pwstr);
-
-    char* err;
-    if (sqlite3_exec(handle, insert_sql, NULL, NULL, &err) != SQLITE_OK)
-    {
-        MXS_ERROR("Failed to insert user: %s", err);
-        sqlite3_free(err);
-    }
-
-    MXS_INFO("Added user: %s", insert_sql);
-}
-
-static void add_database(sqlite3* handle, const char* db)
-{
-    size_t len = sizeof(insert_database_query) + strlen(db) + 1;
-    char insert_sql[len + 1];
-
-    sprintf(insert_sql, insert_database_query, db);
-
-    char* err;
-    if (sqlite3_exec(handle, insert_sql, NULL, NULL, &err) != SQLITE_OK)
-    {
-        MXS_ERROR("Failed to insert database: %s", err);
-        sqlite3_free(err);
-    }
+    MXS_INFO("Added user: %s@%s, db: %s, anydb: %s",
+             user,
+             host,
+             db && *db ? db : "NULL",
+             anydb ? "true" : "false");
 }
 
 /**
@@ -861,46 +719,40 @@ bool check_service_permissions(SERVICE* service)
     return rval;
 }
 
-/**
- * @brief Get client hostname
- *
- * Queries the DNS server for the client's hostname.
- *
- * @param ip_address      Client IP address
- * @param client_hostname Output buffer for hostname
- *
- * @return True if the hostname query was successful
- */
-static bool get_hostname(DCB* dcb, char* client_hostname, size_t size)
+bool resolve_hostname(const std::string& address, std::string* hostname)
 {
     struct addrinfo* ai = NULL, hint = {};
     hint.ai_flags = AI_ALL;
     int rc;
 
-    if ((rc = getaddrinfo(dcb->remote, NULL, &hint, &ai)) != 0)
+    if ((rc = getaddrinfo(address.c_str(), NULL, &hint, &ai)) != 0)
     {
         MXS_ERROR("Failed to obtain address for host %s, %s",
-                  dcb->remote,
+                  address.c_str(),
                   gai_strerror(rc));
         return false;
     }
 
     /* Try to lookup the domain name of the given IP-address. This is a slow
-     * i/o-operation, which will stall the entire thread. TODO: cache results
-     * if this feature is used often. */
+     * i/o-operation, which is why it is done in the hostname resolver thread. */
+    char client_hostname[MYSQL_HOST_MAXLEN] = "";
     int lookup_result = getnameinfo(ai->ai_addr,
                                     ai->ai_addrlen,
                                     client_hostname,
-                                    size,
+                                    sizeof(client_hostname) - 1,
                                     NULL,
                                     0,              // No need for the port
                                     NI_NAMEREQD);   // Text address only
     freeaddrinfo(ai);
 
-    if (lookup_result != 0 && lookup_result != EAI_NONAME)
+    if (lookup_result == 0)
+    {
+        *hostname = client_hostname;
+    }
+    else if (lookup_result != EAI_NONAME)
     {
         MXS_WARNING("Client hostname lookup failed for '%s', getnameinfo() returned: '%s'.",
-                    dcb->remote,
+                    address.c_str(),
                     gai_strerror(lookup_result));
     }
 
@@ -969,7 +821,7 @@ static bool have_mdev13453_problem(MYSQL* con, SERVER* server)
     return rval;
 }
 
-bool query_and_process_users(const char* query, MYSQL* con, sqlite3* handle, SERVICE* service, int* users)
+bool query_and_process_users(const char* query, MYSQL* con, UserIndex* index, SERVICE* service, int* users)
 {
     bool rval = false;
 
@@ -994,7 +846,7 @@ bool query_and_process_users(const char* query, MYSQL* con, sqlite3* handle, SER
                     merge_netmask(row[1]);
                 }
 
-                add_mysql_user(handle, row[0], row[1], row[2],
+                add_mysql_user(index, row[0], row[1], row[2],
                                row[3] && strcmp(row[3], "Y") == 0, row[4]);
                 (*users)++;
             }
@@ -1007,7 +859,7 @@ bool query_and_process_users(const char* query, MYSQL* con, sqlite3* handle, SER
     return rval;
 }
 
-int get_users_from_server(MYSQL* con, SERVER_REF* server_ref, SERVICE* service, SERV_LISTENER* listener)
+int get_users_from_server(MYSQL* con, SERVER_REF* server_ref, SERVICE* service, UserIndex* index)
 {
     if (server_ref->server->version_string[0] == 0)
     {
@@ -1019,11 +871,9 @@ int get_users_from_server(MYSQL* con, SERVER_REF* server_ref, SERVICE* service,
                                   service->enable_root,
                                   roles_are_available(con, service, server_ref->server));
 
-    MYSQL_AUTH* instance = (MYSQL_AUTH*)listener->auth_instance;
-    sqlite3* handle = get_handle(instance);
     int users = 0;
 
-    bool rv = query_and_process_users(query, con, handle, service, &users);
+    bool rv = query_and_process_users(query, con, index, service, &users);
 
     if (!rv && have_mdev13453_problem(con, server_ref->server))
     {
@@ -1033,7 +883,7 @@ int get_users_from_server(MYSQL* con, SERVER_REF* server_ref, SERVICE* service,
          */
         MXS_FREE(query);
         query = get_users_query(server_ref->server->version_string, 100110, service->enable_root, true);
-        rv = query_and_process_users(query, con, handle, service, &users);
+        rv = query_and_process_users(query, con, index, service, &users);
     }
 
     if (!rv)
@@ -1052,7 +902,7 @@ int get_users_from_server(MYSQL* con, SERVER_REF* server_ref, SERVICE* service,
             MYSQL_ROW row;
             while ((row = mysql_fetch_row(result)))
             {
-                add_database(handle, row[0]);
+                index->add_database(row[0]);
             }
 
             mysql_free_result(result);
@@ -1067,14 +917,14 @@ int get_users_from_server(MYSQL* con, SERVER_REF* server_ref, SERVICE* service,
 }
 
 /**
- * Load the user/passwd form mysql.user table into the service users' hashtable
- * environment.
+ * Load the user/passwd form mysql.user table into a user index
  *
- * @param service   The current service
- * @param users     The users table into which to load the users
- * @return          -1 on any error or the number of users inserted
+ * @param listener   The listener whose users are loaded
+ * @param skip_local Skip loading of users on local MaxScale services
+ * @param index      The index into which to load the users
+ * @return           -1 on any error or the number of users inserted
  */
-static int get_users(SERV_LISTENER* listener, bool skip_local)
+static int get_users(SERV_LISTENER* listener, bool skip_local, UserIndex* index)
 {
     const char* service_user = NULL;
     const char* service_passwd = NULL;
@@ -1089,11 +939,6 @@ static int get_users(SERV_LISTENER* listener, bool skip_local)
         return -1;
     }
 
-    /** Delete the old users */
-    MYSQL_AUTH* instance = (MYSQL_AUTH*)listener->auth_instance;
-    sqlite3* handle = get_handle(instance);
-    delete_mysql_users(handle);
-
     SERVER_REF* server = service->dbref;
     int total_users = -1;
     bool no_active_servers = true;
@@ -1126,7 +971,7 @@ static int get_users(SERV_LISTENER* listener, bool skip_local)
             else
             {
                 /** Successfully connected to a server */
-                int users = get_users_from_server(con, server, service, listener);
+                int users = get_users_from_server(con, server, service, index);
 
                 if (users > total_users)
                 {
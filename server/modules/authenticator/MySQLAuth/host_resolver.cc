@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "mysql_auth.h"
+
+#include <algorithm>
+
+#include <maxscale/poll.h>
+#include <maxscale/routingworker.h>
+
+#include "auth_worker.hh"
+
+namespace
+{
+
+AuthWorker resolver_worker("hostname resolver", false);
+}
+
+HostResolver::HostResolver(size_t max_size, std::chrono::seconds ttl, std::chrono::seconds negative_ttl)
+    : m_cache(max_size, ttl, negative_ttl, resolve_hostname)
+{
+}
+
+bool HostResolver::resolve(AuthClient* client, const char* address, bool async)
+{
+    {
+        // The resolver thread modifies the hostname of a parked client
+        std::lock_guard<std::mutex> guard(m_lock);
+
+        if (client->parked)
+        {
+            return false;
+        }
+        else if (client->hostname_resolved)
+        {
+            return true;
+        }
+    }
+
+    if (m_cache.lookup(address, &client->hostname) == HostnameCache::UNKNOWN)
+    {
+        if (async && park(client, address))
+        {
+            return false;
+        }
+
+        m_cache.resolve(address, &client->hostname);
+    }
+
+    client->hostname_resolved = true;
+    return true;
+}
+
+bool HostResolver::park(AuthClient* client, const char* address)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    bool parked = true;
+    std::string addr = address;
+
+    if (client->parked)
+    {
+        // Already waiting for a lookup, a client is never parked twice
+    }
+    else if (m_pending.count(addr))
+    {
+        m_coalesced++;
+    }
+    else if (resolver_worker.execute([this, addr]() {
+                                         lookup(addr);
+                                     }))
+    {
+        m_pending.insert(addr);
+    }
+    else
+    {
+        parked = false;
+    }
+
+    if (parked && !client->parked)
+    {
+        // The address is copied as the DCB might be freed while the lookup is done
+        client->address = addr;
+        client->worker_id = mxs_rworker_get_current_id();
+        client->parked = true;
+        m_parked.push_back(client);
+    }
+
+    return parked;
+}
+
+void HostResolver::forget(AuthClient* client)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_parked.erase(std::remove(m_parked.begin(), m_parked.end(), client), m_parked.end());
+    client->parked = false;
+}
+
+void HostResolver::lookup(const std::string& address)
+{
+    std::string hostname;
+    m_cache.resolve(address, &hostname);
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_pending.erase(address);
+
+        for (AuthClient* client : m_parked)
+        {
+            // The owning workers do not touch the clients while they are parked
+            if (!client->hostname_resolved && client->address == address)
+            {
+                client->hostname = hostname;
+                client->hostname_resolved = true;
+            }
+        }
+    }
+
+    mxs_rworker_broadcast(resume_clients_cb, this);
+}
+
+// static
+void HostResolver::resume_clients_cb(void* data)
+{
+    static_cast<HostResolver*>(data)->resume_clients();
+}
+
+void HostResolver::resume_clients()
+{
+    int worker_id = mxs_rworker_get_current_id();
+    std::vector<AuthClient*> clients;
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        auto it = std::stable_partition(m_parked.begin(), m_parked.end(), [&](AuthClient* client) {
+                                            return client->worker_id != worker_id
+                                            || !client->hostname_resolved;
+                                        });
+        clients.assign(it, m_parked.end());
+        m_parked.erase(it, m_parked.end());
+
+        for (AuthClient* client : clients)
+        {
+            client->parked = false;
+        }
+    }
+
+    for (AuthClient* client : clients)
+    {
+        // Process the handshake response again now that the hostname is known, ahead of
+        // anything the client sent after it
+        GWBUF* packet = client->packet;
+        client->packet = nullptr;
+        dcb_readq_prepend(client->dcb, packet);
+        poll_fake_read_event(client->dcb);
+    }
+}
+
+json_t* HostResolver::stats_json() const
+{
+    HostnameCache::Stats stats = m_cache.stats();
+    uint64_t lookups = stats.hits + stats.negative_hits + stats.misses;
+    json_t* rval = json_object();
+
+    json_object_set_new(rval, "hits", json_integer(stats.hits));
+    json_object_set_new(rval, "negative_hits", json_integer(stats.negative_hits));
+    json_object_set_new(rval, "misses", json_integer(stats.misses));
+    json_object_set_new(rval,
+                        "hit_ratio",
+                        json_real(lookups ? (double)(stats.hits + stats.negative_hits) / lookups : 0));
+    json_object_set_new(rval, "resolved", json_integer(stats.resolved));
+    json_object_set_new(rval, "failed", json_integer(stats.failed));
+    json_object_set_new(rval, "evictions", json_integer(stats.evictions));
+    json_object_set_new(rval, "entries", json_integer(stats.entries));
+    json_object_set_new(rval, "last_lookup_us", json_integer(stats.last_us));
+    json_object_set_new(rval, "max_lookup_us", json_integer(stats.max_us));
+    json_object_set_new(rval,
+                        "avg_lookup_us",
+                        json_integer(stats.resolved ? stats.total_us / stats.resolved : 0));
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    json_object_set_new(rval, "coalesced_requests", json_integer(m_coalesced));
+    json_object_set_new(rval, "waiting_clients", json_integer(m_parked.size()));
+
+    return rval;
+}
+
+// static
+void HostResolver::finish()
+{
+    resolver_worker.finish();
+}
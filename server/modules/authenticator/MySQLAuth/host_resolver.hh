@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <maxbase/jansson.h>
+
+#include "hostname_cache.hh"
+
+struct AuthClient;
+
+/**
+ * Lookups of the hostnames of the clients
+ *
+ * The hostnames are looked up by a background thread so that a slow DNS
+ * server does not block the routing workers. A client whose address is not
+ * in the cache is parked until the lookup has completed, after which its
+ * handshake response is processed again by the worker that owns the client.
+ * Clients with the same address wait for the same lookup.
+ */
+class HostResolver
+{
+public:
+    HostResolver(const HostResolver&) = delete;
+    HostResolver& operator=(const HostResolver&) = delete;
+
+    /**
+     * @param max_size     Maximum number of cached addresses
+     * @param ttl          How long a hostname is cached
+     * @param negative_ttl How long a failed lookup is cached
+     */
+    HostResolver(size_t max_size, std::chrono::seconds ttl, std::chrono::seconds negative_ttl);
+
+    /**
+     * Find the hostname of a client
+     *
+     * The hostname is stored in the client and is looked up only once for
+     * each client.
+     *
+     * @param client  The client
+     * @param address The client address
+     * @param async   Whether the client can be parked if the address is not
+     *                cached. If not, the lookup is done by the calling thread.
+     *
+     * @return True if the hostname is now known. False if the client was
+     *         parked and will be resumed once the lookup has completed.
+     */
+    bool resolve(AuthClient* client, const char* address, bool async);
+
+    /**
+     * Remove a client from the parked clients
+     *
+     * Called when a client DCB is freed.
+     *
+     * @param client The client to remove
+     */
+    void forget(AuthClient* client);
+
+    /**
+     * Get the lookup statistics
+     *
+     * @return The statistics as a JSON object
+     */
+    json_t* stats_json() const;
+
+    /**
+     * Stop the background thread
+     *
+     * After this, the lookups are done by the threads that need them.
+     */
+    static void finish();
+
+private:
+    bool park(AuthClient* client, const char* address);
+    void lookup(const std::string& address);
+    void resume_clients();
+
+    static void resume_clients_cb(void* data);
+
+    HostnameCache                   m_cache;
+    mutable std::mutex              m_lock;
+    std::unordered_set<std::string> m_pending;          /**< Addresses being looked up */
+    std::vector<AuthClient*>        m_parked;
+    uint64_t                        m_coalesced = 0;    /**< Clients that waited for a pending lookup */
+};
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "hostname_cache.hh"
+
+#include <algorithm>
+
+HostnameCache::HostnameCache(size_t max_size,
+                             std::chrono::seconds ttl,
+                             std::chrono::seconds negative_ttl,
+                             Resolver resolver)
+    : m_max_size(max_size)
+    , m_ttl(ttl)
+    , m_negative_ttl(negative_ttl)
+    , m_resolver(resolver)
+{
+}
+
+HostnameCache::Result HostnameCache::lookup(const std::string& address, std::string* hostname)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    Result rval = UNKNOWN;
+    auto it = m_index.find(address);
+
+    if (it != m_index.end())
+    {
+        if (Clock::now() < it->second->expires)
+        {
+            // Move the entry to the front, the entries at the back are evicted first
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+
+            if (it->second->found)
+            {
+                *hostname = it->second->hostname;
+                rval = FOUND;
+                m_stats.hits++;
+            }
+            else
+            {
+                hostname->clear();
+                rval = NOT_FOUND;
+                m_stats.negative_hits++;
+            }
+        }
+        else
+        {
+            m_entries.erase(it->second);
+            m_index.erase(it);
+        }
+    }
+
+    if (rval == UNKNOWN)
+    {
+        m_stats.misses++;
+    }
+
+    return rval;
+}
+
+bool HostnameCache::resolve(const std::string& address, std::string* hostname)
+{
+    auto start = Clock::now();
+    bool found = m_resolver(address, hostname);
+    int64_t duration = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_stats.resolved++;
+
+    if (!found)
+    {
+        hostname->clear();
+        m_stats.failed++;
+    }
+
+    m_stats.last_us = duration;
+    m_stats.max_us = std::max(m_stats.max_us, duration);
+    m_stats.total_us += duration;
+
+    store(address, *hostname, found);
+
+    return found;
+}
+
+HostnameCache::Stats HostnameCache::stats() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    Stats rval = m_stats;
+    rval.entries = m_entries.size();
+    return rval;
+}
+
+void HostnameCache::store(const std::string& address, const std::string& hostname, bool found)
+{
+    if (m_max_size > 0)
+    {
+        Clock::time_point expires = Clock::now() + (found ? m_ttl : m_negative_ttl);
+        auto it = m_index.find(address);
+
+        if (it != m_index.end())
+        {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            *it->second = {address, hostname, found, expires};
+        }
+        else
+        {
+            if (m_entries.size() >= m_max_size)
+            {
+                m_index.erase(m_entries.back().address);
+                m_entries.pop_back();
+                m_stats.evictions++;
+            }
+
+            m_entries.push_front({address, hostname, found, expires});
+            m_index[address] = m_entries.begin();
+        }
+    }
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+
+#include <chrono>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * A cache of the hostnames of client addresses
+ *
+ * Both successful and failed lookups are cached, each with their own time to
+ * live. When the cache is full, the least recently used address is removed.
+ * The cache can be used by multiple threads.
+ */
+class HostnameCache
+{
+public:
+    HostnameCache(const HostnameCache&) = delete;
+    HostnameCache& operator=(const HostnameCache&) = delete;
+
+    /**
+     * Function that finds the hostname of an address
+     *
+     * @param address  The address
+     * @param hostname The hostname is stored here
+     *
+     * @return True if the address has a hostname
+     */
+    typedef std::function<bool (const std::string& address, std::string* hostname)> Resolver;
+
+    enum Result
+    {
+        FOUND,      // The hostname is known
+        NOT_FOUND,  // The address is known to have no hostname
+        UNKNOWN     // The address is not in the cache
+    };
+
+    struct Stats
+    {
+        uint64_t hits = 0;          // Lookups that found a hostname in the cache
+        uint64_t negative_hits = 0; // Lookups that found a failed lookup in the cache
+        uint64_t misses = 0;        // Lookups of addresses that were not in the cache
+        uint64_t resolved = 0;      // Addresses given to the resolver
+        uint64_t failed = 0;        // Addresses for which the resolver found no hostname
+        uint64_t evictions = 0;     // Addresses removed to make room for new ones
+        uint64_t entries = 0;       // Addresses currently in the cache
+        int64_t  last_us = 0;       // Duration of the latest resolver call
+        int64_t  max_us = 0;        // Duration of the longest resolver call
+        int64_t  total_us = 0;      // Total duration of all resolver calls
+    };
+
+    /**
+     * Create a new cache
+     *
+     * @param max_size     Maximum number of addresses in the cache, 0 disables caching
+     * @param ttl          How long a hostname is cached
+     * @param negative_ttl How long a failed lookup is cached
+     * @param resolver     Function used for the lookups that are not in the cache
+     */
+    HostnameCache(size_t max_size,
+                  std::chrono::seconds ttl,
+                  std::chrono::seconds negative_ttl,
+                  Resolver resolver);
+
+    /**
+     * Look up an address from the cache
+     *
+     * @param address  The client address
+     * @param hostname The hostname is stored here if it is found
+     *
+     * @return Whether the address was in the cache and whether it has a hostname
+     */
+    Result lookup(const std::string& address, std::string* hostname);
+
+    /**
+     * Find the hostname with the resolver and store the result in the cache
+     *
+     * This does not check whether the address is already in the cache.
+     *
+     * @param address  The client address
+     * @param hostname The hostname is stored here, an empty string if there is none
+     *
+     * @return True if the address has a hostname
+     */
+    bool resolve(const std::string& address, std::string* hostname);
+
+    /**
+     * Get the statistics of the cache
+     *
+     * @return The statistics
+     */
+    Stats stats() const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry
+    {
+        std::string       address;
+        std::string       hostname;
+        bool              found;
+        Clock::time_point expires;
+    };
+
+    typedef std::list<Entry> Entries;
+
+    void store(const std::string& address, const std::string& hostname, bool found);
+
+    mutable std::mutex                                    m_lock;
+    size_t                                                m_max_size;
+    std::chrono::seconds                                  m_ttl;
+    std::chrono::seconds                                  m_negative_ttl;
+    Resolver                                              m_resolver;
+    Entries                                               m_entries;    // Most recently used first
+    std::unordered_map<std::string, Entries::iterator>    m_index;
+    Stats                                                 m_stats;
+};
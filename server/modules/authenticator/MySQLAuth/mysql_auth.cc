@@ -31,6 +31,7 @@
 #include <maxscale/authenticator.h>
 #include <maxscale/alloc.h>
 #include <maxscale/event.hh>
+#include <maxscale/modulecmd.h>
 #include <maxscale/poll.h>
 #include <maxscale/paths.h>
 #include <maxscale/secrets.h>
@@ -45,6 +46,9 @@ static void  mysql_auth_free_client_data(DCB* dcb);
 static int   mysql_auth_load_users(SERV_LISTENER* port);
 static void* mysql_auth_create(void* instance);
 static void  mysql_auth_destroy(void* data);
+static void  mysql_auth_thread_finish();
+static bool  mysql_auth_refresh_stats(const MODULECMD_ARG* args, json_t** output);
+static bool  mysql_auth_hostname_stats(const MODULECMD_ARG* args, json_t** output);
 
 static int combined_auth_check(DCB* dcb,
                                uint8_t* auth_token,
@@ -82,15 +86,36 @@ extern "C"
  */
     MXS_MODULE* MXS_CREATE_MODULE()
     {
+        static modulecmd_arg_type_t args[] =
+        {
+            {MODULECMD_ARG_SERVICE, "Service to inspect"}
+        };
+
+        modulecmd_register_command(MXS_MODULE_NAME,
+                                   "refresh_stats",
+                                   MODULECMD_TYPE_PASSIVE,
+                                   mysql_auth_refresh_stats,
+                                   1,
+                                   args,
+                                   "Show statistics of the user refreshes of a service");
+
+        modulecmd_register_command(MXS_MODULE_NAME,
+                                   "hostname_stats",
+                                   MODULECMD_TYPE_PASSIVE,
+                                   mysql_auth_hostname_stats,
+                                   1,
+                                   args,
+                                   "Show statistics of the client hostname lookups of a service");
+
         static MXS_AUTHENTICATOR MyObject =
         {
             mysql_auth_init,                    /* Initialize the authenticator */
-            NULL,                               /* Create entry point */
+            mysql_auth_create,                  /* Create entry point */
             mysql_auth_set_protocol_data,       /* Extract data into structure   */
             mysql_auth_is_client_ssl_capable,   /* Check if client supports SSL  */
             mysql_auth_authenticate,            /* Authenticate user credentials */
             mysql_auth_free_client_data,        /* Free the client data held in DCB */
-            NULL,                               /* Destroy entry point */
+            mysql_auth_destroy,                 /* Destroy entry point */
             mysql_auth_load_users,              /* Load users from backend databases */
             mysql_auth_diagnostic,
             mysql_auth_diagnostic_json,
@@ -109,7 +134,7 @@ extern "C"
             NULL,   /* Process init. */
             NULL,   /* Process finish. */
             NULL,   /* Thread init. */
-            NULL,   /* Thread finish. */
+            mysql_auth_thread_finish,   /* Thread finish. */
             {
                 {MXS_END_MODULE_PARAMS}
             }
@@ -119,45 +144,6 @@ extern "C"
     }
 }
 
-static bool open_instance_database(const char* path, sqlite3** handle)
-{
-    int rc = sqlite3_open_v2(path, handle, db_flags, NULL);
-
-    if (rc != SQLITE_OK)
-    {
-        MXS_ERROR("Failed to open SQLite3 handle: %d", rc);
-        return false;
-    }
-
-    char* err;
-
-    if (sqlite3_exec(*handle, users_create_sql, NULL, NULL, &err) != SQLITE_OK
-        || sqlite3_exec(*handle, databases_create_sql, NULL, NULL, &err) != SQLITE_OK
-        || sqlite3_exec(*handle, pragma_sql, NULL, NULL, &err) != SQLITE_OK)
-    {
-        MXS_ERROR("Failed to create database: %s", err);
-        sqlite3_free(err);
-        sqlite3_close_v2(*handle);
-        return false;
-    }
-
-    return true;
-}
-
-sqlite3* get_handle(MYSQL_AUTH* instance)
-{
-    int i = mxs_rworker_get_current_id();
-    mxb_assert(i >= 0);
-
-    if (instance->handles[i] == NULL)
-    {
-        MXB_AT_DEBUG(bool rval = ) open_instance_database(":memory:", &instance->handles[i]);
-        mxb_assert(rval);
-    }
-
-    return instance->handles[i];
-}
-
 /**
  * @brief Check if service permissions should be checked
  *
@@ -171,6 +157,33 @@ static bool should_check_permissions(MYSQL_AUTH* instance)
     return instance->check_permissions;
 }
 
+/**
+ * @brief Parse a hostname cache option
+ *
+ * @param name  Option name
+ * @param value Option value
+ * @param dest  Where the value is stored
+ * @return True if the value is a non-negative integer
+ */
+static bool parse_cache_option(const char* name, const char* value, long* dest)
+{
+    char* end;
+    long number = strtol(value, &end, 10);
+    bool rval = false;
+
+    if (*value && *end == '\0' && number >= 0)
+    {
+        *dest = number;
+        rval = true;
+    }
+    else
+    {
+        MXS_ERROR("Invalid value for authenticator option '%s': %s", name, value);
+    }
+
+    return rval;
+}
+
 /**
  * @brief Initialize the authenticator instance
  *
@@ -179,17 +192,14 @@ static bool should_check_permissions(MYSQL_AUTH* instance)
  */
 static void* mysql_auth_init(char** options)
 {
-    MYSQL_AUTH* instance = static_cast<MYSQL_AUTH*>(MXS_MALLOC(sizeof(*instance)));
+    MYSQL_AUTH* instance = new(std::nothrow) MYSQL_AUTH;
 
-    if (instance
-        && (instance->handles = static_cast<sqlite3**>(MXS_CALLOC(config_threadcount(), sizeof(sqlite3*)))))
+    if (instance)
     {
         bool error = false;
-        instance->cache_dir = NULL;
-        instance->inject_service_user = true;
-        instance->skip_auth = false;
-        instance->check_permissions = true;
-        instance->lower_case_table_names = false;
+        long cache_size = DEFAULT_HOSTNAME_CACHE_SIZE;
+        long cache_ttl = DEFAULT_HOSTNAME_CACHE_TTL;
+        long cache_negative_ttl = DEFAULT_HOSTNAME_CACHE_NEGATIVE_TTL;
 
         for (int i = 0; options[i]; i++)
         {
@@ -219,6 +229,27 @@ static void* mysql_auth_init(char** options)
                 {
                     instance->lower_case_table_names = config_truth_value(value);
                 }
+                else if (strcmp(options[i], "hostname_cache_size") == 0)
+                {
+                    if (!parse_cache_option(options[i], value, &cache_size))
+                    {
+                        error = true;
+                    }
+                }
+                else if (strcmp(options[i], "hostname_cache_ttl") == 0)
+                {
+                    if (!parse_cache_option(options[i], value, &cache_ttl))
+                    {
+                        error = true;
+                    }
+                }
+                else if (strcmp(options[i], "hostname_cache_negative_ttl") == 0)
+                {
+                    if (!parse_cache_option(options[i], value, &cache_negative_ttl))
+                    {
+                        error = true;
+                    }
+                }
                 else
                 {
                     MXS_ERROR("Unknown authenticator option: %s", options[i]);
@@ -232,19 +263,21 @@ static void* mysql_auth_init(char** options)
             }
         }
 
+        if (!error)
+        {
+            instance->resolver.reset(new(std::nothrow) HostResolver(cache_size,
+                                                                    std::chrono::seconds(cache_ttl),
+                                                                    std::chrono::seconds(cache_negative_ttl)));
+            error = !instance->resolver;
+        }
+
         if (error)
         {
             MXS_FREE(instance->cache_dir);
-            MXS_FREE(instance->handles);
-            MXS_FREE(instance);
+            delete instance;
             instance = NULL;
         }
     }
-    else if (instance)
-    {
-        MXS_FREE(instance);
-        instance = NULL;
-    }
 
     return instance;
 }
@@ -277,7 +310,9 @@ static bool is_localhost_address(struct sockaddr_storage* addr)
  * @brief Authenticates a MySQL user who is a client to MaxScale.
  *
  * First call the SSL authentication function. Call other functions to validate
- * the user, reloading the user data if the first attempt fails.
+ * the user, reloading the user data if the first attempt fails. The users are
+ * reloaded in the background and the client is parked until that is done,
+ * after which its handshake response is processed again.
  *
  * @param dcb Request handler DCB connected to the client
  * @return Authentication status
@@ -287,28 +322,43 @@ static int mysql_auth_authenticate(DCB* dcb)
 {
     int auth_ret = MXS_AUTH_SSL_COMPLETE;
     MYSQL_session* client_data = (MYSQL_session*)dcb->data;
-    if (*client_data->user)
+
+    if (((AuthClient*)dcb->authenticator_data)->parked)
+    {
+        // Still waiting for a lookup or a refresh, the data was put back into the read queue
+        auth_ret = MXS_AUTH_INCOMPLETE;
+    }
+    else if (*client_data->user)
     {
         MXS_DEBUG("Receiving connection from '%s' to database '%s'.",
                   client_data->user,
                   client_data->db);
 
         MYSQL_AUTH* instance = (MYSQL_AUTH*)dcb->listener->auth_instance;
+        AuthClient* client = (AuthClient*)dcb->authenticator_data;
         MySQLProtocol* protocol = DCB_PROTOCOL(dcb, MySQLProtocol);
         auth_ret = validate_mysql_user(instance,
                                        dcb,
                                        client_data,
                                        protocol->scramble,
-                                       sizeof(protocol->scramble));
+                                       sizeof(protocol->scramble),
+                                       client->packet != NULL);
+
+        if (auth_ret != MXS_AUTH_SUCCEEDED && auth_ret != MXS_AUTH_INCOMPLETE && !client->refreshed)
+        {
+            // The users are refreshed at most once for each client
+            client->refreshed = true;
+
+            if (client->packet && instance->refresh.request(dcb->listener, client))
+            {
+                auth_ret = MXS_AUTH_INCOMPLETE;
+            }
+        }
 
-        if (auth_ret != MXS_AUTH_SUCCEEDED
-            && service_refresh_users(dcb->service) == 0)
+        if (auth_ret != MXS_AUTH_INCOMPLETE)
         {
-            auth_ret = validate_mysql_user(instance,
-                                           dcb,
-                                           client_data,
-                                           protocol->scramble,
-                                           sizeof(protocol->scramble));
+            gwbuf_free(client->packet);
+            client->packet = NULL;
         }
 
         /* on successful authentication, set user into dcb field */
@@ -318,7 +368,7 @@ static int mysql_auth_authenticate(DCB* dcb)
             dcb->user = MXS_STRDUP_A(client_data->user);
             /** Send an OK packet to the client */
         }
-        else if (dcb->service->log_auth_warnings)
+        else if (auth_ret != MXS_AUTH_INCOMPLETE && dcb->service->log_auth_warnings)
         {
             // The default failure is a `User not found` one
             char extra[256] = "User not found.";
@@ -397,6 +447,22 @@ static bool mysql_auth_set_protocol_data(DCB* dcb, GWBUF* buf)
 
     client_data = (MYSQL_session*)dcb->data;
 
+    AuthClient* client = (AuthClient*)dcb->authenticator_data;
+
+    if (client->parked)
+    {
+        /* The client sent more data before the parked handshake response was processed. The
+         * kept packet and the session data must not change until the client is resumed so the
+         * data is put back into the read queue where it is processed after the kept packet. */
+        dcb_readq_prepend(dcb, gwbuf_clone(buf));
+        return true;
+    }
+
+    /* Keep the packet in case it has to be processed again after the users are refreshed */
+    client->dcb = dcb;
+    gwbuf_free(client->packet);
+    client->packet = gwbuf_clone(buf);
+
     client_auth_packet_size = gwbuf_length(buf);
 
     /* For clients supporting CLIENT_PROTOCOL_41
@@ -511,6 +577,41 @@ static bool mysql_auth_set_client_data(MYSQL_session* client_data,
     return true;
 }
 
+/**
+ * @brief Create the authenticator data of a client
+ *
+ * @param instance Authenticator instance
+ * @return New client data or NULL on memory allocation failure
+ */
+static void* mysql_auth_create(void* instance)
+{
+    return new(std::nothrow) AuthClient((MYSQL_AUTH*)instance);
+}
+
+/**
+ * @brief Free the authenticator data of a client
+ *
+ * @param data Client data created by mysql_auth_create
+ */
+static void mysql_auth_destroy(void* data)
+{
+    AuthClient* client = (AuthClient*)data;
+
+    client->instance->refresh.forget(client);
+    client->instance->resolver->forget(client);
+    gwbuf_free(client->packet);
+    delete client;
+}
+
+/**
+ * @brief Stop the background threads when the routing workers stop
+ */
+static void mysql_auth_thread_finish()
+{
+    UserRefresh::finish();
+    HostResolver::finish();
+}
+
 /**
  * @brief Determine whether the client is SSL capable
  *
@@ -547,12 +648,13 @@ static void mysql_auth_free_client_data(DCB* dcb)
 }
 
 /**
- * @brief Inject the service user into the cache
+ * @brief Inject the service user into the users
  *
- * @param port Service listener
+ * @param port  Service listener
+ * @param index The index where the user is added
  * @return True on success, false on error
  */
-static bool add_service_user(SERV_LISTENER* port)
+static bool add_service_user(SERV_LISTENER* port, UserIndex* index)
 {
     const char* user = NULL;
     const char* password = NULL;
@@ -568,10 +670,8 @@ static bool add_service_user(SERV_LISTENER* port)
 
         if (newpw)
         {
-            MYSQL_AUTH* inst = (MYSQL_AUTH*)port->auth_instance;
-            sqlite3* handle = get_handle(inst);
-            add_mysql_user(handle, user, "%", "", "Y", newpw);
-            add_mysql_user(handle, user, "localhost", "", "Y", newpw);
+            add_mysql_user(index, user, "%", "", true, newpw);
+            add_mysql_user(index, user, "localhost", "", true, newpw);
             MXS_FREE(newpw);
             rval = true;
         }
@@ -626,7 +726,9 @@ static int mysql_auth_load_users(SERV_LISTENER* port)
         first_load = true;
     }
 
-    int loaded = replace_mysql_users(port, first_load);
+    // The users are loaded into a new index which replaces the old one on all workers
+    auto index = std::make_shared<UserIndex>();
+    int loaded = load_mysql_users(port, first_load, index.get());
     bool injected = false;
 
     if (loaded <= 0)
@@ -644,7 +746,7 @@ static int mysql_auth_load_users(SERV_LISTENER* port)
         {
             /** Inject the service user as a 'backup' user that's available
              * if loading of the users fails */
-            if (!add_service_user(port))
+            if (!add_service_user(port, index.get()))
             {
                 MXS_ERROR("[%s] Failed to inject service user.", port->service->name);
             }
@@ -655,6 +757,8 @@ static int mysql_auth_load_users(SERV_LISTENER* port)
         }
     }
 
+    instance->index.assign(index);
+
     if (injected)
     {
         if (service_has_servers(service))
@@ -698,11 +802,11 @@ int mysql_auth_reauthenticate(DCB* dcb,
     temp.auth_token_len = token_len;
 
     MYSQL_AUTH* instance = (MYSQL_AUTH*)dcb->listener->auth_instance;
-    int rc = validate_mysql_user(instance, dcb, &temp, scramble, scramble_len);
+    int rc = validate_mysql_user(instance, dcb, &temp, scramble, scramble_len, false);
 
     if (rc != MXS_AUTH_SUCCEEDED && service_refresh_users(dcb->service) == 0)
     {
-        rc = validate_mysql_user(instance, dcb, &temp, scramble, scramble_len);
+        rc = validate_mysql_user(instance, dcb, &temp, scramble, scramble_len, false);
     }
 
     if (rc == MXS_AUTH_SUCCEEDED)
@@ -714,40 +818,14 @@ int mysql_auth_reauthenticate(DCB* dcb,
     return rval;
 }
 
-int diag_cb(void* data, int columns, char** row, char** field_names)
-{
-    DCB* dcb = (DCB*)data;
-    dcb_printf(dcb, "%s@%s ", row[0], row[1]);
-    return 0;
-}
-
 void mysql_auth_diagnostic(DCB* dcb, SERV_LISTENER* port)
 {
     MYSQL_AUTH* instance = (MYSQL_AUTH*)port->auth_instance;
-    sqlite3* handle = get_handle(instance);
-    char* err;
-
-    if (sqlite3_exec(handle,
-                     "SELECT user, host FROM " MYSQLAUTH_USERS_TABLE_NAME,
-                     diag_cb,
-                     dcb,
-                     &err) != SQLITE_OK)
-    {
-        dcb_printf(dcb, "Could not access users: %s", err);
-        MXS_ERROR("Could not access users: %s", err);
-        sqlite3_free(err);
-    }
-}
+    const SUserIndex& index = instance->index;
 
-int diag_cb_json(void* data, int columns, char** row, char** field_names)
-{
-    json_t* obj = json_object();
-    json_object_set_new(obj, "user", json_string(row[0]));
-    json_object_set_new(obj, "host", json_string(row[1]));
-
-    json_t* arr = (json_t*)data;
-    json_array_append_new(arr, obj);
-    return 0;
+    index->for_each([dcb](const std::string& user, const std::string& host) {
+                        dcb_printf(dcb, "%s@%s ", user.c_str(), host.c_str());
+                    });
 }
 
 json_t* mysql_auth_diagnostic_json(const SERV_LISTENER* port)
@@ -755,18 +833,70 @@ json_t* mysql_auth_diagnostic_json(const SERV_LISTENER* port)
     json_t* rval = json_array();
 
     MYSQL_AUTH* instance = (MYSQL_AUTH*)port->auth_instance;
-    char* err;
-    sqlite3* handle = get_handle(instance);
-
-    if (sqlite3_exec(handle,
-                     "SELECT user, host FROM " MYSQLAUTH_USERS_TABLE_NAME,
-                     diag_cb_json,
-                     rval,
-                     &err) != SQLITE_OK)
+    const SUserIndex& index = instance->index;
+
+    index->for_each([rval](const std::string& user, const std::string& host) {
+                        json_t* obj = json_object();
+                        json_object_set_new(obj, "user", json_string(user.c_str()));
+                        json_object_set_new(obj, "host", json_string(host.c_str()));
+                        json_array_append_new(rval, obj);
+                    });
+
+    return rval;
+}
+
+/**
+ * @brief Collect statistics of the listeners of a service that use this authenticator
+ *
+ * @param service The service
+ * @param func    Function that returns the statistics of an authenticator instance
+ * @return The statistics of each listener
+ */
+template<class Func>
+static json_t* listener_stats(SERVICE* service, Func func)
+{
+    json_t* rval = json_object();
+    LISTENER_ITERATOR iter;
+
+    for (SERV_LISTENER* listener = listener_iterator_init(service, &iter);
+         listener; listener = listener_iterator_next(&iter))
     {
-        MXS_ERROR("Failed to print users: %s", err);
-        sqlite3_free(err);
+        if (listener_is_active(listener) && listener->listener
+            && listener->listener->authfunc.authenticate == mysql_auth_authenticate)
+        {
+            json_object_set_new(rval, listener->name, func((MYSQL_AUTH*)listener->auth_instance));
+        }
     }
 
     return rval;
 }
+
+/**
+ * @brief Show the user refresh statistics of the listeners of a service
+ *
+ * @param args   The service
+ * @param output The statistics of each listener that uses this authenticator
+ * @return Always true
+ */
+static bool mysql_auth_refresh_stats(const MODULECMD_ARG* args, json_t** output)
+{
+    *output = listener_stats(args->argv[0].value.service, [](MYSQL_AUTH* instance) {
+                                 return instance->refresh.stats_json();
+                             });
+    return true;
+}
+
+/**
+ * @brief Show the hostname lookup statistics of the listeners of a service
+ *
+ * @param args   The service
+ * @param output The statistics of each listener that uses this authenticator
+ * @return Always true
+ */
+static bool mysql_auth_hostname_stats(const MODULECMD_ARG* args, json_t** output)
+{
+    *output = listener_stats(args->argv[0].value.service, [](MYSQL_AUTH* instance) {
+                                 return instance->resolver->stats_json();
+                             });
+    return true;
+}
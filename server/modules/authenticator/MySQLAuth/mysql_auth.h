@@ -33,93 +33,63 @@
 #include <maxscale/dcb.h>
 #include <maxscale/buffer.h>
 #include <maxscale/service.h>
-#include <maxscale/sqlite3.h>
+#include <maxscale/routingworker.hh>
 #include <maxscale/protocol/mysql.h>
 
+#include <memory>
+#include <string>
+
+#include "host_resolver.hh"
+#include "user_index.hh"
+#include "user_refresh.hh"
+
 MXS_BEGIN_DECLS
 
 /** Cache directory and file names */
 static const char DBUSERS_DIR[] = "cache";
 static const char DBUSERS_FILE[] = "dbusers.db";
 
-/** The table name where we store the users */
-#define MYSQLAUTH_USERS_TABLE_NAME "mysqlauth_users"
-
-/** The table name where we store the users */
-#define MYSQLAUTH_DATABASES_TABLE_NAME "mysqlauth_databases"
-
-/** CREATE TABLE statement for the in-memory users table */
-static const char users_create_sql[] =
-    "CREATE TABLE IF NOT EXISTS " MYSQLAUTH_USERS_TABLE_NAME
-    "(user varchar(255), host varchar(255), db varchar(255), anydb boolean, password text)";
-
-/** CREATE TABLE statement for the in-memory databases table */
-static const char databases_create_sql[] =
-    "CREATE TABLE IF NOT EXISTS " MYSQLAUTH_DATABASES_TABLE_NAME "(db varchar(255))";
-
-/** PRAGMA configuration options for SQLite */
-static const char pragma_sql[] = "PRAGMA JOURNAL_MODE=NONE";
-
-/** Query that checks if there's a grant for the user being authenticated */
-static const char mysqlauth_validate_user_query[] =
-    "SELECT password FROM " MYSQLAUTH_USERS_TABLE_NAME
-    " WHERE user = '%s' AND ( '%s' = host OR '%s' LIKE host) AND (anydb = '1' OR '%s' = '' OR '%s' LIKE db)"
-    " LIMIT 1";
-
-/** Query that checks if there's a grant for the user being authenticated */
-static const char mysqlauth_validate_user_query_lower[] =
-    "SELECT password FROM " MYSQLAUTH_USERS_TABLE_NAME
-    " WHERE user = '%s' AND ( '%s' = host OR '%s' LIKE host) AND (anydb = '1' OR '%s' = '' OR LOWER('%s') LIKE LOWER(db))"
-    " LIMIT 1";
-
-/** Query that only checks if there's a matching user */
-static const char mysqlauth_skip_auth_query[] =
-    "SELECT password FROM " MYSQLAUTH_USERS_TABLE_NAME
-    " WHERE user = '%s' AND (anydb = '1' OR '%s' = '' OR '%s' LIKE db)"
-    " LIMIT 1";
-
-/** Query that checks that the database exists */
-static const char mysqlauth_validate_database_query[] =
-    "SELECT * FROM " MYSQLAUTH_DATABASES_TABLE_NAME " WHERE db = '%s' LIMIT 1";
-
-/** Delete query used to clean up the database before loading new users */
-static const char delete_users_query[] = "DELETE FROM " MYSQLAUTH_USERS_TABLE_NAME;
-
-/** Delete query used to clean up the database before loading new users */
-static const char delete_databases_query[] = "DELETE FROM " MYSQLAUTH_DATABASES_TABLE_NAME;
-
-/** The insert query template which adds users to the mysqlauth_users table */
-static const char insert_user_query[] =
-    "INSERT OR REPLACE INTO " MYSQLAUTH_USERS_TABLE_NAME " VALUES ('%s', '%s', %s, %s, %s)";
-
-/** The insert query template which adds the databases to the table */
-static const char insert_database_query[] =
-    "INSERT OR REPLACE INTO " MYSQLAUTH_DATABASES_TABLE_NAME " VALUES ('%s')";
-
-static const char dump_users_query[] =
-    "SELECT user, host, db, anydb, password FROM " MYSQLAUTH_USERS_TABLE_NAME;
-
-static const char dump_databases_query[] =
-    "SELECT db FROM " MYSQLAUTH_DATABASES_TABLE_NAME;
-
-/** Used for NULL value creation in the INSERT query */
-static const char null_token[] = "NULL";
-
-/** Flags for sqlite3_open_v2() */
-static int db_flags = SQLITE_OPEN_READWRITE
-    | SQLITE_OPEN_CREATE
-    | SQLITE_OPEN_NOMUTEX;
-
 typedef struct mysql_auth
 {
-    sqlite3** handles;              /**< SQLite3 database handle */
-    char*     cache_dir;            /**< Custom cache directory location */
-    bool      inject_service_user;  /**< Inject the service user into the list of users */
-    bool      skip_auth;            /**< Authentication will always be successful */
-    bool      check_permissions;
-    bool      lower_case_table_names;   /**< Disable database case-sensitivity */
+    mxs::rworker_local<SUserIndex> index {std::make_shared<UserIndex>()};   /**< The loaded users */
+    char* cache_dir = nullptr;              /**< Custom cache directory location */
+    bool  inject_service_user = true;       /**< Inject the service user into the list of users */
+    bool  skip_auth = false;                /**< Authentication will always be successful */
+    bool  check_permissions = true;
+    bool  lower_case_table_names = false;   /**< Disable database case-sensitivity */
+    UserRefresh refresh;                    /**< Background refreshes of the users */
+    std::unique_ptr<HostResolver> resolver; /**< Hostname lookups of the clients */
 } MYSQL_AUTH;
 
+/** Default size and times to live of the hostname cache */
+#define DEFAULT_HOSTNAME_CACHE_SIZE         10000
+#define DEFAULT_HOSTNAME_CACHE_TTL          300
+#define DEFAULT_HOSTNAME_CACHE_NEGATIVE_TTL 60
+
+/**
+ * The authenticator data of a client DCB
+ */
+struct AuthClient
+{
+    AuthClient(MYSQL_AUTH* instance)
+        : instance(instance)
+    {
+    }
+
+    MYSQL_AUTH* instance;
+    DCB*        dcb = nullptr;
+    GWBUF*      packet = nullptr;           /**< The latest handshake packet, replayed when resumed */
+    int         worker_id = -1;             /**< The worker where the client is parked */
+    uint64_t    ticket = 0;                 /**< The refresh the parked client waits for */
+    bool        refreshed = false;          /**< Whether the users were already refreshed for this client */
+    std::string address;                    /**< The address of a client parked for a hostname lookup */
+    std::string hostname;                   /**< Hostname of the client, empty if it has none */
+    bool        hostname_resolved = false;  /**< Whether the hostname has been looked up */
+    bool        parked = false;             /**< Whether the client waits for a lookup or a refresh. Only
+                                             * modified by the owning worker, under the lock of the
+                                             * object where the client is parked. */
+};
+
 /**
  * MySQL user and host data structure
  */
@@ -133,24 +103,16 @@ typedef struct mysql_user_host_key
 } MYSQL_USER_HOST;
 
 /**
- * @brief Get the thread-specific SQLite handle
- *
- * @param instance Authenticator instance
- *
- * @return The thread-specific handle
- */
-sqlite3* get_handle(MYSQL_AUTH* instance);
-
-/**
- * @brief Add new MySQL user to the internal user database
+ * @brief Add new MySQL user to a user index
  *
- * @param handle Database handle
+ * @param index  The index where the user is added
  * @param user   Username
  * @param host   Host
  * @param db     Database
  * @param anydb  Global access to databases
+ * @param pw     Password hash
  */
-void add_mysql_user(sqlite3* handle,
+void add_mysql_user(UserIndex* index,
                     const char* user,
                     const char* host,
                     const char* db,
@@ -172,32 +134,15 @@ void add_mysql_user(sqlite3* handle,
 bool check_service_permissions(SERVICE* service);
 
 /**
- * Load users from persisted database
- *
- * @param dest Open SQLite handle where contents are loaded
- *
- * @return True on success
- */
-bool dbusers_load(sqlite3* handle, const char* filename);
-
-/**
- * Save users to persisted database
+ * Load the database users
  *
- * @param dest Open SQLite handle where contents are stored
- *
- * @return True on success
- */
-bool dbusers_save(sqlite3* src, const char* filename);
-
-/**
- * Reload and replace the currently loaded database users
- *
- * @param service    The current service
+ * @param listener   The listener whose users are loaded
  * @param skip_local Skip loading of users on local MaxScale services
+ * @param index      The index where the users are added
  *
  * @return -1 on any error or the number of users inserted (0 means no users at all)
  */
-int replace_mysql_users(SERV_LISTENER* listener, bool skip_local);
+int load_mysql_users(SERV_LISTENER* listener, bool skip_local, UserIndex* index);
 
 /**
  * @brief Verify the user has access to the database
@@ -207,13 +152,28 @@ int replace_mysql_users(SERV_LISTENER* listener, bool skip_local);
  * @param session      Shared MySQL session
  * @param scramble     The scramble sent to the client in the initial handshake
  * @param scramble_len Length of @c scramble
+ * @param async        Whether the client can be parked while its hostname is looked up
  *
- * @return MXS_AUTH_SUCCEEDED if the user has access to the database
+ * @return MXS_AUTH_SUCCEEDED if the user has access to the database or
+ * MXS_AUTH_INCOMPLETE if the client was parked
  */
 int validate_mysql_user(MYSQL_AUTH* instance,
                         DCB* dcb,
                         MYSQL_session* session,
                         uint8_t* scramble,
-                        size_t   scramble_len);
+                        size_t   scramble_len,
+                        bool     async);
+
+/**
+ * @brief Find the hostname of an address with a DNS lookup
+ *
+ * This is a slow operation that blocks the calling thread.
+ *
+ * @param address  The address
+ * @param hostname The hostname is stored here
+ *
+ * @return True if the address has a hostname
+ */
+bool resolve_hostname(const std::string& address, std::string* hostname);
 
 MXS_END_DECLS
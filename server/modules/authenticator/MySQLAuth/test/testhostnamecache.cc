@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+/**
+ * Tests the hostname cache with a resolver that answers from a table instead
+ * of using DNS.
+ */
+
+// To ensure that the asserts are checked also when building in non-debug mode.
+#if !defined (SS_DEBUG)
+#define SS_DEBUG
+#endif
+
+#include "../hostname_cache.hh"
+
+#include <atomic>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <maxbase/assert.h>
+#include <maxscale/log.h>
+
+using namespace std;
+using std::chrono::seconds;
+
+namespace
+{
+
+/**
+ * A stand-in for the DNS lookups
+ */
+class LocalResolver
+{
+public:
+    LocalResolver()
+        : m_hosts({{"192.168.0.1", "db1.example.com"},
+                   {"192.168.0.2", "db2.example.com"},
+                   {"192.168.0.3", "db3.example.com"},
+                   {"::1", "localhost"}})
+    {
+    }
+
+    bool operator()(const string& address, string* hostname)
+    {
+        m_calls++;
+        auto it = m_hosts.find(address);
+        bool rval = false;
+
+        if (it != m_hosts.end())
+        {
+            *hostname = it->second;
+            rval = true;
+        }
+
+        return rval;
+    }
+
+    int calls() const
+    {
+        return m_calls;
+    }
+
+private:
+    map<string, string> m_hosts;
+    atomic<int>         m_calls {0};
+};
+
+/**
+ * Look up an address the way the authenticator does
+ */
+HostnameCache::Result find(HostnameCache& cache, const string& address, string* hostname)
+{
+    HostnameCache::Result rval = cache.lookup(address, hostname);
+
+    if (rval == HostnameCache::UNKNOWN)
+    {
+        cache.resolve(address, hostname);
+    }
+
+    return rval;
+}
+
+void test_positive_and_negative()
+{
+    LocalResolver resolver;
+    HostnameCache cache(10, seconds(300), seconds(60), std::ref(resolver));
+    string hostname;
+
+    mxb_assert_message(find(cache, "192.168.0.1", &hostname) == HostnameCache::UNKNOWN,
+                       "first lookup is a miss");
+    mxb_assert_message(hostname == "db1.example.com", "hostname is resolved");
+    mxb_assert_message(find(cache, "192.168.0.1", &hostname) == HostnameCache::FOUND,
+                       "second lookup is a hit");
+    mxb_assert_message(hostname == "db1.example.com", "hostname is cached");
+
+    hostname = "garbage";
+    mxb_assert_message(find(cache, "10.0.0.1", &hostname) == HostnameCache::UNKNOWN,
+                       "unresolvable address is a miss");
+    mxb_assert_message(hostname.empty(), "unresolvable address has no hostname");
+
+    hostname = "garbage";
+    mxb_assert_message(find(cache, "10.0.0.1", &hostname) == HostnameCache::NOT_FOUND,
+                       "failed lookup is cached");
+    mxb_assert_message(hostname.empty(), "cached failure has no hostname");
+
+    mxb_assert_message(resolver.calls() == 2, "resolver is called once per address");
+
+    HostnameCache::Stats stats = cache.stats();
+    mxb_assert_message(stats.hits == 1, "one hit");
+    mxb_assert_message(stats.negative_hits == 1, "one negative hit");
+    mxb_assert_message(stats.misses == 2, "two misses");
+    mxb_assert_message(stats.resolved == 2, "two resolved");
+    mxb_assert_message(stats.failed == 1, "one failed");
+    mxb_assert_message(stats.entries == 2, "two entries");
+}
+
+void test_expiry()
+{
+    LocalResolver resolver;
+    string hostname;
+
+    // Cache the hostnames but not the failures
+    HostnameCache cache(10, seconds(300), seconds(0), std::ref(resolver));
+
+    find(cache, "192.168.0.1", &hostname);
+    find(cache, "10.0.0.1", &hostname);
+    mxb_assert_message(find(cache, "192.168.0.1", &hostname) == HostnameCache::FOUND,
+                       "hostname has not expired");
+    mxb_assert_message(find(cache, "10.0.0.1", &hostname) == HostnameCache::UNKNOWN,
+                       "failed lookup has expired");
+    mxb_assert_message(resolver.calls() == 3, "expired address is resolved again");
+
+    // Nothing is cached
+    HostnameCache disabled(0, seconds(300), seconds(60), std::ref(resolver));
+    find(disabled, "192.168.0.1", &hostname);
+    mxb_assert_message(find(disabled, "192.168.0.1", &hostname) == HostnameCache::UNKNOWN,
+                       "disabled cache does not store hostnames");
+    mxb_assert_message(disabled.stats().entries == 0, "disabled cache is empty");
+}
+
+void test_eviction()
+{
+    LocalResolver resolver;
+    HostnameCache cache(2, seconds(300), seconds(60), std::ref(resolver));
+    string hostname;
+
+    find(cache, "192.168.0.1", &hostname);
+    find(cache, "192.168.0.2", &hostname);
+
+    // Use the first one so that the second one is the least recently used
+    find(cache, "192.168.0.1", &hostname);
+    find(cache, "192.168.0.3", &hostname);
+
+    mxb_assert_message(cache.stats().entries == 2, "cache is bounded");
+    mxb_assert_message(cache.stats().evictions == 1, "one eviction");
+    mxb_assert_message(cache.lookup("192.168.0.1", &hostname) == HostnameCache::FOUND,
+                       "recently used address is kept");
+    mxb_assert_message(cache.lookup("192.168.0.3", &hostname) == HostnameCache::FOUND,
+                       "new address is stored");
+    mxb_assert_message(cache.lookup("192.168.0.2", &hostname) == HostnameCache::UNKNOWN,
+                       "least recently used address is evicted");
+}
+
+void test_threads()
+{
+    LocalResolver resolver;
+    HostnameCache cache(3, seconds(300), seconds(60), std::ref(resolver));
+    const char* addresses[] = {"192.168.0.1", "192.168.0.2", "192.168.0.3", "::1", "10.0.0.1"};
+    const char* hostnames[] = {"db1.example.com", "db2.example.com", "db3.example.com", "localhost", ""};
+    atomic<int> errors {0};
+    vector<thread> threads;
+
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&, t]() {
+                                 for (int i = 0; i < 10000; i++)
+                                 {
+                                     int n = (i + t) % 5;
+                                     string hostname;
+                                     find(cache, addresses[n], &hostname);
+
+                                     if (hostname != hostnames[n])
+                                     {
+                                         errors++;
+                                     }
+                                 }
+                             });
+    }
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    HostnameCache::Stats stats = cache.stats();
+
+    mxb_assert_message(errors == 0, "concurrent lookups return the right hostnames");
+    mxb_assert_message(stats.entries <= 3, "concurrent lookups respect the size limit");
+    mxb_assert_message(stats.hits + stats.negative_hits + stats.misses == 40000, "all lookups are counted");
+}
+}
+
+int main(int argc, char** argv)
+{
+    mxs_log_init(NULL, NULL, MXS_LOG_TARGET_STDOUT);
+
+    test_positive_and_negative();
+    test_expiry();
+    test_eviction();
+    test_threads();
+
+    mxs_log_finish();
+    return 0;
+}
@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+/**
+ * Tests the user index against the SQLite based lookup it replaced and
+ * compares the number of connections per second the two can authenticate.
+ */
+
+#include "../user_index.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string.h>
+#include <maxscale/sqlite3.h>
+
+using namespace std;
+
+namespace
+{
+
+/**
+ * The in-memory SQLite database that was used by MySQLAuth
+ */
+class SQLiteUsers
+{
+public:
+    SQLiteUsers()
+    {
+        sqlite3_open_v2(":memory:", &m_handle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL);
+        exec("CREATE TABLE mysqlauth_users"
+             "(user varchar(255), host varchar(255), db varchar(255), anydb boolean, password text)");
+        exec("CREATE TABLE mysqlauth_databases(db varchar(255))");
+    }
+
+    ~SQLiteUsers()
+    {
+        sqlite3_close_v2(m_handle);
+    }
+
+    void add_user(const char* user, const char* host, const char* db, bool anydb, const char* pw)
+    {
+        string dbstr = db && *db ? string("'") + db + "'" : "NULL";
+        string pwstr = pw && *pw ? string("'") + pw + "'" : "NULL";
+        exec("INSERT INTO mysqlauth_users VALUES ('" + string(user) + "', '" + host + "', "
+             + dbstr + ", " + (anydb ? "1" : "0") + ", " + pwstr + ")");
+    }
+
+    void add_database(const char* db)
+    {
+        exec("INSERT INTO mysqlauth_databases VALUES ('" + string(db) + "')");
+    }
+
+    // The same queries that validate_mysql_user() used to execute
+    const char* find(const char* user, const char* host, const char* db)
+    {
+        static const char validate_user_query[] =
+            "SELECT password FROM mysqlauth_users"
+            " WHERE user = '%s' AND ( '%s' = host OR '%s' LIKE host)"
+            " AND (anydb = '1' OR '%s' = '' OR '%s' LIKE db) LIMIT 1";
+        static const char skip_auth_query[] =
+            "SELECT password FROM mysqlauth_users"
+            " WHERE user = '%s' AND (anydb = '1' OR '%s' = '' OR '%s' LIKE db) LIMIT 1";
+
+        char sql[sizeof(validate_user_query) + strlen(user) + 2 * (host ? strlen(host) : 0)
+                 + 2 * strlen(db) + 1];
+
+        if (host)
+        {
+            sprintf(sql, validate_user_query, user, host, host, db, db);
+        }
+        else
+        {
+            sprintf(sql, skip_auth_query, user, db, db);
+        }
+
+        m_found = false;
+        sqlite3_exec(m_handle, sql, find_cb, this, NULL);
+
+        return m_found ? m_password.c_str() : NULL;
+    }
+
+    bool has_database(const char* db)
+    {
+        char sql[strlen(db) + 100];
+        sprintf(sql, "SELECT * FROM mysqlauth_databases WHERE db = '%s' LIMIT 1", db);
+
+        m_found = false;
+        sqlite3_exec(m_handle, sql, find_cb, this, NULL);
+
+        return m_found;
+    }
+
+private:
+    static int find_cb(void* data, int columns, char** rows, char** row_names)
+    {
+        SQLiteUsers* self = static_cast<SQLiteUsers*>(data);
+        self->m_found = true;
+        self->m_password = rows[0] ? rows[0] : "";
+        return 0;
+    }
+
+    void exec(const string& sql)
+    {
+        char* err;
+
+        if (sqlite3_exec(m_handle, sql.c_str(), NULL, NULL, &err) != SQLITE_OK)
+        {
+            cout << "Failed to execute '" << sql << "': " << err << endl;
+            sqlite3_free(err);
+        }
+    }
+
+    sqlite3* m_handle;
+    bool     m_found;
+    string   m_password;
+};
+
+const char* HOSTS[] =
+{
+    "%",
+    "localhost",
+    "127.0.0.1",
+    "192.168.0.1",
+    "192.168.%",
+    "192.168.%.%",
+    "192.168.1.%",
+    "192.168.1.1%",
+    "192.168.1._",
+    "192.%.1.%",
+    "10.%",
+    "10.%.%.%",
+    "10.%.%.%.%",
+    "010.%",
+    "256.%",
+    "%.example.com",
+    "db_.EXAMPLE.com",
+    "app%.example.com",
+    "::1",
+    "::ffff:192.168.%",
+    "192.168.1.0/255.255.255.128",
+    "",
+};
+
+const char* CLIENTS[] =
+{
+    "127.0.0.1",
+    "192.168.0.1",
+    "192.168.1.1",
+    "192.168.1.10",
+    "192.168.1.100",
+    "192.168.10.1",
+    "192.1680.1.1",
+    "10.0.0.1",
+    "010.0.0.1",
+    "10.example.com",
+    "localhost",
+    "LOCALHOST",
+    "db1.example.com",
+    "dbx.Example.Com",
+    "app-server.example.com",
+    "example.com",
+    "::1",
+    "::ffff:192.168.1.1",
+    "192.168.1.0/255.255.255.128",
+    "",
+};
+
+const char* DATABASES[] =
+{
+    "",
+    "test",
+    "TEST",
+    "test1",
+    "te_t",
+    "shop%",
+    "shop_eu",
+    "shopping",
+    "\xc3\xa4ta",
+};
+
+template<class T, size_t N>
+size_t array_size(T (&)[N])
+{
+    return N;
+}
+
+int test_lookups()
+{
+    int rval = 0;
+    UserIndex index;
+    SQLiteUsers sqlite;
+    mt19937 rand(1);
+
+    // Grants with all combinations of the host and database patterns split among a few users
+    // in a random order, so that the first matching grant is not always the same one
+    const char* users[] = {"alice", "bob", "Alice", "carol"};
+    const char* passwords[] = {"", "2470C0C06DEE42FD1618BB99005ADCA2EC9D1E19"};
+    vector<pair<const char*, const char*>> grants;
+
+    for (auto host : HOSTS)
+    {
+        for (auto db : DATABASES)
+        {
+            grants.emplace_back(host, db);
+        }
+    }
+
+    shuffle(grants.begin(), grants.end(), rand);
+
+    for (const auto& grant : grants)
+    {
+        const char* user = users[rand() % array_size(users)];
+        const char* pw = passwords[rand() % array_size(passwords)];
+        bool anydb = rand() % 8 == 0;
+
+        index.add_user(user, grant.first, grant.second, anydb, pw);
+        sqlite.add_user(user, grant.first, grant.second, anydb, pw);
+    }
+
+    for (auto db : {"test", "shop_eu", "\xc3\xa4ta"})
+    {
+        index.add_database(db);
+        sqlite.add_database(db);
+    }
+
+    for (auto user : {"alice", "bob", "Alice", "carol", "dave", "ALICE"})
+    {
+        for (auto db : DATABASES)
+        {
+            const char* hosts[array_size(CLIENTS) + 1];
+            copy(begin(CLIENTS), end(CLIENTS), hosts);
+            hosts[array_size(CLIENTS)] = NULL;
+
+            for (auto host : hosts)
+            {
+                const char* expected = sqlite.find(user, host, db);
+                string expected_pw = expected ? expected : "<no match>";
+                const char* result = index.find(user, host, db);
+                string result_pw = result ? result : "<no match>";
+
+                if (result_pw != expected_pw)
+                {
+                    cout << "Lookup of '" << user << "'@'" << (host ? host : "<any host>") << "' for '"
+                         << db << "' returned " << result_pw << ", expected " << expected_pw << endl;
+                    rval++;
+                }
+            }
+
+            if (index.has_database(db) != sqlite.has_database(db))
+            {
+                cout << "Database '" << db << "' exists in only one of the user stores." << endl;
+                rval++;
+            }
+        }
+    }
+
+    return rval;
+}
+
+int test_patterns()
+{
+    int rval = 0;
+
+    struct
+    {
+        const char* pattern;
+        const char* str;
+        bool        matches;
+    } tests[] =
+    {
+        {"%",         "",            true },
+        {"",          "",            true },
+        {"",          "a",           false},
+        {"a%",        "a",           true },
+        {"%a",        "ba",          true },
+        {"%a",        "ab",          false},
+        {"a%b%c",     "aXbYbZc",     true },
+        {"a%b%c",     "aXbYbZ",      false},
+        {"%%%",       "abc",         true },
+        {"a_c",       "abc",         true },
+        {"a_c",       "ac",          false},
+        {"a_c",       "a\xc3\xa4" "c", true },
+        {"%_",        "",            false},
+        {"%_",        "x",           true },
+        {"%ab%ab",    "abaab",       true },
+        {"%aab",      "aaab",        true },
+        {"ABC",       "abc",         true },
+        {"\xc3\x84",  "\xc3\xa4",    false},
+    };
+
+    for (const auto& t : tests)
+    {
+        if (LikePattern(t.pattern).matches(t.str) != t.matches)
+        {
+            cout << "Pattern '" << t.pattern << "' should " << (t.matches ? "" : "not ")
+                 << "match '" << t.str << "'" << endl;
+            rval++;
+        }
+    }
+
+    return rval;
+}
+
+/**
+ * Measure the rate at which new connections can be authenticated
+ *
+ * Each connection looks up its user with a randomly picked client address
+ * and default database, like validate_mysql_user() does.
+ */
+template<class Users>
+double connection_rate(Users& users, int n_users, int n_connections)
+{
+    mt19937 rand(2);
+    vector<string> names;
+    vector<string> addresses;
+
+    for (int i = 0; i < n_connections; i++)
+    {
+        names.push_back("user" + to_string(rand() % n_users));
+        addresses.push_back("10." + to_string(rand() % 256) + "." + to_string(rand() % 256) + ".1");
+    }
+
+    auto start = chrono::steady_clock::now();
+    int found = 0;
+
+    for (int i = 0; i < n_connections; i++)
+    {
+        if (users.find(names[i].c_str(), addresses[i].c_str(), "test") && users.has_database("test"))
+        {
+            found++;
+        }
+    }
+
+    chrono::duration<double> secs = chrono::steady_clock::now() - start;
+
+    if (found != n_connections)
+    {
+        cout << "Only " << found << " of " << n_connections << " connections were authenticated." << endl;
+    }
+
+    return n_connections / secs.count();
+}
+
+int benchmark()
+{
+    const int N_USERS = 5000;
+    UserIndex index;
+    SQLiteUsers sqlite;
+
+    // Each user has a few grants, only the last of which allows access from the 10.0.0.0/8 network
+    for (int i = 0; i < N_USERS; i++)
+    {
+        string user = "user" + to_string(i);
+        const char* pw = "2470C0C06DEE42FD1618BB99005ADCA2EC9D1E19";
+
+        for (auto host : {"localhost", "192.168.%", "%.example.com", "10.%"})
+        {
+            index.add_user(user.c_str(), host, "test", false, pw);
+            sqlite.add_user(user.c_str(), host, "test", false, pw);
+        }
+    }
+
+    index.add_database("test");
+    sqlite.add_database("test");
+
+    double sqlite_rate = connection_rate(sqlite, N_USERS, 5000);
+    double index_rate = connection_rate(index, N_USERS, 500000);
+
+    cout << "Authenticated connections per second with " << N_USERS << " users:" << endl;
+    cout << "SQLite:     " << (int64_t)sqlite_rate << endl;
+    cout << "User index: " << (int64_t)index_rate << endl;
+
+    return 0;
+}
+}
+
+int main(int argc, char** argv)
+{
+    int rval = 0;
+
+    rval += test_patterns();
+    rval += test_lookups();
+    rval += benchmark();
+
+    return rval;
+}
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "user_index.hh"
+
+#include <arpa/inet.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+namespace
+{
+
+inline char ascii_tolower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+// Skip one UTF-8 character
+inline const char* next_char(const char* str)
+{
+    do
+    {
+        str++;
+    }
+    while ((*str & 0xc0) == 0x80);
+
+    return str;
+}
+
+/**
+ * Match a string against a LIKE pattern
+ *
+ * After a '%', a mismatch restarts the matching from the character after
+ * the one where the previous attempt started.
+ */
+bool like_match(const char* pattern, const char* str)
+{
+    const char* retry_pattern = nullptr;
+    const char* retry_str = nullptr;
+
+    while (*str)
+    {
+        if (*pattern == '%')
+        {
+            while (*pattern == '%')
+            {
+                pattern++;
+            }
+
+            if (*pattern == '\0')
+            {
+                return true;
+            }
+
+            retry_pattern = pattern;
+            retry_str = str;
+        }
+        else if (*pattern == '_')
+        {
+            pattern++;
+            str = next_char(str);
+        }
+        else if (*pattern && ascii_tolower(*pattern) == ascii_tolower(*str))
+        {
+            pattern++;
+            str++;
+        }
+        else if (retry_pattern)
+        {
+            pattern = retry_pattern;
+            retry_str = next_char(retry_str);
+            str = retry_str;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (*pattern == '%')
+    {
+        pattern++;
+    }
+
+    return *pattern == '\0';
+}
+
+// A decimal number from 0 to 255 without leading zeros
+bool parse_octet(const std::string& str, uint32_t* octet)
+{
+    bool rval = false;
+
+    if (!str.empty() && str.length() <= 3 && (str[0] != '0' || str.length() == 1)
+        && str.find_first_not_of("0123456789") == std::string::npos)
+    {
+        *octet = atoi(str.c_str());
+        rval = *octet <= 255;
+    }
+
+    return rval;
+}
+
+/**
+ * Parse a host pattern that matches an IPv4 network
+ *
+ * These are patterns that start with one to three octets which are followed
+ * by one '%' for all of the remaining octets or by a '%' for each of them,
+ * e.g. 192.168.% or 192.168.%.%. For an IPv4 address, this is the same as
+ * matching the pattern with LIKE.
+ */
+bool parse_network(const std::string& host, uint32_t* network, uint32_t* mask)
+{
+    std::vector<std::string> parts;
+    size_t start = 0;
+    size_t end;
+
+    while ((end = host.find('.', start)) != std::string::npos)
+    {
+        parts.push_back(host.substr(start, end - start));
+        start = end + 1;
+    }
+
+    parts.push_back(host.substr(start));
+
+    uint32_t address = 0;
+    size_t octets = 0;
+    uint32_t octet;
+
+    while (octets < parts.size() && octets < 3 && parse_octet(parts[octets], &octet))
+    {
+        address = (address << 8) | octet;
+        octets++;
+    }
+
+    bool rval = octets > 0 && parts.size() > octets && parts.size() <= 4;
+
+    for (size_t i = octets; rval && i < parts.size(); i++)
+    {
+        rval = parts[i] == "%";
+    }
+
+    if (rval)
+    {
+        int bits = 32 - 8 * octets;
+        *network = address << bits;
+        *mask = UINT32_MAX << bits;
+    }
+
+    return rval;
+}
+}
+
+LikePattern::LikePattern(const std::string& pattern)
+    : m_pattern(pattern)
+    , m_type(pattern == "%" ? ANY : pattern.find_first_of("%_") == std::string::npos ? EXACT : WILDCARD)
+{
+}
+
+bool LikePattern::matches(const char* str) const
+{
+    bool rval = false;
+
+    switch (m_type)
+    {
+    case ANY:
+        rval = true;
+        break;
+
+    case EXACT:
+        rval = strcasecmp(m_pattern.c_str(), str) == 0;
+        break;
+
+    case WILDCARD:
+        rval = like_match(m_pattern.c_str(), str);
+        break;
+    }
+
+    return rval;
+}
+
+HostPattern::HostPattern(const std::string& host)
+    : m_like(host)
+{
+    m_netmask = parse_network(host, &m_network, &m_mask);
+}
+
+bool HostPattern::matches(const char* host, const in_addr* ipv4) const
+{
+    bool rval;
+
+    if (m_netmask && ipv4)
+    {
+        rval = (ntohl(ipv4->s_addr) & m_mask) == m_network;
+    }
+    else
+    {
+        rval = m_like.matches(host);
+    }
+
+    return rval;
+}
+
+UserIndex::Grant::Grant(const char* host, const char* db, bool anydb, const char* password)
+    : host(host)
+    , db(db ? db : "")
+    , has_db(db && *db)
+    , anydb(anydb)
+    , password(password ? password : "")
+{
+}
+
+bool UserIndex::Grant::db_matches(const char* name) const
+{
+    return anydb || *name == '\0' || (has_db && db.matches(name));
+}
+
+void UserIndex::add_user(const char* user, const char* host, const char* db, bool anydb, const char* password)
+{
+    m_users[user].emplace_back(host, db, anydb, password);
+}
+
+void UserIndex::add_database(const char* db)
+{
+    m_databases.insert(db);
+}
+
+const char* UserIndex::find(const char* user, const char* host, const char* db) const
+{
+    const char* rval = nullptr;
+    auto it = m_users.find(user);
+
+    if (it != m_users.end())
+    {
+        // Parse the address once instead of doing it for each netmask
+        in_addr addr;
+        const in_addr* ipv4 = host && inet_pton(AF_INET, host, &addr) == 1 ? &addr : nullptr;
+
+        for (const auto& grant : it->second)
+        {
+            if ((!host || grant.host.matches(host, ipv4)) && grant.db_matches(db))
+            {
+                rval = grant.password.c_str();
+                break;
+            }
+        }
+    }
+
+    return rval;
+}
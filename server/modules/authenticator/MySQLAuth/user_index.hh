@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <netinet/in.h>
+
+/**
+ * A pattern in the syntax of the LIKE operator
+ *
+ * A '%' matches any sequence of characters and a '_' matches exactly one
+ * character. The matching is case-insensitive for ASCII characters.
+ */
+class LikePattern
+{
+public:
+    explicit LikePattern(const std::string& pattern);
+
+    /**
+     * Check if a string matches the pattern
+     *
+     * @param str String to match
+     *
+     * @return True if the string matches
+     */
+    bool matches(const char* str) const;
+
+    const std::string& str() const
+    {
+        return m_pattern;
+    }
+
+private:
+    enum Type
+    {
+        ANY,        // The pattern is '%'
+        EXACT,      // No wildcards, a case-insensitive comparison
+        WILDCARD    // Any other pattern
+    };
+
+    std::string m_pattern;
+    Type        m_type;
+};
+
+/**
+ * The host part of a grant
+ *
+ * In addition to the plain LIKE matching, patterns like 192.168.% and
+ * 192.168.%.% are matched against IPv4 addresses with a netmask.
+ */
+class HostPattern
+{
+public:
+    explicit HostPattern(const std::string& host);
+
+    /**
+     * Check if a client host matches the pattern
+     *
+     * @param host Client address or hostname
+     * @param ipv4 The client address if @c host is an IPv4 address, otherwise NULL
+     *
+     * @return True if the host matches
+     */
+    bool matches(const char* host, const in_addr* ipv4) const;
+
+    const std::string& str() const
+    {
+        return m_like.str();
+    }
+
+private:
+    LikePattern m_like;
+    bool        m_netmask = false;
+    uint32_t    m_network = 0;      // In host byte order
+    uint32_t    m_mask = 0;         // In host byte order
+};
+
+/**
+ * An index of the database users
+ *
+ * The index is built once when the users are loaded and is not modified after
+ * that. This allows the same index to be used by all routing workers.
+ */
+class UserIndex
+{
+public:
+    /**
+     * Add a grant to the index
+     *
+     * @param user     Username
+     * @param host     Host pattern
+     * @param db       Database pattern, NULL or an empty string for none
+     * @param anydb    Whether the user has access to all databases
+     * @param password Hex-encoded SHA1 of the SHA1 of the password without
+     *                 the leading '*', NULL or an empty string for none
+     */
+    void add_user(const char* user, const char* host, const char* db, bool anydb, const char* password);
+
+    /**
+     * Add a database to the index
+     *
+     * @param db Database name
+     */
+    void add_database(const char* db);
+
+    /**
+     * Find the grant for a user
+     *
+     * The grants of the user are checked in the order they were added.
+     *
+     * @param user Username
+     * @param host Client address or hostname, NULL to match any host
+     * @param db   Default database, an empty string for none
+     *
+     * @return The password of the first matching grant, an empty string if
+     *         the grant has no password or NULL if no grant matches
+     */
+    const char* find(const char* user, const char* host, const char* db) const;
+
+    /**
+     * Check if a user has any grants
+     *
+     * @param user Username
+     *
+     * @return True if the user has at least one grant
+     */
+    bool has_user(const char* user) const
+    {
+        return m_users.count(user);
+    }
+
+    /**
+     * Check if a database exists
+     *
+     * @param db Database name
+     *
+     * @return True if the database exists
+     */
+    bool has_database(const char* db) const
+    {
+        return m_databases.count(db);
+    }
+
+    /**
+     * Call a function for each grant
+     *
+     * @param func Function called with the username and the host of a grant
+     */
+    template<class Func>
+    void for_each(Func func) const
+    {
+        for (const auto& a : m_users)
+        {
+            for (const auto& grant : a.second)
+            {
+                func(a.first, grant.host.str());
+            }
+        }
+    }
+
+private:
+    struct Grant
+    {
+        Grant(const char* host, const char* db, bool anydb, const char* password);
+
+        bool db_matches(const char* db) const;
+
+        HostPattern host;
+        LikePattern db;
+        bool        has_db;
+        bool        anydb;
+        std::string password;
+    };
+
+    std::unordered_map<std::string, std::vector<Grant>> m_users;
+    std::unordered_set<std::string>                     m_databases;
+};
+
+typedef std::shared_ptr<const UserIndex> SUserIndex;
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "mysql_auth.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <maxbase/stopwatch.hh>
+#include <maxscale/config.h>
+#include <maxscale/poll.h>
+#include <maxscale/routingworker.h>
+
+#include "auth_worker.hh"
+
+namespace
+{
+
+AuthWorker refresh_worker("user refresh", true);
+
+int64_t to_us(mxb::Duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+}
+
+bool UserRefresh::request(SERV_LISTENER* port, AuthClient* client)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    MXS_CONFIG* config = config_get_global_options();
+    time_t now = time(NULL);
+    bool parked = true;
+
+    if (client->parked)
+    {
+        // Already waiting for a refresh, a client is never parked twice
+    }
+    else if (m_queued)
+    {
+        // The queued refresh has not started yet so its results will include this user
+        client->ticket = m_seq;
+        m_stats.coalesced++;
+    }
+    else if (now >= m_last + config->users_refresh_time)
+    {
+        if (refresh_worker.execute([this, port]() {
+                                       refresh(port);
+                                   }))
+        {
+            m_last = now;
+            m_warned = false;
+            m_queued = true;
+            client->ticket = ++m_seq;
+            m_stats.requests++;
+        }
+        else
+        {
+            parked = false;
+        }
+    }
+    else
+    {
+        if (!m_warned)
+        {
+            MXS_WARNING("[%s] Refresh rate limit (once every %ld seconds) exceeded for "
+                        "load of users' table.",
+                        port->service->name,
+                        config->users_refresh_time);
+            m_warned = true;
+        }
+
+        m_stats.rate_limited++;
+
+        if (m_running)
+        {
+            // The user might have been created after the running refresh read the
+            // users but it is the best that can be done without exceeding the limit.
+            client->ticket = m_seq;
+            m_stats.coalesced++;
+        }
+        else
+        {
+            parked = false;
+        }
+    }
+
+    if (parked && !client->parked)
+    {
+        client->worker_id = mxs_rworker_get_current_id();
+        client->parked = true;
+        m_parked.push_back(client);
+        m_stats.waiting++;
+    }
+
+    return parked;
+}
+
+void UserRefresh::forget(AuthClient* client)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    auto it = std::remove(m_parked.begin(), m_parked.end(), client);
+    m_stats.waiting -= std::distance(it, m_parked.end());
+    m_parked.erase(it, m_parked.end());
+    client->parked = false;
+}
+
+void UserRefresh::refresh(SERV_LISTENER* port)
+{
+    uint64_t seq;
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        seq = m_seq;
+        m_queued = false;
+        m_running = true;
+    }
+
+    mxb::StopWatch watch;
+
+    // The new users are published to all routing workers by the authenticator
+    if (port->listener && port->listener->authfunc.loadusers(port) != MXS_AUTH_LOADUSERS_OK)
+    {
+        MXS_WARNING("[%s] Failed to refresh the users for listener '%s', authentication"
+                    " might not work.",
+                    port->service->name,
+                    port->name);
+    }
+
+    int64_t duration = to_us(watch.split());
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_running = false;
+        m_done = seq;
+        m_stats.refreshes++;
+        m_stats.last_us = duration;
+        m_stats.max_us = std::max(m_stats.max_us, duration);
+        m_stats.total_us += duration;
+    }
+
+    mxs_rworker_broadcast(resume_clients_cb, this);
+}
+
+// static
+void UserRefresh::resume_clients_cb(void* data)
+{
+    static_cast<UserRefresh*>(data)->resume_clients();
+}
+
+void UserRefresh::resume_clients()
+{
+    int worker_id = mxs_rworker_get_current_id();
+    std::vector<AuthClient*> clients;
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        auto it = std::stable_partition(m_parked.begin(), m_parked.end(), [&](AuthClient* client) {
+                                            return client->worker_id != worker_id
+                                            || client->ticket > m_done;
+                                        });
+        clients.assign(it, m_parked.end());
+        m_parked.erase(it, m_parked.end());
+        m_stats.waiting -= clients.size();
+
+        for (AuthClient* client : clients)
+        {
+            client->parked = false;
+        }
+    }
+
+    for (AuthClient* client : clients)
+    {
+        // Process the handshake response again now that the users are fresh, ahead of
+        // anything the client sent after it
+        GWBUF* packet = client->packet;
+        client->packet = nullptr;
+        dcb_readq_prepend(client->dcb, packet);
+        poll_fake_read_event(client->dcb);
+    }
+}
+
+json_t* UserRefresh::stats_json() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    json_t* rval = json_object();
+
+    json_object_set_new(rval, "refreshes", json_integer(m_stats.refreshes));
+    json_object_set_new(rval, "requests", json_integer(m_stats.requests));
+    json_object_set_new(rval, "coalesced_requests", json_integer(m_stats.coalesced));
+    json_object_set_new(rval, "rate_limited_requests", json_integer(m_stats.rate_limited));
+    json_object_set_new(rval, "waiting_clients", json_integer(m_stats.waiting));
+    json_object_set_new(rval, "last_refresh_us", json_integer(m_stats.last_us));
+    json_object_set_new(rval, "max_refresh_us", json_integer(m_stats.max_us));
+    json_object_set_new(rval,
+                        "avg_refresh_us",
+                        json_integer(m_stats.refreshes ? m_stats.total_us / m_stats.refreshes : 0));
+
+    return rval;
+}
+
+// static
+void UserRefresh::finish()
+{
+    refresh_worker.finish();
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+
+#include <mutex>
+#include <time.h>
+#include <vector>
+
+#include <maxbase/jansson.h>
+#include <maxscale/listener.h>
+
+struct AuthClient;
+
+/**
+ * Statistics of the user refreshes of one listener
+ */
+struct UserRefreshStats
+{
+    uint64_t refreshes = 0;     /**< Completed refreshes */
+    uint64_t requests = 0;      /**< Refreshes started by failed authentications */
+    uint64_t coalesced = 0;     /**< Failed authentications that waited for a pending refresh */
+    uint64_t rate_limited = 0;  /**< Failed authentications that hit the rate limit */
+    uint64_t waiting = 0;       /**< Clients waiting for a refresh to complete */
+    int64_t  last_us = 0;       /**< Duration of the latest refresh */
+    int64_t  max_us = 0;        /**< Duration of the longest refresh */
+    int64_t  total_us = 0;      /**< Total duration of all refreshes */
+};
+
+/**
+ * Reloading of the users when a client fails to authenticate
+ *
+ * The users are loaded by a background thread so that the routing workers
+ * are not blocked by the queries to the backend servers. A client that fails
+ * to authenticate is parked until the refresh has completed, after which its
+ * handshake response is processed again by the worker that owns the client.
+ * All failures that happen while a refresh is queued wait for the same
+ * refresh instead of starting a new one.
+ */
+class UserRefresh
+{
+public:
+    UserRefresh(const UserRefresh&) = delete;
+    UserRefresh& operator=(const UserRefresh&) = delete;
+
+    UserRefresh() = default;
+
+    /**
+     * Request a refresh of the users for a client that failed to authenticate
+     *
+     * @param port   The listener of the client
+     * @param client The client
+     *
+     * @return True if the client was parked and will be resumed once the
+     *         refresh has completed. False if the users could not be
+     *         refreshed, in which case the caller should proceed with the
+     *         users that it has.
+     */
+    bool request(SERV_LISTENER* port, AuthClient* client);
+
+    /**
+     * Remove a client from the parked clients
+     *
+     * Called when a client DCB is freed.
+     *
+     * @param client The client to remove
+     */
+    void forget(AuthClient* client);
+
+    /**
+     * Get the refresh statistics
+     *
+     * @return The statistics as a JSON object
+     */
+    json_t* stats_json() const;
+
+    /**
+     * Stop the background thread
+     *
+     * After this, no refreshes are done and no clients are parked.
+     */
+    static void finish();
+
+private:
+    void refresh(SERV_LISTENER* port);
+    void resume_clients();
+
+    static void resume_clients_cb(void* data);
+
+    mutable std::mutex       m_lock;
+    uint64_t                 m_seq = 0;         /**< The number of the latest requested refresh */
+    uint64_t                 m_done = 0;        /**< The number of the latest completed refresh */
+    bool                     m_queued = false;  /**< Refresh m_seq has not yet started */
+    bool                     m_running = false; /**< A refresh is in progress */
+    time_t                   m_last = 0;        /**< When the latest refresh was started */
+    bool                     m_warned = false;  /**< Whether the rate limit warning was logged */
+    std::vector<AuthClient*> m_parked;
+    UserRefreshStats         m_stats;
+};
@@ -14,6 +14,9 @@
 
 #include <string>
 #include <maxscale/authenticator.h>
+#include <maxscale/listener.h>
+#include <maxscale/modulecmd.h>
+#include <maxscale/service.h>
 #include <maxscale/users.h>
 
 #include "pam_instance.hh"
@@ -152,6 +155,41 @@ static json_t* pam_auth_diagnostic_json(const SERV_LISTENER* listener)
     return inst->diagnostic_json();
 }
 
+/**
+ * @brief Show the PAM conversation statistics of the listeners of a service
+ *
+ * @param args   The service
+ * @param output The statistics of each listener that uses this authenticator
+ * @return Always true
+ */
+static bool pam_auth_conversation_stats(const MODULECMD_ARG* args, json_t** output)
+{
+    json_t* rval = json_object();
+    LISTENER_ITERATOR iter;
+
+    for (SERV_LISTENER* listener = listener_iterator_init(args->argv[0].value.service, &iter);
+         listener; listener = listener_iterator_next(&iter))
+    {
+        if (listener_is_active(listener) && listener->listener
+            && listener->listener->authfunc.authenticate == pam_auth_authenticate)
+        {
+            PamInstance* inst = static_cast<PamInstance*>(listener->auth_instance);
+            json_object_set_new(rval, listener->name, inst->conversations_json());
+        }
+    }
+
+    *output = rval;
+    return true;
+}
+
+/**
+ * @brief Stop the PAM threads when the routing workers stop
+ */
+static void pam_auth_thread_finish()
+{
+    PamThreadPool::finish();
+}
+
 extern "C"
 {
 /**
@@ -159,6 +197,19 @@ extern "C"
  */
     MXS_MODULE* MXS_CREATE_MODULE()
     {
+        static modulecmd_arg_type_t args[] =
+        {
+            {MODULECMD_ARG_SERVICE, "Service to inspect"}
+        };
+
+        modulecmd_register_command(MXS_MODULE_NAME,
+                                   "conversation_stats",
+                                   MODULECMD_TYPE_PASSIVE,
+                                   pam_auth_conversation_stats,
+                                   1,
+                                   args,
+                                   "Show statistics of the PAM conversations of a service");
+
         static MXS_AUTHENTICATOR MyObject =
         {
             pam_auth_init,              /* Initialize authenticator */
@@ -186,7 +237,7 @@ extern "C"
             NULL,   /* Process init. */
             NULL,   /* Process finish. */
             NULL,   /* Thread init. */
-            NULL,   /* Thread finish. */
+            pam_auth_thread_finish,     /* Thread finish. */
             {
                 {MXS_END_MODULE_PARAMS}
             }
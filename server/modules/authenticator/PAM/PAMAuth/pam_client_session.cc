@@ -15,7 +15,9 @@
 
 #include <sstream>
 #include <security/pam_appl.h>
+#include <maxbase/worker.hh>
 #include <maxscale/event.hh>
+#include <maxscale/poll.h>
 
 using maxscale::Buffer;
 using std::string;
@@ -39,6 +41,9 @@ bool store_client_password(DCB* dcb, GWBUF* buffer)
     {
         size_t plen = gw_mysql_get_byte3(header);
         MYSQL_session* ses = (MYSQL_session*)dcb->data;
+        // The packet is processed again after the PAM conversation
+        MXS_FREE(ses->auth_token);
+        ses->auth_token_len = 0;
         ses->auth_token = (uint8_t*)MXS_CALLOC(plen, sizeof(uint8_t));
         if (ses->auth_token)
         {
@@ -78,12 +83,12 @@ int user_services_cb(void* data, int columns, char** column_vals, char** column_
 /** Used by the PAM conversation function */
 struct ConversationData
 {
-    DCB*   m_client;
+    string m_user;
     int    m_counter;
     string m_password;
 
-    ConversationData(DCB* client, int counter, const string& password)
-        : m_client(client)
+    ConversationData(const string& user, int counter, const string& password)
+        : m_user(user)
         , m_counter(counter)
         , m_password(password)
     {
@@ -108,7 +113,7 @@ int conversation_func(int num_msg,
     if (data->m_counter > 1)
     {
         MXS_ERROR("Multiple calls to conversation function for client '%s'. %s",
-                  data->m_client->user,
+                  data->m_user.c_str(),
                   GENERAL_ERRMSG);
     }
     else if (num_msg == 1)
@@ -149,15 +154,14 @@ int conversation_func(int num_msg,
  * @param user Username
  * @param password Password
  * @param service Which PAM service is the user logging to
- * @param client Client DCB
  * @return True if username & password are ok
  */
-bool validate_pam_password(const string& user, const string& password, const string& service, DCB* client)
+bool validate_pam_password(const string& user, const string& password, const string& service)
 {
     const char PAM_START_ERR_MSG[] = "Failed to start PAM authentication for user '%s': '%s'.";
     const char PAM_AUTH_ERR_MSG[] = "Pam authentication for user '%s' failed: '%s'.";
     const char PAM_ACC_ERR_MSG[] = "Pam account check for user '%s' failed: '%s'.";
-    ConversationData appdata(client, 0, password);
+    ConversationData appdata(user, 0, password);
     pam_conv conv_struct = {conversation_func, &appdata};
     bool authenticated = false;
     bool account_ok = false;
@@ -214,22 +218,53 @@ bool validate_pam_password(const string& user, const string& password, const str
     pam_end(pam_handle, pam_status);
     return account_ok;
 }
+
+/**
+ * Resume the authentication of a client once its PAM conversation has finished. Called in the
+ * worker that owns the client so that the conversation is only marked done in that worker.
+ *
+ * @param conversation The finished conversation
+ */
+void resume_conversation(const std::shared_ptr<PamConversation>& conversation)
+{
+    std::lock_guard<std::mutex> guard(conversation->lock);
+
+    if (conversation->dcb)
+    {
+        // The password packet is processed before anything the client sent after it
+        conversation->done = true;
+        dcb_readq_prepend(conversation->dcb, conversation->packet);
+        conversation->packet = NULL;
+        poll_fake_read_event(conversation->dcb);
+    }
+}
 }
 
-PamClientSession::PamClientSession(sqlite3* dbhandle, const PamInstance& instance)
+PamClientSession::PamClientSession(sqlite3* dbhandle, PamInstance& instance)
     : m_state(PAM_AUTH_INIT)
     , m_sequence(0)
     , m_dbhandle(dbhandle)
     , m_instance(instance)
+    , m_packet(NULL)
+    , m_refreshed(false)
 {
 }
 
 PamClientSession::~PamClientSession()
 {
+    if (m_conversation)
+    {
+        std::lock_guard<std::mutex> guard(m_conversation->lock);
+        m_conversation->dcb = NULL;
+        gwbuf_free(m_conversation->packet);
+        m_conversation->packet = NULL;
+    }
+
+    gwbuf_free(m_packet);
     sqlite3_close_v2(m_dbhandle);
 }
 
-PamClientSession* PamClientSession::create(const PamInstance& inst)
+PamClientSession* PamClientSession::create(PamInstance& inst)
 {
     // This handle is only used from one thread, can define no_mutex.
     sqlite3* dbhandle = NULL;
@@ -352,62 +387,140 @@ int PamClientSession::authenticate(DCB* dcb)
         else if (m_state == PAM_AUTH_DATA_SENT)
         {
             /** We sent the authentication change packet + plugin name and the client
-             * responded with the password. Try to continue authentication without more
-             * messages to client. */
-            string password((char*)ses->auth_token, ses->auth_token_len);
+             * responded with the password. The PAM conversation is done by the thread
+             * pool and the password packet is processed again once it has finished. */
+            if (m_conversation)
+            {
+                std::unique_lock<std::mutex> guard(m_conversation->lock);
+
+                if (m_conversation->done)
+                {
+                    rval = m_conversation->authenticated ? MXS_AUTH_SUCCEEDED : MXS_AUTH_FAILED;
+                    guard.unlock();
+                    m_conversation.reset();
+                }
+                else
+                {
+                    // The client sent more data while the conversation is still running, the
+                    // data was put back into the read queue
+                    rval = MXS_AUTH_INCOMPLETE;
+                }
+            }
+            else
+            {
+                get_pam_user_services(dcb, ses, &m_services);
+                rval = m_services.empty() ? MXS_AUTH_FAILED : start_conversation(dcb, ses);
+            }
+
             /*
              * Authentication may be attempted twice: first with old user account info and then with
              * updated info. Updating may fail if it has been attempted too often lately. The second password
              * check is useless if the user services are same as on the first attempt.
              */
-            bool authenticated = false;
-            StringVector services_old;
-            for (int loop = 0; loop < 2 && !authenticated; loop++)
+            if (rval == MXS_AUTH_FAILED && !m_refreshed)
             {
-                if (loop == 0 || service_refresh_users(dcb->service) == 0)
+                m_refreshed = true;
+
+                if (service_refresh_users(dcb->service) == 0)
                 {
-                    bool try_validate = true;
                     StringVector services;
                     get_pam_user_services(dcb, ses, &services);
-                    if (loop == 0)
-                    {
-                        services_old = services;
-                    }
-                    else if (services == services_old)
+
+                    if (!services.empty() && services != m_services)
                     {
-                        try_validate = false;
+                        m_services = services;
+                        rval = start_conversation(dcb, ses);
                     }
-                    if (try_validate)
+                }
+            }
+        }
+    }
+    return rval;
+}
+
+/**
+ * Start a PAM conversation for the services in m_services
+ *
+ * @param dcb Client DCB
+ * @param session MySQL session
+ *
+ * @return MXS_AUTH_INCOMPLETE if the conversation was started, MXS_AUTH_FAILED
+ * if the limit of conversations was reached or the pool did not accept it
+ */
+int PamClientSession::start_conversation(DCB* dcb, const MYSQL_session* session)
+{
+    int rval = MXS_AUTH_FAILED;
+
+    if (m_packet && m_instance.begin_conversation())
+    {
+        auto conversation = std::make_shared<PamConversation>();
+        conversation->dcb = dcb;
+        conversation->packet = m_packet;
+        m_packet = NULL;
+
+        PamInstance* instance = &m_instance;
+        string user = session->user;
+        string password((char*)session->auth_token, session->auth_token_len);
+        StringVector services = m_services;
+
+        auto task = [instance, conversation, user, password, services]() {
+                auto start = std::chrono::steady_clock::now();
+                bool authenticated = false;
+
+                for (auto it = services.begin(); it != services.end() && !authenticated; it++)
+                {
+                    // The server PAM plugin uses "mysql" as the default service when authenticating
+                    // a user with no service.
+                    authenticated = validate_pam_password(user, password, it->empty() ? "mysql" : *it);
+                }
+
+                instance->end_conversation(std::chrono::steady_clock::now() - start, authenticated);
+
+                std::lock_guard<std::mutex> guard(conversation->lock);
+                conversation->authenticated = authenticated;
+
+                if (conversation->dcb)
+                {
+                    // Resumes the authentication in the worker that owns the client
+                    mxb::Worker* worker = static_cast<mxb::Worker*>(conversation->dcb->poll.owner);
+
+                    if (!worker->execute([conversation]() {
+                                             resume_conversation(conversation);
+                                         }, mxb::Worker::EXECUTE_QUEUED))
                     {
-                        for (StringVector::iterator iter = services.begin();
-                             iter != services.end() && !authenticated;
-                             iter++)
-                        {
-                            // The server PAM plugin uses "mysql" as the default service when authenticating
-                            // a user with no service.
-                            if (iter->empty())
-                            {
-                                *iter = "mysql";
-                            }
-                            if (validate_pam_password(ses->user, password, *iter, dcb))
-                            {
-                                authenticated = true;
-                            }
-                        }
+                        MXS_ERROR("Could not resume the authentication of '%s' after the PAM "
+                                  "conversation.", user.c_str());
                     }
                 }
-            }
-            if (authenticated)
-            {
-                rval = MXS_AUTH_SUCCEEDED;
-            }
+            };
+
+        if (m_instance.m_pool.execute(task))
+        {
+            m_conversation = conversation;
+            rval = MXS_AUTH_INCOMPLETE;
+        }
+        else
+        {
+            MXS_ERROR("Could not start the PAM conversation of '%s'.", session->user);
+            m_packet = conversation->packet;
+            conversation->packet = NULL;
+            m_instance.cancel_conversation();
         }
     }
+
     return rval;
 }
 
 bool PamClientSession::extract(DCB* dcb, GWBUF* buffer)
 {
+    if (m_conversation && !m_conversation->done)
+    {
+        /* The client sent more data while the conversation is still running. The data is put
+         * back into the read queue where it is processed after the password packet. */
+        dcb_readq_prepend(dcb, gwbuf_clone(buffer));
+        return true;
+    }
+
     gwbuf_copy_data(buffer, MYSQL_SEQ_OFFSET, 1, &m_sequence);
     m_sequence++;
     bool rval = false;
@@ -422,6 +535,9 @@ bool PamClientSession::extract(DCB* dcb, GWBUF* buffer)
     case PAM_AUTH_DATA_SENT:
         if (store_client_password(dcb, buffer))
         {
+            // Stored for resuming the authentication once the PAM conversation is done
+            gwbuf_free(m_packet);
+            m_packet = gwbuf_clone(buffer);
             rval = true;
         }
         break;
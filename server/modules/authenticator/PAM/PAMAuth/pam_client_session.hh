@@ -14,12 +14,29 @@
 #include "pam_auth.hh"
 
 #include <stdint.h>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <maxscale/sqlite3.h>
 #include "pam_instance.hh"
 #include "../pam_auth_common.hh"
 
+/**
+ * The state shared by a client session and the thread that runs its PAM
+ * conversation. The session may be freed before the conversation ends, in
+ * which case the DCB is set to NULL.
+ */
+struct PamConversation
+{
+    std::mutex lock;
+    DCB*       dcb = nullptr;           /**< The client, NULL if it has been freed */
+    GWBUF*     packet = nullptr;        /**< The password packet, processed again once done */
+    bool       done = false;            /**< Whether the conversation has finished, only modified in
+                                         * the worker that owns the client */
+    bool       authenticated = false;
+};
+
 /** Client authenticator PAM-specific session data */
 class PamClientSession
 {
@@ -27,19 +44,24 @@ class PamClientSession
     PamClientSession& operator=(const PamClientSession&);
 public:
     typedef std::vector<std::string> StringVector;
-    static PamClientSession* create(const PamInstance& inst);
+    static PamClientSession* create(PamInstance& inst);
     ~PamClientSession();
     int  authenticate(DCB* client);
     bool extract(DCB* dcb, GWBUF* read_buffer);
 private:
-    PamClientSession(sqlite3* dbhandle, const PamInstance& instance);
+    PamClientSession(sqlite3* dbhandle, PamInstance& instance);
     void get_pam_user_services(const DCB* dcb,
                                const MYSQL_session* session,
                                StringVector* services_out);
     maxscale::Buffer create_auth_change_packet() const;
+    int              start_conversation(DCB* dcb, const MYSQL_session* session);
 
-    pam_auth_state     m_state;     /**< Authentication state*/
-    uint8_t            m_sequence;  /**< The next packet seqence number */
-    sqlite3* const     m_dbhandle;  /**< SQLite3 database handle */
-    const PamInstance& m_instance;  /**< Authenticator instance */
+    pam_auth_state                   m_state;       /**< Authentication state*/
+    uint8_t                          m_sequence;    /**< The next packet seqence number */
+    sqlite3* const                   m_dbhandle;    /**< SQLite3 database handle */
+    PamInstance&                     m_instance;    /**< Authenticator instance */
+    GWBUF*                           m_packet;      /**< The password packet of the client */
+    StringVector                     m_services;    /**< Services of the running conversation */
+    bool                             m_refreshed;   /**< Whether the users have been refreshed */
+    std::shared_ptr<PamConversation> m_conversation;/**< The running or finished conversation */
 };
@@ -13,6 +13,8 @@
 
 #include "pam_instance.hh"
 
+#include <algorithm>
+#include <climits>
 #include <string>
 #include <string.h>
 #include <maxscale/jansson.hh>
@@ -22,8 +24,46 @@
 
 #define DEFAULT_PAM_DATABASE_NAME "file:pam.db?mode=memory&cache=shared"
 #define DEFAULT_PAM_TABLE_NAME    "pam_users"
+#define DEFAULT_PAM_THREADS       4
+#define DEFAULT_MAX_CONVERSATIONS 100
 using std::string;
 
+const int64_t PamInstance::LATENCY_BUCKETS[] =
+{
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 30000
+};
+
+namespace
+{
+/**
+ * Parse a numeric authenticator option
+ *
+ * @param name  Option name
+ * @param value Option value
+ * @param min   Smallest allowed value
+ * @param dest  Where the value is stored
+ * @return True if the value is an integer that is at least @c min
+ */
+bool parse_int_option(const char* name, const char* value, long min, int* dest)
+{
+    char* end;
+    long number = strtol(value, &end, 10);
+    bool rval = false;
+
+    if (*value && *end == '\0' && number >= min && number <= INT_MAX)
+    {
+        *dest = number;
+        rval = true;
+    }
+    else
+    {
+        MXS_ERROR("Invalid value for authenticator option '%s': %s", name, value);
+    }
+
+    return rval;
+}
+}
+
 /**
  * Create an instance.
  *
@@ -47,11 +87,36 @@ PamInstance* PamInstance::create(char** options)
                     "corruption of in-memory database.");
     }
     bool error = false;
+    int threads = DEFAULT_PAM_THREADS;
+    int max_conversations = DEFAULT_MAX_CONVERSATIONS;
+
+    for (int i = 0; options[i]; i++)
+    {
+        string option = options[i];
+        size_t pos = option.find('=');
+        string name = option.substr(0, pos);
+        const char* value = pos != string::npos ? options[i] + pos + 1 : NULL;
+
+        if (value && name == "pam_threads")
+        {
+            error = !parse_int_option(name.c_str(), value, 1, &threads) || error;
+        }
+        else if (value && name == "max_pam_conversations")
+        {
+            error = !parse_int_option(name.c_str(), value, 0, &max_conversations) || error;
+        }
+        else
+        {
+            MXS_ERROR("Unknown authenticator option: %s", options[i]);
+            error = true;
+        }
+    }
+
     /* This handle may be used from multiple threads, set full mutex. */
     sqlite3* dbhandle = NULL;
     int db_flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE
         | SQLITE_OPEN_SHAREDCACHE | SQLITE_OPEN_FULLMUTEX;
-    if (sqlite3_open_v2(pam_db_name.c_str(), &dbhandle, db_flags, NULL) != SQLITE_OK)
+    if (!error && sqlite3_open_v2(pam_db_name.c_str(), &dbhandle, db_flags, NULL) != SQLITE_OK)
     {
         MXS_ERROR("Failed to open SQLite3 handle.");
         error = true;
@@ -67,7 +132,11 @@ PamInstance* PamInstance::create(char** options)
 
     PamInstance* instance = NULL;
     if (!error
-        && ((instance = new(std::nothrow) PamInstance(dbhandle, pam_db_name, pam_table_name)) == NULL))
+        && ((instance = new(std::nothrow) PamInstance(dbhandle,
+                                                      pam_db_name,
+                                                      pam_table_name,
+                                                      threads,
+                                                      max_conversations)) == NULL))
     {
         sqlite3_close_v2(dbhandle);
     }
@@ -80,11 +149,19 @@ PamInstance* PamInstance::create(char** options)
  * @param dbhandle Database handle
  * @param dbname Text-form name of @c dbhandle
  * @param tablename Name of table where authentication data is saved
+ * @param threads Number of threads for the PAM conversations
+ * @param max_conversations Maximum number of active conversations, 0 for no limit
  */
-PamInstance::PamInstance(sqlite3* dbhandle, const string& dbname, const string& tablename)
+PamInstance::PamInstance(sqlite3* dbhandle,
+                         const string& dbname,
+                         const string& tablename,
+                         int threads,
+                         int max_conversations)
     : m_dbname(dbname)
     , m_tablename(tablename)
+    , m_pool(threads)
     , m_dbhandle(dbhandle)
+    , m_max_conversations(max_conversations)
 {
 }
 
@@ -251,6 +328,61 @@ int PamInstance::load_users(SERVICE* service)
     return rval;
 }
 
+bool PamInstance::begin_conversation()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    bool rval = false;
+
+    if (m_max_conversations == 0 || m_stats.active < m_max_conversations)
+    {
+        m_stats.active++;
+        rval = true;
+    }
+    else
+    {
+        m_stats.rejected++;
+        MXS_WARNING("The limit of %d concurrent PAM conversations has been reached, "
+                    "rejecting the client.", m_max_conversations);
+    }
+
+    return rval;
+}
+
+void PamInstance::end_conversation(std::chrono::steady_clock::duration duration, bool authenticated)
+{
+    int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+    int bucket = 0;
+
+    while (bucket < N_LATENCY_BUCKETS && ms > LATENCY_BUCKETS[bucket])
+    {
+        bucket++;
+    }
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    mxb_assert(m_stats.active > 0);
+    m_stats.active--;
+
+    if (authenticated)
+    {
+        m_stats.succeeded++;
+    }
+    else
+    {
+        m_stats.failed++;
+    }
+
+    m_stats.total_ms += ms;
+    m_stats.max_ms = std::max(m_stats.max_ms, ms);
+    m_stats.histogram[bucket]++;
+}
+
+void PamInstance::cancel_conversation()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    mxb_assert(m_stats.active > 0);
+    m_stats.active--;
+}
+
 void PamInstance::diagnostic(DCB* dcb)
 {
     json_t* array = diagnostic_json();
@@ -274,8 +406,20 @@ void PamInstance::diagnostic(DCB* dcb)
 
     if (!result.empty())
     {
-        dcb_printf(dcb, "%s", result.c_str());
+        dcb_printf(dcb, "%s\n", result.c_str());
     }
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    uint64_t finished = m_stats.succeeded + m_stats.failed;
+    dcb_printf(dcb,
+               "PAM conversations: %d active, %lu succeeded, %lu failed, %lu rejected, "
+               "%ldms average, %ldms max",
+               m_stats.active,
+               m_stats.succeeded,
+               m_stats.failed,
+               m_stats.rejected,
+               finished ? m_stats.total_ms / (int64_t)finished : 0,
+               m_stats.max_ms);
     json_decref(array);
 }
 
@@ -306,6 +450,37 @@ json_t* PamInstance::diagnostic_json()
     return rval;
 }
 
+json_t* PamInstance::conversations_json()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    uint64_t finished = m_stats.succeeded + m_stats.failed;
+    json_t* rval = json_object();
+
+    json_object_set_new(rval, "active", json_integer(m_stats.active));
+    json_object_set_new(rval, "max_conversations", json_integer(m_max_conversations));
+    json_object_set_new(rval, "threads", json_integer(m_pool.size()));
+    json_object_set_new(rval, "succeeded", json_integer(m_stats.succeeded));
+    json_object_set_new(rval, "failed", json_integer(m_stats.failed));
+    json_object_set_new(rval, "rejected", json_integer(m_stats.rejected));
+    json_object_set_new(rval, "avg_ms", json_integer(finished ? m_stats.total_ms / (int64_t)finished : 0));
+    json_object_set_new(rval, "max_ms", json_integer(m_stats.max_ms));
+
+    json_t* histogram = json_array();
+
+    for (int i = 0; i <= N_LATENCY_BUCKETS; i++)
+    {
+        json_t* bucket = json_object();
+        json_object_set_new(bucket,
+                            "le_ms",
+                            i < N_LATENCY_BUCKETS ? json_integer(LATENCY_BUCKETS[i]) : json_null());
+        json_object_set_new(bucket, "count", json_integer(m_stats.histogram[i]));
+        json_array_append_new(histogram, bucket);
+    }
+
+    json_object_set_new(rval, "latency_histogram", histogram);
+    return rval;
+}
+
 bool PamInstance::query_anon_proxy_user(SERVER* server, MYSQL* conn)
 {
     bool success = true;
@@ -13,9 +13,12 @@
 #pragma once
 #include "pam_auth.hh"
 
+#include <chrono>
+#include <mutex>
 #include <string>
 #include <maxscale/service.h>
 #include <maxscale/sqlite3.h>
+#include "pam_thread_pool.hh"
 
 /** The instance class for the client side PAM authenticator, created in pam_auth_init() */
 class PamInstance
@@ -29,10 +32,58 @@ public:
     void    diagnostic(DCB* dcb);
     json_t* diagnostic_json();
 
+    /**
+     * Get the statistics of the PAM conversations
+     *
+     * @return The statistics as a JSON object
+     */
+    json_t* conversations_json();
+
+    /**
+     * Reserve a slot for a PAM conversation
+     *
+     * @return True if the number of conversations in progress is below the limit
+     */
+    bool begin_conversation();
+
+    /**
+     * Release the slot of a PAM conversation
+     *
+     * @param duration      How long the conversation took
+     * @param authenticated Whether the client was authenticated
+     */
+    void end_conversation(std::chrono::steady_clock::duration duration, bool authenticated);
+
+    /**
+     * Release the slot of a conversation that could not be started
+     */
+    void cancel_conversation();
+
     const std::string m_dbname;     /**< Name of the in-memory database */
     const std::string m_tablename;  /**< The table where users are stored */
+    PamThreadPool     m_pool;       /**< Threads for the PAM conversations */
+
 private:
-    PamInstance(sqlite3* dbhandle, const std::string& m_dbname, const std::string& tablename);
+    /** Upper bounds of the conversation latency histogram buckets, in milliseconds */
+    static const int64_t LATENCY_BUCKETS[];
+    static const int     N_LATENCY_BUCKETS = 14;
+
+    struct Stats
+    {
+        int      active = 0;        /**< Conversations queued or in progress */
+        uint64_t succeeded = 0;     /**< Conversations that authenticated the client */
+        uint64_t failed = 0;        /**< Conversations that did not authenticate the client */
+        uint64_t rejected = 0;      /**< Conversations not started due to the limit */
+        int64_t  total_ms = 0;
+        int64_t  max_ms = 0;
+        uint64_t histogram[N_LATENCY_BUCKETS + 1] = {};     /**< The last bucket is for the rest */
+    };
+
+    PamInstance(sqlite3* dbhandle,
+                const std::string& m_dbname,
+                const std::string& tablename,
+                int threads,
+                int max_conversations);
     void add_pam_user(const char* user,
                       const char* host,
                       const char* db,
@@ -41,5 +92,8 @@ private:
     void delete_old_users();
     bool query_anon_proxy_user(SERVER* server, MYSQL* conn);
 
-    sqlite3* const m_dbhandle;      /**< SQLite3 database handle */
+    sqlite3* const m_dbhandle;          /**< SQLite3 database handle */
+    const int      m_max_conversations; /**< Maximum number of active conversations, 0 for no limit */
+    std::mutex     m_lock;
+    Stats          m_stats;
 };
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "pam_thread_pool.hh"
+
+#include <algorithm>
+#include <system_error>
+#include <maxscale/maxscale.h>
+
+namespace
+{
+// All pools, so that they can be stopped before the routing workers are gone
+std::mutex pools_lock;
+std::vector<PamThreadPool*> pools;
+bool pools_stopped = false;
+}
+
+PamThreadPool::PamThreadPool(int size)
+    : m_size(size)
+{
+    std::lock_guard<std::mutex> guard(pools_lock);
+    pools.push_back(this);
+    m_stopped = pools_stopped;
+}
+
+PamThreadPool::~PamThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(pools_lock);
+        pools.erase(std::find(pools.begin(), pools.end(), this));
+    }
+
+    stop();
+}
+
+bool PamThreadPool::execute(const Task& task)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    bool rval = false;
+
+    if (!m_stopped && !maxscale_is_shutting_down())
+    {
+        try
+        {
+            while ((int)m_threads.size() < m_size)
+            {
+                m_threads.emplace_back(&PamThreadPool::run, this);
+            }
+        }
+        catch (const std::system_error& e)
+        {
+            MXS_ERROR("Could not start a PAM thread: %s", e.what());
+        }
+
+        if (!m_threads.empty())
+        {
+            m_tasks.push_back(task);
+            m_cond.notify_one();
+            rval = true;
+        }
+    }
+
+    return rval;
+}
+
+void PamThreadPool::run()
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+
+    while (!m_stopped)
+    {
+        if (m_tasks.empty())
+        {
+            m_cond.wait(guard);
+        }
+        else
+        {
+            Task task = m_tasks.front();
+            m_tasks.pop_front();
+
+            guard.unlock();
+            task();
+            guard.lock();
+        }
+    }
+}
+
+void PamThreadPool::stop()
+{
+    std::vector<std::thread> threads;
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_stopped = true;
+        m_tasks.clear();
+        threads.swap(m_threads);
+        m_cond.notify_all();
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+// static
+void PamThreadPool::finish()
+{
+    std::lock_guard<std::mutex> guard(pools_lock);
+
+    for (PamThreadPool* pool : pools)
+    {
+        pool->stop();
+    }
+
+    pools_stopped = true;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+#include "pam_auth.hh"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed size pool of threads for the PAM conversations
+ *
+ * The PAM modules may block for a long time, e.g. when they contact an LDAP
+ * server, so the conversations are not done in the routing workers. The
+ * threads are started when the first task is given to the pool.
+ */
+class PamThreadPool
+{
+    PamThreadPool(const PamThreadPool&);
+    PamThreadPool& operator=(const PamThreadPool&);
+public:
+    typedef std::function<void ()> Task;
+
+    /**
+     * @param size Number of threads
+     */
+    explicit PamThreadPool(int size);
+    ~PamThreadPool();
+
+    /**
+     * Execute a task in one of the threads
+     *
+     * @param task The task
+     *
+     * @return True if the task was queued, false if the pool has been stopped
+     *         or no threads could be started
+     */
+    bool execute(const Task& task);
+
+    /**
+     * Stop the threads of all pools
+     *
+     * The tasks that have not started are discarded and no new tasks are
+     * accepted after this. Called when the routing workers stop.
+     */
+    static void finish();
+
+    int size() const
+    {
+        return m_size;
+    }
+
+private:
+    void run();
+    void stop();
+
+    std::mutex               m_lock;
+    std::condition_variable  m_cond;
+    std::deque<Task>         m_tasks;
+    std::vector<std::thread> m_threads;
+    const int                m_size;
+    bool                     m_stopped = false;
+};
@@ -13,10 +13,11 @@
 
 #define MXS_MODULE_NAME "cache"
 #include "cache.hh"
+#include <algorithm>
 #include <new>
 #include <set>
 #include <string>
-#include <zlib.h>
+#include <string.h>
 #include <maxscale/alloc.h>
 #include <maxscale/buffer.h>
 #include <maxscale/modutil.h>
@@ -27,6 +28,120 @@
 
 using namespace std;
 
+namespace
+{
+
+inline uint64_t rotl64(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t fmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+
+    return k;
+}
+
+/**
+ * Hashes data into 128 bits using the x64 variant of MurmurHash3. The data
+ * is consumed 16 bytes at a time, so this is considerably faster than crc32.
+ *
+ * @param pData   The data to hash.
+ * @param len     The length of the data.
+ * @param seed1   The seed of the first half of the hash.
+ * @param seed2   The seed of the second half of the hash.
+ * @param pHash   On output, the hash.
+ */
+void hash128(const uint8_t* pData, size_t len, uint64_t seed1, uint64_t seed2, uint64_t* pHash)
+{
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+    uint64_t h1 = seed1;
+    uint64_t h2 = seed2;
+
+    const size_t n_blocks = len / 16;
+
+    for (size_t i = 0; i < n_blocks; ++i)
+    {
+        uint64_t k1;
+        uint64_t k2;
+        memcpy(&k1, pData + i * 16, sizeof(k1));
+        memcpy(&k2, pData + i * 16 + 8, sizeof(k2));
+
+        k1 *= c1;
+        k1 = rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+
+        h1 = rotl64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2;
+        k2 = rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+
+        h2 = rotl64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const uint8_t* pTail = pData + n_blocks * 16;
+    size_t n_tail = len & 15;
+
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+
+    for (size_t i = n_tail; i > 8; --i)
+    {
+        k2 ^= uint64_t(pTail[i - 1]) << ((i - 9) * 8);
+    }
+
+    for (size_t i = std::min(n_tail, size_t(8)); i > 0; --i)
+    {
+        k1 ^= uint64_t(pTail[i - 1]) << ((i - 1) * 8);
+    }
+
+    if (n_tail > 8)
+    {
+        k2 *= c2;
+        k2 = rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+    }
+
+    if (n_tail > 0)
+    {
+        k1 *= c1;
+        k1 = rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+    }
+
+    h1 ^= len;
+    h2 ^= len;
+
+    h1 += h2;
+    h2 += h1;
+
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+
+    h1 += h2;
+    h2 += h1;
+
+    pHash[0] = h1;
+    pHash[1] = h2;
+}
+}
+
 Cache::Cache(const std::string& name,
              const CACHE_CONFIG* pConfig,
              const std::vector<SCacheRules>& rules,
@@ -142,22 +257,16 @@ cache_result_t Cache::get_default_key(const char* zDefault_db,
 
     modutil_extract_SQL(const_cast<GWBUF*>(pQuery), &pSql, &length);
 
-    uint64_t crc1 = crc32(0, Z_NULL, 0);
-
-    const Bytef* pData;
+    uint64_t seed[2] = {0, 0};
 
     if (zDefault_db)
     {
-        pData = reinterpret_cast<const Bytef*>(zDefault_db);
-        crc1 = crc32(crc1, pData, strlen(zDefault_db));
+        // The hash of the default database is used as the seed of the hash of
+        // the statement, so that e.g. "a" + "bc" and "ab" + "c" differ.
+        hash128(reinterpret_cast<const uint8_t*>(zDefault_db), strlen(zDefault_db), 0, 0, seed);
     }
 
-    pData = reinterpret_cast<const Bytef*>(pSql);
-
-    crc1 = crc32(crc1, pData, length);
-    uint64_t crc2 = crc32(crc1, pData, length);
-
-    pKey->data = (crc1 << 32 | crc2);
+    hash128(reinterpret_cast<const uint8_t*>(pSql), length, seed[0], seed[1], pKey->data);
 
     return CACHE_RESULT_OK;
 }
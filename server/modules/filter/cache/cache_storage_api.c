@@ -17,9 +17,10 @@
 size_t cache_key_hash(const CACHE_KEY* key)
 {
     mxb_assert(key);
-    mxb_assert(sizeof(key->data) == sizeof(size_t));
+    mxb_assert(sizeof(key->data[0]) == sizeof(size_t));
 
-    return key->data;
+    // Both halves are thoroughly mixed, so either will do as a hash.
+    return key->data[0];
 }
 
 bool cache_key_equal_to(const CACHE_KEY* lhs, const CACHE_KEY* rhs)
@@ -27,5 +28,5 @@ bool cache_key_equal_to(const CACHE_KEY* lhs, const CACHE_KEY* rhs)
     mxb_assert(lhs);
     mxb_assert(rhs);
 
-    return lhs->data == rhs->data;
+    return (lhs->data[0] == rhs->data[0]) && (lhs->data[1] == rhs->data[1]);
 }
@@ -14,6 +14,7 @@
 #define MXS_MODULE_NAME "cache"
 #include "cache_storage_api.hh"
 #include <ctype.h>
+#include <iomanip>
 #include <sstream>
 
 using std::string;
@@ -22,7 +23,7 @@ using std::stringstream;
 std::string cache_key_to_string(const CACHE_KEY& key)
 {
     stringstream ss;
-    ss << key.data;
+    ss << std::hex << std::setfill('0') << std::setw(16) << key.data[0] << std::setw(16) << key.data[1];
 
     return ss.str();
 }
@@ -59,11 +59,22 @@ typedef enum cache_thread_model
     CACHE_THREAD_MODEL_MT
 } cache_thread_model_t;
 
+typedef enum cache_invalidate
+{
+    CACHE_INVALIDATE_NEVER,     /*< No invalidation, only the TTLs apply. */
+    CACHE_INVALIDATE_CURRENT,   /*< Invalidate items when the tables they depend upon are modified. */
+} cache_invalidate_t;
+
 typedef void* CACHE_STORAGE;
 
+/**
+ * A cache key is a 128-bit hash of the default database and the statement.
+ * With 128 bits, the probability of two different statements ending up with
+ * the same key is negligible even when the cache holds billions of entries.
+ */
 typedef struct cache_key
 {
-    uint64_t data;
+    uint64_t data[2];
 } CACHE_KEY;
 
 /**
@@ -87,12 +98,13 @@ bool cache_key_equal_to(const CACHE_KEY* lhs, const CACHE_KEY* rhs);
 
 typedef enum cache_storage_capabilities
 {
-    CACHE_STORAGE_CAP_NONE      = 0x00,
-    CACHE_STORAGE_CAP_ST        = 0x01, /*< Storage can optimize for single thread. */
-    CACHE_STORAGE_CAP_MT        = 0x02, /*< Storage can handle multiple threads. */
-    CACHE_STORAGE_CAP_LRU       = 0x04, /*< Storage capable of LRU eviction. */
-    CACHE_STORAGE_CAP_MAX_COUNT = 0x08, /*< Storage capable of capping number of entries.*/
-    CACHE_STORAGE_CAP_MAX_SIZE  = 0x10, /*< Storage capable of capping size of cache.*/
+    CACHE_STORAGE_CAP_NONE         = 0x00,
+    CACHE_STORAGE_CAP_ST           = 0x01,  /*< Storage can optimize for single thread. */
+    CACHE_STORAGE_CAP_MT           = 0x02,  /*< Storage can handle multiple threads. */
+    CACHE_STORAGE_CAP_LRU          = 0x04,  /*< Storage capable of LRU eviction. */
+    CACHE_STORAGE_CAP_MAX_COUNT    = 0x08,  /*< Storage capable of capping number of entries.*/
+    CACHE_STORAGE_CAP_MAX_SIZE     = 0x10,  /*< Storage capable of capping size of cache.*/
+    CACHE_STORAGE_CAP_INVALIDATION = 0x20,  /*< Storage capable of invalidating entries.*/
 } cache_storage_capabilities_t;
 
 static inline bool cache_storage_has_cap(uint32_t capabilities, uint32_t mask)
@@ -139,6 +151,16 @@ typedef struct cache_storage_config_t
      * specify 0, unless CACHE_STORAGE_CAP_MAX_SIZE is returned at initialization.
      */
     uint64_t max_size;
+
+    /**
+     * Whether items should be invalidated when the tables they depend upon
+     * are modified. If CACHE_INVALIDATE_CURRENT is specified, the storage must
+     * keep track of the invalidation words provided when a value is put, so
+     * that the value can be deleted when @c invalidate is called with any
+     * of those words. The caller should specify CACHE_INVALIDATE_NEVER, unless
+     * CACHE_STORAGE_CAP_INVALIDATION is returned at initialization.
+     */
+    cache_invalidate_t invalidate;
 } CACHE_STORAGE_CONFIG;
 
 typedef struct cache_storage_api
@@ -235,6 +257,11 @@ typedef struct cache_storage_api
      *
      * @param storage    Pointer to a CACHE_STORAGE.
      * @param key        A key generated with get_key.
+     * @param words      Array of invalidation words, typically the fully
+     *                   qualified names of the tables the value depends upon.
+     *                   Ignored unless the storage was created with
+     *                   CACHE_INVALIDATE_CURRENT.
+     * @param n_words    The number of elements in @c words.
      * @param value      Pointer to GWBUF containing the value to be stored.
      *                   Must be one contiguous buffer.
      *
@@ -244,6 +271,8 @@ typedef struct cache_storage_api
      */
     cache_result_t (* putValue)(CACHE_STORAGE* storage,
                                 const CACHE_KEY* key,
+                                const char* const* words,
+                                size_t n_words,
                                 const GWBUF* value);
 
     /**
@@ -337,6 +366,23 @@ typedef struct cache_storage_api
      */
     cache_result_t (* getItems)(CACHE_STORAGE* storage,
                                 uint64_t* items);
+
+    /**
+     * Invalidate values. All values that were put with at least one of the
+     * provided invalidation words will be deleted.
+     *
+     * @param storage    Pointer to a CACHE_STORAGE.
+     * @param words      Array of invalidation words.
+     * @param n_words    The number of elements in @c words.
+     *
+     * @return CACHE_RESULT_OK if the invalidation succeeded,
+     *         CACHE_RESULT_OUT_OF_RESOURCES if the storage is incapable
+     *         of invalidating, and
+     *         CACHE_RESULT_ERROR otherwise.
+     */
+    cache_result_t (* invalidate)(CACHE_STORAGE* storage,
+                                  const char* const* words,
+                                  size_t n_words);
 } CACHE_STORAGE_API;
 
 #if defined __cplusplus
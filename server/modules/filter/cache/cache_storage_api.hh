@@ -45,7 +45,7 @@ std::string cache_key_to_string(const CACHE_KEY& key);
 
 inline bool operator==(const CACHE_KEY& lhs, const CACHE_KEY& rhs)
 {
-    return lhs.data == rhs.data;
+    return cache_key_equal_to(&lhs, &rhs);
 }
 
 inline bool operator!=(const CACHE_KEY& lhs, const CACHE_KEY& rhs)
@@ -58,7 +58,8 @@ class CacheKey : public CACHE_KEY
 public:
     CacheKey()
     {
-        data = 0;
+        data[0] = 0;
+        data[1] = 0;
     }
 };
 
@@ -69,13 +70,15 @@ public:
                        uint32_t hard_ttl = 0,
                        uint32_t soft_ttl = 0,
                        uint32_t max_count = 0,
-                       uint64_t max_size = 0)
+                       uint64_t max_size = 0,
+                       cache_invalidate_t invalidate = CACHE_INVALIDATE_NEVER)
     {
         this->thread_model = thread_model;
         this->hard_ttl = hard_ttl;
         this->soft_ttl = soft_ttl;
         this->max_count = max_count;
         this->max_size = max_size;
+        this->invalidate = invalidate;
     }
 
     CacheStorageConfig()
@@ -85,6 +88,7 @@ public:
         soft_ttl = 0;
         max_count = 0;
         max_size = 0;
+        invalidate = CACHE_INVALIDATE_NEVER;
     }
 
     CacheStorageConfig(const CACHE_STORAGE_CONFIG& config)
@@ -94,5 +98,6 @@ public:
         soft_ttl = config.soft_ttl;
         max_count = config.max_count;
         max_size = config.max_size;
+        invalidate = config.invalidate;
     }
 };
@@ -149,6 +149,14 @@ static const MXS_ENUM_VALUE parameter_cache_in_trxs_values[] =
     {NULL}
 };
 
+// Enumeration values for `invalidate`
+static const MXS_ENUM_VALUE parameter_invalidate_values[] =
+{
+    {"never",   CACHE_INVALIDATE_NEVER  },
+    {"current", CACHE_INVALIDATE_CURRENT},
+    {NULL}
+};
+
 extern "C" MXS_MODULE* MXS_CREATE_MODULE()
 {
     static modulecmd_arg_type_t show_argv[] =
@@ -254,6 +262,18 @@ extern "C" MXS_MODULE* MXS_CREATE_MODULE()
                 MXS_MODULE_PARAM_BOOL,
                 CACHE_ZDEFAULT_ENABLED
             },
+            {
+                "invalidate",
+                MXS_MODULE_PARAM_ENUM,
+                CACHE_ZDEFAULT_INVALIDATE,
+                MXS_MODULE_OPT_NONE,
+                parameter_invalidate_values
+            },
+            {
+                "shards",
+                MXS_MODULE_PARAM_COUNT,
+                CACHE_ZDEFAULT_SHARDS
+            },
             {MXS_END_MODULE_PARAMS}
         }
     };
@@ -363,6 +383,10 @@ bool CacheFilter::process_params(MXS_CONFIG_PARAMETER* ppParams, CACHE_CONFIG& c
                                                                         "cache_in_transactions",
                                                                         parameter_cache_in_trxs_values));
     config.enabled = config_get_bool(ppParams, "enabled");
+    config.invalidate = static_cast<cache_invalidate_t>(config_get_enum(ppParams,
+                                                                        "invalidate",
+                                                                        parameter_invalidate_values));
+    config.shards = config_get_integer(ppParams, "shards");
 
     if (!config.storage)
     {
@@ -378,6 +402,12 @@ bool CacheFilter::process_params(MXS_CONFIG_PARAMETER* ppParams, CACHE_CONFIG& c
         error = true;
     }
 
+    if (config.shards == 0)
+    {
+        MXS_ERROR("The value of the configuration entry 'shards' must be at least 1.");
+        error = true;
+    }
+
     config.rules = config_copy_string(ppParams, "rules");
 
     const MXS_CONFIG_PARAMETER* pParam = config_get_param(ppParams, "storage_options");
@@ -461,6 +491,11 @@ bool CacheFilter::process_params(MXS_CONFIG_PARAMETER* ppParams, CACHE_CONFIG& c
                 config.max_resultset_size = config.max_size;
             }
         }
+
+        if ((config.shards > 1) && (config.thread_model != CACHE_THREAD_MODEL_MT))
+        {
+            MXS_WARNING("The value of 'shards' is only used when 'cached_data' is 'shared'.");
+        }
     }
 
     if (error)
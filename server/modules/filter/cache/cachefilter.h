@@ -70,6 +70,10 @@ const cache_selects_t CACHE_DEFAULT_SELECTS = CACHE_SELECTS_ASSUME_CACHEABLE;
 #define CACHE_ZDEFAULT_CACHE_IN_TRXS "all_transactions"
 // Enabled
 #define CACHE_ZDEFAULT_ENABLED "true"
+// Invalidation
+#define CACHE_ZDEFAULT_INVALIDATE "never"
+// Positive integer
+#define CACHE_ZDEFAULT_SHARDS "1"
 
 typedef enum cache_in_trxs
 {
@@ -98,4 +102,6 @@ typedef struct cache_config
     cache_selects_t      selects;           /**< Assume/verify that selects are cacheable. */
     cache_in_trxs_t      cache_in_trxs;     /**< To cache or not to cache inside transactions. */
     bool                 enabled;           /**< Whether the cache is enabled or not. */
+    cache_invalidate_t   invalidate;        /**< Whether modifications invalidate cached items. */
+    uint32_t             shards;            /**< Number of LRU shards of a shared cache. */
 } CACHE_CONFIG;
@@ -13,6 +13,7 @@
 
 #define MXS_MODULE_NAME "cache"
 #include "cachefiltersession.hh"
+#include <algorithm>
 #include <new>
 #include <maxscale/alloc.h>
 #include <maxscale/modutil.h>
@@ -177,6 +178,41 @@ bool is_select_statement(GWBUF* pStmt)
 
     return is_select;
 }
+
+/**
+ * Whether a statement may modify the content or the structure of tables.
+ *
+ * @param pStmt  A COM_QUERY packet.
+ *
+ * @return True, if the statement may modify tables.
+ */
+bool is_modifying_statement(GWBUF* pStmt)
+{
+    bool rv = qc_query_is_type(qc_get_type_mask(pStmt), QUERY_TYPE_WRITE);
+
+    if (!rv)
+    {
+        switch (qc_get_operation(pStmt))
+        {
+        case QUERY_OP_ALTER:
+        case QUERY_OP_CREATE:
+        case QUERY_OP_DELETE:
+        case QUERY_OP_DROP:
+        case QUERY_OP_INSERT:
+        case QUERY_OP_LOAD:
+        case QUERY_OP_LOAD_LOCAL:
+        case QUERY_OP_TRUNCATE:
+        case QUERY_OP_UPDATE:
+            rv = true;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    return rv;
+}
 }
 
 CacheFilterSession::CacheFilterSession(MXS_SESSION* pSession, Cache* pCache, char* zDefaultDb)
@@ -192,8 +228,6 @@ CacheFilterSession::CacheFilterSession(MXS_SESSION* pSession, Cache* pCache, cha
     , m_soft_ttl(pCache->config().soft_ttl)
     , m_hard_ttl(pCache->config().hard_ttl)
 {
-    m_key.data = 0;
-
     reset_response_state();
 
     if (!session_add_variable(pSession,
@@ -327,6 +361,8 @@ int CacheFilterSession::routeQuery(GWBUF* pPacket)
         {
             MXS_NOTICE("COM_STMT_PREPARE, ignoring.");
         }
+
+        prepare_statement(pPacket);
         break;
 
     case MXS_COM_STMT_EXECUTE:
@@ -334,6 +370,12 @@ int CacheFilterSession::routeQuery(GWBUF* pPacket)
         {
             MXS_NOTICE("COM_STMT_EXECUTE, ignoring.");
         }
+
+        execute_statement(pPacket);
+        break;
+
+    case MXS_COM_STMT_CLOSE:
+        close_statement(pPacket);
         break;
 
     case MXS_COM_QUERY:
@@ -356,6 +398,18 @@ int CacheFilterSession::clientReply(GWBUF* pData)
 {
     int rv;
 
+    if (!m_prepared_tables.empty())
+    {
+        store_statement_id(pData);
+    }
+
+    if (!m_modified_tables.empty() && !session_trx_is_active(m_pSession))
+    {
+        // The modification has now been made or, in case of a transaction,
+        // committed (or rolled back), so the dependent entries can go.
+        invalidate_tables();
+    }
+
     if (m_res.pData)
     {
         gwbuf_append(m_res.pData, pData);
@@ -769,7 +823,7 @@ void CacheFilterSession::store_result()
     {
         m_res.pData = pData;
 
-        cache_result_t result = m_pCache->put_value(m_key, m_res.pData);
+        cache_result_t result = m_pCache->put_value(m_key, m_invalidation_words, m_res.pData);
 
         if (!CACHE_RESULT_IS_OK(result))
         {
@@ -791,6 +845,143 @@ void CacheFilterSession::store_result()
     }
 }
 
+/**
+ * Add the fully qualified names of the tables a statement refers to, to a
+ * collection of names. Names already in the collection are not added again.
+ *
+ * @param pPacket  A contiguous COM_QUERY or COM_STMT_PREPARE packet.
+ * @param pNames   The collection to add the names to.
+ */
+void CacheFilterSession::update_table_names(GWBUF* pPacket, std::vector<std::string>* pNames) const
+{
+    int n_names = 0;
+    char** pzNames = qc_get_table_names(pPacket, &n_names, true);
+
+    if (pzNames)
+    {
+        for (int i = 0; i < n_names; ++i)
+        {
+            std::string name;
+
+            if (!strchr(pzNames[i], '.') && m_zDefaultDb)
+            {
+                name = m_zDefaultDb;
+                name += ".";
+            }
+
+            name += pzNames[i];
+
+            // Whether table names are case sensitive depends upon the server
+            // configuration. Better to invalidate too much than too little.
+            std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+            if (std::find(pNames->begin(), pNames->end(), name) == pNames->end())
+            {
+                pNames->push_back(name);
+            }
+        }
+
+        qc_free_table_names(pzNames, n_names);
+    }
+}
+
+/**
+ * Invalidate all cache entries that depend upon the modified tables.
+ */
+void CacheFilterSession::invalidate_tables()
+{
+    if (log_decisions())
+    {
+        std::string tables;
+
+        for (const auto& table : m_modified_tables)
+        {
+            tables += (tables.empty() ? "" : ", ") + table;
+        }
+
+        MXS_NOTICE("Invalidating cache entries depending upon: %s", tables.c_str());
+    }
+
+    cache_result_t result = m_pCache->invalidate(m_modified_tables);
+
+    if (!CACHE_RESULT_IS_OK(result))
+    {
+        MXS_ERROR("Could not invalidate cache entries.");
+    }
+
+    m_modified_tables.clear();
+}
+
+/**
+ * Record the tables a prepared statement modifies. The tables are associated
+ * with the statement once its id is known from the response.
+ *
+ * @param pPacket  A contiguous COM_STMT_PREPARE packet.
+ */
+void CacheFilterSession::prepare_statement(GWBUF* pPacket)
+{
+    m_prepared_tables.clear();
+
+    if (should_invalidate() && is_modifying_statement(pPacket))
+    {
+        update_table_names(pPacket, &m_prepared_tables);
+    }
+}
+
+/**
+ * Associate the tables of the statement being prepared with its id.
+ *
+ * @param pResponse  The response to a COM_STMT_PREPARE.
+ */
+void CacheFilterSession::store_statement_id(GWBUF* pResponse)
+{
+    uint8_t ok[MYSQL_PS_ID_OFFSET + MYSQL_PS_ID_SIZE];
+
+    // Only COM_STMT_PREPARE_OK, which starts with 0x00, carries a statement id.
+    if (gwbuf_copy_data(pResponse, 0, sizeof(ok), ok) == sizeof(ok) && ok[MYSQL_HEADER_LEN] == 0)
+    {
+        uint32_t id = gw_mysql_get_byte4(ok + MYSQL_PS_ID_OFFSET);
+        m_ps_tables[id] = std::move(m_prepared_tables);
+    }
+
+    m_prepared_tables.clear();
+}
+
+/**
+ * Mark the tables of an executed prepared statement as modified.
+ *
+ * @param pPacket  A contiguous COM_STMT_EXECUTE packet.
+ */
+void CacheFilterSession::execute_statement(GWBUF* pPacket)
+{
+    auto it = m_ps_tables.find(mxs_mysql_extract_ps_id(pPacket));
+
+    if (it != m_ps_tables.end())
+    {
+        // As with COM_QUERY, the invalidation is performed when the response
+        // arrives or when the response ending the transaction arrives.
+        for (const auto& table : it->second)
+        {
+            auto end = m_modified_tables.end();
+
+            if (std::find(m_modified_tables.begin(), end, table) == end)
+            {
+                m_modified_tables.push_back(table);
+            }
+        }
+    }
+}
+
+/**
+ * Forget the tables of a closed prepared statement.
+ *
+ * @param pPacket  A contiguous COM_STMT_CLOSE packet.
+ */
+void CacheFilterSession::close_statement(GWBUF* pPacket)
+{
+    m_ps_tables.erase(mxs_mysql_extract_ps_id(pPacket));
+}
+
 /**
  * Whether the cache should be consulted.
  *
@@ -1014,6 +1205,8 @@ CacheFilterSession::routing_action_t CacheFilterSession::route_COM_QUERY(GWBUF*
     routing_action_t routing_action = ROUTING_CONTINUE;
     cache_action_t cache_action = get_cache_action(pPacket);
 
+    m_invalidation_words.clear();
+
     if (cache_action != CACHE_IGNORE)
     {
         const CacheRules* pRules = m_pCache->should_store(m_zDefaultDb, pPacket);
@@ -1024,6 +1217,11 @@ CacheFilterSession::routing_action_t CacheFilterSession::route_COM_QUERY(GWBUF*
 
             if (CACHE_RESULT_IS_OK(result))
             {
+                if (should_invalidate() && should_populate(cache_action))
+                {
+                    update_table_names(pPacket, &m_invalidation_words);
+                }
+
                 routing_action = route_SELECT(cache_action, *pRules, pPacket);
             }
             else
@@ -1037,6 +1235,13 @@ CacheFilterSession::routing_action_t CacheFilterSession::route_COM_QUERY(GWBUF*
             m_state = CACHE_IGNORING_RESPONSE;
         }
     }
+    else if (should_invalidate() && is_modifying_statement(pPacket))
+    {
+        // The invalidation is performed when the response arrives, or if a
+        // transaction is active, when the response to the statement ending
+        // the transaction arrives.
+        update_table_names(pPacket, &m_modified_tables);
+    }
 
     return routing_action;
 }
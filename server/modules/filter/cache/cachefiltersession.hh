@@ -13,11 +13,14 @@
 #pragma once
 
 #include <maxscale/ccdefs.hh>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <maxscale/buffer.h>
 #include <maxscale/filter.hh>
 #include "cache.hh"
 #include "cachefilter.h"
-#include "cache_storage_api.h"
+#include "cache_storage_api.hh"
 
 class CacheFilterSession : public maxscale::FilterSession
 {
@@ -114,6 +117,20 @@ private:
 
     void store_result();
 
+    bool should_invalidate() const
+    {
+        return m_pCache->config().invalidate != CACHE_INVALIDATE_NEVER;
+    }
+
+    void update_table_names(GWBUF* pPacket, std::vector<std::string>* pNames) const;
+
+    void invalidate_tables();
+
+    void prepare_statement(GWBUF* pPacket);
+    void execute_statement(GWBUF* pPacket);
+    void close_statement(GWBUF* pPacket);
+    void store_statement_id(GWBUF* pResponse);
+
     enum cache_action_t
     {
         CACHE_IGNORE           = 0,
@@ -181,16 +198,21 @@ private:
     CacheFilterSession(MXS_SESSION* pSession, Cache* pCache, char* zDefaultDb);
 
 private:
-    cache_session_state_t m_state;          /**< What state is the session in, what data is expected. */
-    Cache*                m_pCache;         /**< The cache instance the session is associated with. */
-    CACHE_RESPONSE_STATE  m_res;            /**< The response state. */
-    CACHE_KEY             m_key;            /**< Key storage. */
-    char*                 m_zDefaultDb;     /**< The default database. */
-    char*                 m_zUseDb;         /**< Pending default database. Needs server response. */
-    bool                  m_refreshing;     /**< Whether the session is updating a stale cache entry. */
-    bool                  m_is_read_only;   /**< Whether the current trx has been read-only in pratice. */
-    bool                  m_use;            /**< Whether the cache should be used in this session. */
-    bool                  m_populate;       /**< Whether the cache should be populated in this session. */
-    uint32_t              m_soft_ttl;       /**< The soft TTL used in the session. */
-    uint32_t              m_hard_ttl;       /**< The hard TTL used in the session. */
+    cache_session_state_t    m_state;              /**< What state is the session in, what data is expected. */
+    Cache*                   m_pCache;             /**< The cache instance the session is associated with. */
+    CACHE_RESPONSE_STATE     m_res;                /**< The response state. */
+    CacheKey                 m_key;                /**< Key storage. */
+    char*                    m_zDefaultDb;         /**< The default database. */
+    char*                    m_zUseDb;             /**< Pending default database. Needs server response. */
+    bool                     m_refreshing;         /**< Whether the session is updating a stale cache entry. */
+    bool                     m_is_read_only;       /**< Whether the current trx has been read-only in pratice. */
+    bool                     m_use;                /**< Whether the cache should be used in this session. */
+    bool                     m_populate;           /**< Whether the cache should be populated in this session. */
+    uint32_t                 m_soft_ttl;           /**< The soft TTL used in the session. */
+    uint32_t                 m_hard_ttl;           /**< The hard TTL used in the session. */
+    std::vector<std::string> m_invalidation_words; /**< The tables the current SELECT depends upon. */
+    std::vector<std::string> m_modified_tables;    /**< The tables modified but not yet invalidated. */
+    std::vector<std::string> m_prepared_tables;    /**< The tables the statement being prepared modifies. */
+    std::unordered_map<uint32_t, std::vector<std::string>>
+    m_ps_tables;                                   /**< The tables each prepared write statement modifies. */
 };
@@ -84,12 +84,17 @@ CacheMT* CacheMT::Create(const std::string& name,
                                       pConfig->hard_ttl,
                                       pConfig->soft_ttl,
                                       pConfig->max_count,
-                                      pConfig->max_size);
+                                      pConfig->max_size,
+                                      pConfig->invalidate);
 
     int argc = pConfig->storage_argc;
     char** argv = pConfig->storage_argv;
 
-    Storage* pStorage = sFactory->createStorage(name.c_str(), storage_config, argc, argv);
+    Storage* pStorage = sFactory->createShardedStorage(name.c_str(),
+                                                       storage_config,
+                                                       pConfig->shards,
+                                                       argc,
+                                                       argv);
 
     if (pStorage)
     {
@@ -16,6 +16,7 @@
 
 #include <maxbase/atomic.h>
 #include <maxscale/config.h>
+#include <maxscale/routingworker.hh>
 
 #include "cachest.hh"
 #include "storagefactory.hh"
@@ -136,9 +137,11 @@ cache_result_t CachePT::get_value(const CACHE_KEY& key,
     return thread_cache().get_value(key, flags, soft_ttl, hard_ttl, ppValue);
 }
 
-cache_result_t CachePT::put_value(const CACHE_KEY& key, const GWBUF* pValue)
+cache_result_t CachePT::put_value(const CACHE_KEY& key,
+                                  const std::vector<std::string>& invalidation_words,
+                                  const GWBUF* pValue)
 {
-    return thread_cache().put_value(key, pValue);
+    return thread_cache().put_value(key, invalidation_words, pValue);
 }
 
 cache_result_t CachePT::del_value(const CACHE_KEY& key)
@@ -146,6 +149,21 @@ cache_result_t CachePT::del_value(const CACHE_KEY& key)
     return thread_cache().del_value(key);
 }
 
+cache_result_t CachePT::invalidate(const std::vector<std::string>& words)
+{
+    // The cache of the current thread is invalidated immediately, the caches
+    // of the other threads when those threads get around to it. The thread
+    // caches are single threaded so they must only be accessed from their
+    // own threads.
+    auto func = [this, words]() {
+            thread_cache().invalidate(words);
+        };
+
+    size_t n_threads = mxs::RoutingWorker::broadcast(func, mxs::RoutingWorker::EXECUTE_AUTO);
+
+    return n_threads == m_caches.size() ? CACHE_RESULT_OK : CACHE_RESULT_ERROR;
+}
+
 // static
 CachePT* CachePT::Create(const std::string& name,
                          const CACHE_CONFIG* pConfig,
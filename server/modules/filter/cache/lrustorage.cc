@@ -81,7 +81,9 @@ cache_result_t LRUStorage::do_get_value(const CACHE_KEY& key,
     return access_value(APPROACH_GET, key, flags, soft_ttl, hard_ttl, ppValue);
 }
 
-cache_result_t LRUStorage::do_put_value(const CACHE_KEY& key, const GWBUF* pvalue)
+cache_result_t LRUStorage::do_put_value(const CACHE_KEY& key,
+                                        const std::vector<std::string>& invalidation_words,
+                                        const GWBUF* pvalue)
 {
     cache_result_t result = CACHE_RESULT_ERROR;
 
@@ -123,6 +125,9 @@ cache_result_t LRUStorage::do_put_value(const CACHE_KEY& key, const GWBUF* pvalu
             pNode->reset(&i->first, value_size);
             m_stats.size += pNode->size();
 
+            unindex_node(pNode);
+            index_node(pNode, invalidation_words);
+
             move_to_head(pNode);
         }
         else if (!existed)
@@ -219,6 +224,60 @@ cache_result_t LRUStorage::do_get_items(uint64_t* pItems) const
     return CACHE_RESULT_OK;
 }
 
+cache_result_t LRUStorage::do_invalidate(const std::vector<std::string>& words)
+{
+    cache_result_t result = CACHE_RESULT_OUT_OF_RESOURCES;
+
+    if (m_config.invalidate != CACHE_INVALIDATE_NEVER)
+    {
+        ++m_stats.invalidations;
+
+        result = CACHE_RESULT_OK;
+
+        for (const auto& word : words)
+        {
+            NodesByWord::iterator i = m_nodes_by_word.find(word);
+
+            if (i != m_nodes_by_word.end())
+            {
+                // Freeing a node modifies the set, so the nodes must be copied.
+                std::vector<Node*> nodes(i->second.begin(), i->second.end());
+
+                for (Node* pNode : nodes)
+                {
+                    mxb_assert(pNode->key());
+
+                    NodesByKey::iterator j = m_nodes_by_key.find(*pNode->key());
+                    mxb_assert(j != m_nodes_by_key.end());
+
+                    cache_result_t rv = m_pStorage->del_value(*pNode->key());
+
+                    if (CACHE_RESULT_IS_OK(rv) || CACHE_RESULT_IS_NOT_FOUND(rv))
+                    {
+                        // If it wasn't found, we'll assume it was because ttl has hit in.
+                        ++m_stats.invalidated;
+
+                        mxb_assert(m_stats.size >= pNode->size());
+                        mxb_assert(m_stats.items > 0);
+
+                        m_stats.size -= pNode->size();
+                        --m_stats.items;
+
+                        free_node(j);
+                    }
+                    else
+                    {
+                        MXS_ERROR("Could not invalidate value in storage.");
+                        result = rv;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
 cache_result_t LRUStorage::access_value(access_approach_t approach,
                                         const CACHE_KEY&  key,
                                         uint32_t flags,
@@ -263,6 +322,15 @@ cache_result_t LRUStorage::access_value(access_approach_t approach,
     return result;
 }
 
+bool LRUStorage::do_evict_lru()
+{
+    Node* pNode = m_pTail ? vacate_lru() : NULL;
+
+    delete pNode;
+
+    return pNode != NULL;
+}
+
 /**
  * Free the data associated with the least recently used node,
  * but not the node itself.
@@ -366,6 +434,8 @@ bool LRUStorage::free_node_data(Node* pNode)
             m_nodes_by_key.erase(i);
         }
 
+        unindex_node(pNode);
+
         mxb_assert(m_stats.size >= pNode->size());
         mxb_assert(m_stats.items > 0);
 
@@ -391,6 +461,7 @@ bool LRUStorage::free_node_data(Node* pNode)
  */
 void LRUStorage::free_node(Node* pNode) const
 {
+    unindex_node(pNode);
     remove_node(pNode);
     delete pNode;
 
@@ -464,6 +535,53 @@ void LRUStorage::move_to_head(Node* pNode) const
     mxb_assert(m_pTail->next() == NULL);
 }
 
+/**
+ * Make a node reachable via its invalidation words.
+ *
+ * @param pNode  The node to be indexed. Must currently not be indexed.
+ * @param words  The invalidation words of the node.
+ */
+void LRUStorage::index_node(Node* pNode, const std::vector<std::string>& words)
+{
+    mxb_assert(pNode->invalidation_words().empty());
+
+    if (m_config.invalidate != CACHE_INVALIDATE_NEVER)
+    {
+        for (const auto& word : words)
+        {
+            m_nodes_by_word[word].insert(pNode);
+        }
+
+        pNode->invalidation_words() = words;
+    }
+}
+
+/**
+ * Remove a node from the invalidation index.
+ *
+ * @param pNode  The node to be removed from the index.
+ */
+void LRUStorage::unindex_node(Node* pNode) const
+{
+    for (const auto& word : pNode->invalidation_words())
+    {
+        NodesByWord::iterator i = m_nodes_by_word.find(word);
+
+        // Not found, if the same word occurs several times.
+        if (i != m_nodes_by_word.end())
+        {
+            i->second.erase(pNode);
+
+            if (i->second.empty())
+            {
+                m_nodes_by_word.erase(i);
+            }
+        }
+    }
+
+    pNode->invalidation_words().clear();
+}
+
 cache_result_t LRUStorage::get_existing_node(NodesByKey::iterator& i, const GWBUF* pValue, Node** ppNode)
 {
     cache_result_t result = CACHE_RESULT_OK;
@@ -607,4 +725,6 @@ void LRUStorage::Stats::fill(json_t* pObject) const
     set_integer(pObject, "updates", updates);
     set_integer(pObject, "deletes", deletes);
     set_integer(pObject, "evictions", evictions);
+    set_integer(pObject, "invalidations", invalidations);
+    set_integer(pObject, "invalidated", invalidated);
 }
@@ -52,11 +52,13 @@ cache_result_t LRUStorageMT::get_value(const CACHE_KEY& key,
     return do_get_value(key, flags, soft_ttl, hard_ttl, ppValue);
 }
 
-cache_result_t LRUStorageMT::put_value(const CACHE_KEY& key, const GWBUF* pValue)
+cache_result_t LRUStorageMT::put_value(const CACHE_KEY& key,
+                                       const std::vector<std::string>& invalidation_words,
+                                       const GWBUF* pValue)
 {
     std::lock_guard<std::mutex> guard(m_lock);
 
-    return do_put_value(key, pValue);
+    return do_put_value(key, invalidation_words, pValue);
 }
 
 cache_result_t LRUStorageMT::del_value(const CACHE_KEY& key)
@@ -93,3 +95,10 @@ cache_result_t LRUStorageMT::get_items(uint64_t* pItems) const
 
     return LRUStorage::do_get_items(pItems);
 }
+
+cache_result_t LRUStorageMT::invalidate(const std::vector<std::string>& words)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    return LRUStorage::do_invalidate(words);
+}
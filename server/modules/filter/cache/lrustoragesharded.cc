@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#define MXS_MODULE_NAME "cache"
+#include "lrustoragesharded.hh"
+
+LRUStorageSharded::LRUStorageSharded(const CACHE_STORAGE_CONFIG& config, size_t n_shards)
+    : m_config(config)
+    , m_max_count(config.max_count != 0 ? config.max_count : UINT64_MAX)
+    , m_max_size(config.max_size != 0 ? config.max_size : UINT64_MAX)
+    , m_size(0)
+    , m_items(0)
+    , m_next_eviction(0)
+{
+    for (size_t i = 0; i < n_shards; ++i)
+    {
+        m_shards.emplace_back(new Shard);
+    }
+
+    MXS_NOTICE("Created sharded LRU storage with %lu shards.", (unsigned long)n_shards);
+}
+
+LRUStorageSharded::~LRUStorageSharded()
+{
+}
+
+LRUStorageSharded* LRUStorageSharded::create(const CACHE_STORAGE_CONFIG& config,
+                                             const std::vector<Storage*>& storages)
+{
+    mxb_assert(!storages.empty());
+
+    LRUStorageSharded* pSharded = NULL;
+
+    MXS_EXCEPTION_GUARD(pSharded = new LRUStorageSharded(config, storages.size()));
+
+    // Each shard is accessed by one thread at a time and only the totals
+    // are subject to the limits. The invalidation is handled by the shards.
+    CacheStorageConfig shard_config(config);
+    shard_config.thread_model = CACHE_THREAD_MODEL_ST;
+    shard_config.max_count = 0;
+    shard_config.max_size = 0;
+
+    for (size_t i = 0; i < storages.size(); ++i)
+    {
+        LRUStorageST* pStorage = pSharded ? LRUStorageST::create(shard_config, storages[i]) : NULL;
+
+        if (pStorage)
+        {
+            pSharded->m_shards[i]->pStorage = pStorage;
+        }
+        else
+        {
+            delete storages[i];
+            delete pSharded;
+            pSharded = NULL;
+        }
+    }
+
+    return pSharded;
+}
+
+void LRUStorageSharded::get_config(CACHE_STORAGE_CONFIG* pConfig)
+{
+    *pConfig = m_config;
+}
+
+cache_result_t LRUStorageSharded::get_info(uint32_t what,
+                                           json_t** ppInfo) const
+{
+    *ppInfo = json_object();
+
+    if (*ppInfo)
+    {
+        json_t* pShards = json_array();
+
+        if (pShards)
+        {
+            for (const auto& sShard : m_shards)
+            {
+                std::lock_guard<std::mutex> guard(sShard->lock);
+
+                json_t* pShard_info;
+
+                if (CACHE_RESULT_IS_OK(sShard->pStorage->get_info(what, &pShard_info)))
+                {
+                    json_array_append_new(pShards, pShard_info);
+                }
+            }
+
+            json_object_set_new(*ppInfo, "shards", pShards);
+        }
+
+        json_object_set_new(*ppInfo, "size", json_integer(m_size));
+        json_object_set_new(*ppInfo, "items", json_integer(m_items));
+    }
+
+    return *ppInfo ? CACHE_RESULT_OK : CACHE_RESULT_OUT_OF_RESOURCES;
+}
+
+cache_result_t LRUStorageSharded::get_value(const CACHE_KEY& key,
+                                            uint32_t flags,
+                                            uint32_t soft_ttl,
+                                            uint32_t hard_ttl,
+                                            GWBUF**  ppValue) const
+{
+    Shard& shard = shard_of(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    cache_result_t result = shard.pStorage->get_value(key, flags, soft_ttl, hard_ttl, ppValue);
+
+    // A stale item may have been discarded.
+    update_totals(shard);
+
+    return result;
+}
+
+cache_result_t LRUStorageSharded::put_value(const CACHE_KEY& key,
+                                            const std::vector<std::string>& invalidation_words,
+                                            const GWBUF* pValue)
+{
+    cache_result_t result;
+
+    if (GWBUF_LENGTH(pValue) > m_max_size)
+    {
+        // The item can never fit, but the current value must not linger.
+        del_value(key);
+        result = CACHE_RESULT_OUT_OF_RESOURCES;
+    }
+    else
+    {
+        Shard& shard = shard_of(key);
+
+        {
+            std::lock_guard<std::mutex> guard(shard.lock);
+
+            result = shard.pStorage->put_value(key, invalidation_words, pValue);
+
+            update_totals(shard);
+        }
+
+        if (CACHE_RESULT_IS_OK(result))
+        {
+            enforce_limits();
+        }
+    }
+
+    return result;
+}
+
+cache_result_t LRUStorageSharded::del_value(const CACHE_KEY& key)
+{
+    Shard& shard = shard_of(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    cache_result_t result = shard.pStorage->del_value(key);
+
+    update_totals(shard);
+
+    return result;
+}
+
+cache_result_t LRUStorageSharded::get_head(CACHE_KEY* pKey, GWBUF** ppValue) const
+{
+    // There is no global LRU order.
+    return CACHE_RESULT_OUT_OF_RESOURCES;
+}
+
+cache_result_t LRUStorageSharded::get_tail(CACHE_KEY* pKey, GWBUF** ppValue) const
+{
+    // There is no global LRU order.
+    return CACHE_RESULT_OUT_OF_RESOURCES;
+}
+
+cache_result_t LRUStorageSharded::get_size(uint64_t* pSize) const
+{
+    *pSize = m_size;
+
+    return CACHE_RESULT_OK;
+}
+
+cache_result_t LRUStorageSharded::get_items(uint64_t* pItems) const
+{
+    *pItems = m_items;
+
+    return CACHE_RESULT_OK;
+}
+
+cache_result_t LRUStorageSharded::invalidate(const std::vector<std::string>& words)
+{
+    cache_result_t result = CACHE_RESULT_OK;
+
+    for (const auto& sShard : m_shards)
+    {
+        std::lock_guard<std::mutex> guard(sShard->lock);
+
+        cache_result_t shard_result = sShard->pStorage->invalidate(words);
+
+        if (!CACHE_RESULT_IS_OK(shard_result))
+        {
+            result = shard_result;
+        }
+
+        update_totals(*sShard);
+    }
+
+    return result;
+}
+
+/**
+ * Brings the totals up to date with the current state of a shard. Must
+ * be called with the lock of the shard held.
+ *
+ * @param shard  The shard that may have changed.
+ */
+void LRUStorageSharded::update_totals(Shard& shard) const
+{
+    uint64_t size;
+    uint64_t items;
+
+    shard.pStorage->get_size(&size);
+    shard.pStorage->get_items(&items);
+
+    // Unsigned arithmetic, so also a decrease is correctly added.
+    m_size += size - shard.size;
+    m_items += items - shard.items;
+
+    shard.size = size;
+    shard.items = items;
+}
+
+/**
+ * Evicts items, one shard at a time, until the totals are within the limits.
+ * No lock may be held when this is called.
+ */
+void LRUStorageSharded::enforce_limits()
+{
+    size_t n_empty = 0;
+
+    while (((m_items > m_max_count) || (m_size > m_max_size)) && (n_empty < m_shards.size()))
+    {
+        Shard& shard = *m_shards[m_next_eviction++ % m_shards.size()];
+        std::lock_guard<std::mutex> guard(shard.lock);
+
+        if (shard.pStorage->evict_lru())
+        {
+            update_totals(shard);
+            n_empty = 0;
+        }
+        else
+        {
+            ++n_empty;
+        }
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "lrustoragest.hh"
+
+/**
+ * LRUStorageSharded divides the items between a number of independent LRU
+ * storages, selected using the key, each protected by a lock of its own.
+ * Threads accessing different shards do not contend with each other.
+ *
+ * The maximum count and size are enforced over all shards. When exceeded,
+ * the least recently used item of a shard is evicted, with the shards taking
+ * turns. The eviction order is thus only approximately LRU.
+ */
+class LRUStorageSharded : public Storage
+{
+public:
+    ~LRUStorageSharded();
+
+    /**
+     * Create a sharded storage.
+     *
+     * @param config    The configuration, including the global limits.
+     * @param storages  The storages the shards should use, one per shard. The
+     *                  storages must be independent of each other. They are
+     *                  owned by the returned instance, and deleted if the
+     *                  instance cannot be created.
+     *
+     * @return A new instance or NULL if out of memory.
+     */
+    static LRUStorageSharded* create(const CACHE_STORAGE_CONFIG& config,
+                                     const std::vector<Storage*>& storages);
+
+    void get_config(CACHE_STORAGE_CONFIG* pConfig);
+
+    cache_result_t get_info(uint32_t what,
+                            json_t** ppInfo) const;
+
+    cache_result_t get_value(const CACHE_KEY& key,
+                             uint32_t flags,
+                             uint32_t soft_ttl,
+                             uint32_t hard_ttl,
+                             GWBUF**  ppValue) const;
+
+    cache_result_t put_value(const CACHE_KEY& key,
+                             const std::vector<std::string>& invalidation_words,
+                             const GWBUF* pValue);
+
+    cache_result_t del_value(const CACHE_KEY& key);
+
+    cache_result_t get_head(CACHE_KEY* pKey,
+                            GWBUF** ppValue) const;
+
+    cache_result_t get_tail(CACHE_KEY* pKey,
+                            GWBUF** ppValue) const;
+
+    cache_result_t get_size(uint64_t* pSize) const;
+
+    cache_result_t get_items(uint64_t* pItems) const;
+
+    cache_result_t invalidate(const std::vector<std::string>& words);
+
+private:
+    LRUStorageSharded(const CACHE_STORAGE_CONFIG& config, size_t n_shards);
+
+    LRUStorageSharded(const LRUStorageSharded&);
+    LRUStorageSharded& operator=(const LRUStorageSharded&);
+
+    struct Shard
+    {
+        Shard()
+            : pStorage(NULL)
+            , size(0)
+            , items(0)
+        {
+        }
+
+        ~Shard()
+        {
+            delete pStorage;
+        }
+
+        std::mutex    lock;
+        LRUStorageST* pStorage;
+        uint64_t      size;     /*< The size of the shard, when last accessed. */
+        uint64_t      items;    /*< The items of the shard, when last accessed. */
+    };
+
+    typedef std::vector<std::unique_ptr<Shard>> Shards;
+
+    Shard& shard_of(const CACHE_KEY& key) const
+    {
+        return *m_shards[key.data[1] % m_shards.size()];
+    }
+
+    void update_totals(Shard& shard) const;
+    void enforce_limits();
+
+    const CACHE_STORAGE_CONFIG    m_config;         /*< The configuration. */
+    const uint64_t                m_max_count;      /*< The maximum number of items in all shards. */
+    const uint64_t                m_max_size;       /*< The maximum size of all items in all shards. */
+    Shards                        m_shards;         /*< The shards. */
+    mutable std::atomic<uint64_t> m_size;           /*< The total size of all shards. */
+    mutable std::atomic<uint64_t> m_items;          /*< The total number of items in all shards. */
+    std::atomic<size_t>           m_next_eviction;  /*< The shard to evict from next. */
+};
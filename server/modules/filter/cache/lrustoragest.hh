@@ -32,6 +32,7 @@ public:
                              GWBUF**  ppValue) const;
 
     cache_result_t put_value(const CACHE_KEY& key,
+                             const std::vector<std::string>& invalidation_words,
                              const GWBUF* pValue);
 
     cache_result_t del_value(const CACHE_KEY& key);
@@ -46,6 +47,10 @@ public:
 
     cache_result_t get_items(uint64_t* pItems) const;
 
+    cache_result_t invalidate(const std::vector<std::string>& words);
+
+    bool evict_lru();
+
 private:
     LRUStorageST(const CACHE_STORAGE_CONFIG& config, Storage* pstorage);
 
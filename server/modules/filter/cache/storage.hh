@@ -13,6 +13,8 @@
 #pragma once
 
 #include <maxscale/ccdefs.hh>
+#include <string>
+#include <vector>
 #include "cache_storage_api.h"
 
 class Storage
@@ -80,14 +82,24 @@ public:
     /**
      * Put a value to the cache.
      *
-     * @param key     A key generated with get_key.
-     * @param pValue  Pointer to GWBUF containing the value to be stored.
-     *                Must be one contiguous buffer.
+     * @param key                 A key generated with get_key.
+     * @param invalidation_words  Words that, when given to @c invalidate, cause
+     *                            the value to be deleted. Typically the fully
+     *                            qualified names of the tables the value depends upon.
+     * @param pValue              Pointer to GWBUF containing the value to be stored.
+     *                            Must be one contiguous buffer.
      * @return CACHE_RESULT_OK if item was successfully put,
      *         CACHE_RESULT_OUT_OF_RESOURCES if item could not be put, due to
      *         some resource having become exhausted, or some other error code.
      */
-    virtual cache_result_t put_value(const CACHE_KEY& key, const GWBUF* pValue) = 0;
+    virtual cache_result_t put_value(const CACHE_KEY& key,
+                                     const std::vector<std::string>& invalidation_words,
+                                     const GWBUF* pValue) = 0;
+
+    cache_result_t put_value(const CACHE_KEY& key, const GWBUF* pValue)
+    {
+        return put_value(key, std::vector<std::string>(), pValue);
+    }
 
     /**
      * Delete a value from the cache.
@@ -170,6 +182,19 @@ public:
      */
     virtual cache_result_t get_items(uint64_t* pItems) const = 0;
 
+    /**
+     * Invalidate values. All values that were put with at least one of the
+     * provided invalidation words will be deleted.
+     *
+     * @param words  The invalidation words.
+     *
+     * @return CACHE_RESULT_OK if the invalidation succeeded,
+     *         CACHE_RESULT_OUT_OF_RESOURCES if the storage is incapable
+     *         of invalidating, and
+     *         CACHE_RESULT_ERROR otherwise.
+     */
+    virtual cache_result_t invalidate(const std::vector<std::string>& words) = 0;
+
 protected:
     Storage();
 
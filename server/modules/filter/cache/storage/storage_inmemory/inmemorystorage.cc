@@ -45,7 +45,7 @@ InMemoryStorage::~InMemoryStorage()
 
 bool InMemoryStorage::Initialize(uint32_t* pCapabilities)
 {
-    *pCapabilities = (CACHE_STORAGE_CAP_ST | CACHE_STORAGE_CAP_MT);
+    *pCapabilities = (CACHE_STORAGE_CAP_ST | CACHE_STORAGE_CAP_MT | CACHE_STORAGE_CAP_INVALIDATION);
 
     return true;
 }
@@ -170,7 +170,7 @@ cache_result_t InMemoryStorage::do_get_value(const CACHE_KEY& key,
 
         if (is_hard_stale)
         {
-            m_entries.erase(i);
+            erase_entry(i);
             result |= CACHE_RESULT_DISCARDED;
         }
         else if (!is_soft_stale || include_stale)
@@ -209,7 +209,9 @@ cache_result_t InMemoryStorage::do_get_value(const CACHE_KEY& key,
     return result;
 }
 
-cache_result_t InMemoryStorage::do_put_value(const CACHE_KEY& key, const GWBUF& value)
+cache_result_t InMemoryStorage::do_put_value(const CACHE_KEY& key,
+                                             const std::vector<std::string>& invalidation_words,
+                                             const GWBUF& value)
 {
     mxb_assert(GWBUF_IS_CONTIGUOUS(&value));
 
@@ -231,6 +233,8 @@ cache_result_t InMemoryStorage::do_put_value(const CACHE_KEY& key, const GWBUF&
 
         pEntry = &i->second;
 
+        unindex_entry(key, pEntry);
+
         m_stats.size -= pEntry->value.size();
 
         if (size < pEntry->value.capacity())
@@ -253,14 +257,17 @@ cache_result_t InMemoryStorage::do_put_value(const CACHE_KEY& key, const GWBUF&
     copy(pData, pData + size, pEntry->value.begin());
     pEntry->time = time(NULL);
 
+    index_entry(key, pEntry, invalidation_words);
+
     return CACHE_RESULT_OK;
 }
 
 cache_result_t InMemoryStorage::do_del_value(const CACHE_KEY& key)
 {
     Entries::iterator i = m_entries.find(key);
+    bool existed = (i != m_entries.end());
 
-    if (i != m_entries.end())
+    if (existed)
     {
         mxb_assert(m_stats.size >= i->second.value.size());
         mxb_assert(m_stats.items > 0);
@@ -269,10 +276,94 @@ cache_result_t InMemoryStorage::do_del_value(const CACHE_KEY& key)
         m_stats.items -= 1;
         m_stats.deletes += 1;
 
-        m_entries.erase(i);
+        erase_entry(i);
+    }
+
+    return existed ? CACHE_RESULT_OK : CACHE_RESULT_NOT_FOUND;
+}
+
+cache_result_t InMemoryStorage::do_invalidate(const std::vector<std::string>& words)
+{
+    cache_result_t result = CACHE_RESULT_OUT_OF_RESOURCES;
+
+    if (m_config.invalidate != CACHE_INVALIDATE_NEVER)
+    {
+        m_stats.invalidations += 1;
+
+        for (const auto& word : words)
+        {
+            KeysByWord::iterator i = m_keys_by_word.find(word);
+
+            if (i != m_keys_by_word.end())
+            {
+                // Erasing an entry modifies the set, so the keys must be copied.
+                std::vector<CACHE_KEY> keys(i->second.begin(), i->second.end());
+
+                for (const auto& key : keys)
+                {
+                    Entries::iterator j = m_entries.find(key);
+                    mxb_assert(j != m_entries.end());
+
+                    mxb_assert(m_stats.size >= j->second.value.size());
+                    mxb_assert(m_stats.items > 0);
+
+                    m_stats.size -= j->second.value.size();
+                    m_stats.items -= 1;
+                    m_stats.invalidated += 1;
+
+                    erase_entry(j);
+                }
+            }
+        }
+
+        result = CACHE_RESULT_OK;
+    }
+
+    return result;
+}
+
+void InMemoryStorage::index_entry(const CACHE_KEY& key,
+                                  Entry* pEntry,
+                                  const std::vector<std::string>& words)
+{
+    mxb_assert(pEntry->invalidation_words.empty());
+
+    if (m_config.invalidate != CACHE_INVALIDATE_NEVER)
+    {
+        for (const auto& word : words)
+        {
+            m_keys_by_word[word].insert(key);
+        }
+
+        pEntry->invalidation_words = words;
+    }
+}
+
+void InMemoryStorage::unindex_entry(const CACHE_KEY& key, Entry* pEntry)
+{
+    for (const auto& word : pEntry->invalidation_words)
+    {
+        KeysByWord::iterator i = m_keys_by_word.find(word);
+
+        // Not found, if the same word occurs several times.
+        if (i != m_keys_by_word.end())
+        {
+            i->second.erase(key);
+
+            if (i->second.empty())
+            {
+                m_keys_by_word.erase(i);
+            }
+        }
     }
 
-    return i != m_entries.end() ? CACHE_RESULT_OK : CACHE_RESULT_NOT_FOUND;
+    pEntry->invalidation_words.clear();
+}
+
+void InMemoryStorage::erase_entry(Entries::iterator i)
+{
+    unindex_entry(i->first, &i->second);
+    m_entries.erase(i);
 }
 
 static void set_integer(json_t* pObject, const char* zName, size_t value)
@@ -294,4 +385,6 @@ void InMemoryStorage::Stats::fill(json_t* pObject) const
     set_integer(pObject, "misses", misses);
     set_integer(pObject, "updates", updates);
     set_integer(pObject, "deletes", deletes);
+    set_integer(pObject, "invalidations", invalidations);
+    set_integer(pObject, "invalidated", invalidated);
 }
@@ -17,6 +17,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include "../../cache_storage_api.hh"
 
 class InMemoryStorage
@@ -38,8 +39,11 @@ public:
                                      uint32_t soft_ttl,
                                      uint32_t hard_ttl,
                                      GWBUF**  ppResult) = 0;
-    virtual cache_result_t put_value(const CACHE_KEY& key, const GWBUF& value) = 0;
+    virtual cache_result_t put_value(const CACHE_KEY& key,
+                                     const std::vector<std::string>& invalidation_words,
+                                     const GWBUF& value) = 0;
     virtual cache_result_t del_value(const CACHE_KEY& key) = 0;
+    virtual cache_result_t invalidate(const std::vector<std::string>& words) = 0;
 
     cache_result_t get_head(CACHE_KEY* pKey, GWBUF** ppHead) const;
     cache_result_t get_tail(CACHE_KEY* pKey, GWBUF** ppHead) const;
@@ -56,8 +60,11 @@ protected:
                                 uint32_t soft_ttl,
                                 uint32_t hard_ttl,
                                 GWBUF**  ppResult);
-    cache_result_t do_put_value(const CACHE_KEY& key, const GWBUF& value);
+    cache_result_t do_put_value(const CACHE_KEY& key,
+                                const std::vector<std::string>& invalidation_words,
+                                const GWBUF& value);
     cache_result_t do_del_value(const CACHE_KEY& key);
+    cache_result_t do_invalidate(const std::vector<std::string>& words);
 
 private:
     InMemoryStorage(const InMemoryStorage&);
@@ -73,8 +80,9 @@ private:
         {
         }
 
-        uint32_t time;
-        Value    value;
+        uint32_t                 time;
+        Value                    value;
+        std::vector<std::string> invalidation_words;
     };
 
     struct Stats
@@ -86,6 +94,8 @@ private:
             , misses(0)
             , updates(0)
             , deletes(0)
+            , invalidations(0)
+            , invalidated(0)
         {
         }
 
@@ -96,13 +106,21 @@ private:
         uint64_t hits;      /*< How many times a key was found in the cache. */
         uint64_t misses;    /*< How many times a key was not found in the cache. */
         uint64_t updates;   /*< How many times an existing key in the cache was updated. */
-        uint64_t deletes;   /*< How many times an existing key in the cache was deleted. */
+        uint64_t deletes;       /*< How many times an existing key in the cache was deleted. */
+        uint64_t invalidations; /*< How many times an invalidation has been performed. */
+        uint64_t invalidated;   /*< How many items have been deleted due to invalidation. */
     };
 
-    typedef std::unordered_map<CACHE_KEY, Entry> Entries;
+    typedef std::unordered_map<CACHE_KEY, Entry>                         Entries;
+    typedef std::unordered_map<std::string, std::unordered_set<CACHE_KEY>> KeysByWord;
+
+    void index_entry(const CACHE_KEY& key, Entry* pEntry, const std::vector<std::string>& words);
+    void unindex_entry(const CACHE_KEY& key, Entry* pEntry);
+    void erase_entry(Entries::iterator i);
 
     std::string                m_name;
     const CACHE_STORAGE_CONFIG m_config;
     Entries                    m_entries;
+    KeysByWord                 m_keys_by_word;  /*< Invalidation word to keys of entries. */
     Stats                      m_stats;
 };
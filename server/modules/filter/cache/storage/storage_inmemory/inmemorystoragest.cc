@@ -48,12 +48,19 @@ cache_result_t InMemoryStorageST::get_value(const CACHE_KEY& key,
     return do_get_value(key, flags, soft_ttl, hard_ttl, ppResult);
 }
 
-cache_result_t InMemoryStorageST::put_value(const CACHE_KEY& key, const GWBUF& value)
+cache_result_t InMemoryStorageST::put_value(const CACHE_KEY& key,
+                                            const std::vector<std::string>& invalidation_words,
+                                            const GWBUF& value)
 {
-    return do_put_value(key, value);
+    return do_put_value(key, invalidation_words, value);
 }
 
 cache_result_t InMemoryStorageST::del_value(const CACHE_KEY& key)
 {
     return do_del_value(key);
 }
+
+cache_result_t InMemoryStorageST::invalidate(const std::vector<std::string>& words)
+{
+    return do_invalidate(words);
+}
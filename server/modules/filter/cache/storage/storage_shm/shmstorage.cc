@@ -0,0 +1,1526 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#define MXS_MODULE_NAME "storage_shm"
+#include "shmstorage.hh"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <maxscale/alloc.h>
+#include <maxscale/log.h>
+#include <maxscale/paths.h>
+
+using std::string;
+using std::vector;
+
+namespace
+{
+
+const uint64_t SHM_MAGIC = 0x45484341435358ffULL;
+const uint32_t SHM_VERSION = 2;
+
+const uint64_t SHM_DEFAULT_SIZE = 64 * 1024 * 1024;
+const uint64_t SHM_MIN_SIZE = 1024 * 1024;
+
+// The chunks of the smallest size class are 256 bytes, those of the largest 16MB.
+const int SHM_MIN_CLASS_SHIFT = 8;
+const int SHM_N_SIZE_CLASSES = 17;
+
+// In the chunk map, the byte of the first unit of a free chunk has this bit set.
+const uint8_t SHM_CHUNK_FREE = 0x80;
+
+// One bucket per this many bytes of the file.
+const uint64_t SHM_BYTES_PER_BUCKET = 4096;
+const uint64_t SHM_MIN_BUCKETS = 1024;
+
+inline uint64_t round_up(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+inline uint64_t class_size(int size_class)
+{
+    return uint64_t(1) << (SHM_MIN_CLASS_SHIFT + size_class);
+}
+
+/**
+ * The FNV-1a hash of an invalidation word. The hash is stored in the file,
+ * so it must not depend on the process.
+ */
+uint32_t word_hash(const char* zWord)
+{
+    uint32_t hash = 2166136261U;
+
+    while (*zWord)
+    {
+        hash ^= static_cast<uint8_t>(*zWord++);
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+/**
+ * Returns the size class whose chunks can hold the specified number of bytes.
+ *
+ * @param size  The number of bytes needed.
+ *
+ * @return The size class; SHM_N_SIZE_CLASSES if the size is too large.
+ */
+int size_class_of(uint64_t size)
+{
+    int size_class = 0;
+
+    while ((size_class < SHM_N_SIZE_CLASSES) && (class_size(size_class) < size))
+    {
+        ++size_class;
+    }
+
+    return size_class;
+}
+
+bool parse_size(const char* zValue, uint64_t* pSize)
+{
+    char* zEnd;
+    uint64_t size = strtoull(zValue, &zEnd, 10);
+    bool rv = (zEnd != zValue);
+
+    if (rv)
+    {
+        switch (*zEnd)
+        {
+        case 'G':
+        case 'g':
+            size *= 1024;
+
+        case 'M':
+        case 'm':
+            size *= 1024;
+
+        case 'K':
+        case 'k':
+            size *= 1024;
+            ++zEnd;
+            break;
+
+        default:
+            break;
+        }
+
+        rv = (*zEnd == 0);
+    }
+
+    if (rv)
+    {
+        *pSize = size;
+    }
+
+    return rv;
+}
+
+void set_integer(json_t* pObject, const char* zName, size_t value)
+{
+    json_t* pValue = json_integer(value);
+
+    if (pValue)
+    {
+        json_object_set(pObject, zName, pValue);
+        json_decref(pValue);
+    }
+}
+
+struct Stats
+{
+    void fill(json_t* pObject) const
+    {
+        set_integer(pObject, "size", size);
+        set_integer(pObject, "items", items);
+        set_integer(pObject, "hits", hits);
+        set_integer(pObject, "misses", misses);
+        set_integer(pObject, "updates", updates);
+        set_integer(pObject, "deletes", deletes);
+        set_integer(pObject, "evictions", evictions);
+        set_integer(pObject, "invalidations", invalidations);
+        set_integer(pObject, "invalidated", invalidated);
+    }
+
+    uint64_t size;          /*< The total size of the stored values. */
+    uint64_t items;         /*< The number of stored items. */
+    uint64_t hits;          /*< How many times a key was found in the cache. */
+    uint64_t misses;        /*< How many times a key was not found in the cache. */
+    uint64_t updates;       /*< How many times an existing key in the cache was updated. */
+    uint64_t deletes;       /*< How many times an existing key in the cache was deleted. */
+    uint64_t evictions;     /*< How many times an item has been evicted from the cache. */
+    uint64_t invalidations; /*< How many times an invalidation has been performed. */
+    uint64_t invalidated;   /*< How many items have been deleted due to invalidation. */
+};
+}
+
+/**
+ * The header is at the beginning of the file. It is followed by the key
+ * buckets, the word buckets, the chunk map and then by the chunks in which
+ * the entries are stored. All references within the file are offsets from
+ * the beginning of the file, with 0 meaning none, so that the file can be
+ * mapped at any address.
+ *
+ * The chunks are managed as a buddy system: a free chunk is split in halves
+ * when a smaller chunk is needed and a released chunk is merged with its free
+ * buddy, so space freed by entries of one size class can be used by entries
+ * of any other. The chunk map has one byte for each unit of the size of the
+ * smallest chunk; the byte of the first unit of a chunk tells its size class
+ * and whether it is free.
+ */
+struct ShmStorage::Header
+{
+    uint64_t        magic;
+    uint32_t        version;
+    uint32_t        header_size;    /*< sizeof(Header), changes if e.g. pthread_mutex_t changes. */
+    Layout          layout;
+    uint64_t        head;           /*< The most recently used entry. */
+    uint64_t        tail;           /*< The least recently used entry. */
+    uint64_t        class_head[SHM_N_SIZE_CLASSES]; /*< The most recently used entry of a class. */
+    uint64_t        class_tail[SHM_N_SIZE_CLASSES]; /*< The least recently used entry of a class. */
+    uint64_t        free_chunks[SHM_N_SIZE_CLASSES];
+    Stats           stats;
+    pthread_mutex_t lock;
+};
+
+/**
+ * An invalidation word of an entry. The links of all words whose hashes fall
+ * in the same word bucket form a list, so the entries that depend on a word
+ * are found without checking all entries. The link is followed by the NULL
+ * terminated word.
+ */
+struct ShmStorage::WordLink
+{
+    char* word()
+    {
+        return reinterpret_cast<char*>(this + 1);
+    }
+
+    const char* word() const
+    {
+        return reinterpret_cast<const char*>(this + 1);
+    }
+
+    uint64_t entry;     /*< The entry the word belongs to. */
+    uint64_t prev;      /*< The previous link in the same bucket. */
+    uint64_t next;      /*< The next link in the same bucket. */
+    uint32_t hash;
+    uint32_t length;    /*< The length of the link, including the word and the padding. */
+};
+
+/**
+ * An entry occupies a chunk of the size class it was allocated from. The
+ * entry is followed by the links of its invalidation words and then the
+ * value.
+ */
+struct ShmStorage::Entry
+{
+    WordLink* words()
+    {
+        return reinterpret_cast<WordLink*>(this + 1);
+    }
+
+    const uint8_t* value() const
+    {
+        return reinterpret_cast<const uint8_t*>(this + 1) + words_length;
+    }
+
+    uint8_t* value()
+    {
+        return reinterpret_cast<uint8_t*>(this + 1) + words_length;
+    }
+
+    CACHE_KEY key;
+    uint64_t  bucket_next;  /*< The next entry in the same bucket. */
+    uint64_t  prev;         /*< The next more recently used entry. */
+    uint64_t  next;         /*< The next less recently used entry. */
+    uint64_t  class_prev;   /*< As prev but within the size class, or the previous free chunk. */
+    uint64_t  class_next;   /*< As next but within the size class, or the next free chunk. */
+    uint64_t  value_length;
+    uint32_t  words_length;
+    uint32_t  time;
+    uint32_t  size_class;
+    uint32_t  n_words;
+};
+
+class ShmStorage::Guard
+{
+public:
+    Guard(const ShmStorage& storage)
+        : m_storage(storage)
+    {
+        m_storage.lock();
+    }
+
+    ~Guard()
+    {
+        m_storage.unlock();
+    }
+
+private:
+    const ShmStorage& m_storage;
+};
+
+namespace
+{
+
+/**
+ * Sets the offsets and sizes of the areas of a file of the specified size.
+ */
+void set_layout(ShmStorage::Layout* pLayout, uint64_t size)
+{
+    uint64_t n_buckets = SHM_MIN_BUCKETS;
+
+    while (n_buckets < size / SHM_BYTES_PER_BUCKET)
+    {
+        n_buckets *= 2;
+    }
+
+    pLayout->size = size;
+    pLayout->n_buckets = n_buckets;
+    pLayout->buckets = round_up(sizeof(ShmStorage::Header), 64);
+    pLayout->word_buckets = pLayout->buckets + n_buckets * sizeof(uint64_t);
+    pLayout->chunk_map = pLayout->word_buckets + n_buckets * sizeof(uint64_t);
+
+    // The map is sized for the space that remains, which is a little more than the chunks need.
+    uint64_t n_units = (size - pLayout->chunk_map) >> SHM_MIN_CLASS_SHIFT;
+
+    pLayout->chunks = round_up(pLayout->chunk_map + n_units, 4096);
+    pLayout->chunks_size = ((size - pLayout->chunks) >> SHM_MIN_CLASS_SHIFT) << SHM_MIN_CLASS_SHIFT;
+}
+
+/**
+ * Checks that the header is one written by this version of the module for a
+ * file of the specified size. As all offsets are checked against the layout,
+ * the layout itself must be exactly what this version would have created.
+ */
+bool is_compatible(const ShmStorage::Header& header, uint64_t file_size)
+{
+    bool rv = header.magic == SHM_MAGIC
+        && header.version == SHM_VERSION
+        && header.header_size == sizeof(ShmStorage::Header)
+        && header.layout.size == file_size
+        && file_size >= SHM_MIN_SIZE;
+
+    if (rv)
+    {
+        ShmStorage::Layout layout;
+        set_layout(&layout, file_size);
+
+        rv = header.layout.n_buckets == layout.n_buckets
+            && header.layout.buckets == layout.buckets
+            && header.layout.word_buckets == layout.word_buckets
+            && header.layout.chunk_map == layout.chunk_map
+            && header.layout.chunks == layout.chunks
+            && header.layout.chunks_size == layout.chunks_size;
+    }
+
+    return rv;
+}
+
+inline uint64_t word_link_length(const string& word)
+{
+    return round_up(sizeof(ShmStorage::WordLink) + word.length() + 1, sizeof(uint64_t));
+}
+
+inline uint8_t* chunk_map_of(ShmStorage::Header& header, const ShmStorage::Layout& layout)
+{
+    return reinterpret_cast<uint8_t*>(&header) + layout.chunk_map;
+}
+
+/**
+ * Returns the chunk at an offset. The offsets are read from a file that other
+ * processes can modify, so they are checked also in release builds, against
+ * the layout the file had when it was opened.
+ *
+ * @return The chunk, or NULL if the offset is 0 or not the start of a unit
+ *         within the chunk area.
+ */
+inline ShmStorage::Entry* chunk_at(ShmStorage::Header& header, const ShmStorage::Layout& layout, uint64_t offset)
+{
+    bool valid = (offset >= layout.chunks)
+        && (offset - layout.chunks < layout.chunks_size)
+        && (((offset - layout.chunks) & (class_size(0) - 1)) == 0);
+
+    return valid ? reinterpret_cast<ShmStorage::Entry*>(reinterpret_cast<uint8_t*>(&header) + offset) : NULL;
+}
+
+void push_free_chunk(ShmStorage::Header& header,
+                     const ShmStorage::Layout& layout,
+                     uint64_t offset,
+                     int size_class)
+{
+    ShmStorage::Entry* pChunk = chunk_at(header, layout, offset);
+    mxb_assert(pChunk);
+
+    pChunk->size_class = size_class;
+    pChunk->class_prev = 0;
+    pChunk->class_next = header.free_chunks[size_class];
+
+    if (ShmStorage::Entry* pNext = chunk_at(header, layout, pChunk->class_next))
+    {
+        pNext->class_prev = offset;
+    }
+
+    header.free_chunks[size_class] = offset;
+    chunk_map_of(header, layout)[(offset - layout.chunks) >> SHM_MIN_CLASS_SHIFT] = SHM_CHUNK_FREE | size_class;
+}
+
+/**
+ * Removes a chunk from the free list of its size class.
+ *
+ * @return False, if the offset or the chunk is not valid.
+ */
+bool remove_free_chunk(ShmStorage::Header& header, const ShmStorage::Layout& layout, uint64_t offset)
+{
+    ShmStorage::Entry* pChunk = chunk_at(header, layout, offset);
+    bool rv = pChunk && (pChunk->size_class < SHM_N_SIZE_CLASSES);
+
+    if (rv)
+    {
+        if (ShmStorage::Entry* pPrev = chunk_at(header, layout, pChunk->class_prev))
+        {
+            pPrev->class_next = pChunk->class_next;
+        }
+        else
+        {
+            header.free_chunks[pChunk->size_class] = pChunk->class_next;
+        }
+
+        if (ShmStorage::Entry* pNext = chunk_at(header, layout, pChunk->class_next))
+        {
+            pNext->class_prev = pChunk->class_prev;
+        }
+
+        chunk_map_of(header, layout)[(offset - layout.chunks) >> SHM_MIN_CLASS_SHIFT] = pChunk->size_class;
+    }
+
+    return rv;
+}
+
+/**
+ * Divides the chunk area into free chunks, each as large as its alignment
+ * within the area allows. That way the buddy of a chunk is always either a
+ * chunk of the same size or divided into smaller chunks.
+ */
+void format_chunks(ShmStorage::Header& header, const ShmStorage::Layout& layout)
+{
+    memset(header.free_chunks, 0, sizeof(header.free_chunks));
+
+    uint64_t pos = 0;
+
+    while (pos + class_size(0) <= layout.chunks_size)
+    {
+        int size_class = SHM_N_SIZE_CLASSES - 1;
+
+        while ((pos & (class_size(size_class) - 1)) || (pos + class_size(size_class) > layout.chunks_size))
+        {
+            --size_class;
+        }
+
+        push_free_chunk(header, layout, layout.chunks + pos, size_class);
+        pos += class_size(size_class);
+    }
+}
+
+bool initialize(ShmStorage::Header* pHeader, uint64_t size)
+{
+    bool rv = false;
+
+    memset(pHeader, 0, sizeof(*pHeader));
+    set_layout(&pHeader->layout, size);
+
+    pthread_mutexattr_t attr;
+
+    if (pthread_mutexattr_init(&attr) == 0)
+    {
+        // If a process dies while holding the lock, the next one to lock it
+        // gets EOWNERDEAD, instead of blocking forever.
+        if (pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) == 0
+            && pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST) == 0
+            && pthread_mutex_init(&pHeader->lock, &attr) == 0)
+        {
+            format_chunks(*pHeader, pHeader->layout);
+
+            pHeader->magic = SHM_MAGIC;
+            pHeader->version = SHM_VERSION;
+            pHeader->header_size = sizeof(*pHeader);
+            rv = true;
+        }
+
+        pthread_mutexattr_destroy(&attr);
+    }
+
+    return rv;
+}
+
+/**
+ * Opens the cache file, creating it if it does not exist. An existing file is
+ * only used if it is a regular file that is owned by the effective user of
+ * MaxScale and that no other user can write to, as all data in it is trusted.
+ *
+ * @param zPath  The path of the file.
+ *
+ * @return The file descriptor, or -1 if the file could not or should not be used.
+ */
+int open_file(const char* zPath)
+{
+    int fd = open(zPath, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, S_IRUSR | S_IWUSR);
+
+    if (fd == -1 && errno == EEXIST)
+    {
+        fd = open(zPath, O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+    }
+
+    struct stat st;
+
+    if (fd == -1)
+    {
+        MXS_ERROR("Could not open the cache file '%s': %s", zPath, mxs_strerror(errno));
+    }
+    else if (fstat(fd, &st) != 0
+             || !S_ISREG(st.st_mode)
+             || st.st_uid != geteuid()
+             || (st.st_mode & (S_IWGRP | S_IWOTH)))
+    {
+        MXS_ERROR("The cache file '%s' is not a regular file owned by the user MaxScale "
+                  "runs as, or it is writable by other users. The file will not be used.",
+                  zPath);
+        close(fd);
+        fd = -1;
+    }
+
+    return fd;
+}
+
+enum file_state_t
+{
+    FILE_NEW,           /*< The file has not been initialized. */
+    FILE_COMPATIBLE,    /*< The file contains a cache created by this version. */
+    FILE_OTHER          /*< The file contains something else. */
+};
+
+/**
+ * Finds out what a locked file contains.
+ *
+ * @param fd       The file.
+ * @param pHeader  The header is read here.
+ *
+ * @return The state of the file.
+ */
+file_state_t get_file_state(int fd, ShmStorage::Header* pHeader)
+{
+    file_state_t rv = FILE_OTHER;
+    struct stat st;
+
+    if (fstat(fd, &st) == 0)
+    {
+        if (st.st_size == 0)
+        {
+            rv = FILE_NEW;
+        }
+        else if (pread(fd, pHeader, sizeof(*pHeader), 0) == sizeof(*pHeader))
+        {
+            if (pHeader->magic == 0)
+            {
+                // The magic is written last and only while the file is locked,
+                // so no process can have mapped a file that does not have it.
+                rv = FILE_NEW;
+            }
+            else if (is_compatible(*pHeader, st.st_size))
+            {
+                rv = FILE_COMPATIBLE;
+            }
+        }
+    }
+
+    return rv;
+}
+
+/**
+ * Maps the file, and initializes it if it has not been initialized. If the
+ * file already contains a compatible cache, that cache will be used. A file
+ * with any other content is not touched, as other processes may have it mapped.
+ *
+ * @param zPath    The path of the file.
+ * @param size     The size the file should have, if it is created.
+ * @param pLayout  On success, the layout of the file.
+ *
+ * @return The mapped file, or NULL if an error occurred.
+ */
+ShmStorage::Header* map_file(const char* zPath, uint64_t size, ShmStorage::Layout* pLayout)
+{
+    ShmStorage::Header* pHeader = NULL;
+
+    int fd = open_file(zPath);
+
+    if (fd != -1)
+    {
+        // Other MaxScale instances may be opening the same file at the same time.
+        flock(fd, LOCK_EX);
+
+        ShmStorage::Header header;
+        file_state_t state = get_file_state(fd, &header);
+
+        if (state == FILE_COMPATIBLE)
+        {
+            if (header.layout.size != size)
+            {
+                MXS_WARNING("The existing cache file '%s' is %lu bytes and not %lu bytes as "
+                            "specified. The file will be used as such.",
+                            zPath, (unsigned long)header.layout.size, (unsigned long)size);
+            }
+
+            size = header.layout.size;
+        }
+        else if (state == FILE_OTHER)
+        {
+            MXS_ERROR("The cache file '%s' has not been created by this version of the module. "
+                      "Remove the file or specify another path.", zPath);
+            size = 0;
+        }
+        else if (ftruncate(fd, size) != 0 || posix_fallocate(fd, 0, size) != 0)
+        {
+            MXS_ERROR("Could not allocate %lu bytes for the cache file '%s': %s",
+                      (unsigned long)size, zPath, mxs_strerror(errno));
+            size = 0;
+        }
+
+        if (size != 0)
+        {
+            void* pMap = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+            if (pMap != MAP_FAILED)
+            {
+                pHeader = static_cast<ShmStorage::Header*>(pMap);
+
+                if (state == FILE_COMPATIBLE)
+                {
+                    // The layout is taken from the copy that was checked, as the file may change.
+                    *pLayout = header.layout;
+
+                    MXS_NOTICE("Using the existing content of the cache file '%s', %lu items.",
+                               zPath, (unsigned long)pHeader->stats.items);
+                }
+                else if (initialize(pHeader, size))
+                {
+                    set_layout(pLayout, size);
+                }
+                else
+                {
+                    MXS_ERROR("Could not initialize the lock of the cache file '%s'.", zPath);
+                    munmap(pMap, size);
+                    pHeader = NULL;
+                }
+            }
+            else
+            {
+                MXS_ERROR("Could not map the cache file '%s': %s", zPath, mxs_strerror(errno));
+            }
+        }
+
+        flock(fd, LOCK_UN);
+        close(fd);
+    }
+
+    return pHeader;
+}
+}
+
+ShmStorage::ShmStorage(const string& name,
+                       const CACHE_STORAGE_CONFIG& config,
+                       const string& path,
+                       Header* pHeader,
+                       const Layout& layout)
+    : m_name(name)
+    , m_config(config)
+    , m_path(path)
+    , m_pHeader(pHeader)
+    , m_layout(layout)
+    , m_corrupt(false)
+{
+}
+
+ShmStorage::~ShmStorage()
+{
+    munmap(m_pHeader, m_layout.size);
+}
+
+bool ShmStorage::Initialize(uint32_t* pCapabilities)
+{
+    *pCapabilities = (CACHE_STORAGE_CAP_ST
+                      | CACHE_STORAGE_CAP_MT
+                      | CACHE_STORAGE_CAP_LRU
+                      | CACHE_STORAGE_CAP_MAX_COUNT
+                      | CACHE_STORAGE_CAP_MAX_SIZE
+                      | CACHE_STORAGE_CAP_INVALIDATION);
+
+    return true;
+}
+
+ShmStorage* ShmStorage::Create_instance(const char* zName,
+                                        const CACHE_STORAGE_CONFIG& config,
+                                        int argc,
+                                        char* argv[])
+{
+    mxb_assert(zName);
+
+    string name(zName);
+    std::replace(name.begin(), name.end(), '/', '_');
+
+    string path = string(get_piddir()) + "/maxscale-cache-" + name;
+    uint64_t size = SHM_DEFAULT_SIZE;
+    bool error = false;
+
+    for (int i = 0; i < argc; ++i)
+    {
+        const char* zArg = argv[i];
+        const char* zValue = strchr(zArg, '=');
+
+        if (!zValue)
+        {
+            MXS_ERROR("Argument '%s' is not of the form 'key=value'.", zArg);
+            error = true;
+        }
+        else
+        {
+            string key(zArg, zValue - zArg);
+            ++zValue;
+
+            if (key == "path")
+            {
+                path = zValue;
+            }
+            else if (key == "size")
+            {
+                if (!parse_size(zValue, &size) || (size < SHM_MIN_SIZE))
+                {
+                    MXS_ERROR("Invalid size '%s', the size must be at least %lu bytes.",
+                              zValue, (unsigned long)SHM_MIN_SIZE);
+                    error = true;
+                }
+            }
+            else
+            {
+                MXS_WARNING("Unknown argument '%s' ignored.", zArg);
+            }
+        }
+    }
+
+    ShmStorage* pStorage = NULL;
+
+    if (!error)
+    {
+        Layout layout;
+        Header* pHeader = map_file(path.c_str(), size, &layout);
+
+        if (pHeader)
+        {
+            pStorage = new(std::nothrow) ShmStorage(zName, config, path, pHeader, layout);
+
+            if (pStorage)
+            {
+                MXS_NOTICE("Storage module created, using cache file '%s'.", path.c_str());
+            }
+            else
+            {
+                munmap(pHeader, layout.size);
+            }
+        }
+    }
+
+    return pStorage;
+}
+
+void ShmStorage::get_config(CACHE_STORAGE_CONFIG* pConfig)
+{
+    *pConfig = m_config;
+}
+
+cache_result_t ShmStorage::get_info(uint32_t what, json_t** ppInfo) const
+{
+    *ppInfo = json_object();
+
+    if (*ppInfo)
+    {
+        Guard guard(*this);
+
+        set_integer(*ppInfo, "capacity", m_layout.size);
+        m_pHeader->stats.fill(*ppInfo);
+    }
+
+    return *ppInfo ? CACHE_RESULT_OK : CACHE_RESULT_OUT_OF_RESOURCES;
+}
+
+cache_result_t ShmStorage::get_value(const CACHE_KEY& key,
+                                     uint32_t flags,
+                                     uint32_t soft_ttl,
+                                     uint32_t hard_ttl,
+                                     GWBUF**  ppResult)
+{
+    cache_result_t result = CACHE_RESULT_NOT_FOUND;
+
+    if (soft_ttl == CACHE_USE_CONFIG_TTL)
+    {
+        soft_ttl = m_config.soft_ttl;
+    }
+
+    if (hard_ttl == CACHE_USE_CONFIG_TTL)
+    {
+        hard_ttl = m_config.hard_ttl;
+    }
+
+    if (soft_ttl > hard_ttl)
+    {
+        soft_ttl = hard_ttl;
+    }
+
+    Guard guard(*this);
+
+    Entry* pEntry = find_entry(key);
+
+    if (pEntry)
+    {
+        uint32_t now = time(NULL);
+
+        bool is_hard_stale = hard_ttl == 0 ? false : (now - pEntry->time > hard_ttl);
+        bool is_soft_stale = soft_ttl == 0 ? false : (now - pEntry->time > soft_ttl);
+        bool include_stale = ((flags & CACHE_FLAGS_INCLUDE_STALE) != 0);
+
+        if (is_hard_stale)
+        {
+            erase_entry(pEntry);
+            result |= CACHE_RESULT_DISCARDED;
+        }
+        else if (!is_soft_stale || include_stale)
+        {
+            result = copy_value(pEntry, NULL, ppResult);
+
+            if (CACHE_RESULT_IS_OK(result))
+            {
+                move_to_head(pEntry);
+
+                if (is_soft_stale)
+                {
+                    result |= CACHE_RESULT_STALE;
+                }
+            }
+        }
+        else
+        {
+            mxb_assert(is_soft_stale);
+            result |= CACHE_RESULT_STALE;
+        }
+    }
+
+    if (CACHE_RESULT_IS_OK(result))
+    {
+        ++m_pHeader->stats.hits;
+    }
+    else
+    {
+        ++m_pHeader->stats.misses;
+    }
+
+    return result;
+}
+
+cache_result_t ShmStorage::put_value(const CACHE_KEY& key,
+                                     const vector<string>& invalidation_words,
+                                     const GWBUF& value)
+{
+    mxb_assert(GWBUF_IS_CONTIGUOUS(&value));
+
+    cache_result_t result = CACHE_RESULT_OUT_OF_RESOURCES;
+
+    uint64_t value_length = GWBUF_LENGTH(&value);
+    uint64_t words_length = 0;
+
+    if (m_config.invalidate != CACHE_INVALIDATE_NEVER)
+    {
+        for (const auto& word : invalidation_words)
+        {
+            words_length += word_link_length(word);
+        }
+    }
+
+    int size_class = size_class_of(sizeof(Entry) + words_length + value_length);
+
+    if ((size_class < SHM_N_SIZE_CLASSES)
+        && ((m_config.max_size == 0) || (value_length <= m_config.max_size)))
+    {
+        Guard guard(*this);
+        Stats& stats = m_pHeader->stats;
+
+        Entry* pEntry = find_entry(key);
+
+        if (pEntry)
+        {
+            // The chunk is released and, if the size class is the same, immediately reused.
+            erase_entry(pEntry);
+            ++stats.updates;
+        }
+
+        while (((m_config.max_count != 0) && (stats.items >= m_config.max_count))
+               || ((m_config.max_size != 0) && (stats.size + value_length > m_config.max_size)))
+        {
+            if (!evict_lru())
+            {
+                mxb_assert(!true);
+                break;
+            }
+        }
+
+        pEntry = allocate_entry(size_class);
+
+        if (pEntry)
+        {
+            uint64_t* pBucket = bucket_of(key);
+
+            pEntry->key = key;
+            pEntry->bucket_next = *pBucket;
+            pEntry->value_length = value_length;
+            pEntry->words_length = words_length;
+            pEntry->n_words = 0;
+            pEntry->time = time(NULL);
+
+            if (words_length != 0)
+            {
+                WordLink* pLink = pEntry->words();
+
+                for (const auto& word : invalidation_words)
+                {
+                    pLink->entry = offset_of(pEntry);
+                    pLink->hash = word_hash(word.c_str());
+                    pLink->length = word_link_length(word);
+                    memcpy(pLink->word(), word.c_str(), word.length() + 1);
+
+                    link_word(pLink);
+                    ++pEntry->n_words;
+
+                    pLink = next_word(pLink);
+                }
+            }
+
+            memcpy(pEntry->value(), GWBUF_DATA(&value), value_length);
+
+            *pBucket = offset_of(pEntry);
+            link_to_head(pEntry);
+
+            stats.size += value_length;
+            stats.items += 1;
+
+            result = CACHE_RESULT_OK;
+        }
+    }
+
+    return result;
+}
+
+cache_result_t ShmStorage::del_value(const CACHE_KEY& key)
+{
+    cache_result_t result = CACHE_RESULT_NOT_FOUND;
+
+    Guard guard(*this);
+
+    Entry* pEntry = find_entry(key);
+
+    if (pEntry)
+    {
+        erase_entry(pEntry);
+        ++m_pHeader->stats.deletes;
+        result = CACHE_RESULT_OK;
+    }
+
+    return result;
+}
+
+cache_result_t ShmStorage::invalidate(const vector<string>& words)
+{
+    cache_result_t result = CACHE_RESULT_OUT_OF_RESOURCES;
+
+    if (m_config.invalidate != CACHE_INVALIDATE_NEVER)
+    {
+        Guard guard(*this);
+        Stats& stats = m_pHeader->stats;
+
+        ++stats.invalidations;
+
+        // An entry may depend on several of the words, so the entries are
+        // collected before any of them is erased.
+        vector<uint64_t> entries;
+
+        for (const auto& word : words)
+        {
+            uint32_t hash = word_hash(word.c_str());
+            WordLink* pLink = word_link_at(*word_bucket_of(hash));
+
+            while (pLink)
+            {
+                if (pLink->hash == hash && word == pLink->word())
+                {
+                    entries.push_back(pLink->entry);
+                }
+
+                pLink = word_link_at(pLink->next);
+            }
+        }
+
+        std::sort(entries.begin(), entries.end());
+        entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+        for (uint64_t offset : entries)
+        {
+            if (Entry* pEntry = entry_at(offset))
+            {
+                erase_entry(pEntry);
+                ++stats.invalidated;
+            }
+        }
+
+        result = CACHE_RESULT_OK;
+    }
+
+    return result;
+}
+
+cache_result_t ShmStorage::get_head(CACHE_KEY* pKey, GWBUF** ppHead) const
+{
+    Guard guard(*this);
+
+    Entry* pEntry = entry_at(m_pHeader->head);
+
+    return pEntry ? copy_value(pEntry, pKey, ppHead) : CACHE_RESULT_NOT_FOUND;
+}
+
+cache_result_t ShmStorage::get_tail(CACHE_KEY* pKey, GWBUF** ppTail) const
+{
+    Guard guard(*this);
+
+    Entry* pEntry = entry_at(m_pHeader->tail);
+
+    return pEntry ? copy_value(pEntry, pKey, ppTail) : CACHE_RESULT_NOT_FOUND;
+}
+
+cache_result_t ShmStorage::get_size(uint64_t* pSize) const
+{
+    Guard guard(*this);
+
+    *pSize = m_pHeader->stats.size;
+
+    return CACHE_RESULT_OK;
+}
+
+cache_result_t ShmStorage::get_items(uint64_t* pItems) const
+{
+    Guard guard(*this);
+
+    *pItems = m_pHeader->stats.items;
+
+    return CACHE_RESULT_OK;
+}
+
+void ShmStorage::lock() const
+{
+    int rc = pthread_mutex_lock(&m_pHeader->lock);
+
+    if (rc == EOWNERDEAD)
+    {
+        // The process holding the lock died, possibly in the middle of
+        // modifying the index or the LRU list, so nothing can be trusted.
+        MXS_WARNING("A process died while modifying the cache file '%s', the cache is cleared.",
+                    m_path.c_str());
+
+        clear();
+        pthread_mutex_consistent(&m_pHeader->lock);
+    }
+    else
+    {
+        mxb_assert(rc == 0);
+    }
+}
+
+void ShmStorage::unlock() const
+{
+    if (m_corrupt)
+    {
+        MXS_ERROR("The cache file '%s' contains invalid references, the cache is cleared.",
+                  m_path.c_str());
+
+        clear();
+    }
+
+    pthread_mutex_unlock(&m_pHeader->lock);
+}
+
+void ShmStorage::clear() const
+{
+    Header& header = *m_pHeader;
+
+    memset(reinterpret_cast<uint8_t*>(m_pHeader) + m_layout.buckets, 0, m_layout.n_buckets * sizeof(uint64_t));
+    memset(reinterpret_cast<uint8_t*>(m_pHeader) + m_layout.word_buckets, 0, m_layout.n_buckets * sizeof(uint64_t));
+    memset(header.class_head, 0, sizeof(header.class_head));
+    memset(header.class_tail, 0, sizeof(header.class_tail));
+    memset(&header.stats, 0, sizeof(header.stats));
+
+    format_chunks(header, m_layout);
+
+    header.head = 0;
+    header.tail = 0;
+    m_corrupt = false;
+}
+
+/**
+ * Returns the entry at an offset. If the offset is not 0 but the entry is not
+ * valid, the file is marked as corrupt and cleared when it is unlocked.
+ */
+ShmStorage::Entry* ShmStorage::entry_at(uint64_t offset) const
+{
+    Header& header = *m_pHeader;
+    Entry* pEntry = chunk_at(header, m_layout, offset);
+
+    if (pEntry)
+    {
+        uint64_t pos = offset - m_layout.chunks;
+
+        if ((pEntry->size_class >= SHM_N_SIZE_CLASSES)
+            || (pos + class_size(pEntry->size_class) > m_layout.chunks_size)
+            || (pEntry->words_length > class_size(pEntry->size_class))
+            || (pEntry->value_length > class_size(pEntry->size_class))
+            || (sizeof(Entry) + pEntry->words_length + pEntry->value_length > class_size(pEntry->size_class)))
+        {
+            pEntry = NULL;
+        }
+    }
+
+    if (offset && !pEntry)
+    {
+        m_corrupt = true;
+    }
+
+    return pEntry;
+}
+
+/**
+ * Returns the word link at an offset. As with entries, an invalid link marks
+ * the file as corrupt.
+ */
+ShmStorage::WordLink* ShmStorage::word_link_at(uint64_t offset) const
+{
+    uint64_t end = m_layout.chunks + m_layout.chunks_size;
+    WordLink* pLink = NULL;
+
+    if ((offset >= m_layout.chunks)
+        && (offset + sizeof(WordLink) < end)
+        && (offset % sizeof(uint64_t) == 0))
+    {
+        pLink = reinterpret_cast<WordLink*>(reinterpret_cast<uint8_t*>(m_pHeader) + offset);
+
+        if ((pLink->length <= sizeof(WordLink))
+            || (offset + pLink->length > end)
+            || !memchr(pLink->word(), 0, pLink->length - sizeof(WordLink)))
+        {
+            pLink = NULL;
+        }
+    }
+
+    if (offset && !pLink)
+    {
+        m_corrupt = true;
+    }
+
+    return pLink;
+}
+
+uint64_t ShmStorage::offset_of(const Entry* pEntry) const
+{
+    return reinterpret_cast<const uint8_t*>(pEntry) - reinterpret_cast<const uint8_t*>(m_pHeader);
+}
+
+uint64_t* ShmStorage::bucket_of(const CACHE_KEY& key) const
+{
+    uint64_t* pBuckets = reinterpret_cast<uint64_t*>(reinterpret_cast<uint8_t*>(m_pHeader)
+                                                     + m_layout.buckets);
+
+    return &pBuckets[cache_key_hash(&key) & (m_layout.n_buckets - 1)];
+}
+
+uint64_t* ShmStorage::word_bucket_of(uint32_t hash) const
+{
+    uint64_t* pBuckets = reinterpret_cast<uint64_t*>(reinterpret_cast<uint8_t*>(m_pHeader)
+                                                     + m_layout.word_buckets);
+
+    return &pBuckets[hash & (m_layout.n_buckets - 1)];
+}
+
+ShmStorage::Entry* ShmStorage::find_entry(const CACHE_KEY& key) const
+{
+    Entry* pEntry = entry_at(*bucket_of(key));
+
+    while (pEntry && (pEntry->key != key))
+    {
+        pEntry = entry_at(pEntry->bucket_next);
+    }
+
+    return pEntry;
+}
+
+/**
+ * Allocates a chunk for an entry. If the file is full, the least recently
+ * used entry of the same size class is evicted. If there is none, the least
+ * recently used entries of the other size classes are evicted until their
+ * chunks have merged into a large enough one.
+ *
+ * @param size_class  The size class of the chunk.
+ *
+ * @return The entry, or NULL if no chunk could be allocated.
+ */
+ShmStorage::Entry* ShmStorage::allocate_entry(uint8_t size_class)
+{
+    Header& header = *m_pHeader;
+    Entry* pEntry = allocate_chunk(size_class);
+
+    while (!pEntry && !m_corrupt && header.tail)
+    {
+        Entry* pVictim = entry_at(header.class_tail[size_class]);
+
+        if (!pVictim)
+        {
+            pVictim = entry_at(header.tail);
+        }
+
+        if (pVictim)
+        {
+            erase_entry(pVictim);
+            ++header.stats.evictions;
+
+            pEntry = allocate_chunk(size_class);
+        }
+    }
+
+    if (pEntry)
+    {
+        pEntry->bucket_next = 0;
+        pEntry->prev = 0;
+        pEntry->next = 0;
+        pEntry->class_prev = 0;
+        pEntry->class_next = 0;
+    }
+
+    return pEntry;
+}
+
+/**
+ * Takes a free chunk of the size class, splitting a larger one if necessary.
+ *
+ * @param size_class  The size class of the chunk.
+ *
+ * @return The chunk, or NULL if there is no large enough free chunk.
+ */
+ShmStorage::Entry* ShmStorage::allocate_chunk(int size_class)
+{
+    Header& header = *m_pHeader;
+    int free_class = size_class;
+
+    while ((free_class < SHM_N_SIZE_CLASSES) && !header.free_chunks[free_class])
+    {
+        ++free_class;
+    }
+
+    Entry* pChunk = NULL;
+
+    if (free_class < SHM_N_SIZE_CLASSES)
+    {
+        uint64_t offset = header.free_chunks[free_class];
+        Entry* pFree = chunk_at(header, m_layout, offset);
+
+        if (pFree
+            && (pFree->size_class == static_cast<uint32_t>(free_class))
+            && (offset - m_layout.chunks + class_size(free_class) <= m_layout.chunks_size)
+            && remove_free_chunk(header, m_layout, offset))
+        {
+            // The upper halves are returned to the free chunks of the smaller classes.
+            while (free_class > size_class)
+            {
+                --free_class;
+                push_free_chunk(header, m_layout, offset + class_size(free_class), free_class);
+            }
+
+            pChunk = pFree;
+            pChunk->size_class = size_class;
+            chunk_map_of(header, m_layout)[(offset - m_layout.chunks) >> SHM_MIN_CLASS_SHIFT] = size_class;
+        }
+        else
+        {
+            m_corrupt = true;
+        }
+    }
+
+    return pChunk;
+}
+
+/**
+ * Releases a chunk, merging it with its buddy for as long as the buddy is free.
+ */
+void ShmStorage::release_chunk(Entry* pChunk)
+{
+    Header& header = *m_pHeader;
+    const uint8_t* pMap = chunk_map_of(header, m_layout);
+    uint64_t pos = offset_of(pChunk) - m_layout.chunks;
+    int size_class = pChunk->size_class;
+
+    while (size_class < SHM_N_SIZE_CLASSES - 1)
+    {
+        uint64_t buddy = pos ^ class_size(size_class);
+
+        if ((buddy + class_size(size_class) > m_layout.chunks_size)
+            || (pMap[buddy >> SHM_MIN_CLASS_SHIFT] != (SHM_CHUNK_FREE | size_class)))
+        {
+            break;
+        }
+
+        if (!remove_free_chunk(header, m_layout, m_layout.chunks + buddy))
+        {
+            m_corrupt = true;
+            break;
+        }
+
+        pos = std::min(pos, buddy);
+        ++size_class;
+    }
+
+    push_free_chunk(header, m_layout, m_layout.chunks + pos, size_class);
+}
+
+/**
+ * Removes an entry from the index and the LRU lists, and releases its chunk.
+ */
+void ShmStorage::erase_entry(Entry* pEntry)
+{
+    Header& header = *m_pHeader;
+    uint64_t offset = offset_of(pEntry);
+
+    uint64_t* pLink = bucket_of(pEntry->key);
+
+    while (pLink && (*pLink != offset))
+    {
+        Entry* pPrev = entry_at(*pLink);
+        pLink = pPrev ? &pPrev->bucket_next : NULL;
+    }
+
+    if (pLink)
+    {
+        *pLink = pEntry->bucket_next;
+    }
+    else
+    {
+        m_corrupt = true;
+    }
+
+    WordLink* pWord = pEntry->words();
+    const uint8_t* pEnd = reinterpret_cast<const uint8_t*>(pWord) + pEntry->words_length;
+
+    for (uint32_t i = 0; i < pEntry->n_words; ++i)
+    {
+        if ((reinterpret_cast<const uint8_t*>(pWord) + sizeof(WordLink) > pEnd)
+            || (pWord->length <= sizeof(WordLink)))
+        {
+            m_corrupt = true;
+            break;
+        }
+
+        unlink_word(pWord);
+        pWord = next_word(pWord);
+    }
+
+    unlink(pEntry);
+
+    mxb_assert(header.stats.size >= pEntry->value_length);
+    mxb_assert(header.stats.items > 0);
+
+    header.stats.size -= pEntry->value_length;
+    header.stats.items -= 1;
+
+    release_chunk(pEntry);
+}
+
+void ShmStorage::link_word(WordLink* pLink)
+{
+    uint64_t* pBucket = word_bucket_of(pLink->hash);
+    uint64_t offset = reinterpret_cast<uint8_t*>(pLink) - reinterpret_cast<uint8_t*>(m_pHeader);
+
+    pLink->prev = 0;
+    pLink->next = *pBucket;
+
+    if (WordLink* pNext = word_link_at(pLink->next))
+    {
+        pNext->prev = offset;
+    }
+
+    *pBucket = offset;
+}
+
+void ShmStorage::unlink_word(WordLink* pLink)
+{
+    if (WordLink* pPrev = word_link_at(pLink->prev))
+    {
+        pPrev->next = pLink->next;
+    }
+    else
+    {
+        *word_bucket_of(pLink->hash) = pLink->next;
+    }
+
+    if (WordLink* pNext = word_link_at(pLink->next))
+    {
+        pNext->prev = pLink->prev;
+    }
+}
+
+ShmStorage::WordLink* ShmStorage::next_word(WordLink* pLink) const
+{
+    return reinterpret_cast<WordLink*>(reinterpret_cast<uint8_t*>(pLink) + pLink->length);
+}
+
+void ShmStorage::move_to_head(Entry* pEntry)
+{
+    if (m_pHeader->head != offset_of(pEntry))
+    {
+        unlink(pEntry);
+        link_to_head(pEntry);
+    }
+}
+
+void ShmStorage::link_to_head(Entry* pEntry)
+{
+    Header& header = *m_pHeader;
+    uint64_t offset = offset_of(pEntry);
+    uint32_t size_class = pEntry->size_class;
+
+    pEntry->prev = 0;
+    pEntry->next = header.head;
+
+    if (Entry* pNext = entry_at(header.head))
+    {
+        pNext->prev = offset;
+    }
+    else
+    {
+        header.tail = offset;
+    }
+
+    header.head = offset;
+
+    pEntry->class_prev = 0;
+    pEntry->class_next = header.class_head[size_class];
+
+    if (Entry* pNext = entry_at(header.class_head[size_class]))
+    {
+        pNext->class_prev = offset;
+    }
+    else
+    {
+        header.class_tail[size_class] = offset;
+    }
+
+    header.class_head[size_class] = offset;
+}
+
+void ShmStorage::unlink(Entry* pEntry)
+{
+    Header& header = *m_pHeader;
+
+    if (Entry* pPrev = entry_at(pEntry->prev))
+    {
+        pPrev->next = pEntry->next;
+    }
+    else
+    {
+        header.head = pEntry->next;
+    }
+
+    if (Entry* pNext = entry_at(pEntry->next))
+    {
+        pNext->prev = pEntry->prev;
+    }
+    else
+    {
+        header.tail = pEntry->prev;
+    }
+
+    if (Entry* pPrev = entry_at(pEntry->class_prev))
+    {
+        pPrev->class_next = pEntry->class_next;
+    }
+    else
+    {
+        header.class_head[pEntry->size_class] = pEntry->class_next;
+    }
+
+    if (Entry* pNext = entry_at(pEntry->class_next))
+    {
+        pNext->class_prev = pEntry->class_prev;
+    }
+    else
+    {
+        header.class_tail[pEntry->size_class] = pEntry->class_prev;
+    }
+
+    pEntry->prev = 0;
+    pEntry->next = 0;
+    pEntry->class_prev = 0;
+    pEntry->class_next = 0;
+}
+
+bool ShmStorage::evict_lru()
+{
+    Entry* pEntry = entry_at(m_pHeader->tail);
+
+    if (pEntry)
+    {
+        erase_entry(pEntry);
+        ++m_pHeader->stats.evictions;
+    }
+
+    return pEntry != NULL;
+}
+
+cache_result_t ShmStorage::copy_value(const Entry* pEntry, CACHE_KEY* pKey, GWBUF** ppValue) const
+{
+    cache_result_t result = CACHE_RESULT_OUT_OF_RESOURCES;
+
+    *ppValue = gwbuf_alloc(pEntry->value_length);
+
+    if (*ppValue)
+    {
+        memcpy(GWBUF_DATA(*ppValue), pEntry->value(), pEntry->value_length);
+
+        if (pKey)
+        {
+            *pKey = pEntry->key;
+        }
+
+        result = CACHE_RESULT_OK;
+    }
+
+    return result;
+}
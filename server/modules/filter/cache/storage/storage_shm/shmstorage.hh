@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+#include <string>
+#include <vector>
+#include "../../cache_storage_api.hh"
+
+/**
+ * ShmStorage stores the cached data in a memory mapped file, by default
+ * located in the runtime directory of MaxScale. As all data, including the index and the LRU list,
+ * is in the file, the content of the cache survives a restart of MaxScale
+ * and is shared by all MaxScale instances that use the same file.
+ *
+ * The file is accessed by several threads and possibly several processes,
+ * so the storage is always protected by a process shared mutex, irrespective
+ * of the thread model. To keep the critical sections short, the entries that
+ * depend on an invalidation word are found through an index of the words and
+ * a chunk for a new entry is found without scanning the entries.
+ */
+class ShmStorage
+{
+public:
+    ~ShmStorage();
+
+    static bool Initialize(uint32_t* pCapabilities);
+
+    static ShmStorage* Create_instance(const char* zName,
+                                       const CACHE_STORAGE_CONFIG& config,
+                                       int argc,
+                                       char* argv[]);
+
+    void           get_config(CACHE_STORAGE_CONFIG* pConfig);
+    cache_result_t get_info(uint32_t what, json_t** ppInfo) const;
+    cache_result_t get_value(const CACHE_KEY& key,
+                             uint32_t flags,
+                             uint32_t soft_ttl,
+                             uint32_t hard_ttl,
+                             GWBUF**  ppResult);
+    cache_result_t put_value(const CACHE_KEY& key,
+                             const std::vector<std::string>& invalidation_words,
+                             const GWBUF& value);
+    cache_result_t del_value(const CACHE_KEY& key);
+    cache_result_t invalidate(const std::vector<std::string>& words);
+
+    cache_result_t get_head(CACHE_KEY* pKey, GWBUF** ppHead) const;
+    cache_result_t get_tail(CACHE_KEY* pKey, GWBUF** ppTail) const;
+    cache_result_t get_size(uint64_t* pSize) const;
+    cache_result_t get_items(uint64_t* pItems) const;
+
+    struct Header;
+    struct Entry;
+    struct WordLink;
+
+    /**
+     * The offsets and sizes of the areas of the file.
+     */
+    struct Layout
+    {
+        uint64_t size;          /*< The size of the file. */
+        uint64_t n_buckets;     /*< The number of key and of word buckets, a power of 2. */
+        uint64_t buckets;       /*< Offset of the key buckets. */
+        uint64_t word_buckets;  /*< Offset of the word buckets. */
+        uint64_t chunk_map;     /*< Offset of the chunk map. */
+        uint64_t chunks;        /*< Offset of the first chunk. */
+        uint64_t chunks_size;   /*< The size of the chunk area. */
+    };
+
+private:
+    ShmStorage(const std::string& name,
+               const CACHE_STORAGE_CONFIG& config,
+               const std::string& path,
+               Header* pHeader,
+               const Layout& layout);
+
+    ShmStorage(const ShmStorage&);
+    ShmStorage& operator=(const ShmStorage&);
+
+    class Guard;
+
+    void lock() const;
+    void unlock() const;
+    void clear() const;
+
+    Entry*    entry_at(uint64_t offset) const;
+    WordLink* word_link_at(uint64_t offset) const;
+    uint64_t  offset_of(const Entry* pEntry) const;
+    uint64_t* bucket_of(const CACHE_KEY& key) const;
+    uint64_t* word_bucket_of(uint32_t hash) const;
+
+    Entry*    find_entry(const CACHE_KEY& key) const;
+    Entry*    allocate_entry(uint8_t size_class);
+    Entry*    allocate_chunk(int size_class);
+    void      release_chunk(Entry* pChunk);
+    void      erase_entry(Entry* pEntry);
+    void      link_word(WordLink* pLink);
+    void      unlink_word(WordLink* pLink);
+    WordLink* next_word(WordLink* pLink) const;
+    void      move_to_head(Entry* pEntry);
+    void      link_to_head(Entry* pEntry);
+    void      unlink(Entry* pEntry);
+    bool      evict_lru();
+
+    cache_result_t copy_value(const Entry* pEntry, CACHE_KEY* pKey, GWBUF** ppValue) const;
+
+    std::string                m_name;
+    const CACHE_STORAGE_CONFIG m_config;
+    std::string                m_path;
+    Header*                    m_pHeader;   /*< The start of the mapped file. */
+    const Layout               m_layout;    /*< The layout when the file was opened, offsets are checked against it. */
+    mutable bool               m_corrupt;   /*< Whether an invalid offset was found in the file. */
+};
@@ -13,6 +13,8 @@
 #pragma once
 
 #include <maxscale/ccdefs.hh>
+#include <string>
+#include <vector>
 
 template<class StorageType>
 class StorageModule
@@ -91,17 +93,22 @@ public:
 
     static cache_result_t putValue(CACHE_STORAGE* pCache_storage,
                                    const CACHE_KEY* pKey,
+                                   const char* const* pzWords,
+                                   size_t nWords,
                                    const GWBUF* pValue)
     {
         mxb_assert(pCache_storage);
         mxb_assert(pKey);
+        mxb_assert(pzWords || (nWords == 0));
         mxb_assert(pValue);
 
         cache_result_t result = CACHE_RESULT_ERROR;
 
         StorageType* pStorage = reinterpret_cast<StorageType*>(pCache_storage);
 
-        MXS_EXCEPTION_GUARD(result = pStorage->put_value(*pKey, *pValue));
+        MXS_EXCEPTION_GUARD(result = pStorage->put_value(*pKey,
+                                                         std::vector<std::string>(pzWords, pzWords + nWords),
+                                                         *pValue));
 
         return result;
     }
@@ -176,6 +183,23 @@ public:
         return result;
     }
 
+    static cache_result_t invalidate(CACHE_STORAGE* pCache_storage,
+                                     const char* const* pzWords,
+                                     size_t nWords)
+    {
+        mxb_assert(pCache_storage);
+        mxb_assert(pzWords || (nWords == 0));
+
+        cache_result_t result = CACHE_RESULT_ERROR;
+
+        StorageType* pStorage = reinterpret_cast<StorageType*>(pCache_storage);
+
+        MXS_EXCEPTION_GUARD(result = pStorage->invalidate(std::vector<std::string>(pzWords,
+                                                                                   pzWords + nWords)));
+
+        return result;
+    }
+
     static CACHE_STORAGE_API s_api;
 };
 
@@ -193,5 +217,6 @@ CACHE_STORAGE_API StorageModule<StorageType>::s_api =
     &StorageModule<StorageType>::getHead,
     &StorageModule<StorageType>::getTail,
     &StorageModule<StorageType>::getSize,
-    &StorageModule<StorageType>::getItems
+    &StorageModule<StorageType>::getItems,
+    &StorageModule<StorageType>::invalidate
 };
@@ -22,6 +22,7 @@
 #include "cachefilter.h"
 #include "lrustoragest.hh"
 #include "lrustoragemt.hh"
+#include "lrustoragesharded.hh"
 #include "storagereal.hh"
 
 
@@ -90,6 +91,22 @@ bool open_cache_storage(const char* zName,
 }
 
 
+/**
+ * The capabilities a storage must have for not having to be decorated
+ * with an LRUStorage.
+ */
+uint32_t required_capabilities(const CACHE_STORAGE_CONFIG& config)
+{
+    uint32_t mask = CACHE_STORAGE_CAP_MAX_COUNT | CACHE_STORAGE_CAP_MAX_SIZE;
+
+    if (config.invalidate != CACHE_INVALIDATE_NEVER)
+    {
+        mask |= CACHE_STORAGE_CAP_INVALIDATION;
+    }
+
+    return mask;
+}
+
 void close_cache_storage(void* handle, CACHE_STORAGE_API* pApi)
 {
     // TODO: pApi->finalize();
@@ -116,6 +133,7 @@ StorageFactory::StorageFactory(void* handle,
     m_caps |= CACHE_STORAGE_CAP_LRU;
     m_caps |= CACHE_STORAGE_CAP_MAX_COUNT;
     m_caps |= CACHE_STORAGE_CAP_MAX_SIZE;
+    m_caps |= CACHE_STORAGE_CAP_INVALIDATION;
 }
 
 StorageFactory::~StorageFactory()
@@ -157,16 +175,18 @@ Storage* StorageFactory::createStorage(const char* zName,
 
     CacheStorageConfig used_config(config);
 
-    uint32_t mask = CACHE_STORAGE_CAP_MAX_COUNT | CACHE_STORAGE_CAP_MAX_SIZE;
+    uint32_t mask = required_capabilities(config);
 
     if (!cache_storage_has_cap(m_storage_caps, mask))
     {
         // Since we will wrap the native storage with a LRUStorage, according
         // to the used threading model, the storage itself may be single
-        // threaded. No point in locking twice.
+        // threaded. No point in locking twice. Nor is there any point in
+        // maintaining the invalidation information twice.
         used_config.thread_model = CACHE_THREAD_MODEL_ST;
         used_config.max_count = 0;
         used_config.max_size = 0;
+        used_config.invalidate = CACHE_INVALIDATE_NEVER;
     }
 
     Storage* pStorage = createRawStorage(zName, used_config, argc, argv);
@@ -175,8 +195,8 @@ Storage* StorageFactory::createStorage(const char* zName,
     {
         if (!cache_storage_has_cap(m_storage_caps, mask))
         {
-            // Ok, so the cache cannot handle eviction. Let's decorate the
-            // real storage with a storage than can.
+            // Ok, so the cache cannot handle eviction or invalidation. Let's
+            // decorate the real storage with a storage than can.
 
             LRUStorage* pLruStorage = NULL;
 
@@ -206,6 +226,65 @@ Storage* StorageFactory::createStorage(const char* zName,
     return pStorage;
 }
 
+Storage* StorageFactory::createShardedStorage(const char* zName,
+                                              const CACHE_STORAGE_CONFIG& config,
+                                              uint32_t n_shards,
+                                              int argc,
+                                              char* argv[])
+{
+    mxb_assert(m_handle);
+    mxb_assert(m_pApi);
+    mxb_assert(config.thread_model == CACHE_THREAD_MODEL_MT);
+
+    Storage* pStorage = NULL;
+
+    if ((n_shards <= 1) || cache_storage_has_cap(m_storage_caps, required_capabilities(config)))
+    {
+        pStorage = createStorage(zName, config, argc, argv);
+    }
+    else
+    {
+        // Each shard gets a storage of its own, accessed only with the lock
+        // of the shard held.
+        CacheStorageConfig used_config(config);
+        used_config.thread_model = CACHE_THREAD_MODEL_ST;
+        used_config.max_count = 0;
+        used_config.max_size = 0;
+        used_config.invalidate = CACHE_INVALIDATE_NEVER;
+
+        std::vector<Storage*> storages;
+        bool error = false;
+
+        for (uint32_t i = 0; !error && (i < n_shards); ++i)
+        {
+            Storage* pShard_storage = createRawStorage(zName, used_config, argc, argv);
+
+            if (pShard_storage)
+            {
+                storages.push_back(pShard_storage);
+            }
+            else
+            {
+                error = true;
+            }
+        }
+
+        if (!error)
+        {
+            pStorage = LRUStorageSharded::create(config, storages);
+        }
+        else
+        {
+            for (auto pShard_storage : storages)
+            {
+                delete pShard_storage;
+            }
+        }
+    }
+
+    return pStorage;
+}
+
 
 Storage* StorageFactory::createRawStorage(const char* zName,
                                           const CACHE_STORAGE_CONFIG& config,
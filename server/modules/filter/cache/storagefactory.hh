@@ -67,6 +67,28 @@ public:
                            int argc = 0,
                            char* argv[] = NULL);
 
+    /**
+     * Create a multi-threaded storage instance whose items are divided
+     * between a number of shards, each with an LRU list and lock of its own.
+     *
+     * If the number of shards is 1, or if the underlying storage provides
+     * all required functionality natively, this is the same as
+     * @c createStorage.
+     *
+     * @param zName      The name of the storage.
+     * @param config     The storage configuration, the thread model must be MT.
+     * @param n_shards   The number of shards.
+     * @argc             Number of items in argv.
+     * @argv             Storage specific arguments.
+     *
+     * @return A storage instance or NULL in case of errors.
+     */
+    Storage* createShardedStorage(const char* zName,
+                                  const CACHE_STORAGE_CONFIG& config,
+                                  uint32_t n_shards,
+                                  int argc = 0,
+                                  char* argv[] = NULL);
+
     /**
      * Create raw storage instance.
      *
@@ -14,6 +14,22 @@
 #define MXS_MODULE_NAME "cache"
 #include "storagereal.hh"
 
+namespace
+{
+
+std::vector<const char*> to_zwords(const std::vector<std::string>& words)
+{
+    std::vector<const char*> zwords;
+    zwords.reserve(words.size());
+
+    for (const auto& word : words)
+    {
+        zwords.push_back(word.c_str());
+    }
+
+    return zwords;
+}
+}
 
 StorageReal::StorageReal(CACHE_STORAGE_API* pApi, CACHE_STORAGE* pStorage)
     : m_pApi(pApi)
@@ -47,9 +63,13 @@ cache_result_t StorageReal::get_value(const CACHE_KEY& key,
     return m_pApi->getValue(m_pStorage, &key, flags, soft_ttl, hard_ttl, ppValue);
 }
 
-cache_result_t StorageReal::put_value(const CACHE_KEY& key, const GWBUF* pValue)
+cache_result_t StorageReal::put_value(const CACHE_KEY& key,
+                                      const std::vector<std::string>& invalidation_words,
+                                      const GWBUF* pValue)
 {
-    return m_pApi->putValue(m_pStorage, &key, pValue);
+    std::vector<const char*> zwords = to_zwords(invalidation_words);
+
+    return m_pApi->putValue(m_pStorage, &key, zwords.data(), zwords.size(), pValue);
 }
 
 cache_result_t StorageReal::del_value(const CACHE_KEY& key)
@@ -76,3 +96,17 @@ cache_result_t StorageReal::get_items(uint64_t* pItems) const
 {
     return m_pApi->getItems(m_pStorage, pItems);
 }
+
+cache_result_t StorageReal::invalidate(const std::vector<std::string>& words)
+{
+    cache_result_t result = CACHE_RESULT_OUT_OF_RESOURCES;
+
+    if (m_pApi->invalidate)
+    {
+        std::vector<const char*> zwords = to_zwords(words);
+
+        result = m_pApi->invalidate(m_pStorage, zwords.data(), zwords.size());
+    }
+
+    return result;
+}
@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include <maxscale/ccdefs.hh>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <maxscale/alloc.h>
+#include <maxscale/log.h>
+#include <maxscale/paths.h>
+#include "storagefactory.hh"
+#include "storage.hh"
+#include "cache_storage_api.hh"
+#include "tester.hh"
+
+using namespace std;
+
+namespace
+{
+
+const size_t N_SHARED_TABLES = 16;
+const size_t N_SHARED_KEYS = 1000;
+const size_t N_OWN_KEYS = 10;
+
+void print_usage(const char* zProgram)
+{
+    cout << "usage: " << zProgram << " storage-module [threads [time]]\n"
+         << "\n"
+         << "where:\n"
+         << "  storage-module  is the name of a storage module,\n"
+         << "  threads         is the number of populating and the number of invalidating threads, and\n"
+         << "  time            is the number of seconds we should run." << endl;
+}
+
+string table_name(const string& prefix, size_t i)
+{
+    return "db." + prefix + std::to_string(i);
+}
+
+GWBUF* create_value(uint64_t data)
+{
+    return gwbuf_alloc_and_load(sizeof(data), &data);
+}
+
+bool is_present(Storage& storage, const CACHE_KEY& key)
+{
+    GWBUF* pValue = NULL;
+    cache_result_t result = storage.get_value(key, CACHE_FLAGS_INCLUDE_STALE, &pValue);
+    gwbuf_free(pValue);
+
+    return CACHE_RESULT_IS_OK(result);
+}
+
+/**
+ * Checks that exactly the items depending upon an invalidated table disappear.
+ */
+int test_invalidation(Storage& storage)
+{
+    int rv = EXIT_SUCCESS;
+
+    CacheKey key1;
+    key1.data[0] = 1;
+    CacheKey key2;
+    key2.data[0] = 2;
+    CacheKey key3;
+    key3.data[0] = 3;
+
+    GWBUF* pValue = create_value(1);
+
+    storage.put_value(key1, {"db.t1"}, pValue);
+    storage.put_value(key2, {"db.t2"}, pValue);
+    storage.put_value(key3, {"db.t1", "db.t2"}, pValue);
+
+    storage.invalidate({"db.t1"});
+
+    if (is_present(storage, key1) || !is_present(storage, key2) || is_present(storage, key3))
+    {
+        cerr << "error: Invalidation of one table did not delete the right items." << endl;
+        rv = EXIT_FAILURE;
+    }
+
+    // An updated item depends only upon the tables it was last put with.
+    storage.put_value(key2, {"db.t3"}, pValue);
+    storage.invalidate({"db.t2"});
+
+    if (!is_present(storage, key2))
+    {
+        cerr << "error: Item was invalidated using the words of an earlier value." << endl;
+        rv = EXIT_FAILURE;
+    }
+
+    storage.invalidate({"db.t3"});
+
+    if (is_present(storage, key2))
+    {
+        cerr << "error: Item was not invalidated using the words of its current value." << endl;
+        rv = EXIT_FAILURE;
+    }
+
+    gwbuf_free(pValue);
+
+    return rv;
+}
+
+/**
+ * Populates items depending upon tables shared by all threads.
+ */
+void populate(Storage* pStorage, size_t seed, const atomic<bool>* pTerminate)
+{
+    mt19937 random(seed);
+    GWBUF* pValue = create_value(seed);
+
+    while (!pTerminate->load(memory_order_relaxed))
+    {
+        CacheKey key;
+        key.data[0] = random() % N_SHARED_KEYS;
+
+        vector<string> words {table_name("shared", key.data[0] % N_SHARED_TABLES),
+                              table_name("shared", (key.data[0] / N_SHARED_TABLES) % N_SHARED_TABLES)};
+
+        pStorage->put_value(key, words, pValue);
+        is_present(*pStorage, key);
+    }
+
+    gwbuf_free(pValue);
+}
+
+/**
+ * Invalidates shared tables and, while doing so, puts and invalidates items
+ * depending upon a table no other thread uses. Those items must always be
+ * gone once their table has been invalidated.
+ */
+void invalidate(Storage* pStorage, size_t id, const atomic<bool>* pTerminate, atomic<size_t>* pErrors)
+{
+    mt19937 random(id);
+    GWBUF* pValue = create_value(id);
+    string own_table = table_name("own", id);
+
+    while (!pTerminate->load(memory_order_relaxed))
+    {
+        pStorage->invalidate({table_name("shared", random() % N_SHARED_TABLES)});
+
+        vector<CacheKey> keys(N_OWN_KEYS);
+
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            keys[i].data[0] = N_SHARED_KEYS + id * N_OWN_KEYS + i;
+            pStorage->put_value(keys[i], {own_table}, pValue);
+        }
+
+        pStorage->invalidate({own_table});
+
+        for (const auto& key : keys)
+        {
+            if (is_present(*pStorage, key))
+            {
+                ++(*pErrors);
+            }
+        }
+    }
+
+    gwbuf_free(pValue);
+}
+
+int test_concurrent_invalidation(Storage& storage, size_t n_threads, size_t n_seconds)
+{
+    int rv = EXIT_SUCCESS;
+
+    atomic<bool> terminate(false);
+    atomic<size_t> errors(0);
+    vector<thread> threads;
+
+    for (size_t i = 0; i < n_threads; ++i)
+    {
+        threads.emplace_back(populate, &storage, i, &terminate);
+        threads.emplace_back(invalidate, &storage, i, &terminate, &errors);
+    }
+
+    this_thread::sleep_for(chrono::seconds(n_seconds));
+    terminate.store(true);
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    if (errors != 0)
+    {
+        cerr << "error: " << errors << " items were present after their table was invalidated." << endl;
+        rv = EXIT_FAILURE;
+    }
+
+    vector<string> words;
+
+    for (size_t i = 0; i < N_SHARED_TABLES; ++i)
+    {
+        words.push_back(table_name("shared", i));
+    }
+
+    storage.invalidate(words);
+
+    for (size_t i = 0; i < N_SHARED_KEYS; ++i)
+    {
+        CacheKey key;
+        key.data[0] = i;
+
+        if (is_present(storage, key))
+        {
+            cerr << "error: Item " << i << " was present after all tables were invalidated." << endl;
+            rv = EXIT_FAILURE;
+        }
+    }
+
+    uint64_t items;
+
+    if (CACHE_RESULT_IS_OK(storage.get_items(&items)) && (items != 0))
+    {
+        cerr << "error: Storage reports " << items << " items after all tables were invalidated." << endl;
+        rv = EXIT_FAILURE;
+    }
+
+    json_t* pInfo;
+
+    if (CACHE_RESULT_IS_OK(storage.get_info(Storage::INFO_ALL, &pInfo)))
+    {
+        char* zInfo = json_dumps(pInfo, JSON_COMPACT);
+        cout << zInfo << endl;
+        MXS_FREE(zInfo);
+        json_decref(pInfo);
+    }
+
+    return rv;
+}
+
+int test(StorageFactory& factory, size_t n_threads, size_t n_seconds)
+{
+    int rv = EXIT_SUCCESS;
+
+    CacheStorageConfig config(CACHE_THREAD_MODEL_MT);
+    config.invalidate = CACHE_INVALIDATE_CURRENT;
+
+    // The raw storage handles the invalidation itself.
+    Storage* pStorage = factory.createRawStorage("raw", config);
+
+    if (pStorage)
+    {
+        cout << "Raw storage" << endl;
+        rv = Tester::combine_rvs(rv, test_invalidation(*pStorage));
+        rv = Tester::combine_rvs(rv, test_concurrent_invalidation(*pStorage, n_threads, n_seconds));
+        delete pStorage;
+    }
+    else
+    {
+        rv = EXIT_FAILURE;
+    }
+
+    // The LRU storage handles the invalidation and must also keep its index
+    // consistent when items are evicted.
+    config.max_count = N_SHARED_KEYS / 2;
+
+    pStorage = factory.createStorage("lru", config);
+
+    if (pStorage)
+    {
+        cout << "LRU storage" << endl;
+        rv = Tester::combine_rvs(rv, test_invalidation(*pStorage));
+        rv = Tester::combine_rvs(rv, test_concurrent_invalidation(*pStorage, n_threads, n_seconds));
+        delete pStorage;
+    }
+    else
+    {
+        rv = EXIT_FAILURE;
+    }
+
+    return rv;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    int rv = EXIT_FAILURE;
+
+    if ((argc >= 2) && (argc <= 4))
+    {
+        size_t n_threads = (argc >= 3) ? atoi(argv[2]) : 4;
+        size_t n_seconds = (argc >= 4) ? atoi(argv[3]) : 3;
+
+        if (mxs_log_init(NULL, ".", MXS_LOG_TARGET_DEFAULT))
+        {
+            const char* zModule = argv[1];
+            char* libdir = MXS_STRDUP("../storage/storage_inmemory/");
+            set_libdir(libdir);
+
+            StorageFactory* pFactory = StorageFactory::Open(zModule);
+
+            if (pFactory)
+            {
+                rv = test(*pFactory, n_threads, n_seconds);
+                delete pFactory;
+            }
+            else
+            {
+                cerr << "error: Could not initialize factory." << endl;
+            }
+
+            mxs_log_finish();
+        }
+        else
+        {
+            cerr << "error: Could not initialize log." << endl;
+        }
+    }
+    else
+    {
+        print_usage(argv[0]);
+    }
+
+    return rv;
+}
@@ -12,9 +12,12 @@
  */
 
 #include <maxscale/ccdefs.hh>
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <unordered_map>
+#include <zlib.h>
+#include <maxscale/modutil.h>
 #include <maxscale/alloc.h>
 #include <maxscale/paths.h>
 #include <maxscale/query_classifier.h>
@@ -38,79 +41,254 @@ void print_usage(const char* zProgram)
          << "  test-file       is the name of a text file." << endl;
 }
 
-int test(StorageFactory& factory, istream& in)
-{
-    int rv = EXIT_SUCCESS;
+typedef unordered_map<CACHE_KEY, string> Keys;
 
-    typedef vector<string> Statements;
-    Statements statements;
+/**
+ * Generates a key for a statement and checks whether the key has already
+ * been generated for some other statement.
+ *
+ * @param zDefault_db    The default database, can be NULL.
+ * @param statement      A statement.
+ * @param pKeys          The keys generated so far.
+ * @param pN_collisions  Incremented if a collision is detected.
+ *
+ * @return True, if a key could be generated.
+ */
+bool check_key(const char* zDefault_db, const string& statement, Keys* pKeys, size_t* pN_collisions)
+{
+    bool rv = false;
+    GWBUF* pQuery = Tester::gwbuf_from_string(statement);
+    mxb_assert(pQuery);
 
-    if (Tester::get_statements(in, 0, &statements))
+    if (pQuery)
     {
-        typedef unordered_map<CACHE_KEY, string> Keys;
-        Keys keys;
+        CACHE_KEY key;
+        cache_result_t result = Cache::get_default_key(zDefault_db, pQuery, &key);
 
-        size_t n_keys = 0;
-        size_t n_collisions = 0;
-
-        for (Statements::iterator i = statements.begin(); i < statements.end(); ++i)
+        if (result == CACHE_RESULT_OK)
         {
-            string statement = *i;
-            GWBUF* pQuery = Tester::gwbuf_from_string(statement);
-            mxb_assert(pQuery);
-
-            if (pQuery)
-            {
-                CACHE_KEY key;
-                cache_result_t result = Cache::get_default_key(NULL, pQuery, &key);
+            string id = zDefault_db ? string(zDefault_db) + ": " + statement : statement;
 
-                if (result == CACHE_RESULT_OK)
-                {
-                    Keys::iterator i = keys.find(key);
+            Keys::iterator i = pKeys->find(key);
 
-                    if (i != keys.end())
-                    {
-                        if (i->second != statement)
-                        {
-                            ++n_collisions;
-                            cerr << "error: Same key generated for '" << i->second << "' and '"
-                                 << statement << "'." << endl;
-                        }
-                    }
-                    else
-                    {
-                        ++n_keys;
-                        keys.insert(make_pair(key, statement));
-                    }
-                }
-                else
+            if (i != pKeys->end())
+            {
+                if (i->second != id)
                 {
-                    cerr << "error: Could not generate a key for '" << statement << "'." << endl;
-                    rv = EXIT_FAILURE;
+                    ++*pN_collisions;
+                    cerr << "error: Same key generated for '" << i->second << "' and '"
+                         << id << "'." << endl;
                 }
-
-                gwbuf_free(pQuery);
             }
             else
             {
-                rv = EXIT_FAILURE;
+                pKeys->insert(make_pair(key, id));
             }
+
+            rv = true;
+        }
+        else
+        {
+            cerr << "error: Could not generate a key for '" << statement << "'." << endl;
+        }
+
+        gwbuf_free(pQuery);
+    }
+
+    return rv;
+}
+
+int test_collisions(const vector<string>& statements)
+{
+    int rv = EXIT_SUCCESS;
+
+    Keys keys;
+    size_t n_collisions = 0;
+
+    for (const auto& statement : statements)
+    {
+        if (!check_key(NULL, statement, &keys, &n_collisions))
+        {
+            rv = EXIT_FAILURE;
         }
+    }
+
+    cout << statements.size() << " statements, "
+         << keys.size() << " unique keys, "
+         << n_collisions << " collisions."
+         << endl;
+
+    if (n_collisions != 0)
+    {
+        rv = EXIT_FAILURE;
+    }
 
-        cout << statements.size() << " statements, "
-             << n_keys << " unique keys, "
-             << n_collisions << " collisions."
-             << endl;
+    return rv;
+}
+
+/**
+ * Generates keys for a large number of statements that differ only slightly
+ * from each other, both with and without a default database. The database
+ * and the statement must be hashed so that moving a character from one to
+ * the other results in a different key.
+ */
+int test_synthetic_collisions(size_t n_statements)
+{
+    int rv = EXIT_SUCCESS;
 
+    Keys keys;
+    size_t n_collisions = 0;
+    size_t n_generated = 0;
+
+    for (size_t i = 0; i < n_statements; ++i)
+    {
+        string statement = "SELECT * FROM t WHERE id = " + std::to_string(i);
+        string db = "db" + std::to_string(i % 100);
 
-        if (rv == EXIT_SUCCESS)
+        if (!check_key(NULL, statement, &keys, &n_collisions)
+            || !check_key(db.c_str(), statement, &keys, &n_collisions))
         {
-            if (n_collisions != 0)
-            {
-                rv = EXIT_FAILURE;
-            }
+            rv = EXIT_FAILURE;
+        }
+
+        n_generated += 2;
+    }
+
+    for (size_t i = 1; i < 16; ++i)
+    {
+        string s = "abcdefghijklmnop";
+
+        if (!check_key(s.substr(0, i).c_str(), s.substr(i), &keys, &n_collisions))
+        {
+            rv = EXIT_FAILURE;
+        }
+
+        ++n_generated;
+    }
+
+    cout << n_generated << " synthetic statements, "
+         << keys.size() << " unique keys, "
+         << n_collisions << " collisions."
+         << endl;
+
+    if (n_collisions != 0)
+    {
+        rv = EXIT_FAILURE;
+    }
+
+    return rv;
+}
+
+/**
+ * The way keys were generated before they were widened to 128 bits. Only
+ * used as a reference in the benchmark.
+ */
+void get_crc32_key(const char* zDefault_db, const GWBUF* pQuery, uint64_t* pKey)
+{
+    char* pSql;
+    int length;
+
+    modutil_extract_SQL(const_cast<GWBUF*>(pQuery), &pSql, &length);
+
+    uint64_t crc1 = crc32(0, Z_NULL, 0);
+
+    const Bytef* pData;
+
+    if (zDefault_db)
+    {
+        pData = reinterpret_cast<const Bytef*>(zDefault_db);
+        crc1 = crc32(crc1, pData, strlen(zDefault_db));
+    }
+
+    pData = reinterpret_cast<const Bytef*>(pSql);
+
+    crc1 = crc32(crc1, pData, length);
+    uint64_t crc2 = crc32(crc1, pData, length);
+
+    *pKey = (crc1 << 32 | crc2);
+}
+
+/**
+ * Reports how long it takes to generate keys for the statements, using both
+ * the current key generation and the earlier crc32 based one.
+ */
+void benchmark(const vector<string>& statements)
+{
+    vector<GWBUF*> queries;
+    size_t n_bytes = 0;
+
+    for (const auto& statement : statements)
+    {
+        queries.push_back(Tester::gwbuf_from_string(statement));
+        n_bytes += statement.length();
+    }
+
+    // Hash at least 100MB so that the timings are meaningful.
+    const size_t N_MIN_BYTES = 100 * 1024 * 1024;
+    size_t n_rounds = (n_bytes != 0) ? N_MIN_BYTES / n_bytes + 1 : 0;
+    uint64_t sum = 0;
+
+    auto start = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < n_rounds; ++i)
+    {
+        for (auto pQuery : queries)
+        {
+            CACHE_KEY key;
+            Cache::get_default_key("test", pQuery, &key);
+            sum += key.data[0];
+        }
+    }
+
+    chrono::duration<double> key_time = chrono::steady_clock::now() - start;
+
+    start = chrono::steady_clock::now();
+
+    for (size_t i = 0; i < n_rounds; ++i)
+    {
+        for (auto pQuery : queries)
+        {
+            uint64_t key;
+            get_crc32_key("test", pQuery, &key);
+            sum += key;
         }
     }
+
+    chrono::duration<double> crc32_time = chrono::steady_clock::now() - start;
+
+    double n_keys = n_rounds * queries.size();
+    double n_mb = n_rounds * n_bytes / (1024.0 * 1024.0);
+
+    if (n_keys != 0)
+    {
+        cout << "128-bit keys: " << key_time.count() * 1e9 / n_keys << "ns/key, "
+             << n_mb / key_time.count() << "MB/s" << endl;
+        cout << "crc32 keys:   " << crc32_time.count() * 1e9 / n_keys << "ns/key, "
+             << n_mb / crc32_time.count() << "MB/s" << endl;
+    }
+
+    // Prevents the loops from being optimized away.
+    cout << "(checksum " << (sum & 0xff) << ")" << endl;
+
+    for (auto pQuery : queries)
+    {
+        gwbuf_free(pQuery);
+    }
+}
+
+int test(StorageFactory& factory, istream& in)
+{
+    int rv = EXIT_SUCCESS;
+
+    typedef vector<string> Statements;
+    Statements statements;
+
+    if (Tester::get_statements(in, 0, &statements))
+    {
+        rv = Tester::combine_rvs(rv, test_collisions(statements));
+        rv = Tester::combine_rvs(rv, test_synthetic_collisions(100000));
+        benchmark(statements);
+    }
     else
     {
         rv = EXIT_FAILURE;
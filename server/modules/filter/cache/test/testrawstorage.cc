@@ -50,6 +50,9 @@ int main(int argc, char* argv[])
 {
     char* libdir = MXS_STRDUP("../../../../../query_classifier/qc_sqlite/");
     set_libdir(libdir);
+    // The storage_shm module creates its default file in the runtime directory.
+    char* piddir = MXS_STRDUP(".");
+    set_piddir(piddir);
 
     TestRawStorage test(&cout);
     int rv = test.run(argc, argv);
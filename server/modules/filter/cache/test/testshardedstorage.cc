@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include <maxscale/ccdefs.hh>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <maxscale/alloc.h>
+#include <maxscale/log.h>
+#include <maxscale/paths.h>
+#include "storagefactory.hh"
+#include "storage.hh"
+#include "cache_storage_api.hh"
+#include "tester.hh"
+
+using namespace std;
+
+namespace
+{
+
+const size_t N_KEYS = 10000;
+const size_t VALUE_SIZE = 256;
+
+void print_usage(const char* zProgram)
+{
+    cout << "usage: " << zProgram << " storage-module [threads [time [shards]]]\n"
+         << "\n"
+         << "where:\n"
+         << "  storage-module  is the name of a storage module,\n"
+         << "  threads         is the number of threads accessing the storage,\n"
+         << "  time            is the number of seconds each storage is accessed, and\n"
+         << "  shards          is the number of shards of the sharded storage." << endl;
+}
+
+/**
+ * Accesses the storage as the cache does; mostly hits, some misses followed by puts.
+ */
+void access(Storage* pStorage, size_t seed, const atomic<bool>* pTerminate, atomic<uint64_t>* pOps)
+{
+    mt19937 random(seed);
+    vector<uint8_t> data(VALUE_SIZE, seed);
+    GWBUF* pValue = gwbuf_alloc_and_load(data.size(), data.data());
+    uint64_t ops = 0;
+
+    while (!pTerminate->load(memory_order_relaxed))
+    {
+        CacheKey key;
+        key.data[0] = random() % N_KEYS;
+        key.data[1] = key.data[0] * 0x9e3779b97f4a7c15ULL;
+
+        GWBUF* pResult = NULL;
+        cache_result_t result = pStorage->get_value(key, 0, &pResult);
+
+        if (CACHE_RESULT_IS_OK(result))
+        {
+            gwbuf_free(pResult);
+        }
+        else
+        {
+            pStorage->put_value(key, pValue);
+        }
+
+        ++ops;
+    }
+
+    *pOps += ops;
+    gwbuf_free(pValue);
+}
+
+int run(const char* zName, Storage* pStorage, size_t n_threads, size_t n_seconds, uint64_t max_count)
+{
+    int rv = EXIT_SUCCESS;
+
+    atomic<bool> terminate(false);
+    atomic<uint64_t> ops(0);
+    vector<thread> threads;
+
+    for (size_t i = 0; i < n_threads; ++i)
+    {
+        threads.emplace_back(access, pStorage, i, &terminate, &ops);
+    }
+
+    this_thread::sleep_for(chrono::seconds(n_seconds));
+    terminate.store(true);
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    uint64_t items = 0;
+    pStorage->get_items(&items);
+
+    cout << zName << ": " << ops / n_seconds << " operations/s, " << items << " items." << endl;
+
+    if (items > max_count)
+    {
+        cerr << "error: " << zName << " holds " << items << " items, although the maximum is "
+             << max_count << "." << endl;
+        rv = EXIT_FAILURE;
+    }
+
+    return rv;
+}
+
+int test(StorageFactory& factory, size_t n_threads, size_t n_seconds, size_t n_shards)
+{
+    int rv1 = EXIT_FAILURE;
+    int rv2 = EXIT_FAILURE;
+
+    // Half the keys fit, so there will be evictions.
+    CacheStorageConfig config(CACHE_THREAD_MODEL_MT);
+    config.max_count = N_KEYS / 2;
+
+    Storage* pStorage = factory.createStorage("mt", config);
+
+    if (pStorage)
+    {
+        rv1 = run("MT", pStorage, n_threads, n_seconds, config.max_count);
+        delete pStorage;
+    }
+
+    pStorage = factory.createShardedStorage("sharded", config, n_shards);
+
+    if (pStorage)
+    {
+        rv2 = run("Sharded", pStorage, n_threads, n_seconds, config.max_count);
+        delete pStorage;
+    }
+
+    return Tester::combine_rvs(rv1, rv2);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    int rv = EXIT_FAILURE;
+
+    if ((argc >= 2) && (argc <= 5))
+    {
+        size_t n_threads = (argc >= 3) ? atoi(argv[2]) : thread::hardware_concurrency();
+        size_t n_seconds = (argc >= 4) ? atoi(argv[3]) : 3;
+        size_t n_shards = (argc >= 5) ? atoi(argv[4]) : 16;
+
+        if (mxs_log_init(NULL, ".", MXS_LOG_TARGET_DEFAULT))
+        {
+            const char* zModule = argv[1];
+            char* libdir = MXS_STRDUP("../storage/storage_inmemory/");
+            set_libdir(libdir);
+
+            StorageFactory* pFactory = StorageFactory::Open(zModule);
+
+            if (pFactory)
+            {
+                rv = test(*pFactory, n_threads, n_seconds, n_shards);
+                delete pFactory;
+            }
+            else
+            {
+                cerr << "error: Could not initialize factory." << endl;
+            }
+
+            mxs_log_finish();
+        }
+        else
+        {
+            cerr << "error: Could not initialize log." << endl;
+        }
+    }
+    else
+    {
+        print_usage(argv[0]);
+    }
+
+    return rv;
+}
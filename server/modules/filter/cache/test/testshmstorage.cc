@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include <maxscale/ccdefs.hh>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <iostream>
+#include <maxscale/alloc.h>
+#include <maxscale/log.h>
+#include <maxscale/paths.h>
+#include "storagefactory.hh"
+#include "storage.hh"
+#include "cache_storage_api.hh"
+#include "tester.hh"
+
+using namespace std;
+
+namespace
+{
+
+const char ZPATH[] = "testshmstorage.cache";
+
+char zPath_arg[] = "path=testshmstorage.cache";
+char zSize_arg[] = "size=1M";
+char* ARGV[] = {zPath_arg, zSize_arg};
+const int ARGC = sizeof(ARGV) / sizeof(ARGV[0]);
+
+GWBUF* create_value(size_t size, uint8_t c)
+{
+    vector<uint8_t> data(size, c);
+    return gwbuf_alloc_and_load(data.size(), data.data());
+}
+
+CacheKey create_key(uint64_t i)
+{
+    CacheKey key;
+    key.data[0] = i;
+    key.data[1] = ~i;
+    return key;
+}
+
+bool is_present(Storage& storage, uint64_t i)
+{
+    GWBUF* pValue = NULL;
+    cache_result_t result = storage.get_value(create_key(i), CACHE_FLAGS_INCLUDE_STALE, &pValue);
+    gwbuf_free(pValue);
+
+    return CACHE_RESULT_IS_OK(result);
+}
+
+/**
+ * Checks that the content survives the storage being closed and reopened,
+ * which is what happens when MaxScale is restarted.
+ */
+int test_persistence(StorageFactory& factory)
+{
+    int rv = EXIT_SUCCESS;
+
+    CacheStorageConfig config(CACHE_THREAD_MODEL_MT);
+    Storage* pStorage = factory.createRawStorage("shm", config, ARGC, ARGV);
+
+    if (pStorage)
+    {
+        for (uint64_t i = 0; i < 100; ++i)
+        {
+            GWBUF* pValue = create_value(100 + i, i);
+            pStorage->put_value(create_key(i), pValue);
+            gwbuf_free(pValue);
+        }
+
+        delete pStorage;
+    }
+
+    pStorage = factory.createRawStorage("shm", config, ARGC, ARGV);
+
+    if (pStorage)
+    {
+        uint64_t items = 0;
+        pStorage->get_items(&items);
+
+        if (items != 100)
+        {
+            cerr << "error: Expected 100 items after reopening, found " << items << "." << endl;
+            rv = EXIT_FAILURE;
+        }
+
+        for (uint64_t i = 0; i < 100; ++i)
+        {
+            GWBUF* pValue = NULL;
+            cache_result_t result = pStorage->get_value(create_key(i), 0, &pValue);
+
+            if (!CACHE_RESULT_IS_OK(result)
+                || (gwbuf_length(pValue) != 100 + i)
+                || (GWBUF_DATA(pValue)[0] != i))
+            {
+                cerr << "error: Item " << i << " was not intact after reopening." << endl;
+                rv = EXIT_FAILURE;
+            }
+
+            gwbuf_free(pValue);
+        }
+
+        delete pStorage;
+    }
+    else
+    {
+        rv = EXIT_FAILURE;
+    }
+
+    return rv;
+}
+
+/**
+ * Checks that the least recently used item is evicted.
+ */
+int test_lru(StorageFactory& factory)
+{
+    int rv = EXIT_SUCCESS;
+
+    unlink(ZPATH);
+
+    CacheStorageConfig config(CACHE_THREAD_MODEL_MT);
+    config.max_count = 10;
+
+    Storage* pStorage = factory.createRawStorage("shm", config, ARGC, ARGV);
+
+    if (pStorage)
+    {
+        GWBUF* pValue = create_value(100, 0);
+
+        for (uint64_t i = 0; i < 10; ++i)
+        {
+            pStorage->put_value(create_key(i), pValue);
+        }
+
+        // Item 0 is used, so item 1 becomes the least recently used one.
+        is_present(*pStorage, 0);
+        pStorage->put_value(create_key(10), pValue);
+
+        if (!is_present(*pStorage, 0) || is_present(*pStorage, 1) || !is_present(*pStorage, 10))
+        {
+            cerr << "error: The least recently used item was not the one evicted." << endl;
+            rv = EXIT_FAILURE;
+        }
+
+        CACHE_KEY key;
+        GWBUF* pHead = NULL;
+
+        if (!CACHE_RESULT_IS_OK(pStorage->get_head(&key, &pHead)) || (key != create_key(10)))
+        {
+            cerr << "error: The most recently used item is not at the head." << endl;
+            rv = EXIT_FAILURE;
+        }
+
+        gwbuf_free(pHead);
+        gwbuf_free(pValue);
+        delete pStorage;
+    }
+    else
+    {
+        rv = EXIT_FAILURE;
+    }
+
+    return rv;
+}
+
+int test_invalidation(StorageFactory& factory)
+{
+    int rv = EXIT_SUCCESS;
+
+    unlink(ZPATH);
+
+    CacheStorageConfig config(CACHE_THREAD_MODEL_MT);
+    config.invalidate = CACHE_INVALIDATE_CURRENT;
+
+    Storage* pStorage = factory.createRawStorage("shm", config, ARGC, ARGV);
+
+    if (pStorage)
+    {
+        GWBUF* pValue = create_value(100, 0);
+
+        pStorage->put_value(create_key(1), {"db.t1"}, pValue);
+        pStorage->put_value(create_key(2), {"db.t2"}, pValue);
+        pStorage->put_value(create_key(3), {"db.t1", "db.t2"}, pValue);
+
+        pStorage->invalidate({"db.t1"});
+
+        if (is_present(*pStorage, 1) || !is_present(*pStorage, 2) || is_present(*pStorage, 3))
+        {
+            cerr << "error: Invalidation did not delete the right items." << endl;
+            rv = EXIT_FAILURE;
+        }
+
+        gwbuf_free(pValue);
+        delete pStorage;
+    }
+    else
+    {
+        rv = EXIT_FAILURE;
+    }
+
+    return rv;
+}
+
+/**
+ * Checks that storing items when the file is full evicts items, instead of failing.
+ */
+int test_full(StorageFactory& factory)
+{
+    int rv = EXIT_SUCCESS;
+
+    unlink(ZPATH);
+
+    CacheStorageConfig config(CACHE_THREAD_MODEL_MT);
+    Storage* pStorage = factory.createRawStorage("shm", config, ARGC, ARGV);
+
+    if (pStorage)
+    {
+        GWBUF* pValue = create_value(10000, 0);
+        const uint64_t N_ITEMS = 1000;
+
+        for (uint64_t i = 0; i < N_ITEMS; ++i)
+        {
+            if (!CACHE_RESULT_IS_OK(pStorage->put_value(create_key(i), pValue)))
+            {
+                cerr << "error: Could not store item " << i << " in a full file." << endl;
+                rv = EXIT_FAILURE;
+                break;
+            }
+        }
+
+        uint64_t items = 0;
+        pStorage->get_items(&items);
+
+        if ((items == 0) || (items == N_ITEMS) || !is_present(*pStorage, N_ITEMS - 1))
+        {
+            cerr << "error: Unexpected content, " << items << " items, in a full file." << endl;
+            rv = EXIT_FAILURE;
+        }
+
+        gwbuf_free(pValue);
+        delete pStorage;
+    }
+    else
+    {
+        rv = EXIT_FAILURE;
+    }
+
+    return rv;
+}
+
+/**
+ * Checks that a large item can be stored when the file is full of small items.
+ */
+int test_size_classes(StorageFactory& factory)
+{
+    int rv = EXIT_SUCCESS;
+
+    unlink(ZPATH);
+
+    CacheStorageConfig config(CACHE_THREAD_MODEL_MT);
+    Storage* pStorage = factory.createRawStorage("shm", config, ARGC, ARGV);
+
+    if (pStorage)
+    {
+        GWBUF* pSmall = create_value(100, 0);
+
+        for (uint64_t i = 0; i < 10000; ++i)
+        {
+            pStorage->put_value(create_key(i), pSmall);
+        }
+
+        GWBUF* pLarge = create_value(200000, 1);
+
+        if (!CACHE_RESULT_IS_OK(pStorage->put_value(create_key(10000), pLarge))
+            || !is_present(*pStorage, 10000))
+        {
+            cerr << "error: Could not store a large item in a file full of small items." << endl;
+            rv = EXIT_FAILURE;
+        }
+
+        if (!CACHE_RESULT_IS_OK(pStorage->put_value(create_key(10001), pSmall))
+            || !is_present(*pStorage, 10000))
+        {
+            cerr << "error: Storing a small item evicted the recently stored large item." << endl;
+            rv = EXIT_FAILURE;
+        }
+
+        gwbuf_free(pLarge);
+        gwbuf_free(pSmall);
+        delete pStorage;
+    }
+    else
+    {
+        rv = EXIT_FAILURE;
+    }
+
+    return rv;
+}
+
+/**
+ * Checks that a file that was not created by the module, or that other users
+ * can modify, is neither used nor modified.
+ */
+int test_foreign_file(StorageFactory& factory)
+{
+    int rv = EXIT_SUCCESS;
+
+    unlink(ZPATH);
+
+    const char CONTENT[] = "This is not a cache file.";
+    int fd = open(ZPATH, O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
+
+    if (fd == -1 || write(fd, CONTENT, sizeof(CONTENT)) != sizeof(CONTENT))
+    {
+        cerr << "error: Could not create '" << ZPATH << "'." << endl;
+        rv = EXIT_FAILURE;
+    }
+
+    close(fd);
+
+    CacheStorageConfig config(CACHE_THREAD_MODEL_MT);
+    Storage* pStorage = factory.createRawStorage("shm", config, ARGC, ARGV);
+    struct stat st;
+
+    if (pStorage || (stat(ZPATH, &st) != 0) || (st.st_size != sizeof(CONTENT)))
+    {
+        cerr << "error: A file with other content was used or modified." << endl;
+        rv = EXIT_FAILURE;
+    }
+
+    delete pStorage;
+    unlink(ZPATH);
+
+    // An empty file that other users can write to.
+    fd = open(ZPATH, O_CREAT | O_WRONLY, S_IRUSR | S_IWUSR);
+    fchmod(fd, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    close(fd);
+
+    pStorage = factory.createRawStorage("shm", config, ARGC, ARGV);
+
+    if (pStorage)
+    {
+        cerr << "error: A file writable by other users was used." << endl;
+        rv = EXIT_FAILURE;
+    }
+
+    delete pStorage;
+    unlink(ZPATH);
+
+    return rv;
+}
+
+int test(StorageFactory& factory)
+{
+    unlink(ZPATH);
+
+    int rv1 = test_persistence(factory);
+    int rv2 = test_lru(factory);
+    int rv3 = test_invalidation(factory);
+    int rv4 = test_full(factory);
+    int rv5 = test_size_classes(factory);
+    int rv6 = test_foreign_file(factory);
+
+    unlink(ZPATH);
+
+    return Tester::combine_rvs(rv1, rv2, rv3, rv4, Tester::combine_rvs(rv5, rv6));
+}
+}
+
+int main(int argc, char* argv[])
+{
+    int rv = EXIT_FAILURE;
+
+    if (mxs_log_init(NULL, ".", MXS_LOG_TARGET_DEFAULT))
+    {
+        char* libdir = MXS_STRDUP("../storage/storage_shm/");
+        set_libdir(libdir);
+
+        StorageFactory* pFactory = StorageFactory::Open("storage_shm");
+
+        if (pFactory)
+        {
+            rv = test(*pFactory);
+            delete pFactory;
+        }
+        else
+        {
+            cerr << "error: Could not initialize factory." << endl;
+        }
+
+        mxs_log_finish();
+    }
+    else
+    {
+        cerr << "error: Could not initialize log." << endl;
+    }
+
+    return rv;
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#define MXS_MODULE_NAME "digestfilter"
+
+#include "digest.hh"
+#include <cinttypes>
+#include <cmath>
+
+namespace digest
+{
+
+// static
+int LatencyHistogram::index_of(uint64_t usecs)
+{
+    int rval;
+
+    if (usecs < SUB_BUCKETS)
+    {
+        rval = usecs;
+    }
+    else
+    {
+        int msb = 63 - __builtin_clzll(usecs);
+
+        if (msb >= MAX_BITS)
+        {
+            rval = N_BUCKETS - 1;
+        }
+        else
+        {
+            // The SUB_BITS bits below the most significant bit select the bucket
+            int shift = msb - SUB_BITS;
+            rval = shift * SUB_BUCKETS + (usecs >> shift);
+        }
+    }
+
+    return rval;
+}
+
+// static
+uint64_t LatencyHistogram::lower_bound(int index)
+{
+    uint64_t rval = index;
+
+    if (index >= SUB_BUCKETS)
+    {
+        int shift = index / SUB_BUCKETS - 1;
+        rval = (uint64_t)(index - shift * SUB_BUCKETS) << shift;
+    }
+
+    return rval;
+}
+
+// static
+uint64_t LatencyHistogram::upper_bound(int index)
+{
+    return lower_bound(index + 1);
+}
+
+LatencyHistogram& LatencyHistogram::operator+=(const LatencyHistogram& rhs)
+{
+    for (int i = 0; i < N_BUCKETS; i++)
+    {
+        m_counts[i] += rhs.m_counts[i];
+    }
+
+    return *this;
+}
+
+uint64_t LatencyHistogram::percentile(double percentile) const
+{
+    uint64_t total = 0;
+
+    for (auto count : m_counts)
+    {
+        total += count;
+    }
+
+    uint64_t rval = 0;
+
+    if (total > 0)
+    {
+        uint64_t target = std::max<uint64_t>(std::ceil(total * percentile / 100), 1);
+        uint64_t seen = 0;
+
+        for (int i = 0; i < N_BUCKETS; i++)
+        {
+            seen += m_counts[i];
+
+            if (seen >= target)
+            {
+                rval = lower_bound(i) + (upper_bound(i) - lower_bound(i)) / 2;
+                break;
+            }
+        }
+    }
+
+    return rval;
+}
+
+json_t* LatencyHistogram::to_json() const
+{
+    json_t* arr = json_array();
+
+    for (int i = 0; i < N_BUCKETS; i++)
+    {
+        if (m_counts[i])
+        {
+            json_t* obj = json_object();
+            json_object_set_new(obj, "le_us", json_integer(upper_bound(i) - 1));
+            json_object_set_new(obj, "count", json_integer(m_counts[i]));
+            json_array_append_new(arr, obj);
+        }
+    }
+
+    return arr;
+}
+
+DigestStats& DigestStats::operator+=(const DigestStats& rhs)
+{
+    if (statement.empty())
+    {
+        statement = rhs.statement;
+    }
+
+    count += rhs.count;
+    errors += rhs.errors;
+    rows += rhs.rows;
+    total_usecs += rhs.total_usecs;
+    min_usecs = std::min(min_usecs, rhs.min_usecs);
+    max_usecs = std::max(max_usecs, rhs.max_usecs);
+    histogram += rhs.histogram;
+
+    return *this;
+}
+
+json_t* DigestStats::to_json(uint64_t digest) const
+{
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016" PRIx64, digest);
+
+    json_t* percentiles = json_object();
+    json_object_set_new(percentiles, "p50", json_integer(histogram.percentile(50)));
+    json_object_set_new(percentiles, "p90", json_integer(histogram.percentile(90)));
+    json_object_set_new(percentiles, "p99", json_integer(histogram.percentile(99)));
+    json_object_set_new(percentiles, "p999", json_integer(histogram.percentile(99.9)));
+
+    json_t* obj = json_object();
+    json_object_set_new(obj, "digest", json_string(hex));
+
+    // The statement is not necessarily valid UTF-8
+    json_t* stmt = json_stringn(statement.c_str(), statement.length());
+    json_object_set_new(obj, "statement", stmt ? stmt : json_null());
+    json_object_set_new(obj, "count", json_integer(count));
+    json_object_set_new(obj, "errors", json_integer(errors));
+    json_object_set_new(obj, "rows", json_integer(rows));
+    json_object_set_new(obj, "total_time_us", json_integer(total_usecs));
+    json_object_set_new(obj, "min_time_us", json_integer(count ? min_usecs : 0));
+    json_object_set_new(obj, "max_time_us", json_integer(max_usecs));
+    json_object_set_new(obj, "percentiles_us", percentiles);
+    json_object_set_new(obj, "histogram", histogram.to_json());
+
+    return obj;
+}
+
+json_t* tables_to_json(const std::vector<DigestTable>& tables)
+{
+    std::unordered_map<uint64_t, DigestStats> merged;
+    uint64_t untracked = 0;
+
+    for (const auto& table : tables)
+    {
+        for (const auto& a : table.digests)
+        {
+            merged[a.first] += a.second;
+        }
+
+        untracked += table.untracked;
+    }
+
+    std::vector<std::pair<uint64_t, const DigestStats*>> sorted;
+    sorted.reserve(merged.size());
+
+    for (const auto& a : merged)
+    {
+        sorted.emplace_back(a.first, &a.second);
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<uint64_t, const DigestStats*>& lhs,
+                                               const std::pair<uint64_t, const DigestStats*>& rhs) {
+                  return lhs.second->total_usecs > rhs.second->total_usecs;
+              });
+
+    json_t* arr = json_array();
+
+    for (const auto& a : sorted)
+    {
+        json_array_append_new(arr, a.second->to_json(a.first));
+    }
+
+    json_t* rval = json_object();
+    json_object_set_new(rval, "statements", arr);
+    json_object_set_new(rval, "untracked_queries", json_integer(untracked));
+
+    return rval;
+}
+}
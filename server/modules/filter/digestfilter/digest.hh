@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+#include <maxscale/jansson.hh>
+#include <algorithm>
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace digest
+{
+
+/**
+ * A latency histogram with logarithmic buckets
+ *
+ * Each power of two is split into SUB_BUCKETS linear buckets, so the width
+ * of a bucket is at most 1/SUB_BUCKETS of its lower bound. The latencies are
+ * recorded in microseconds and values at or above 2^MAX_BITS microseconds are
+ * recorded in the last bucket.
+ */
+class LatencyHistogram
+{
+public:
+    static const int SUB_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int MAX_BITS = 32;
+    static const int N_BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram()
+    {
+        m_counts.fill(0);
+    }
+
+    /**
+     * Record a latency
+     *
+     * @param usecs Latency in microseconds
+     */
+    void add(uint64_t usecs)
+    {
+        m_counts[index_of(usecs)]++;
+    }
+
+    /**
+     * Add the counts of another histogram to this one
+     */
+    LatencyHistogram& operator+=(const LatencyHistogram& rhs);
+
+    /**
+     * Get a percentile of the recorded latencies
+     *
+     * @param percentile The percentile, between 0 and 100
+     *
+     * @return The middle of the bucket where the percentile is, in microseconds
+     */
+    uint64_t percentile(double percentile) const;
+
+    /**
+     * Get the histogram as a JSON array
+     *
+     * @return An array of the non-empty buckets as objects with the upper bound
+     *         of the bucket in microseconds and the number of latencies in it
+     */
+    json_t* to_json() const;
+
+    static int index_of(uint64_t usecs);
+
+    // The lowest value that is recorded in a bucket
+    static uint64_t lower_bound(int index);
+
+    // The lowest value that is recorded in the next bucket
+    static uint64_t upper_bound(int index);
+
+private:
+    std::array<uint64_t, N_BUCKETS> m_counts;
+};
+
+/**
+ * The statistics of one canonical statement
+ */
+struct DigestStats
+{
+    std::string      statement;                 // The canonical statement, possibly truncated
+    uint64_t         count = 0;                 // Number of completed executions
+    uint64_t         errors = 0;                // How many of them returned an error
+    uint64_t         rows = 0;                  // Rows returned or affected
+    uint64_t         total_usecs = 0;           // Total latency
+    uint64_t         min_usecs = UINT64_MAX;    // Lowest latency
+    uint64_t         max_usecs = 0;             // Highest latency
+    LatencyHistogram histogram;
+
+    /**
+     * Record a completed execution
+     *
+     * @param usecs  Latency in microseconds
+     * @param n_rows Rows returned or affected
+     * @param error  Whether the statement failed
+     */
+    void add(uint64_t usecs, uint64_t n_rows, bool error)
+    {
+        ++count;
+        errors += error;
+        rows += n_rows;
+        total_usecs += usecs;
+        min_usecs = std::min(min_usecs, usecs);
+        max_usecs = std::max(max_usecs, usecs);
+        histogram.add(usecs);
+    }
+
+    DigestStats& operator+=(const DigestStats& rhs);
+
+    json_t* to_json(uint64_t digest) const;
+};
+
+/**
+ * The statistics of all statements executed by one routing worker
+ */
+struct DigestTable
+{
+    std::unordered_map<uint64_t, DigestStats> digests;
+    uint64_t                                  untracked = 0;    // Executions that did not fit
+};
+
+/**
+ * Merge the tables of all workers and convert the result into JSON
+ *
+ * @param tables The tables to merge
+ *
+ * @return A JSON object with the statements in an array, ordered by total
+ *         latency, and the number of executions that were not tracked
+ */
+json_t* tables_to_json(const std::vector<DigestTable>& tables);
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+/**
+ * @file digestfilter.cc - Statement digest statistics
+ *
+ * The filter aggregates the latencies and row counts of the statements by
+ * the hash of their canonical form. Each routing worker has its own table of
+ * statements so nothing is shared between the sessions while the statements
+ * are executed. The tables are merged only when the statistics are requested.
+ */
+
+#define MXS_MODULE_NAME "digestfilter"
+
+#include "digestfilter.hh"
+#include <maxscale/modulecmd.h>
+
+namespace
+{
+
+const char CN_MAX_DIGESTS[] = "max_digests";
+
+// How many of the statements with the highest total latency are printed
+const size_t DIAGNOSTICS_STATEMENTS = 10;
+
+bool cb_reset(const MODULECMD_ARG* argv, json_t** output)
+{
+    mxb_assert(argv->argc > 0);
+    mxb_assert(argv->argv[0].type.type == MODULECMD_ARG_FILTER);
+
+    MXS_FILTER_DEF* filter = argv->argv[0].value.filter;
+    DigestFilter* instance = reinterpret_cast<DigestFilter*>(filter_def_get_instance(filter));
+    instance->reset();
+
+    return true;
+}
+}
+
+// This declares a module in MaxScale
+extern "C" MXS_MODULE* MXS_CREATE_MODULE()
+{
+    modulecmd_arg_type_t args[] =
+    {
+        {MODULECMD_ARG_FILTER | MODULECMD_ARG_NAME_MATCHES_DOMAIN, "Filter to reset"}
+    };
+
+    modulecmd_register_command(MXS_MODULE_NAME,
+                               "reset",
+                               MODULECMD_TYPE_ACTIVE,
+                               cb_reset,
+                               MXS_ARRAY_NELEMS(args),
+                               args,
+                               "Clear the statement statistics");
+
+    static MXS_MODULE info =
+    {
+        MXS_MODULE_API_FILTER,
+        MXS_MODULE_IN_DEVELOPMENT,
+        MXS_FILTER_VERSION,
+        "A filter that aggregates statement statistics by statement digest",
+        "V1.0.0",
+        RCAP_TYPE_CONTIGUOUS_INPUT | RCAP_TYPE_CONTIGUOUS_OUTPUT,
+        &DigestFilter::s_object,
+        NULL,   /* Process init. */
+        NULL,   /* Process finish. */
+        NULL,   /* Thread init. */
+        NULL,   /* Thread finish. */
+        {
+            {CN_MAX_DIGESTS,         MXS_MODULE_PARAM_COUNT, "1000"},
+            {MXS_END_MODULE_PARAMS}
+        }
+    };
+
+    return &info;
+}
+
+DigestFilter::DigestFilter(uint64_t max_digests)
+    : m_max_digests(max_digests)
+{
+}
+
+// static
+DigestFilter* DigestFilter::create(const char* zName, MXS_CONFIG_PARAMETER* pParams)
+{
+    return new DigestFilter(config_get_integer(pParams, CN_MAX_DIGESTS));
+}
+
+DigestFilterSession* DigestFilter::newSession(MXS_SESSION* pSession)
+{
+    return DigestFilterSession::create(pSession, this);
+}
+
+void DigestFilter::diagnostics(DCB* pDcb) const
+{
+    json_t* json = digest::tables_to_json(m_tables.values());
+    json_t* statements = json_object_get(json, "statements");
+
+    dcb_printf(pDcb, "\t\tStatements:        %lu\n", json_array_size(statements));
+    dcb_printf(pDcb,
+               "\t\tUntracked queries: %" JSON_INTEGER_FORMAT "\n",
+               json_integer_value(json_object_get(json, "untracked_queries")));
+
+    size_t i;
+    json_t* value;
+
+    json_array_foreach(statements, i, value)
+    {
+        if (i == DIAGNOSTICS_STATEMENTS)
+        {
+            break;
+        }
+
+        json_t* statement = json_object_get(value, "statement");
+
+        dcb_printf(pDcb,
+                   "\t\t%s count: %" JSON_INTEGER_FORMAT " total: %" JSON_INTEGER_FORMAT "us p99: %"
+                   JSON_INTEGER_FORMAT "us %s\n",
+                   json_string_value(json_object_get(value, "digest")),
+                   json_integer_value(json_object_get(value, "count")),
+                   json_integer_value(json_object_get(value, "total_time_us")),
+                   json_integer_value(json_object_get(json_object_get(value, "percentiles_us"), "p99")),
+                   json_is_string(statement) ? json_string_value(statement) : "");
+    }
+
+    json_decref(json);
+}
+
+json_t* DigestFilter::diagnostics_json() const
+{
+    json_t* rval = digest::tables_to_json(m_tables.values());
+    json_object_set_new(rval, CN_MAX_DIGESTS, json_integer(m_max_digests));
+    return rval;
+}
+
+uint64_t DigestFilter::getCapabilities()
+{
+    return RCAP_TYPE_CONTIGUOUS_INPUT | RCAP_TYPE_CONTIGUOUS_OUTPUT;
+}
+
+void DigestFilter::reset()
+{
+    m_tables.assign(digest::DigestTable());
+}
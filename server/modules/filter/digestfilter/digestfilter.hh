@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+#include <maxscale/filter.hh>
+#include <maxscale/routingworker.hh>
+#include "digest.hh"
+#include "digestfiltersession.hh"
+
+class DigestFilter : public maxscale::Filter<DigestFilter, DigestFilterSession>
+{
+public:
+    // Prevent copy-constructor and assignment operator usage
+    DigestFilter(const DigestFilter&) = delete;
+    DigestFilter& operator=(const DigestFilter&) = delete;
+
+    // Creates a new filter instance
+    static DigestFilter* create(const char* zName, MXS_CONFIG_PARAMETER* pParams);
+
+    // Creates a new session for this filter
+    DigestFilterSession* newSession(MXS_SESSION* pSession);
+
+    // Print diagnostics to a DCB
+    void diagnostics(DCB* pDcb) const;
+
+    // Returns JSON form diagnostic data
+    json_t* diagnostics_json() const;
+
+    // Get filter capabilities
+    uint64_t getCapabilities();
+
+    // The statistics of the calling routing worker
+    digest::DigestTable& table()
+    {
+        return *m_tables;
+    }
+
+    // How many statements each routing worker tracks
+    uint64_t max_digests() const
+    {
+        return m_max_digests;
+    }
+
+    // Clear the statistics of all routing workers
+    void reset();
+
+private:
+    DigestFilter(uint64_t max_digests);
+
+    uint64_t                                 m_max_digests;
+    mxs::rworker_local<digest::DigestTable> m_tables;
+};
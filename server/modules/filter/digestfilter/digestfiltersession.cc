@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#define MXS_MODULE_NAME "digestfilter"
+
+#include "digestfiltersession.hh"
+#include "digestfilter.hh"
+#include <maxscale/modutil.hh>
+#include <maxscale/mysql_utils.h>
+#include <maxscale/protocol/mysql.h>
+
+namespace
+{
+
+// Longer canonical statements are truncated before they are stored
+const size_t MAX_STATEMENT_LENGTH = 1024;
+
+std::string truncate_statement(const mxs::Canonical& canonical)
+{
+    size_t len = canonical.len;
+
+    if (len > MAX_STATEMENT_LENGTH)
+    {
+        len = MAX_STATEMENT_LENGTH;
+
+        // Don't cut a multi-byte UTF-8 character in half
+        while (len > 0 && (canonical.pStmt[len] & 0xc0) == 0x80)
+        {
+            --len;
+        }
+    }
+
+    return std::string(canonical.pStmt, len);
+}
+
+uint16_t get_status(const uint8_t* pPayload, uint32_t len, uint32_t offset)
+{
+    return offset + 2 <= len ? gw_mysql_get_byte2(pPayload + offset) : 0;
+}
+}
+
+DigestFilterSession::DigestFilterSession(MXS_SESSION* pSession, DigestFilter* pFilter)
+    : maxscale::FilterSession(pSession)
+    , m_filter(*pFilter)
+{
+}
+
+// static
+DigestFilterSession* DigestFilterSession::create(MXS_SESSION* pSession, DigestFilter* pFilter)
+{
+    return new DigestFilterSession(pSession, pFilter);
+}
+
+int DigestFilterSession::routeQuery(GWBUF* pPacket)
+{
+    // A statement that is sent before the previous one is complete is not measured
+    if (m_state == IDLE && modutil_is_SQL(pPacket))
+    {
+        mxs::Canonical canonical = mxs::canonicalize(pPacket);
+        digest::DigestTable& table = m_filter.table();
+        bool tracked = table.digests.count(canonical.hash);
+
+        if (!tracked && table.digests.size() < m_filter.max_digests())
+        {
+            table.digests[canonical.hash].statement = truncate_statement(canonical);
+            tracked = true;
+        }
+
+        if (tracked)
+        {
+            m_state = EXPECTING_RESPONSE;
+            m_digest = canonical.hash;
+            m_rows = 0;
+            m_large_packet = false;
+            m_watch.restart();
+        }
+        else
+        {
+            table.untracked++;
+        }
+    }
+
+    return mxs::FilterSession::routeQuery(pPacket);
+}
+
+int DigestFilterSession::clientReply(GWBUF* pPacket)
+{
+    if (m_state != IDLE)
+    {
+        // The output is contiguous and consists of complete packets
+        const uint8_t* ptr = GWBUF_DATA(pPacket);
+        const uint8_t* end = ptr + GWBUF_LENGTH(pPacket);
+
+        while (m_state != IDLE && end - ptr >= MYSQL_HEADER_LEN)
+        {
+            uint32_t len = MYSQL_GET_PAYLOAD_LEN(ptr);
+            const uint8_t* pPayload = ptr + MYSQL_HEADER_LEN;
+            mxb_assert(end - pPayload >= len);
+
+            if (!m_large_packet && len > 0)
+            {
+                process_packet(pPayload, len);
+            }
+
+            m_large_packet = len == GW_MYSQL_MAX_PACKET_LEN;
+            ptr = pPayload + len;
+        }
+    }
+
+    return mxs::FilterSession::clientReply(pPacket);
+}
+
+void DigestFilterSession::process_packet(const uint8_t* pPayload, uint32_t len)
+{
+    uint8_t cmd = pPayload[0];
+    bool is_eof = cmd == MYSQL_REPLY_EOF && len + MYSQL_HEADER_LEN == MYSQL_EOF_PACKET_LEN;
+
+    switch (m_state)
+    {
+    case EXPECTING_RESPONSE:
+        if (cmd == MYSQL_REPLY_ERR)
+        {
+            complete(true);
+        }
+        else if (cmd == MYSQL_REPLY_OK)
+        {
+            // Affected rows and the last insert ID are followed by the status
+            const uint8_t* ptr = pPayload + 1;
+            m_rows += mxs_leint_value(ptr);
+            ptr += mxs_leint_bytes(ptr);
+            ptr += mxs_leint_bytes(ptr);
+
+            if ((get_status(pPayload, len, ptr - pPayload) & SERVER_MORE_RESULTS_EXIST) == 0)
+            {
+                complete(false);
+            }
+        }
+        else if (cmd != MYSQL_REPLY_LOCAL_INFILE)
+        {
+            // The column count of a result set. The OK of a LOAD DATA LOCAL INFILE
+            // arrives after the client has sent the file.
+            m_state = EXPECTING_FIELDS;
+        }
+        break;
+
+    case EXPECTING_FIELDS:
+        if (is_eof)
+        {
+            m_state = EXPECTING_ROWS;
+        }
+        break;
+
+    case EXPECTING_ROWS:
+        if (is_eof)
+        {
+            // The status follows the warning count
+            if (get_status(pPayload, len, 3) & SERVER_MORE_RESULTS_EXIST)
+            {
+                m_state = EXPECTING_RESPONSE;
+            }
+            else
+            {
+                complete(false);
+            }
+        }
+        else if (cmd == MYSQL_REPLY_ERR)
+        {
+            complete(true);
+        }
+        else
+        {
+            m_rows++;
+        }
+        break;
+
+    case IDLE:
+        mxb_assert(!true);
+        break;
+    }
+}
+
+void DigestFilterSession::complete(bool error)
+{
+    auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(m_watch.split());
+    digest::DigestTable& table = m_filter.table();
+    auto it = table.digests.find(m_digest);
+
+    // The statistics may have been reset or the session moved to another worker
+    if (it != table.digests.end())
+    {
+        it->second.add(usecs.count(), m_rows, error);
+    }
+
+    m_state = IDLE;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+#include <maxscale/filter.hh>
+#include <maxbase/stopwatch.hh>
+
+class DigestFilter;
+
+class DigestFilterSession : public maxscale::FilterSession
+{
+public:
+    // Prevent copy-constructor and assignment operator usage
+    DigestFilterSession(const DigestFilterSession&) = delete;
+    DigestFilterSession& operator=(const DigestFilterSession&) = delete;
+
+    // Create a new filter session
+    static DigestFilterSession* create(MXS_SESSION* pSession, DigestFilter* pFilter);
+
+    // Handle a query from the client
+    int routeQuery(GWBUF* pPacket);
+
+    // Handle a reply from server
+    int clientReply(GWBUF* pPacket);
+
+private:
+    enum State
+    {
+        IDLE,               // No statement is being measured
+        EXPECTING_RESPONSE, // Waiting for the first packet of a result
+        EXPECTING_FIELDS,   // Waiting for the EOF after the column definitions
+        EXPECTING_ROWS      // Counting rows until the EOF of the result set
+    };
+
+    DigestFilterSession(MXS_SESSION* pSession, DigestFilter* pFilter);
+
+    void process_packet(const uint8_t* pPayload, uint32_t len);
+    void complete(bool error);
+
+    DigestFilter&      m_filter;
+    State              m_state = IDLE;
+    uint64_t           m_digest = 0;            // Digest of the statement being measured
+    uint64_t           m_rows = 0;              // Rows returned or affected so far
+    bool               m_large_packet = false;  // Whether the previous packet continues in the next one
+    maxbase::StopWatch m_watch;                 // Started when the statement is routed
+};
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "../digest.hh"
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+using digest::DigestStats;
+using digest::DigestTable;
+using digest::LatencyHistogram;
+
+namespace
+{
+
+int test_buckets()
+{
+    int rval = 0;
+    int prev = -1;
+
+    // Every value falls into the bucket whose bounds contain it and the buckets are contiguous
+    for (uint64_t v = 0; v < (1UL << 20); v++)
+    {
+        int i = LatencyHistogram::index_of(v);
+
+        if (i < prev || i > prev + 1
+            || v < LatencyHistogram::lower_bound(i)
+            || v >= LatencyHistogram::upper_bound(i))
+        {
+            cout << "Value " << v << " is in bucket " << i << " ["
+                 << LatencyHistogram::lower_bound(i) << ", "
+                 << LatencyHistogram::upper_bound(i) << ")" << endl;
+            rval++;
+            break;
+        }
+
+        // The width of a bucket is at most 1/SUB_BUCKETS of its lower bound
+        uint64_t width = LatencyHistogram::upper_bound(i) - LatencyHistogram::lower_bound(i);
+
+        if (width > 1 && width * LatencyHistogram::SUB_BUCKETS > LatencyHistogram::lower_bound(i))
+        {
+            cout << "Bucket " << i << " is too wide: " << width << endl;
+            rval++;
+            break;
+        }
+
+        prev = i;
+    }
+
+    int last = LatencyHistogram::N_BUCKETS - 1;
+
+    if (LatencyHistogram::index_of((1UL << LatencyHistogram::MAX_BITS) - 1) != last
+        || LatencyHistogram::index_of(1UL << LatencyHistogram::MAX_BITS) != last
+        || LatencyHistogram::index_of(UINT64_MAX) != last)
+    {
+        cout << "Large values are not in the last bucket." << endl;
+        rval++;
+    }
+
+    return rval;
+}
+
+int test_percentiles()
+{
+    int rval = 0;
+    LatencyHistogram histogram;
+
+    if (histogram.percentile(50) != 0)
+    {
+        cout << "Empty histogram has a non-zero median." << endl;
+        rval++;
+    }
+
+    // 1..1000 microseconds, so the n:th percentile is close to 10 * n
+    for (uint64_t v = 1; v <= 1000; v++)
+    {
+        histogram.add(v);
+    }
+
+    for (double p : {1.0, 50.0, 90.0, 99.0, 99.9, 100.0})
+    {
+        double expected = 10 * p;
+        double value = histogram.percentile(p);
+
+        if (value < expected * (1 - 1.0 / LatencyHistogram::SUB_BUCKETS)
+            || value > expected * (1 + 1.0 / LatencyHistogram::SUB_BUCKETS))
+        {
+            cout << "Percentile " << p << " is " << value << ", expected about " << expected << endl;
+            rval++;
+        }
+    }
+
+    return rval;
+}
+
+int test_merge()
+{
+    int rval = 0;
+    DigestTable t1;
+    DigestTable t2;
+
+    // Statement 1 is fast on both workers, statement 2 is slow on one worker
+    t1.digests[1].statement = "SELECT ?";
+    t2.digests[1].statement = "SELECT ?";
+    t2.digests[2].statement = "UPDATE t SET a = ?";
+
+    for (int i = 0; i < 100; i++)
+    {
+        t1.digests[1].add(10, 1, false);
+        t2.digests[1].add(20, 1, false);
+    }
+
+    t2.digests[2].add(50000, 5, false);
+    t2.digests[2].add(100, 0, true);
+    t1.untracked = 3;
+    t2.untracked = 4;
+
+    json_t* json = digest::tables_to_json({t1, t2});
+    json_t* statements = json_object_get(json, "statements");
+    json_t* first = json_array_get(statements, 0);
+    json_t* second = json_array_get(statements, 1);
+
+    if (json_array_size(statements) != 2
+        || json_integer_value(json_object_get(json, "untracked_queries")) != 7)
+    {
+        cout << "Wrong number of statements or untracked queries." << endl;
+        rval++;
+    }
+    else if (strcmp(json_string_value(json_object_get(first, "statement")), "UPDATE t SET a = ?") != 0
+             || strcmp(json_string_value(json_object_get(first, "digest")), "0000000000000002") != 0
+             || json_integer_value(json_object_get(first, "count")) != 2
+             || json_integer_value(json_object_get(first, "errors")) != 1
+             || json_integer_value(json_object_get(first, "rows")) != 5
+             || json_integer_value(json_object_get(first, "min_time_us")) != 100
+             || json_integer_value(json_object_get(first, "max_time_us")) != 50000)
+    {
+        cout << "Statement with the highest total time is not first." << endl;
+        rval++;
+    }
+    else if (json_integer_value(json_object_get(second, "count")) != 200
+             || json_integer_value(json_object_get(second, "rows")) != 200
+             || json_integer_value(json_object_get(second, "total_time_us")) != 3000
+             || json_integer_value(json_object_get(second, "min_time_us")) != 10
+             || json_integer_value(json_object_get(second, "max_time_us")) != 20
+             || json_array_size(json_object_get(second, "histogram")) != 2)
+    {
+        cout << "Statistics of the workers were not merged." << endl;
+        rval++;
+    }
+
+    if (rval)
+    {
+        char* str = json_dumps(json, JSON_INDENT(2));
+        cout << str << endl;
+        free(str);
+    }
+
+    json_decref(json);
+    return rval;
+}
+}
+
+int main(int argc, char** argv)
+{
+    int rval = 0;
+
+    rval += test_buckets();
+    rval += test_percentiles();
+    rval += test_merge();
+
+    return rval;
+}
@@ -34,6 +34,10 @@
  * is defined and valid, the matching entry point function in Lua will be called.
  * The same holds true for session script apart from no calls to createInstance
  * or diagnostic being made for the session script.
+ *
+ * The global script is either executed in a single Lua state protected by a
+ * mutex, or in a separate Lua state on each routing worker. Values that must be
+ * visible in all states can be stored with the lua_shared_* functions.
  */
 
 #define MXS_MODULE_NAME "luafilter"
@@ -51,6 +55,8 @@ extern "C"
 }
 
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <maxscale/alloc.h>
 #include <maxscale/filter.h>
 #include <maxscale/log.h>
@@ -77,6 +83,22 @@ static void     diagnostic(MXS_FILTER* instance, MXS_FILTER_SESSION* fsession, D
 static json_t*  diagnostic_json(const MXS_FILTER* instance, const MXS_FILTER_SESSION* fsession);
 static uint64_t getCapabilities(MXS_FILTER* instance);
 
+/**
+ * How the global script is executed
+ */
+enum lua_global_mode_t
+{
+    LUA_GLOBAL_LOCKED,      /**< One Lua state, calls are serialized with a mutex */
+    LUA_GLOBAL_PER_WORKER   /**< One Lua state per routing worker */
+};
+
+static const MXS_ENUM_VALUE global_mode_values[] =
+{
+    {"locked",     LUA_GLOBAL_LOCKED    },
+    {"per_worker", LUA_GLOBAL_PER_WORKER},
+    {NULL}
+};
+
 extern "C"
 {
 
@@ -122,6 +144,13 @@ extern "C"
             {
                 {"global_script",      MXS_MODULE_PARAM_PATH,  NULL, MXS_MODULE_OPT_PATH_R_OK},
                 {"session_script",     MXS_MODULE_PARAM_PATH,  NULL, MXS_MODULE_OPT_PATH_R_OK},
+                {
+                    "global_script_mode",
+                    MXS_MODULE_PARAM_ENUM,
+                    "locked",
+                    MXS_MODULE_OPT_NONE,
+                    global_mode_values
+                },
                 {MXS_END_MODULE_PARAMS}
             }
         };
@@ -131,7 +160,6 @@ extern "C"
 }
 
 static int id_pool = 0;
-static GWBUF* current_global_query = NULL;
 
 /**
  * Push an unique integer to the Lua state's stack
@@ -202,15 +230,37 @@ static int lua_get_canonical(lua_State* state)
     return 1;
 }
 
+/**
+ * A Lua state running the global script, and the query it is processing.
+ */
+typedef struct
+{
+    lua_State* state;
+    GWBUF*     current_query;
+} LUA_GLOBAL_STATE;
+
+/**
+ * A value stored with lua_shared_set().
+ */
+typedef struct
+{
+    int         type = LUA_TNIL;    /**< LUA_TBOOLEAN, LUA_TNUMBER or LUA_TSTRING */
+    lua_Number  number = 0;         /**< The value of a number or a boolean */
+    std::string string;             /**< The value of a string */
+} LUA_SHARED_VALUE;
+
 /**
  * The Lua filter instance.
  */
 typedef struct
 {
-    lua_State* global_lua_state;
-    char*      global_script;
-    char*      session_script;
-    std::mutex lock;
+    LUA_GLOBAL_STATE  global;           /**< The global state in the locked mode */
+    lua_global_mode_t global_mode;
+    char*             global_script;
+    char*             session_script;
+    std::mutex        lock;             /**< Protects the global state in the locked mode */
+    std::mutex        shared_lock;      /**< Protects the shared values */
+    std::unordered_map<std::string, LUA_SHARED_VALUE> shared_values;
 } LUA_INSTANCE;
 
 /**
@@ -225,12 +275,154 @@ typedef struct
     MXS_UPSTREAM   up;
 } LUA_SESSION;
 
-void expose_functions(lua_State* state, GWBUF** active_buffer)
+static LUA_INSTANCE* shared_instance(lua_State* state)
+{
+    return static_cast<LUA_INSTANCE*>(lua_touserdata(state, lua_upvalueindex(1)));
+}
+
+/**
+ * Get a shared value, nil if the value has not been set
+ */
+static int lua_shared_get(lua_State* state)
+{
+    LUA_INSTANCE* instance = shared_instance(state);
+    const char* key = luaL_checkstring(state, 1);
+    std::lock_guard<std::mutex> guard(instance->shared_lock);
+
+    auto it = instance->shared_values.find(key);
+
+    if (it == instance->shared_values.end())
+    {
+        lua_pushnil(state);
+    }
+    else if (it->second.type == LUA_TSTRING)
+    {
+        lua_pushlstring(state, it->second.string.c_str(), it->second.string.length());
+    }
+    else if (it->second.type == LUA_TBOOLEAN)
+    {
+        lua_pushboolean(state, it->second.number != 0);
+    }
+    else
+    {
+        lua_pushnumber(state, it->second.number);
+    }
+
+    return 1;
+}
+
+/**
+ * Set a shared value, setting it to nil removes the value
+ *
+ * Lua errors are raised before any C++ objects are created, as they do not
+ * return and would leak the objects.
+ */
+static int lua_shared_set(lua_State* state)
+{
+    LUA_INSTANCE* instance = shared_instance(state);
+    const char* key = luaL_checkstring(state, 1);
+    int type = lua_type(state, 2);
+
+    if (type != LUA_TNONE && type != LUA_TNIL && type != LUA_TBOOLEAN
+        && type != LUA_TNUMBER && type != LUA_TSTRING)
+    {
+        return luaL_error(state, "lua_shared_set: values of type '%s' cannot be shared",
+                          lua_typename(state, type));
+    }
+
+    LUA_SHARED_VALUE value;
+    value.type = type;
+
+    if (type == LUA_TBOOLEAN)
+    {
+        value.number = lua_toboolean(state, 2);
+    }
+    else if (type == LUA_TNUMBER)
+    {
+        value.number = lua_tonumber(state, 2);
+    }
+    else if (type == LUA_TSTRING)
+    {
+        size_t len;
+        const char* str = lua_tolstring(state, 2, &len);
+        value.string.assign(str, len);
+    }
+
+    std::lock_guard<std::mutex> guard(instance->shared_lock);
+
+    if (type == LUA_TNONE || type == LUA_TNIL)
+    {
+        instance->shared_values.erase(key);
+    }
+    else
+    {
+        instance->shared_values[key] = std::move(value);
+    }
+
+    return 0;
+}
+
+/**
+ * Atomically add to a shared number and return the new value. A missing value is
+ * treated as 0 and the default increment is 1.
+ */
+static int lua_shared_add(lua_State* state)
+{
+    LUA_INSTANCE* instance = shared_instance(state);
+    const char* key = luaL_checkstring(state, 1);
+    lua_Number delta = luaL_optnumber(state, 2, 1);
+    lua_Number result = 0;
+    bool is_number = true;
+
+    {
+        std::lock_guard<std::mutex> guard(instance->shared_lock);
+        LUA_SHARED_VALUE& value = instance->shared_values[key];
+
+        if (value.type == LUA_TNIL)
+        {
+            // A new value
+            value.type = LUA_TNUMBER;
+        }
+
+        if (value.type == LUA_TNUMBER)
+        {
+            value.number += delta;
+            result = value.number;
+        }
+        else
+        {
+            is_number = false;
+        }
+    }
+
+    if (!is_number)
+    {
+        return luaL_error(state, "lua_shared_add: the value of '%s' is not a number", key);
+    }
+
+    lua_pushnumber(state, result);
+    return 1;
+}
+
+void expose_functions(lua_State* state, GWBUF** active_buffer, LUA_INSTANCE* instance)
 {
     /** Expose an ID generation function */
     lua_pushcfunction(state, id_gen);
     lua_setglobal(state, "id_gen");
 
+    /** Expose the values shared by all Lua states of the filter */
+    lua_pushlightuserdata(state, instance);
+    lua_pushcclosure(state, lua_shared_get, 1);
+    lua_setglobal(state, "lua_shared_get");
+
+    lua_pushlightuserdata(state, instance);
+    lua_pushcclosure(state, lua_shared_set, 1);
+    lua_setglobal(state, "lua_shared_set");
+
+    lua_pushlightuserdata(state, instance);
+    lua_pushcclosure(state, lua_shared_add, 1);
+    lua_setglobal(state, "lua_shared_add");
+
     /** Expose a part of the query classifier API */
     lua_pushlightuserdata(state, active_buffer);
     lua_pushcclosure(state, lua_qc_get_type_mask, 1);
@@ -245,11 +437,149 @@ void expose_functions(lua_State* state, GWBUF** active_buffer)
     lua_setglobal(state, "lua_get_canonical");
 }
 
+/**
+ * Create a Lua state for the global script. The script is executed once on a global
+ * level before calling the createInstance function in the Lua script.
+ *
+ * @param instance The filter instance
+ * @param global   The global state to initialize
+ * @return True if the script could be executed
+ */
+static bool create_global_state(LUA_INSTANCE* instance, LUA_GLOBAL_STATE* global)
+{
+    global->current_query = NULL;
+
+    if ((global->state = luaL_newstate()) == NULL)
+    {
+        MXS_ERROR("Unable to initialize new Lua state.");
+        return false;
+    }
+
+    luaL_openlibs(global->state);
+
+    if (luaL_dofile(global->state, instance->global_script))
+    {
+        MXS_ERROR("Failed to execute global script at '%s':%s.",
+                  instance->global_script,
+                  lua_tostring(global->state, -1));
+        lua_close(global->state);
+        global->state = NULL;
+        return false;
+    }
+
+    expose_functions(global->state, &global->current_query, instance);
+
+    lua_getglobal(global->state, "createInstance");
+
+    if (lua_pcall(global->state, 0, 0, 0))
+    {
+        MXS_WARNING("Failed to get global variable 'createInstance':  %s."
+                    " The createInstance entry point will not be called for the global script.",
+                    lua_tostring(global->state, -1));
+        lua_pop(global->state, -1);     // Pop the error off the stack
+    }
+
+    return true;
+}
+
+/**
+ * The global states of the current routing worker, one for each filter instance
+ * in the per-worker mode. The states are closed when the worker exits.
+ */
+class WorkerGlobalStates
+{
+public:
+    ~WorkerGlobalStates()
+    {
+        for (auto& kv : m_states)
+        {
+            if (kv.second.state)
+            {
+                lua_close(kv.second.state);
+            }
+        }
+    }
+
+    LUA_GLOBAL_STATE* get(LUA_INSTANCE* instance)
+    {
+        auto it = m_states.find(instance);
+
+        if (it == m_states.end())
+        {
+            LUA_GLOBAL_STATE global;
+
+            // If the script fails on this worker, the error is logged only once and the
+            // global script is not called on this worker.
+            create_global_state(instance, &global);
+            it = m_states.emplace(instance, global).first;
+        }
+
+        return &it->second;
+    }
+
+private:
+    std::unordered_map<const LUA_INSTANCE*, LUA_GLOBAL_STATE> m_states;
+};
+
+static thread_local WorkerGlobalStates worker_global_states;
+
+/**
+ * Access to the global script state. In the locked mode the mutex of the instance
+ * is held for the lifetime of the object.
+ */
+class GlobalScope
+{
+public:
+    GlobalScope(const GlobalScope&) = delete;
+    GlobalScope& operator=(const GlobalScope&) = delete;
+
+    GlobalScope(LUA_INSTANCE* instance)
+        : m_global(NULL)
+    {
+        if (instance->global_mode == LUA_GLOBAL_PER_WORKER)
+        {
+            if (instance->global_script)
+            {
+                m_global = worker_global_states.get(instance);
+            }
+        }
+        else if (instance->global.state)
+        {
+            m_guard = std::unique_lock<std::mutex>(instance->lock);
+            m_global = &instance->global;
+        }
+    }
+
+    /**
+     * @return The Lua state, NULL if there is no global script
+     */
+    lua_State* state() const
+    {
+        return m_global ? m_global->state : NULL;
+    }
+
+    /**
+     * @return The query being processed by the global script
+     */
+    GWBUF** current_query() const
+    {
+        mxb_assert(m_global);
+        return &m_global->current_query;
+    }
+
+private:
+    std::unique_lock<std::mutex> m_guard;
+    LUA_GLOBAL_STATE*            m_global;
+};
+
 /**
  * Create a new instance of the Lua filter.
  *
- * The global script will be loaded in this function and executed once on a global
- * level before calling the createInstance function in the Lua script.
+ * In the locked mode, the global script will be loaded in this function and executed
+ * once on a global level before calling the createInstance function in the Lua script.
+ * In the per-worker mode, the same is done when a routing worker first uses the filter
+ * and here the script is only checked for syntax errors.
+ *
  * @param options The options for this filter
  * @param params  Filter parameters
  * @return The instance data for this new instance
@@ -265,43 +595,44 @@ static MXS_FILTER* createInstance(const char* name, MXS_CONFIG_PARAMETER* params
 
     my_instance->global_script = config_copy_string(params, "global_script");
     my_instance->session_script = config_copy_string(params, "session_script");
-    my_instance->global_lua_state = nullptr;
+    my_instance->global_mode =
+        static_cast<lua_global_mode_t>(config_get_enum(params, "global_script_mode", global_mode_values));
+    my_instance->global.state = nullptr;
+    my_instance->global.current_query = nullptr;
 
     if (my_instance->global_script)
     {
-        if ((my_instance->global_lua_state = luaL_newstate()))
-        {
-            luaL_openlibs(my_instance->global_lua_state);
+        bool ok = false;
 
-            if (luaL_dofile(my_instance->global_lua_state, my_instance->global_script))
+        if (my_instance->global_mode == LUA_GLOBAL_LOCKED)
+        {
+            ok = create_global_state(my_instance, &my_instance->global);
+        }
+        else if (lua_State* state = luaL_newstate())
+        {
+            if (luaL_loadfile(state, my_instance->global_script) == 0)
             {
-                MXS_ERROR("Failed to execute global script at '%s':%s.",
-                          my_instance->global_script,
-                          lua_tostring(my_instance->global_lua_state, -1));
-                MXS_FREE(my_instance->global_script);
-                MXS_FREE(my_instance->session_script);
-                MXS_FREE(my_instance);
-                my_instance = NULL;
+                ok = true;
             }
-            else if (my_instance->global_lua_state)
+            else
             {
-                lua_getglobal(my_instance->global_lua_state, "createInstance");
-
-                if (lua_pcall(my_instance->global_lua_state, 0, 0, 0))
-                {
-                    MXS_WARNING("Failed to get global variable 'createInstance':  %s."
-                                " The createInstance entry point will not be called for the global script.",
-                                lua_tostring(my_instance->global_lua_state, -1));
-                    lua_pop(my_instance->global_lua_state, -1);     // Pop the error off the stack
-                }
-
-                expose_functions(my_instance->global_lua_state, &current_global_query);
+                MXS_ERROR("Failed to load global script at '%s':%s.",
+                          my_instance->global_script,
+                          lua_tostring(state, -1));
             }
+
+            lua_close(state);
         }
         else
         {
             MXS_ERROR("Unable to initialize new Lua state.");
-            MXS_FREE(my_instance);
+        }
+
+        if (!ok)
+        {
+            MXS_FREE(my_instance->global_script);
+            MXS_FREE(my_instance->session_script);
+            delete my_instance;
             my_instance = NULL;
         }
     }
@@ -353,7 +684,7 @@ static MXS_FILTER_SESSION* newSession(MXS_FILTER* instance, MXS_SESSION* session
         }
         else
         {
-            expose_functions(my_session->lua_state, &my_session->current_query);
+            expose_functions(my_session->lua_state, &my_session->current_query, my_instance);
 
             /** Call the newSession entry point */
             lua_getglobal(my_session->lua_state, "newSession");
@@ -370,20 +701,21 @@ static MXS_FILTER_SESSION* newSession(MXS_FILTER* instance, MXS_SESSION* session
         }
     }
 
-    if (my_session && my_instance->global_lua_state)
-    {
-        std::lock_guard<std::mutex> guard(my_instance->lock);
+    GlobalScope global(my_instance);
+    lua_State* global_state = global.state();
 
-        lua_getglobal(my_instance->global_lua_state, "newSession");
-        lua_pushstring(my_instance->global_lua_state, session->client_dcb->user);
-        lua_pushstring(my_instance->global_lua_state, session->client_dcb->remote);
+    if (my_session && global_state)
+    {
+        lua_getglobal(global_state, "newSession");
+        lua_pushstring(global_state, session->client_dcb->user);
+        lua_pushstring(global_state, session->client_dcb->remote);
 
-        if (lua_pcall(my_instance->global_lua_state, 2, 0, 0))
+        if (lua_pcall(global_state, 2, 0, 0))
         {
             MXS_WARNING("Failed to get global variable 'newSession': '%s'."
                         " The newSession entry point will not be called for the global script.",
-                        lua_tostring(my_instance->global_lua_state, -1));
-            lua_pop(my_instance->global_lua_state, -1);     // Pop the error off the stack
+                        lua_tostring(global_state, -1));
+            lua_pop(global_state, -1);      // Pop the error off the stack
         }
     }
 
@@ -417,18 +749,18 @@ static void closeSession(MXS_FILTER* instance, MXS_FILTER_SESSION* session)
         }
     }
 
-    if (my_instance->global_lua_state)
-    {
-        std::lock_guard<std::mutex> guard(my_instance->lock);
+    GlobalScope global(my_instance);
 
-        lua_getglobal(my_instance->global_lua_state, "closeSession");
+    if (lua_State* global_state = global.state())
+    {
+        lua_getglobal(global_state, "closeSession");
 
-        if (lua_pcall(my_instance->global_lua_state, 0, 0, 0))
+        if (lua_pcall(global_state, 0, 0, 0))
         {
             MXS_WARNING("Failed to get global variable 'closeSession': '%s'."
                         " The closeSession entry point will not be called for the global script.",
-                        lua_tostring(my_instance->global_lua_state, -1));
-            lua_pop(my_instance->global_lua_state, -1);
+                        lua_tostring(global_state, -1));
+            lua_pop(global_state, -1);
         }
     }
 }
@@ -503,17 +835,19 @@ static int32_t clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GW
         }
     }
 
-    if (my_instance->global_lua_state)
     {
-        std::lock_guard<std::mutex> guard(my_instance->lock);
-
-        lua_getglobal(my_instance->global_lua_state, "clientReply");
+        GlobalScope global(my_instance);
 
-        if (lua_pcall(my_instance->global_lua_state, 0, 0, 0))
+        if (lua_State* global_state = global.state())
         {
-            MXS_ERROR("Global scope call to 'clientReply' failed: '%s'.",
-                      lua_tostring(my_session->lua_state, -1));
-            lua_pop(my_instance->global_lua_state, -1);
+            lua_getglobal(global_state, "clientReply");
+
+            if (lua_pcall(global_state, 0, 0, 0))
+            {
+                MXS_ERROR("Global scope call to 'clientReply' failed: '%s'.",
+                          lua_tostring(global_state, -1));
+                lua_pop(global_state, -1);
+            }
         }
     }
 
@@ -522,6 +856,57 @@ static int32_t clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GW
                                       queue);
 }
 
+/**
+ * Call the routeQuery function of a Lua script and interpret its return value.
+ *
+ * @param scope         "Session" or "Global", for error messages
+ * @param state         The Lua state
+ * @param current_query Where the query is stored for the duration of the call
+ * @param queue         The query
+ * @param fullquery     The SQL of the query
+ * @param forward       The buffer to route, replaced if the script returns a string
+ * @param route         Set to the return value of the script, if it returns a bool
+ */
+static void call_route_query(const char* scope,
+                             lua_State* state,
+                             GWBUF** current_query,
+                             GWBUF* queue,
+                             const char* fullquery,
+                             GWBUF** forward,
+                             bool* route)
+{
+    /** Store the current query being processed */
+    *current_query = queue;
+
+    lua_getglobal(state, "routeQuery");
+
+    lua_pushlstring(state, fullquery, strlen(fullquery));
+
+    if (lua_pcall(state, 1, 1, 0))
+    {
+        MXS_ERROR("%s scope call to 'routeQuery' failed: '%s'.",
+                  scope,
+                  lua_tostring(state, -1));
+        lua_pop(state, -1);
+    }
+    else if (lua_gettop(state))
+    {
+        if (lua_isstring(state, -1))
+        {
+            gwbuf_free(*forward);
+            *forward = modutil_create_query(lua_tostring(state, -1));
+        }
+        else if (lua_isboolean(state, -1))
+        {
+            *route = lua_toboolean(state, -1);
+        }
+
+        lua_settop(state, 0);       // Pop the return value off the stack
+    }
+
+    *current_query = NULL;
+}
+
 /**
  * The routeQuery entry point. This is passed the query buffer
  * to which the filter should be applied. Once processed the
@@ -556,63 +941,19 @@ static int32_t routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWB
 
         if (fullquery && my_session->lua_state)
         {
-            /** Store the current query being processed */
-            my_session->current_query = queue;
-
-            lua_getglobal(my_session->lua_state, "routeQuery");
-
-            lua_pushlstring(my_session->lua_state, fullquery, strlen(fullquery));
-
-            if (lua_pcall(my_session->lua_state, 1, 1, 0))
-            {
-                MXS_ERROR("Session scope call to 'routeQuery' failed: '%s'.",
-                          lua_tostring(my_session->lua_state, -1));
-                lua_pop(my_session->lua_state, -1);
-            }
-            else if (lua_gettop(my_session->lua_state))
-            {
-                if (lua_isstring(my_session->lua_state, -1))
-                {
-                    gwbuf_free(forward);
-                    forward = modutil_create_query(lua_tostring(my_session->lua_state, -1));
-                }
-                else if (lua_isboolean(my_session->lua_state, -1))
-                {
-                    route = lua_toboolean(my_session->lua_state, -1);
-                }
-            }
-            my_session->current_query = NULL;
+            call_route_query("Session", my_session->lua_state, &my_session->current_query,
+                             queue, fullquery, &forward, &route);
         }
 
-        if (my_instance->global_lua_state)
+        if (fullquery)
         {
-            std::lock_guard<std::mutex> guard(my_instance->lock);
-            current_global_query = queue;
-
-            lua_getglobal(my_instance->global_lua_state, "routeQuery");
-
-            lua_pushlstring(my_instance->global_lua_state, fullquery, strlen(fullquery));
+            GlobalScope global(my_instance);
 
-            if (lua_pcall(my_instance->global_lua_state, 1, 1, 0))
+            if (lua_State* global_state = global.state())
             {
-                MXS_ERROR("Global scope call to 'routeQuery' failed: '%s'.",
-                          lua_tostring(my_instance->global_lua_state, -1));
-                lua_pop(my_instance->global_lua_state, -1);
+                call_route_query("Global", global_state, global.current_query(),
+                                 queue, fullquery, &forward, &route);
             }
-            else if (lua_gettop(my_instance->global_lua_state))
-            {
-                if (lua_isstring(my_instance->global_lua_state, -1))
-                {
-                    gwbuf_free(forward);
-                    forward = modutil_create_query(lua_tostring(my_instance->global_lua_state, -1));
-                }
-                else if (lua_isboolean(my_instance->global_lua_state, -1))
-                {
-                    route = lua_toboolean(my_instance->global_lua_state, -1);
-                }
-            }
-
-            current_global_query = NULL;
         }
 
         MXS_FREE(fullquery);
@@ -650,32 +991,40 @@ static void diagnostic(MXS_FILTER* instance, MXS_FILTER_SESSION* fsession, DCB*
 
     if (my_instance)
     {
-        if (my_instance->global_lua_state)
+        /** With per_worker, the state of this thread does not represent the state of the
+         * script and creating it here would load the script for a thread that never uses it. */
+        if (my_instance->global_mode != LUA_GLOBAL_PER_WORKER)
         {
-            std::lock_guard<std::mutex> guard(my_instance->lock);
+            GlobalScope global(my_instance);
 
-            lua_getglobal(my_instance->global_lua_state, "diagnostic");
-
-            if (lua_pcall(my_instance->global_lua_state, 0, 1, 0) == 0)
+            if (lua_State* global_state = global.state())
             {
-                lua_gettop(my_instance->global_lua_state);
-                if (lua_isstring(my_instance->global_lua_state, -1))
+                lua_getglobal(global_state, "diagnostic");
+
+                if (lua_pcall(global_state, 0, 1, 0) == 0)
                 {
-                    dcb_printf(dcb, "%s", lua_tostring(my_instance->global_lua_state, -1));
-                    dcb_printf(dcb, "\n");
+                    lua_gettop(global_state);
+                    if (lua_isstring(global_state, -1))
+                    {
+                        dcb_printf(dcb, "%s", lua_tostring(global_state, -1));
+                        dcb_printf(dcb, "\n");
+                    }
                 }
-            }
-            else
-            {
-                dcb_printf(dcb,
-                           "Global scope call to 'diagnostic' failed: '%s'.\n",
-                           lua_tostring(my_instance->global_lua_state, -1));
-                lua_pop(my_instance->global_lua_state, -1);
+                else
+                {
+                    dcb_printf(dcb,
+                               "Global scope call to 'diagnostic' failed: '%s'.\n",
+                               lua_tostring(global_state, -1));
+                }
+
+                lua_pop(global_state, -1);
             }
         }
         if (my_instance->global_script)
         {
             dcb_printf(dcb, "Global script: %s\n", my_instance->global_script);
+            dcb_printf(dcb, "Global script mode: %s\n",
+                       my_instance->global_mode == LUA_GLOBAL_PER_WORKER ? "per_worker" : "locked");
         }
         if (my_instance->session_script)
         {
@@ -700,30 +1049,35 @@ static json_t* diagnostic_json(const MXS_FILTER* instance, const MXS_FILTER_SESS
 
     if (my_instance)
     {
-        if (my_instance->global_lua_state)
+        // See diagnostic() for why the script is not called with per_worker
+        if (my_instance->global_mode != LUA_GLOBAL_PER_WORKER)
         {
-            std::lock_guard<std::mutex> guard(my_instance->lock);
-
-            lua_getglobal(my_instance->global_lua_state, "diagnostic");
+            GlobalScope global(my_instance);
 
-            if (lua_pcall(my_instance->global_lua_state, 0, 1, 0) == 0)
+            if (lua_State* global_state = global.state())
             {
-                lua_gettop(my_instance->global_lua_state);
-                if (lua_isstring(my_instance->global_lua_state, -1))
+                lua_getglobal(global_state, "diagnostic");
+
+                if (lua_pcall(global_state, 0, 1, 0) == 0)
                 {
-                    json_object_set_new(rval,
-                                        "script_output",
-                                        json_string(lua_tostring(my_instance->global_lua_state, -1)));
+                    lua_gettop(global_state);
+                    if (lua_isstring(global_state, -1))
+                    {
+                        json_object_set_new(rval,
+                                            "script_output",
+                                            json_string(lua_tostring(global_state, -1)));
+                    }
                 }
-            }
-            else
-            {
-                lua_pop(my_instance->global_lua_state, -1);
+
+                lua_pop(global_state, -1);
             }
         }
         if (my_instance->global_script)
         {
             json_object_set_new(rval, "global_script", json_string(my_instance->global_script));
+            json_object_set_new(rval, "global_script_mode",
+                                json_string(my_instance->global_mode == LUA_GLOBAL_PER_WORKER ?
+                                            "per_worker" : "locked"));
         }
         if (my_instance->session_script)
         {
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+/**
+ * Runs the routeQuery entry point of a global script concurrently from several
+ * threads, first with the global script in the locked mode and then in the
+ * per-worker mode. Checks that the shared values see every call in both modes
+ * and reports the throughput of each mode.
+ */
+
+#include <unistd.h>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../luafilter.cc"
+
+using namespace std;
+
+namespace
+{
+
+char USAGE[] = "usage: test_global_mode [-t threads] [-n queries per thread] [-w work per query]\n";
+
+const char SCRIPT[] =
+    "function createInstance()\n"
+    "    lua_shared_add('states')\n"
+    "end\n"
+    "\n"
+    "function routeQuery(query)\n"
+    "    local n = 0\n"
+    "    for i = 1, lua_shared_get('work') do\n"
+    "        n = n + i\n"
+    "    end\n"
+    "    lua_shared_add('queries')\n"
+    "end\n";
+
+double now()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+lua_Number shared_number(LUA_INSTANCE* pInstance, const char* zKey)
+{
+    auto it = pInstance->shared_values.find(zKey);
+    return it != pInstance->shared_values.end() ? it->second.number : -1;
+}
+
+void route_queries(LUA_INSTANCE* pInstance, int nQueries)
+{
+    const char SQL[] = "SELECT 1";
+    GWBUF* pQuery = modutil_create_query(SQL);
+
+    for (int i = 0; i < nQueries; ++i)
+    {
+        GWBUF* pForward = pQuery;
+        bool route = true;
+        GlobalScope global(pInstance);
+
+        call_route_query("Global", global.state(), global.current_query(),
+                         pQuery, SQL, &pForward, &route);
+    }
+
+    gwbuf_free(pQuery);
+}
+
+int test(const char* zScript, const char* zMode, int nThreads, int nQueries, int work)
+{
+    int rv = 0;
+
+    MXS_CONFIG_PARAMETER mode = {(char*)"global_script_mode", (char*)zMode, NULL};
+    MXS_CONFIG_PARAMETER script = {(char*)"global_script", (char*)zScript, &mode};
+
+    LUA_INSTANCE* pInstance = (LUA_INSTANCE*)createInstance("test", &script);
+
+    if (!pInstance)
+    {
+        cerr << "error: Could not create the filter instance in the " << zMode << " mode." << endl;
+        return 1;
+    }
+
+    LUA_SHARED_VALUE value;
+    value.type = LUA_TNUMBER;
+    value.number = work;
+    pInstance->shared_values["work"] = value;
+
+    vector<thread> threads;
+    double start = now();
+
+    for (int i = 0; i < nThreads; ++i)
+    {
+        threads.emplace_back(route_queries, pInstance, nQueries);
+    }
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    double duration = now() - start;
+
+    lua_Number nStates = shared_number(pInstance, "states");
+    lua_Number nRouted = shared_number(pInstance, "queries");
+    lua_Number nExpected_states = pInstance->global_mode == LUA_GLOBAL_PER_WORKER ? nThreads : 1;
+
+    cout << setw(12) << zMode
+         << " states: " << setw(4) << nStates
+         << " queries: " << setw(10) << nRouted
+         << " queries/s: " << setw(12) << fixed << setprecision(0) << nThreads * nQueries / duration
+         << endl;
+
+    if (nStates != nExpected_states)
+    {
+        cerr << "error: Expected " << nExpected_states << " Lua states, got " << nStates << "." << endl;
+        rv = 1;
+    }
+
+    if (nRouted != (lua_Number)nThreads * nQueries)
+    {
+        cerr << "error: Expected " << nThreads * nQueries << " queries, got " << nRouted << "." << endl;
+        rv = 1;
+    }
+
+    // The instance is not freed, the per-worker states of the threads have been closed
+    // when the threads exited, and the filter has no destroyInstance.
+    return rv;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    int nThreads = 4;
+    int nQueries = 10000;
+    int work = 100;
+
+    int c;
+    while ((c = getopt(argc, argv, "t:n:w:")) != -1)
+    {
+        switch (c)
+        {
+        case 't':
+            nThreads = atoi(optarg);
+            break;
+
+        case 'n':
+            nQueries = atoi(optarg);
+            break;
+
+        case 'w':
+            work = atoi(optarg);
+            break;
+
+        default:
+            cout << USAGE << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (nThreads <= 0 || nQueries <= 0 || work < 0)
+    {
+        cout << USAGE << endl;
+        return EXIT_FAILURE;
+    }
+
+    int rv = EXIT_FAILURE;
+
+    if (mxs_log_init(NULL, ".", MXS_LOG_TARGET_STDOUT))
+    {
+        char zScript[] = "/tmp/test_global_mode_XXXXXX";
+        int fd = mkstemp(zScript);
+
+        if (fd != -1)
+        {
+            if (write(fd, SCRIPT, sizeof(SCRIPT) - 1) == sizeof(SCRIPT) - 1)
+            {
+                cout << nThreads << " threads routing " << nQueries << " queries each" << endl;
+
+                rv = test(zScript, "locked", nThreads, nQueries, work);
+                rv += test(zScript, "per_worker", nThreads, nQueries, work);
+                rv = rv == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+            }
+            else
+            {
+                cerr << "error: Could not write the script: " << mxs_strerror(errno) << endl;
+            }
+
+            close(fd);
+            unlink(zScript);
+        }
+        else
+        {
+            cerr << "error: Could not create the script file: " << mxs_strerror(errno) << endl;
+        }
+
+        mxs_log_finish();
+    }
+
+    return rv;
+}
@@ -28,6 +28,7 @@
 #include <cmath>
 #include <errno.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <time.h>
 #include <stdio.h>
 #include <string.h>
@@ -42,7 +43,7 @@
 #include <maxscale/filter.h>
 #include <maxscale/log.h>
 #include <maxscale/modinfo.h>
-#include <maxscale/modutil.h>
+#include <maxscale/modutil.hh>
 #include <maxscale/pcre2.h>
 #include <maxscale/service.h>
 #include <maxscale/utils.h>
@@ -86,6 +87,7 @@ enum log_options
     LOG_DATA_USER       = (1 << 3),
     LOG_DATA_QUERY      = (1 << 4),
     LOG_DATA_REPLY_TIME = (1 << 5),
+    LOG_DATA_DIGEST     = (1 << 6),
 };
 
 /* The filter entry points */
@@ -108,7 +110,7 @@ static uint64_t getCapabilities(MXS_FILTER* instance);
 
 static FILE* open_log_file(QlaInstance*, uint32_t, const char*);
 static int write_log_entry(FILE*, QlaInstance*, QlaFilterSession*, uint32_t,
-                           const char*, const char*, size_t, int);
+                           const char*, const char*, size_t, int, uint64_t);
 static bool cb_log(const MODULECMD_ARG* argv, json_t** output);
 
 static const MXS_ENUM_VALUE option_values[] =
@@ -134,6 +136,7 @@ static const MXS_ENUM_VALUE log_data_values[] =
     {"user",       LOG_DATA_USER      },
     {"query",      LOG_DATA_QUERY     },
     {"reply_time", LOG_DATA_REPLY_TIME},
+    {"digest",     LOG_DATA_DIGEST    },
     {NULL}
 };
 
@@ -154,6 +157,7 @@ public:
     {
         0, 0
     })
+        , digest(0)
     {
     }
 
@@ -174,12 +178,14 @@ public:
         query_clone = NULL;
         query_date[0] = '\0';
         begin_time = {0, 0};
+        digest = 0;
     }
 
     bool     has_message;                       // Does message data exist?
     GWBUF*   query_clone;                       // Clone of the query buffer.
     char     query_date[QLA_DATE_BUFFER_SIZE];  // Text representation of date.
     timespec begin_time;                        // Timer value at the moment of receiving query.
+    uint64_t digest;                            // Hash of the canonical form of the query.
 };
 
 /**
@@ -686,13 +692,15 @@ static void setUpstream(MXS_FILTER* instance, MXS_FILTER_SESSION* session, MXS_U
  * @param query Query string, not 0-terminated
  * @param querylen Query string length
  * @param elapsed_ms Query execution time, in milliseconds
+ * @param digest Hash of the canonical form of the query
  */
 void write_log_entries(QlaInstance* my_instance,
                        QlaFilterSession* my_session,
                        const char* date_string,
                        const char* query,
                        int querylen,
-                       int elapsed_ms)
+                       int elapsed_ms,
+                       uint64_t digest)
 {
     bool write_error = false;
     if (my_instance->log_mode_flags & CONFIG_FILE_SESSION)
@@ -707,7 +715,8 @@ void write_log_entries(QlaInstance* my_instance,
                             date_string,
                             query,
                             querylen,
-                            elapsed_ms) < 0)
+                            elapsed_ms,
+                            digest) < 0)
         {
             write_error = true;
         }
@@ -722,7 +731,8 @@ void write_log_entries(QlaInstance* my_instance,
                             date_string,
                             query,
                             querylen,
-                            elapsed_ms) < 0)
+                            elapsed_ms,
+                            digest) < 0)
         {
             write_error = true;
         }
@@ -764,6 +774,8 @@ static int routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
     {
         const uint32_t data_flags = my_instance->log_file_data_flags;
         LogEventData& event = my_session->m_event_data;
+        uint64_t digest = (data_flags & LOG_DATA_DIGEST) ? mxs::canonicalize(queue).hash : 0;
+
         if (data_flags & LOG_DATA_DATE)
         {
             // Print current date to a buffer. Use the buffer in the event data struct even if execution time
@@ -788,12 +800,13 @@ static int routeQuery(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
             {
                 event.query_clone = gwbuf_clone(queue);
             }
+            event.digest = digest;
             event.has_message = true;
         }
         else
         {
             // If execution times are not logged, write the log entry now.
-            write_log_entries(my_instance, my_session, event.query_date, query, query_len, -1);
+            write_log_entries(my_instance, my_session, event.query_date, query, query_len, -1, digest);
         }
     }
     /* Pass the query downstream */
@@ -834,7 +847,8 @@ static int clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
                           event.query_date,
                           query,
                           query_len,
-                          std::floor(elapsed_ms + 0.5));
+                          std::floor(elapsed_ms + 0.5),
+                          event.digest);
         event.clear();
     }
     return my_session->up.clientReply(my_session->up.instance, my_session->up.session, queue);
@@ -996,6 +1010,7 @@ static FILE* open_log_file(QlaInstance* instance, uint32_t data_flags, const cha
         const char USERHOST[] = "User@Host";
         const char QUERY[] = "Query";
         const char REPLY_TIME[] = "Reply_time";
+        const char DIGEST[] = "Digest";
 
         std::stringstream header;
         string curr_sep;    // Use empty string as the first separator
@@ -1026,6 +1041,11 @@ static FILE* open_log_file(QlaInstance* instance, uint32_t data_flags, const cha
             header << curr_sep << REPLY_TIME;
             curr_sep = real_sep;
         }
+        if (data_flags & LOG_DATA_DIGEST)
+        {
+            header << curr_sep << DIGEST;
+            curr_sep = real_sep;
+        }
         if (data_flags & LOG_DATA_QUERY)
         {
             header << curr_sep << QUERY;
@@ -1109,6 +1129,7 @@ static void print_string_replace_newlines(const char* sql_string,
  * @param   sql_string    SQL-query, *not* NULL terminated
  * @param   sql_str_len   Length of SQL-string
  * @param   elapsed_ms    Query execution time, in milliseconds
+ * @param   digest        Hash of the canonical form of the query
  * @return  The number of characters written, or a negative value on failure
  */
 static int write_log_entry(FILE* logfile,
@@ -1118,7 +1139,8 @@ static int write_log_entry(FILE* logfile,
                            const char* time_string,
                            const char* sql_string,
                            size_t sql_str_len,
-                           int elapsed_ms)
+                           int elapsed_ms,
+                           uint64_t digest)
 {
     mxb_assert(logfile != NULL);
     if (data_flags == 0)
@@ -1158,6 +1180,13 @@ static int write_log_entry(FILE* logfile,
         output << curr_sep << elapsed_ms;
         curr_sep = real_sep;
     }
+    if (data_flags & LOG_DATA_DIGEST)
+    {
+        char digest_string[17];
+        snprintf(digest_string, sizeof(digest_string), "%016" PRIx64, digest);
+        output << curr_sep << digest_string;
+        curr_sep = real_sep;
+    }
     if (data_flags & LOG_DATA_QUERY)
     {
         output << curr_sep;
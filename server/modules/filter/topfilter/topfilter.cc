@@ -36,9 +36,10 @@
 
 #include <stdio.h>
 #include <fcntl.h>
+#include <inttypes.h>
 #include <maxscale/filter.h>
 #include <maxscale/modinfo.h>
-#include <maxscale/modutil.h>
+#include <maxscale/modutil.hh>
 #include <maxscale/log.h>
 #include <string.h>
 #include <time.h>
@@ -94,6 +95,7 @@ typedef struct topnq
 {
     struct timeval duration;
     char*          sql;
+    uint64_t       digest;  /* Hash of the canonical form of the query */
 } TOPNQ;
 
 /**
@@ -525,6 +527,19 @@ static int cmp_topn(const void* va, const void* vb)
     return (*b)->duration.tv_sec - (*a)->duration.tv_sec;
 }
 
+/**
+ * Compute the digest of a query. Only done for the queries that make it to
+ * the top list, as most do not.
+ *
+ * @param sql  The SQL of the query
+ *
+ * @return Hash of the canonical form of the query
+ */
+static uint64_t query_digest(const char* sql)
+{
+    return mxs::canonicalize(sql, strlen(sql)).hash;
+}
+
 static int clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF* reply)
 {
     TOPN_INSTANCE* my_instance = (TOPN_INSTANCE*) instance;
@@ -545,6 +560,7 @@ static int clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
             if (my_session->top[i]->sql == NULL)
             {
                 my_session->top[i]->sql = my_session->current;
+                my_session->top[i]->digest = query_digest(my_session->current);
                 my_session->top[i]->duration = diff;
                 inserted = 1;
                 break;
@@ -558,6 +574,7 @@ static int clientReply(MXS_FILTER* instance, MXS_FILTER_SESSION* session, GWBUF*
         {
             MXS_FREE(my_session->top[my_instance->topN - 1]->sql);
             my_session->top[my_instance->topN - 1]->sql = my_session->current;
+            my_session->top[my_instance->topN - 1]->digest = query_digest(my_session->current);
             my_session->top[my_instance->topN - 1]->duration = diff;
             inserted = 1;
         }
@@ -644,6 +661,9 @@ static void diagnostic(MXS_FILTER* instance, MXS_FILTER_SESSION* fsession, DCB*
                 dcb_printf(dcb,
                            "\t\t\tSQL: %s\n",
                            my_session->top[i]->sql);
+                dcb_printf(dcb,
+                           "\t\t\tDigest: %016" PRIx64 "\n",
+                           my_session->top[i]->digest);
             }
         }
     }
@@ -706,6 +726,10 @@ static json_t* diagnostic_json(const MXS_FILTER* instance, const MXS_FILTER_SESS
                 json_object_set_new(obj, "time", json_real(exec_time));
                 json_object_set_new(obj, "sql", json_string(my_session->top[i]->sql));
 
+                char digest[17];
+                snprintf(digest, sizeof(digest), "%016" PRIx64, my_session->top[i]->digest);
+                json_object_set_new(obj, "digest", json_string(digest));
+
                 json_array_append_new(arr, obj);
             }
         }
@@ -58,6 +58,11 @@ static const char CN_REPLICATION_PASSWORD[] = "replication_password";
 static const char DIAG_ERROR[] = "Internal error, could not print diagnostics. "
                                  "Check log for more information.";
 
+static int64_t duration_to_ms(mxb::Duration duration)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
+}
+
 MariaDBMonitor::MariaDBMonitor(MXS_MONITOR* monitor)
     : maxscale::MonitorInstance(monitor)
 {
@@ -288,6 +293,9 @@ string MariaDBMonitor::diagnostics_to_string() const
     rval += string_printf("Enforce read-only:      %s\n", m_enforce_read_only_slaves ? "Enabled" :
                           "Disabled");
     rval += string_printf("Detect stale master:    %s\n", m_detect_stale_master ? "Enabled" : "Disabled");
+    rval += string_printf("Tick duration:          %s (server updates %s)\n",
+                          mxb::to_string(m_tick_duration).c_str(),
+                          mxb::to_string(m_server_update_duration).c_str());
     if (m_excluded_servers.size() > 0)
     {
         rval += string_printf("Non-promotable servers (failover): ");
@@ -334,11 +342,121 @@ json_t* MariaDBMonitor::to_json() const
         json_array_append_new(server_info, server->to_json());
     }
     json_object_set_new(rval, "server_info", server_info);
+    json_object_set_new(rval, "tick_duration", json_integer(duration_to_ms(m_tick_duration)));
+    json_object_set_new(rval, "server_update_duration",
+                        json_integer(duration_to_ms(m_server_update_duration)));
     return rval;
 }
 
 /**
- * Connect to and query/update a server.
+ * Update all servers. The servers are queried concurrently by the monitor thread and the update threads,
+ * so that the updating takes roughly as long as the slowest server.
+ */
+void MariaDBMonitor::update_servers()
+{
+    UpdateThreads& upd = m_update_threads;
+    upd.next_server.store(0, std::memory_order_relaxed);
+
+    if (!upd.threads.empty())
+    {
+        std::lock_guard<std::mutex> guard(upd.mutex);
+        upd.n_busy = upd.threads.size();
+        upd.round++;
+        upd.has_work.notify_all();
+    }
+
+    update_servers_from_queue();
+
+    if (!upd.threads.empty())
+    {
+        std::unique_lock<std::mutex> lock(upd.mutex);
+        upd.work_done.wait(lock, [&upd] {
+                               return upd.n_busy == 0;
+                           });
+    }
+}
+
+/**
+ * Update servers until every server of the current tick has been taken by some thread.
+ */
+void MariaDBMonitor::update_servers_from_queue()
+{
+    size_t i;
+    while ((i = m_update_threads.next_server.fetch_add(1, std::memory_order_relaxed)) < m_servers.size())
+    {
+        update_server(m_servers[i]);
+    }
+}
+
+void MariaDBMonitor::update_thread_main(uint64_t round)
+{
+    UpdateThreads& upd = m_update_threads;
+
+    if (mysql_thread_init() != 0)
+    {
+        MXS_ERROR("mysql_thread_init() failed for a server update thread of %s.", m_monitor->name);
+    }
+
+    std::unique_lock<std::mutex> lock(upd.mutex);
+
+    while (true)
+    {
+        upd.has_work.wait(lock, [&upd, round] {
+                              return upd.stop || upd.round != round;
+                          });
+
+        if (upd.stop)
+        {
+            break;
+        }
+
+        round = upd.round;
+        lock.unlock();
+        update_servers_from_queue();
+        lock.lock();
+
+        if (--upd.n_busy == 0)
+        {
+            upd.work_done.notify_one();
+        }
+    }
+
+    lock.unlock();
+    mysql_thread_end();
+}
+
+void MariaDBMonitor::start_update_threads()
+{
+    mxb_assert(m_update_threads.threads.empty());
+    m_update_threads.stop = false;
+
+    for (size_t i = 1; i < m_servers.size(); i++)
+    {
+        // The threads start waiting for the round after the current one.
+        m_update_threads.threads.emplace_back(&MariaDBMonitor::update_thread_main, this,
+                                              m_update_threads.round);
+    }
+}
+
+void MariaDBMonitor::stop_update_threads()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_update_threads.mutex);
+        m_update_threads.stop = true;
+        m_update_threads.has_work.notify_all();
+    }
+
+    for (auto& thread : m_update_threads.threads)
+    {
+        thread.join();
+    }
+
+    m_update_threads.threads.clear();
+}
+
+/**
+ * Connect to and query/update a server. May be called concurrently for different servers, so only the
+ * server itself may be modified.
  *
  * @param server The server to update
  */
@@ -427,10 +545,20 @@ void MariaDBMonitor::pre_loop()
             server->m_server_base->con = NULL;
         }
     }
+
+    start_update_threads();
+}
+
+void MariaDBMonitor::post_loop()
+{
+    stop_update_threads();
+    MonitorInstance::post_loop();
 }
 
 void MariaDBMonitor::tick()
 {
+    mxb::StopWatch tick_watch;
+
     /* Update MXS_MONITORED_SERVER->pending_status. This is where the monitor loop writes it's findings.
      * Also, backup current status so that it can be compared to any deduced state. */
     for (auto mon_srv = m_monitor->monitored_servers; mon_srv; mon_srv = mon_srv->next)
@@ -441,9 +569,11 @@ void MariaDBMonitor::tick()
     }
 
     // Query all servers for their status.
+    update_servers();
+    m_server_update_duration = tick_watch.split();
+
     for (MariaDBServer* server : m_servers)
     {
-        update_server(server);
         if (server->m_topology_changed)
         {
             m_cluster_topology_changed = true;
@@ -498,6 +628,8 @@ void MariaDBMonitor::tick()
     // member variable of MonitorInstance so that the right server will be
     // stored to the journal.
     MonitorInstance::m_master = m_master ? m_master->m_server_base : NULL;
+
+    m_tick_duration = tick_watch.split();
 }
 
 void MariaDBMonitor::process_state_changes()
@@ -13,9 +13,11 @@
 #pragma once
 #include "mariadbmon_common.hh"
 
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -107,6 +109,7 @@ public:
 
 protected:
     void pre_loop();
+    void post_loop();
     void tick();
     void process_state_changes();
 
@@ -164,6 +167,28 @@ private:
 
     ManualCommand m_manual_cmd;     /* Communicates manual commands and results */
 
+    /* Threads which query the servers concurrently with the monitor thread at the start of a tick, so that
+     * a slow server does not delay the updating of the others. The monitor thread updates servers as
+     * well, so there is one thread less than there are servers. */
+    struct UpdateThreads
+    {
+    public:
+        std::vector<std::thread>  threads;      /* The update threads */
+        std::mutex                mutex;        /* Mutex used by the condition variables */
+        std::condition_variable   has_work;     /* Notified when a tick starts */
+        std::condition_variable   work_done;    /* Notified when a thread has finished its updates */
+        std::atomic<size_t>       next_server;  /* Index of the next server to update */
+
+        uint64_t round = 0;     /* Tick counter, guard variable for has_work */
+        int      n_busy = 0;    /* Number of threads still updating, guard variable for work_done */
+        bool     stop = false;  /* Set when the threads should exit */
+    };
+
+    UpdateThreads m_update_threads; /* Threads updating the servers */
+
+    mxb::Duration m_tick_duration;          /* Duration of the previous tick */
+    mxb::Duration m_server_update_duration; /* Duration of the server updates of the previous tick */
+
     // Server containers, mostly constant.
     ServerArray   m_servers;        /* Servers of the monitor */
     IdToServerMap m_servers_by_id;  /* Map from server id:s to MariaDBServer */
@@ -254,6 +279,11 @@ private:
     MariaDBServer* get_server(SERVER* server);
 
     // Cluster discovery and status assignment methods, top levels
+    void update_servers();
+    void update_servers_from_queue();
+    void update_thread_main(uint64_t round);
+    void start_update_threads();
+    void stop_update_threads();
     void update_server(MariaDBServer* server);
     void update_topology();
     void build_replication_graph();
@@ -60,6 +60,7 @@ static bool get_ip_string_and_port(struct sockaddr_storage* sa,
                                    int   iplen,
                                    in_port_t* port_out);
 static bool gw_connection_established(DCB* dcb);
+static bool gw_backend_is_idle(DCB* dcb);
 json_t*     gw_json_diagnostics(DCB* dcb);
 
 extern "C"
@@ -90,6 +91,7 @@ extern "C"
             NULL,                           /* Connection limit reached      */
             gw_connection_established,
             gw_json_diagnostics,
+            gw_backend_is_idle,
         };
 
         static MXS_MODULE info =
@@ -552,6 +554,15 @@ static int gw_read_backend_event(DCB* dcb)
                 proto->protocol_auth_state = handle_server_response(dcb, readbuf);
             }
 
+            if (proto->protocol_auth_state == MXS_AUTH_STATE_COMPLETE
+                && proto->compress && !mxs_mysql_enable_compression(dcb))
+            {
+                /** Everything after the OK packet is compressed */
+                MXS_ERROR("Failed to decompress the data sent by server '%s' after the authentication.",
+                          dcb->server->name);
+                proto->protocol_auth_state = MXS_AUTH_STATE_FAILED;
+            }
+
             if (proto->protocol_auth_state == MXS_AUTH_STATE_COMPLETE)
             {
                 /** Authentication completed successfully */
@@ -2026,6 +2037,15 @@ static bool gw_connection_established(DCB* dcb)
            && !proto->stored_query;
 }
 
+static bool gw_backend_is_idle(DCB* dcb)
+{
+    MySQLProtocol* proto = (MySQLProtocol*)dcb->protocol;
+    return gw_connection_established(dcb)
+           && !proto->compressed_readq
+           && !proto->collect_result
+           && !proto->large_query;
+}
+
 json_t* gw_json_diagnostics(DCB* dcb)
 {
     MySQLProtocol* proto = static_cast<MySQLProtocol*>(dcb->protocol);
@@ -68,6 +68,7 @@ static int   gw_client_close(DCB* dcb);
 static int   gw_client_hangup_event(DCB* dcb);
 static char* gw_default_auth();
 static int   gw_connection_limit(DCB* dcb, int limit);
+static bool  gw_client_is_idle(DCB* dcb);
 static int   MySQLSendHandshake(DCB* dcb);
 static int route_by_statement(MXS_SESSION*, uint64_t, GWBUF**);
 static void           mysql_client_auth_error_handling(DCB* dcb, int auth_val, int packet_number);
@@ -112,7 +113,8 @@ extern "C"
             gw_default_auth,                        /* Default authenticator         */
             gw_connection_limit,                    /* Send error connection limit   */
             NULL,
-            NULL
+            NULL,
+            gw_client_is_idle
         };
 
         static MXS_MODULE info =
@@ -373,6 +375,11 @@ int MySQLSendHandshake(DCB* dcb)
         mysql_server_capabilities_one[1] |= (int)GW_MYSQL_CAPABILITIES_SSL >> 8;
     }
 
+    if (dcb->listener->compression)
+    {
+        mysql_server_capabilities_one[0] |= (uint8_t)GW_MYSQL_CAPABILITIES_COMPRESS;
+    }
+
     memcpy(mysql_handshake_payload, mysql_server_capabilities_one, sizeof(mysql_server_capabilities_one));
     mysql_handshake_payload = mysql_handshake_payload + sizeof(mysql_server_capabilities_one);
 
@@ -793,6 +800,21 @@ static int gw_read_do_authentication(DCB* dcb, GWBUF* read_buffer, int nbytes_re
             mxb_assert(check);
             mxs_mysql_send_ok(dcb, next_sequence, 0, NULL);
 
+            if (dcb->listener->compression
+                && (protocol->client_capabilities & GW_MYSQL_CAPABILITIES_COMPRESS))
+            {
+                // Everything after the OK packet is compressed
+                if (!mxs_mysql_enable_compression(dcb))
+                {
+                    MXS_ERROR("Failed to decompress the data sent by '%s'@'%s' after the authentication.",
+                              dcb->user,
+                              dcb->remote);
+                    dcb_close(dcb);
+                    gwbuf_free(read_buffer);
+                    return 0;
+                }
+            }
+
             if (dcb->readq)
             {
                 // The user has already send more data, process it
@@ -853,6 +875,23 @@ static bool protocol_is_idle(DCB* dcb)
     return dcb->protocol_bytes_processed == dcb->protocol_packet_length;
 }
 
+/**
+ * @brief Check if the client protocol holds no data of the client
+ *
+ * @param dcb Client DCB
+ * @return True if no partial or stored packets are held by the protocol
+ */
+static bool gw_client_is_idle(DCB* dcb)
+{
+    MySQLProtocol* proto = (MySQLProtocol*)dcb->protocol;
+    return protocol_is_idle(dcb)
+           && proto->protocol_auth_state == MXS_AUTH_STATE_COMPLETE
+           && !proto->stored_query
+           && !proto->compressed_readq
+           && !proto->large_query
+           && !proto->changing_user;
+}
+
 /**
  * @brief Process the commands the client is executing
  *
@@ -1440,8 +1479,9 @@ static void gw_process_one_new_client(DCB* client_dcb)
      * task has been processed by the owning thread.
      */
     mxs::RoutingWorker* worker = mxs::RoutingWorker::pick_worker();
+    client_dcb->flags |= DCBF_PENDING;
 
-    worker->execute([=]() {
+    bool posted = worker->execute([=]() {
                         client_dcb->protocol = mysql_protocol_init(client_dcb, client_dcb->fd);
                         MXS_ABORT_IF_NULL(client_dcb->protocol);
 
@@ -1469,6 +1509,17 @@ static void gw_process_one_new_client(DCB* client_dcb)
                             MySQLSendHandshake(client_dcb);
                         }
                     }, mxs::RoutingWorker::EXECUTE_AUTO);
+
+    if (!posted)
+    {
+        // The worker will never add the DCB, so its slot is released here.
+        client_dcb->flags &= ~DCBF_PENDING;
+        worker->pending_client_done();
+
+        MXS_ERROR("Failed to hand the connection of dcb %p for fd %d to worker %d, closing it.",
+                  client_dcb, client_dcb->fd, worker->id());
+        dcb_close(client_dcb);
+    }
 }
 
 static int gw_error_client_event(DCB* dcb)
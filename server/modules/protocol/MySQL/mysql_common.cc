@@ -16,6 +16,7 @@
  */
 
 #include <netinet/tcp.h>
+#include <zlib.h>
 
 #include <set>
 #include <sstream>
@@ -79,6 +80,8 @@ bool mysql_protocol_done(DCB* dcb)
     if (p->protocol_state == MYSQL_PROTOCOL_ACTIVE)
     {
         gwbuf_free(p->stored_query);
+        gwbuf_free(p->compressed_readq);
+        p->compressed_readq = NULL;
         p->protocol_state = MYSQL_PROTOCOL_DONE;
         rval = true;
     }
@@ -811,13 +814,12 @@ static uint8_t* load_hashed_password(uint8_t* scramble, uint8_t* payload, uint8_
  * We start by taking the default bitmask and removing any bits not set in
  * the bitmask contained in the connection structure. Then add SSL flag if
  * the connection requires SSL (set from the MaxScale configuration). The
- * compression flag may be set, although compression is NOT SUPPORTED. If a
+ * compression flag is set if the compressed protocol is to be used. If a
  * database name has been specified in the function call, the relevant flag
  * is set.
  *
  * @param conn  The MySQLProtocol structure for the connection
  * @param db_specified Whether the connection request specified a database
- * @param compress Whether compression is requested - NOT SUPPORTED
  * @return Bit mask (32 bits)
  * @note Capability bits are defined in maxscale/protocol/mysql.h
  */
@@ -863,6 +865,11 @@ static uint32_t create_capabilities(MySQLProtocol* conn,
 
     final_capabilities |= (int)GW_MYSQL_CAPABILITIES_PLUGIN_AUTH;
 
+    if (conn->compress)
+    {
+        final_capabilities |= (uint32_t)GW_MYSQL_CAPABILITIES_COMPRESS;
+    }
+
     return final_capabilities;
 }
 
@@ -986,8 +993,12 @@ mxs_auth_state_t gw_send_backend_auth(DCB* dcb)
     MYSQL_session client;
     gw_get_shared_session_auth_info(dcb->session->client_dcb, &client);
 
+    MySQLProtocol* proto = (MySQLProtocol*)dcb->protocol;
+    proto->compress = dcb->server->compression
+        && (proto->server_capabilities & GW_MYSQL_CAPABILITIES_COMPRESS);
+
     GWBUF* buffer = gw_generate_auth_response(&client,
-                                              (MySQLProtocol*)dcb->protocol,
+                                              proto,
                                               with_ssl,
                                               ssl_established,
                                               dcb->service->capabilities);
@@ -1705,3 +1716,187 @@ mysql_tx_state_t parse_trx_state(const char* str)
 
     return (mysql_tx_state_t)s;
 }
+
+namespace
+{
+
+/**
+ * The header of a compressed packet: the length of the payload, the sequence
+ * number and the length of the payload before compression or 0 if the
+ * payload is not compressed.
+ */
+const size_t COMPRESSED_HEADER_LEN = 7;
+
+/** Shorter payloads are sent uncompressed, like the server does */
+const size_t MIN_COMPRESS_LEN = 50;
+
+GWBUF* uncompress_payload(GWBUF* payload, size_t len)
+{
+    payload = gwbuf_make_contiguous(payload);
+    GWBUF* rval = gwbuf_alloc(len);
+
+    if (rval)
+    {
+        uLongf n = len;
+
+        if (uncompress(GWBUF_DATA(rval), &n, GWBUF_DATA(payload), GWBUF_LENGTH(payload)) != Z_OK
+            || n != len)
+        {
+            MXS_ERROR("Malformed compressed packet, could not decompress %lu bytes into %lu bytes.",
+                      GWBUF_LENGTH(payload), len);
+            gwbuf_free(rval);
+            rval = NULL;
+        }
+    }
+
+    gwbuf_free(payload);
+    return rval;
+}
+
+GWBUF* compress_payload(const uint8_t* data, size_t len, uint8_t seq)
+{
+    uLongf n = compressBound(len);
+    GWBUF* rval = gwbuf_alloc(COMPRESSED_HEADER_LEN + n);
+
+    if (rval)
+    {
+        uint8_t* ptr = GWBUF_DATA(rval);
+        size_t uncompressed_len = len;
+
+        if (len < MIN_COMPRESS_LEN
+            || compress(ptr + COMPRESSED_HEADER_LEN, &n, data, len) != Z_OK
+            || n >= len)
+        {
+            // Not worth compressing, send as-is
+            memcpy(ptr + COMPRESSED_HEADER_LEN, data, len);
+            n = len;
+            uncompressed_len = 0;
+        }
+
+        GWBUF_RTRIM(rval, GWBUF_LENGTH(rval) - COMPRESSED_HEADER_LEN - n);
+        gw_mysql_set_byte3(ptr, n);
+        ptr[3] = seq;
+        gw_mysql_set_byte3(ptr + 4, uncompressed_len);
+    }
+
+    return rval;
+}
+
+bool compressed_decode(DCB* dcb, GWBUF* data, GWBUF** decoded)
+{
+    MySQLProtocol* proto = (MySQLProtocol*)dcb->protocol;
+    GWBUF* queue = gwbuf_append(proto->compressed_readq, data);
+    GWBUF* rval = NULL;
+    uint8_t header[COMPRESSED_HEADER_LEN];
+    bool ok = true;
+
+    while (ok && gwbuf_copy_data(queue, 0, sizeof(header), header) == sizeof(header))
+    {
+        size_t len = gw_mysql_get_byte3(header);
+        size_t uncompressed_len = gw_mysql_get_byte3(header + 4);
+
+        if (gwbuf_length(queue) < sizeof(header) + len)
+        {
+            // Wait for the rest of the packet
+            break;
+        }
+
+        // Replies continue from the sequence number of the client's packet
+        proto->compressed_seq = header[3] + 1;
+        queue = gwbuf_consume(queue, sizeof(header));
+        GWBUF* payload = gwbuf_split(&queue, len);
+
+        if (payload && uncompressed_len)
+        {
+            payload = uncompress_payload(payload, uncompressed_len);
+            ok = payload != NULL;
+        }
+
+        rval = gwbuf_append(rval, payload);
+    }
+
+    proto->compressed_readq = queue;
+
+    if (!ok)
+    {
+        gwbuf_free(rval);
+        rval = NULL;
+    }
+
+    *decoded = rval;
+    return ok;
+}
+
+GWBUF* compressed_encode(DCB* dcb, GWBUF* data)
+{
+    MySQLProtocol* proto = (MySQLProtocol*)dcb->protocol;
+    uint8_t seq;
+
+    if (gwbuf_length(data) == 0)
+    {
+        return data;
+    }
+
+    if (dcb->dcb_role == DCB_ROLE_BACKEND_HANDLER
+        && gwbuf_copy_data(data, MYSQL_SEQ_OFFSET, 1, &seq) == 1 && seq == 0)
+    {
+        // A new command, the server expects the compressed sequence to start from zero
+        proto->compressed_seq = 0;
+    }
+
+    data = gwbuf_make_contiguous(data);
+    const uint8_t* ptr = GWBUF_DATA(data);
+    const uint8_t* end = ptr + GWBUF_LENGTH(data);
+    GWBUF* rval = NULL;
+    bool ok = true;
+
+    while (ok && ptr < end)
+    {
+        size_t len = MXS_MIN(end - ptr, GW_MYSQL_MAX_PACKET_LEN);
+
+        if (GWBUF* packet = compress_payload(ptr, len, proto->compressed_seq++))
+        {
+            rval = gwbuf_append(rval, packet);
+            ptr += len;
+        }
+        else
+        {
+            gwbuf_free(rval);
+            rval = NULL;
+            ok = false;
+        }
+    }
+
+    gwbuf_free(data);
+    return rval;
+}
+
+const DCB_CODEC compressed_codec =
+{
+    compressed_decode,
+    compressed_encode
+};
+}
+
+bool mxs_mysql_enable_compression(DCB* dcb)
+{
+    MySQLProtocol* proto = (MySQLProtocol*)dcb->protocol;
+    proto->compress = true;
+    proto->compressed_seq = 0;
+    dcb->codec = &compressed_codec;
+    bool rval = true;
+
+    if (dcb->readq)
+    {
+        // Data that was read together with the authentication is already compressed
+        GWBUF* encoded = dcb->readq;
+        size_t nencoded = gwbuf_length(encoded);
+        dcb->readq = NULL;
+
+        rval = dcb->codec->decode(dcb, encoded, &dcb->readq);
+        dcb->stats.n_encoded_in += nencoded;
+        dcb->stats.n_decoded_in += gwbuf_length(dcb->readq);
+    }
+
+    return rval;
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include <maxscale/cdefs.h>
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <maxscale/dcb.h>
+#include <maxscale/log.h>
+#include <maxscale/modutil.h>
+#include <maxscale/protocol/mysql.h>
+
+namespace
+{
+
+/**
+ * Create a DCB that has only the fields needed by the codec
+ */
+void init_dcb(DCB* dcb, MySQLProtocol* proto, dcb_role_t role)
+{
+    memset(dcb, 0, sizeof(*dcb));
+    memset(proto, 0, sizeof(*proto));
+    dcb->dcb_role = role;
+    dcb->protocol = proto;
+    mxs_mysql_enable_compression(dcb);
+}
+
+std::vector<uint8_t> to_vector(GWBUF* buffer)
+{
+    std::vector<uint8_t> rval(gwbuf_length(buffer));
+    gwbuf_copy_data(buffer, 0, rval.size(), rval.data());
+    return rval;
+}
+
+/**
+ * Compress a query, check the header of the compressed packet and decompress
+ * it one byte at a time.
+ */
+int test_roundtrip(const std::string& sql, bool expect_compressed)
+{
+    int errors = 0;
+    DCB backend;
+    DCB client;
+    MySQLProtocol backend_proto;
+    MySQLProtocol client_proto;
+    init_dcb(&backend, &backend_proto, DCB_ROLE_BACKEND_HANDLER);
+    init_dcb(&client, &client_proto, DCB_ROLE_CLIENT_HANDLER);
+
+    // A sequence number from an earlier command must not be used for a new command
+    backend_proto.compressed_seq = 5;
+
+    GWBUF* query = modutil_create_query(sql.c_str());
+    std::vector<uint8_t> original = to_vector(query);
+    GWBUF* encoded = backend.codec->encode(&backend, query);
+    std::vector<uint8_t> wire = to_vector(encoded);
+    gwbuf_free(encoded);
+
+    size_t len = gw_mysql_get_byte3(wire.data());
+    size_t uncompressed_len = gw_mysql_get_byte3(wire.data() + 4);
+
+    if (len + 7 != wire.size())
+    {
+        printf("Compressed packet is %lu bytes, header says %lu.\n", wire.size(), len + 7);
+        ++errors;
+    }
+
+    if (wire[3] != 0)
+    {
+        printf("Expected compressed sequence 0, got %d.\n", wire[3]);
+        ++errors;
+    }
+
+    if (expect_compressed != (uncompressed_len != 0))
+    {
+        printf("Query of %lu bytes was%s compressed.\n", original.size(), expect_compressed ? " not" : "");
+        ++errors;
+    }
+    else if (expect_compressed && (uncompressed_len != original.size() || len >= original.size()))
+    {
+        printf("Bad compressed length %lu or uncompressed length %lu for %lu bytes.\n",
+               len, uncompressed_len, original.size());
+        ++errors;
+    }
+
+    GWBUF* decoded = NULL;
+
+    for (size_t i = 0; i < wire.size(); ++i)
+    {
+        GWBUF* output = NULL;
+
+        if (!client.codec->decode(&client, gwbuf_alloc_and_load(1, &wire[i]), &output))
+        {
+            printf("Decoding failed at byte %lu.\n", i);
+            ++errors;
+            break;
+        }
+        else if (output && i != wire.size() - 1)
+        {
+            printf("Incomplete packet was decoded at byte %lu.\n", i);
+            ++errors;
+        }
+
+        decoded = gwbuf_append(decoded, output);
+    }
+
+    if (to_vector(decoded) != original)
+    {
+        printf("Decoded query differs from the original.\n");
+        ++errors;
+    }
+
+    if (client_proto.compressed_seq != 1)
+    {
+        printf("Expected the reply sequence to be 1, got %d.\n", client_proto.compressed_seq);
+        ++errors;
+    }
+
+    gwbuf_free(decoded);
+    gwbuf_free(client_proto.compressed_readq);
+    return errors;
+}
+
+int test_malformed()
+{
+    DCB client;
+    MySQLProtocol client_proto;
+    init_dcb(&client, &client_proto, DCB_ROLE_CLIENT_HANDLER);
+
+    // Claims 10 compressed bytes that decompress into 100 bytes
+    uint8_t data[] = {10, 0, 0, 0, 100, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    GWBUF* output = NULL;
+    int errors = 0;
+
+    if (client.codec->decode(&client, gwbuf_alloc_and_load(sizeof(data), data), &output) || output)
+    {
+        printf("Malformed compressed packet was accepted.\n");
+        ++errors;
+    }
+
+    gwbuf_free(client_proto.compressed_readq);
+    return errors;
+}
+
+/**
+ * Enable compression when the client has already sent a compressed packet and
+ * a part of another one after the authentication.
+ */
+int test_pipelined()
+{
+    int errors = 0;
+    DCB backend;
+    DCB client;
+    MySQLProtocol backend_proto;
+    MySQLProtocol client_proto;
+    init_dcb(&backend, &backend_proto, DCB_ROLE_BACKEND_HANDLER);
+
+    GWBUF* query = modutil_create_query(("SELECT " + std::string(1000, '1')).c_str());
+    std::vector<uint8_t> original = to_vector(query);
+    GWBUF* first = backend.codec->encode(&backend, query);
+    GWBUF* second = backend.codec->encode(&backend, modutil_create_query("SELECT 2"));
+    size_t partial = gwbuf_length(second) / 2;
+    second = gwbuf_rtrim(second, gwbuf_length(second) - partial);
+
+    memset(&client, 0, sizeof(client));
+    memset(&client_proto, 0, sizeof(client_proto));
+    client.dcb_role = DCB_ROLE_CLIENT_HANDLER;
+    client.protocol = &client_proto;
+    client.readq = gwbuf_append(first, second);
+
+    if (!mxs_mysql_enable_compression(&client))
+    {
+        printf("Decoding the read queue failed.\n");
+        ++errors;
+    }
+    else if (!client.readq || to_vector(client.readq) != original)
+    {
+        printf("Read queue does not contain the decoded query.\n");
+        ++errors;
+    }
+    else if (gwbuf_length(client_proto.compressed_readq) != partial)
+    {
+        printf("Expected %lu bytes of an incomplete packet, got %lu.\n",
+               partial, (size_t)gwbuf_length(client_proto.compressed_readq));
+        ++errors;
+    }
+
+    gwbuf_free(client.readq);
+    gwbuf_free(client_proto.compressed_readq);
+    return errors;
+}
+}
+
+int main(int argc, char** argv)
+{
+    int errors = 0;
+
+    if (mxs_log_init(NULL, ".", MXS_LOG_TARGET_STDOUT))
+    {
+        errors += test_roundtrip("SELECT 1", false);
+        errors += test_roundtrip("SELECT " + std::string(1000, '1'), true);
+        errors += test_malformed();
+        errors += test_pipelined();
+        mxs_log_finish();
+    }
+    else
+    {
+        ++errors;
+    }
+
+    return errors ? 1 : 0;
+}
@@ -385,45 +385,62 @@ static int send_row(DCB* dcb, json_t* row)
     return rc;
 }
 
-void AvroSession::set_current_gtid(json_t* row)
+/**
+ * Set the current GTID to the GTID of the record last read as JSON text
+ */
+void AvroSession::set_current_gtid()
 {
-    json_t* obj = json_object_get(row, avro_sequence);
-    mxb_assert(json_is_integer(obj));
-    gtid.seq = json_integer_value(obj);
-
-    obj = json_object_get(row, avro_server_id);
-    mxb_assert(json_is_integer(obj));
-    gtid.server_id = json_integer_value(obj);
-
-    obj = json_object_get(row, avro_domain);
-    mxb_assert(json_is_integer(obj));
-    gtid.domain = json_integer_value(obj);
+    MXB_AT_DEBUG(bool ok = )
+        maxavro_record_get_integer(file_handle, avro_sequence, &gtid.seq)
+        && maxavro_record_get_integer(file_handle, avro_server_id, &gtid.server_id)
+        && maxavro_record_get_integer(file_handle, avro_domain, &gtid.domain);
+    mxb_assert(ok);
 }
 
 /**
  * @brief Stream Avro data in JSON format
  *
- * @param file File to stream from
- * @param dcb DCB to stream to
+ * The records are converted directly from the Avro binary format into JSON
+ * text, and the records of a data block are sent in one buffer.
+ *
  * @return True if more data is readable, false if all data was sent
  */
 bool AvroSession::stream_json()
 {
     int bytes = 0;
+    int rc = 1;
+    MAXAVRO_TEXT text = {NULL, 0, 0};
 
     do
     {
-        json_t* row;
-        int rc = 1;
-        while (rc > 0 && (row = maxavro_record_read_json(file_handle)))
+        text.length = 0;
+
+        while (maxavro_record_read_json_text(file_handle, &text))
         {
-            rc = send_row(dcb, row);
-            set_current_gtid(row);
-            json_decref(row);
+            // Read all records of the block
+        }
+
+        if (text.length > 0)
+        {
+            GWBUF* buf = gwbuf_alloc_and_load(text.length, text.data);
+
+            if (buf)
+            {
+                rc = dcb->func.write(dcb, buf);
+                set_current_gtid();
+            }
+            else
+            {
+                MXS_ERROR("Failed to allocate %lu bytes for JSON data.", text.length);
+                rc = 0;
+            }
         }
+
         bytes += file_handle->buffer_size;
     }
-    while (maxavro_next_block(file_handle) && bytes < AVRO_DATA_BURST_SIZE);
+    while (rc > 0 && maxavro_next_block(file_handle) && bytes < AVRO_DATA_BURST_SIZE);
+
+    MXS_FREE(text.data);
 
     return bytes >= AVRO_DATA_BURST_SIZE;
 }
@@ -470,10 +487,47 @@ static int sqlite_cb(void* data, int rows, char** values, char** names)
     return 0;
 }
 
+/**
+ * Skip the data blocks that the GTID index says precede the requested GTID
+ */
+void AvroSession::seek_to_indexed_block()
+{
+    long pos = avro_index_find(router->avrodir + '/' + avro_binfile, gtid);
+
+    if (pos != -1)
+    {
+        if (maxavro_record_set_pos(file_handle, pos))
+        {
+            MXS_INFO("Skipped to offset %ld of '%s' when looking for GTID %lu-%lu-%lu",
+                     pos,
+                     avro_binfile.c_str(),
+                     gtid.domain,
+                     gtid.server_id,
+                     gtid.seq);
+        }
+        else
+        {
+            MXS_WARNING("GTID index of '%s' points to an invalid offset %ld, "
+                        "looking for GTID %lu-%lu-%lu from the start of the file.",
+                        avro_binfile.c_str(),
+                        pos,
+                        gtid.domain,
+                        gtid.server_id,
+                        gtid.seq);
+            maxavro_record_set_pos(file_handle, file_handle->header_end_pos);
+        }
+    }
+}
+
 bool AvroSession::seek_to_gtid()
 {
     bool seeking = true;
 
+    if (file_handle->records_read == 0)
+    {
+        seek_to_indexed_block();
+    }
+
     do
     {
         json_t* row;
@@ -14,6 +14,7 @@
 #include "avro_converter.hh"
 
 #include <limits.h>
+#include <sys/stat.h>
 
 #include <maxbase/assert.h>
 #include <maxscale/alloc.h>
@@ -45,6 +46,7 @@ AvroTable* avro_table_alloc(const char* filepath,
     }
 
     int rc = 0;
+    bool created = false;
 
     if (access(filepath, F_OK) == 0)
     {
@@ -57,6 +59,7 @@ AvroTable* avro_table_alloc(const char* filepath,
                                                 &avro_file,
                                                 codec,
                                                 block_size);
+        created = true;
     }
 
     if (rc)
@@ -74,13 +77,25 @@ AvroTable* avro_table_alloc(const char* filepath,
         return NULL;
     }
 
-    AvroTable* table = new(std::nothrow) AvroTable(avro_file, avro_writer_iface, avro_schema);
+    // An index left over from an earlier file of the same name is of no use
+    FILE* index = avro_index_open(filepath, created);
+    AvroTable* table = new(std::nothrow) AvroTable(avro_file,
+                                                   avro_writer_iface,
+                                                   avro_schema,
+                                                   filepath,
+                                                   index);
 
     if (!table)
     {
         avro_file_writer_close(avro_file);
         avro_value_iface_decref(avro_writer_iface);
         avro_schema_decref(avro_schema);
+
+        if (index)
+        {
+            fclose(index);
+        }
+
         MXS_OOM();
     }
 
@@ -304,7 +319,8 @@ static const char* codec_to_string(enum mxs_avro_codec_type type)
 }
 
 AvroConverter::AvroConverter(std::string avrodir, uint64_t block_size, mxs_avro_codec_type codec)
-    : m_avrodir(avrodir)
+    : m_table(NULL)
+    , m_avrodir(avrodir)
     , m_block_size(block_size)
     , m_codec(codec)
 {
@@ -362,6 +378,7 @@ bool AvroConverter::prepare_table(const STableMapEvent& map, const STableCreateE
     {
         m_writer_iface = it->second->avro_writer_iface;
         m_avro_file = &it->second->avro_file;
+        m_table = it->second.get();
         m_map = map;
         m_create = create;
         rval = true;
@@ -374,7 +391,16 @@ void AvroConverter::flush_tables()
 {
     for (auto it = m_open_tables.begin(); it != m_open_tables.end(); it++)
     {
-        avro_file_writer_flush(it->second->avro_file);
+        AvroTable* table = it->second.get();
+        avro_file_writer_flush(table->avro_file);
+
+        if (table->modified && table->avro_index)
+        {
+            // Everything is now on disk so the next record starts a new block at the end of the file
+            struct stat st;
+            table->modified = false;
+            table->block_pos = stat(table->avro_filepath.c_str(), &st) == 0 ? st.st_size : -1;
+        }
     }
 }
 
@@ -409,6 +435,28 @@ bool AvroConverter::commit(const gtid_pos_t& gtid)
         MXS_ERROR("Failed to write value: %s", avro_strerror());
         rval = false;
     }
+    else
+    {
+        m_table->modified = true;
+
+        if (m_table->block_pos != -1)
+        {
+            /**
+             * This is the first record of the block. To keep the index sparse,
+             * the block is indexed only if enough data has been written since
+             * the last indexed block of the same replication domain.
+             */
+            long& indexed_pos = m_table->indexed_pos[gtid.domain];
+
+            if (m_table->block_pos - indexed_pos >= AVRO_INDEX_INTERVAL)
+            {
+                avro_index_add(m_table->avro_index, gtid, m_table->block_pos);
+                indexed_pos = m_table->block_pos;
+            }
+
+            m_table->block_pos = -1;
+        }
+    }
 
     return rval;
 }
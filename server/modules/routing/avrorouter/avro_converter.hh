@@ -19,10 +19,18 @@
 
 struct AvroTable
 {
-    AvroTable(avro_file_writer_t file, avro_value_iface_t* iface, avro_schema_t schema)
+    AvroTable(avro_file_writer_t file,
+              avro_value_iface_t* iface,
+              avro_schema_t schema,
+              const std::string& path,
+              FILE* index)
         : avro_file(file)
         , avro_writer_iface(iface)
         , avro_schema(schema)
+        , avro_filepath(path)
+        , avro_index(index)
+        , block_pos(-1)
+        , modified(false)
     {
     }
 
@@ -32,11 +40,23 @@ struct AvroTable
         avro_file_writer_close(avro_file);
         avro_value_iface_decref(avro_writer_iface);
         avro_schema_decref(avro_schema);
+
+        if (avro_index)
+        {
+            fclose(avro_index);
+        }
     }
 
     avro_file_writer_t  avro_file;          /*< Current Avro data file */
     avro_value_iface_t* avro_writer_iface;  /*< Avro C API writer interface */
     avro_schema_t       avro_schema;        /*< Native Avro schema of the table */
+    std::string         avro_filepath;      /*< Path to the Avro data file */
+    FILE*               avro_index;         /*< GTID index of the data file, NULL if not available */
+    long                block_pos;          /*< Offset of the next block if it is still empty, else -1 */
+    bool                modified;           /*< Whether records were added since the last flush */
+
+    /** The offset of the last indexed block of each replication domain */
+    std::unordered_map<uint64_t, long> indexed_pos;
 };
 
 typedef std::shared_ptr<AvroTable>                  SAvroTable;
@@ -64,6 +84,7 @@ public:
 private:
     avro_value_iface_t* m_writer_iface;
     avro_file_writer_t* m_avro_file;
+    AvroTable*          m_table;
     avro_value_t        m_record;
     avro_value_t        m_union_value;
     avro_value_t        m_field;
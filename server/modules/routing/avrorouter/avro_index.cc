@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+/**
+ * @file avro_index.cc - The GTID index of the Avro data files
+ *
+ * Each Avro data file has a sparse index, stored in a file with the suffix
+ * @c .idx appended to the name of the data file. The index consists of fixed
+ * size entries that each map the GTID of the first record of a data block to
+ * the file offset where the block starts. The entries are in file order.
+ *
+ * The index is written by the conversion while it flushes the data files and
+ * it is read by the clients when they request to start from a GTID.
+ */
+
+#include "avrorouter.hh"
+
+#include <errno.h>
+#include <stdio.h>
+
+#include <maxscale/log.h>
+
+namespace
+{
+
+struct AvroIndexEntry
+{
+    uint64_t domain;    /*< Replication domain */
+    uint64_t server_id; /*< Server ID */
+    uint64_t seq;       /*< Sequence number */
+    uint64_t pos;       /*< The offset of the data block */
+};
+
+/** How many entries are read at a time */
+const size_t AVRO_INDEX_BATCH = 512;
+}
+
+std::string avro_index_filename(const std::string& avrofile)
+{
+    return avrofile + ".idx";
+}
+
+FILE* avro_index_open(const std::string& avrofile, bool truncate)
+{
+    std::string filename = avro_index_filename(avrofile);
+    FILE* file = fopen(filename.c_str(), truncate ? "wb" : "ab");
+
+    if (!file)
+    {
+        MXS_WARNING("Failed to open GTID index '%s', seeking to a GTID in '%s' will "
+                    "be slower: %d, %s",
+                    filename.c_str(),
+                    avrofile.c_str(),
+                    errno,
+                    mxs_strerror(errno));
+    }
+
+    return file;
+}
+
+bool avro_index_add(FILE* file, const gtid_pos_t& gtid, long pos)
+{
+    AvroIndexEntry entry;
+    entry.domain = gtid.domain;
+    entry.server_id = gtid.server_id;
+    entry.seq = gtid.seq;
+    entry.pos = pos;
+
+    // The index is read while it is being written so the entry is flushed immediately
+    bool rval = fwrite(&entry, sizeof(entry), 1, file) == 1 && fflush(file) == 0;
+
+    if (!rval)
+    {
+        MXS_ERROR("Failed to write GTID index entry: %d, %s", errno, mxs_strerror(errno));
+    }
+
+    return rval;
+}
+
+long avro_index_find(const std::string& avrofile, const gtid_pos_t& gtid)
+{
+    long rval = -1;
+    FILE* file = fopen(avro_index_filename(avrofile).c_str(), "rb");
+
+    if (file)
+    {
+        AvroIndexEntry entries[AVRO_INDEX_BATCH];
+        bool found = false;
+        size_t n;
+
+        // A partially written entry at the end of the file is not read
+        while (!found && (n = fread(entries, sizeof(entries[0]), AVRO_INDEX_BATCH, file)) > 0)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                if (entries[i].domain == gtid.domain)
+                {
+                    if (entries[i].seq < gtid.seq)
+                    {
+                        /**
+                         * The sequence numbers of a domain only grow, so none
+                         * of the records before this block can be a match.
+                         */
+                        rval = entries[i].pos;
+                    }
+                    else
+                    {
+                        found = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        fclose(file);
+    }
+
+    return rval;
+}
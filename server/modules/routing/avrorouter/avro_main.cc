@@ -436,7 +436,8 @@ static bool avro_handle_purge(const MODULECMD_ARG* args, json_t** output)
     // Then delete the files
     return do_unlink("%s/%s", inst->avrodir.c_str(), AVRO_PROGRESS_FILE)    // State file
            && do_unlink_with_pattern("/%s/*.avro", inst->avrodir.c_str())   // .avro files
-           && do_unlink_with_pattern("/%s/*.avsc", inst->avrodir.c_str());  // .avsc files
+           && do_unlink_with_pattern("/%s/*.avsc", inst->avrodir.c_str())   // .avsc files
+           && do_unlink_with_pattern("/%s/*.avro.idx", inst->avrodir.c_str()); // GTID indexes
 }
 
 /**
@@ -87,6 +87,9 @@ typedef enum avro_binlog_end
 /** How many bytes each thread tries to send */
 #define AVRO_DATA_BURST_SIZE (32 * 1024)
 
+/** The minimum distance in bytes between two data blocks in the GTID index */
+#define AVRO_INDEX_INTERVAL (256 * 1024)
+
 /** Data format used when streaming data to the clients */
 enum avro_data_format
 {
@@ -99,15 +102,14 @@ enum mxs_avro_codec_type
 {
     MXS_AVRO_CODEC_NULL,
     MXS_AVRO_CODEC_DEFLATE,
-    MXS_AVRO_CODEC_SNAPPY,      /**< Not yet implemented */
+    MXS_AVRO_CODEC_SNAPPY,
 };
 
 static const MXS_ENUM_VALUE codec_values[] =
 {
     {"null",    MXS_AVRO_CODEC_NULL   },
     {"deflate", MXS_AVRO_CODEC_DEFLATE},
-// Not yet implemented
-//    {"snappy", MXS_AVRO_CODEC_SNAPPY},
+    {"snappy",  MXS_AVRO_CODEC_SNAPPY },
     {NULL}
 };
 
@@ -181,9 +183,10 @@ private:
     int  do_registration(GWBUF* data);
     void process_command(GWBUF* queue);
     void send_gtid_info(gtid_pos_t* gtid_pos);
-    void set_current_gtid(json_t* row);
+    void set_current_gtid();
     bool stream_json();
     bool stream_binary();
+    void seek_to_indexed_block();
     bool seek_to_gtid();
     bool stream_data();
     void rotate_avro_file(std::string fullname);
@@ -221,4 +224,45 @@ bool              avro_load_conversion_state(Avro* router);
 void              avro_load_metadata_from_schemas(Avro* router);
 void              notify_all_clients(Avro* router);
 
+/**
+ * Get the name of the GTID index of an Avro file
+ *
+ * @param avrofile Path to the Avro file
+ *
+ * @return Path to the GTID index
+ */
+std::string avro_index_filename(const std::string& avrofile);
+
+/**
+ * Open the GTID index of an Avro file for writing
+ *
+ * @param avrofile Path to the Avro file
+ * @param truncate Whether the existing index should be discarded
+ *
+ * @return The opened index or NULL on error
+ */
+FILE* avro_index_open(const std::string& avrofile, bool truncate);
+
+/**
+ * Add a data block to the GTID index
+ *
+ * @param file The index opened with avro_index_open
+ * @param gtid The GTID of the first record in the block
+ * @param pos  The offset of the block in the Avro file
+ *
+ * @return True if the entry was written
+ */
+bool avro_index_add(FILE* file, const gtid_pos_t& gtid, long pos);
+
+/**
+ * Find the data block to start from when looking for a GTID
+ *
+ * @param avrofile Path to the Avro file
+ * @param gtid     The GTID to look for
+ *
+ * @return The offset of the last data block that starts before the GTID
+ *         or -1 if the GTID should be looked for from the start of the file
+ */
+long avro_index_find(const std::string& avrofile, const gtid_pos_t& gtid);
+
 MXS_END_DECLS
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "../avro_index.cc"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+const char SCHEMA[] =
+    "{\"namespace\": \"MaxScaleChangeDataSchema.avro\", \"type\": \"record\", \"name\": \"ChangeRecord\","
+    " \"fields\": [{\"name\": \"domain\", \"type\": {\"type\": \"int\"}},"
+    " {\"name\": \"server_id\", \"type\": {\"type\": \"int\"}},"
+    " {\"name\": \"sequence\", \"type\": {\"type\": \"int\"}},"
+    " {\"name\": \"data\", \"type\": {\"type\": \"string\"}}]}";
+
+const uint8_t SYNC[SYNC_MARKER_SIZE] =
+{
+    0x9f, 0x3a, 0x51, 0x0c, 0x77, 0xe2, 0x18, 0x4b, 0xd6, 0x2e, 0x85, 0x6a, 0x03, 0xc1, 0xf9, 0x40
+};
+
+const int N_DOMAINS = 2;
+const int ROWS_PER_TRX = 10;
+
+void encode_long(vector<uint8_t>& dest, int64_t value)
+{
+    uint64_t n = (value << 1) ^ (value >> 63);
+
+    while (n & ~0x7fUL)
+    {
+        dest.push_back((n & 0x7f) | 0x80);
+        n >>= 7;
+    }
+
+    dest.push_back(n);
+}
+
+void encode_string(vector<uint8_t>& dest, const string& str)
+{
+    encode_long(dest, str.size());
+    dest.insert(dest.end(), str.begin(), str.end());
+}
+
+void write(FILE* file, const vector<uint8_t>& data)
+{
+    fwrite(data.data(), 1, data.size(), file);
+}
+
+/**
+ * Write an Avro file the way the avrorouter does, one transaction per data
+ * block with the transactions alternating between the replication domains.
+ *
+ * @return The GTID of the last transaction of each domain
+ */
+vector<gtid_pos_t> write_file(const string& filename, long size)
+{
+    vector<gtid_pos_t> gtids(N_DOMAINS);
+    FILE* file = fopen(filename.c_str(), "wb");
+    FILE* index = avro_index_open(filename, true);
+
+    if (file && index)
+    {
+        vector<uint8_t> header(avro_magic, avro_magic + AVRO_MAGIC_SIZE);
+        encode_long(header, 2);
+        encode_string(header, "avro.schema");
+        encode_string(header, SCHEMA);
+        encode_string(header, "avro.codec");
+        encode_string(header, "null");
+        encode_long(header, 0);
+        header.insert(header.end(), SYNC, SYNC + SYNC_MARKER_SIZE);
+        write(file, header);
+
+        for (int i = 0; i < N_DOMAINS; i++)
+        {
+            gtids[i].domain = i;
+            gtids[i].server_id = 1;
+        }
+
+        string data(200, 'a');
+        vector<long> indexed_pos(N_DOMAINS, 0);
+
+        for (int trx = 0; ftell(file) < size; trx++)
+        {
+            gtid_pos_t& gtid = gtids[trx % N_DOMAINS];
+            gtid.seq++;
+
+            vector<uint8_t> records;
+
+            for (int i = 0; i < ROWS_PER_TRX; i++)
+            {
+                encode_long(records, gtid.domain);
+                encode_long(records, gtid.server_id);
+                encode_long(records, gtid.seq);
+                encode_string(records, data);
+            }
+
+            long pos = ftell(file);
+
+            if (pos - indexed_pos[gtid.domain] >= AVRO_INDEX_INTERVAL)
+            {
+                avro_index_add(index, gtid, pos);
+                indexed_pos[gtid.domain] = pos;
+            }
+
+            vector<uint8_t> block;
+            encode_long(block, ROWS_PER_TRX);
+            encode_long(block, records.size());
+            block.insert(block.end(), records.begin(), records.end());
+            block.insert(block.end(), SYNC, SYNC + SYNC_MARKER_SIZE);
+            write(file, block);
+        }
+    }
+
+    if (index)
+    {
+        fclose(index);
+    }
+
+    if (file)
+    {
+        fclose(file);
+    }
+
+    return gtids;
+}
+
+/**
+ * Read records until the GTID is found, the way AvroSession::seek_to_gtid() does
+ *
+ * @return The sequence number of the found record or 0 if none was found
+ */
+uint64_t scan(MAXAVRO_FILE* file, const gtid_pos_t& gtid)
+{
+    uint64_t rval = 0;
+
+    do
+    {
+        json_t* row;
+
+        while (rval == 0 && (row = maxavro_record_read_json(file)))
+        {
+            uint64_t seq = json_integer_value(json_object_get(row, avro_sequence));
+
+            if (seq >= gtid.seq
+                && (uint64_t)json_integer_value(json_object_get(row, avro_server_id)) == gtid.server_id
+                && (uint64_t)json_integer_value(json_object_get(row, avro_domain)) == gtid.domain)
+            {
+                rval = seq;
+            }
+
+            json_decref(row);
+        }
+    }
+    while (rval == 0 && maxavro_next_block(file));
+
+    return rval;
+}
+
+uint64_t seek(const string& filename, const gtid_pos_t& gtid, bool use_index)
+{
+    uint64_t rval = 0;
+    MAXAVRO_FILE* file = maxavro_file_open(filename.c_str());
+
+    if (file)
+    {
+        long pos = use_index ? avro_index_find(filename, gtid) : -1;
+
+        if (pos == -1 || maxavro_record_set_pos(file, pos))
+        {
+            rval = scan(file, gtid);
+        }
+
+        maxavro_file_close(file);
+    }
+
+    return rval;
+}
+
+double seek_ms(const string& filename, const gtid_pos_t& gtid, bool use_index, uint64_t* pSeq)
+{
+    auto start = chrono::steady_clock::now();
+    *pSeq = seek(filename, gtid, use_index);
+    auto end = chrono::steady_clock::now();
+
+    return chrono::duration<double, milli>(end - start).count();
+}
+
+/**
+ * Check that the indexed seek finds the same record as the full scan
+ */
+int test_seek(const string& filename, const gtid_pos_t& gtid, bool print)
+{
+    int rval = 0;
+    uint64_t linear_seq;
+    uint64_t indexed_seq;
+
+    double linear = seek_ms(filename, gtid, false, &linear_seq);
+    double indexed = seek_ms(filename, gtid, true, &indexed_seq);
+
+    if (linear_seq != gtid.seq || indexed_seq != gtid.seq)
+    {
+        cout << "Seeking to " << gtid.domain << "-" << gtid.server_id << "-" << gtid.seq
+             << " found " << linear_seq << " with a full scan and " << indexed_seq
+             << " with the index." << endl;
+        rval = 1;
+    }
+    else if (print)
+    {
+        cout << "  full scan: " << linear << " ms, indexed: " << indexed << " ms" << endl;
+    }
+
+    return rval;
+}
+}
+
+int main(int argc, char** argv)
+{
+    int rval = 0;
+    long max_size = (argc > 1 ? atol(argv[1]) : 16) * 1024 * 1024;
+    string filename = "test_gtid_index.000001.avro";
+
+    for (long size = 1024 * 1024; size <= max_size; size *= 4)
+    {
+        vector<gtid_pos_t> gtids = write_file(filename, size);
+        cout << "File of " << size / (1024 * 1024) << " MiB:" << endl;
+
+        for (auto gtid : gtids)
+        {
+            // The last transaction, one in the middle and the first one
+            rval += test_seek(filename, gtid, gtid.domain == 0);
+
+            gtid.seq /= 2;
+            rval += test_seek(filename, gtid, false);
+
+            gtid.seq = 1;
+            rval += test_seek(filename, gtid, false);
+        }
+    }
+
+    remove(filename.c_str());
+    remove(avro_index_filename(filename).c_str());
+
+    return rval;
+}
@@ -211,6 +211,8 @@ extern "C" MXS_MODULE* MXS_CREATE_MODULE()
              DEF_LONG_BURST},
             {"burstsize",                                MXS_MODULE_PARAM_SIZE,
              DEF_BURST_SIZE},
+            {"event_cache_size",                         MXS_MODULE_PARAM_SIZE,
+             DEF_EVENT_CACHE_SIZE},
             {"heartbeat",                                MXS_MODULE_PARAM_COUNT,
              BLR_HEARTBEAT_DEFAULT_INTERVAL},
             {"connect_retry",                            MXS_MODULE_PARAM_COUNT,
@@ -344,6 +346,7 @@ static MXS_ROUTER* createInstance(SERVICE* service, MXS_CONFIG_PARAMETER* params
     inst->short_burst = config_get_integer(params, "shortburst");
     inst->long_burst = config_get_integer(params, "longburst");
     inst->burst_size = config_get_size(params, "burstsize");
+    inst->event_cache_size = config_get_size(params, "event_cache_size");
     inst->binlogdir = config_copy_string(params, "binlogdir");
     inst->heartbeat = config_get_integer(params, "heartbeat");
     inst->retry_interval = config_get_integer(params, "connect_retry");
@@ -1150,6 +1153,8 @@ static void free_instance(ROUTER_INSTANCE* instance)
     MXS_FREE(instance->ssl_key);
     MXS_FREE(instance->ssl_version);
 
+    blr_free_cache(instance);
+
     MXS_FREE(instance);
 }
 
@@ -1651,6 +1656,28 @@ static void diagnostics(MXS_ROUTER* router, DCB* dcb)
                router_inst->stats.n_reads != 0 ?
                ((double)router_inst->stats.n_binlogs / router_inst->stats.n_reads) : 0);
 
+    if (router_inst->event_cache)
+    {
+        uint64_t lookups = router_inst->stats.n_cachehits + router_inst->stats.n_cachemisses;
+
+        dcb_printf(dcb,
+                   "\tBinlog event cache size:                     %lu/%lu\n",
+                   router_inst->event_cache->size,
+                   router_inst->event_cache->max_size);
+        dcb_printf(dcb,
+                   "\tBinlog event cache hits:                     %lu\n",
+                   router_inst->stats.n_cachehits);
+        dcb_printf(dcb,
+                   "\tBinlog event cache misses:                   %lu\n",
+                   router_inst->stats.n_cachemisses);
+        dcb_printf(dcb,
+                   "\tBinlog event cache evictions:                %lu\n",
+                   router_inst->stats.n_cacheevictions);
+        dcb_printf(dcb,
+                   "\tBinlog event cache hit ratio:                %.1f%%\n",
+                   lookups != 0 ? 100.0 * router_inst->stats.n_cachehits / lookups : 0);
+    }
+
     pthread_mutex_lock(&router_inst->lock);
     if (router_inst->stats.lastReply)
     {
@@ -2107,6 +2134,21 @@ static json_t* diagnostics_json(const MXS_ROUTER* router)
 
     json_object_set_new(rval, "average_events_per_packets", json_real(average_packets));
 
+    if (router_inst->event_cache)
+    {
+        uint64_t lookups = router_inst->stats.n_cachehits + router_inst->stats.n_cachemisses;
+
+        json_object_set_new(rval, "event_cache_size", json_integer(router_inst->event_cache->size));
+        json_object_set_new(rval, "event_cache_max_size",
+                            json_integer(router_inst->event_cache->max_size));
+        json_object_set_new(rval, "event_cache_hits", json_integer(router_inst->stats.n_cachehits));
+        json_object_set_new(rval, "event_cache_misses", json_integer(router_inst->stats.n_cachemisses));
+        json_object_set_new(rval, "event_cache_evictions",
+                            json_integer(router_inst->stats.n_cacheevictions));
+        json_object_set_new(rval, "event_cache_hit_ratio",
+                            json_real(lookups != 0 ? (double)router_inst->stats.n_cachehits / lookups : 0));
+    }
+
     pthread_mutex_lock(&router_inst->lock);
     if (router_inst->stats.lastReply)
     {
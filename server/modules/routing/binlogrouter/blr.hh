@@ -29,6 +29,7 @@
 
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include <maxscale/buffer.h>
@@ -219,6 +220,13 @@ typedef enum
 #define DEF_LONG_BURST  "500"
 #define DEF_BURST_SIZE  "1024000"           /* 1 Mb */
 
+/**
+ * Default size of the binlog event cache shared by the slaves
+ * and the maximum number of events it holds
+ */
+#define DEF_EVENT_CACHE_SIZE   "16Mi"
+#define BLR_CACHE_MAX_RECORDS  16384
+
 /**
  * master reconnect backoff constants
  * BLR_MASTER_BACKOFF_TIME      The increments of the back off time (seconds)
@@ -483,26 +491,34 @@ typedef struct rep_header
 } REP_HEADER;
 
 /**
- * The binlog record structure. This contains the actual packet read from the binlog
- * file.
+ * The binlog record structure. This contains an event as it was read from
+ * a binlog file.
  */
 typedef struct
 {
-    unsigned long position;         /*< binlog record position for this cache entry */
-    GWBUF*        pkt;              /*< The packet received from the master */
-    REP_HEADER    hdr;              /*< The packet header */
+    char               binlog_name[BINLOG_FNAMELEN + 1];
+    /*< Name of the binlog file the event was read from */
+    MARIADB_GTID_ELEMS gtid_elms;   /*< Elements for file prefix */
+    unsigned long      position;    /*< binlog record position for this cache entry */
+    uint8_t*           event;       /*< The event data, hdr.event_size bytes */
+    REP_HEADER         hdr;         /*< The event header */
 } BLCACHE_RECORD;
 
 /**
- * The binlog cache. A cache exists for each file that hold cached bin log records.
- * Caches will be used for all files being read by more than 1 slave.
+ * The binlog cache. A bounded ring of the most recently read binlog events,
+ * shared by all slaves of a router instance. The oldest events are evicted
+ * when either the number of records or the total size exceeds the limits.
  */
 typedef struct
 {
-    BLCACHE_RECORD**        records;/*< The actual binlog records */
-    int                     current;/*< The next record that will be inserted */
-    int                     cnt;    /*< The number of records in the cache */
-    mutable pthread_mutex_t lock;   /*< The spinlock for the cache */
+    BLCACHE_RECORD*              records;   /*< The ring of cached binlog records */
+    int                          capacity;  /*< The number of slots in the ring */
+    int                          current;   /*< The next record that will be inserted */
+    int                          cnt;       /*< The number of records in the cache */
+    uint64_t                     size;      /*< Total size of the cached events */
+    uint64_t                     max_size;  /*< Maximum total size of the cached events */
+    std::unordered_map<uint64_t, int> index; /*< Record key to slot in the ring */
+    mutable pthread_mutex_t      lock;      /*< The lock for the cache */
 } BLCACHE;
 
 typedef struct blfile
@@ -646,6 +662,7 @@ typedef struct
     uint64_t n_rotates;         /*< Number of binlog rotate events */
     uint64_t n_cachehits;       /*< Number of hits on the binlog cache */
     uint64_t n_cachemisses;     /*< Number of misses on the binlog cache */
+    uint64_t n_cacheevictions;  /*< Number of events evicted from the binlog cache */
     int      n_registered;      /*< Number of registered slaves */
     int      n_masterstarts;    /*< Number of times connection restarted */
     int      n_delayedreconnects;
@@ -798,6 +815,8 @@ struct ROUTER_INSTANCE : public MXS_ROUTER
     unsigned int            short_burst;/*< Short burst for slave catchup */
     unsigned int            long_burst; /*< Long burst for slave catchup */
     unsigned long           burst_size; /*< Maximum size of burst to send */
+    uint64_t                event_cache_size;   /*< Size of the shared binlog event cache */
+    BLCACHE*                event_cache;        /*< Events recently read by the slaves */
     unsigned long           heartbeat;  /*< Configured heartbeat value */
     ROUTER_STATS            stats;      /*< Statistics for this router */
     int                     active_logs;
@@ -1058,7 +1077,19 @@ extern void blr_slave_rotate(ROUTER_INSTANCE*,
 extern int blr_slave_catchup(ROUTER_INSTANCE* router,
                              ROUTER_SLAVE* slave,
                              bool large);
-extern void blr_init_cache(ROUTER_INSTANCE*);
+extern void    blr_init_cache(ROUTER_INSTANCE*);
+extern void    blr_free_cache(ROUTER_INSTANCE*);
+extern GWBUF*  blr_cache_get(ROUTER_INSTANCE* router,
+                             const BLFILE* file,
+                             unsigned long pos,
+                             REP_HEADER* hdr);
+extern void    blr_cache_put(ROUTER_INSTANCE* router,
+                             const BLFILE* file,
+                             unsigned long pos,
+                             const REP_HEADER* hdr,
+                             GWBUF* event);
+extern void    blr_cache_invalidate(ROUTER_INSTANCE* router,
+                                    const char* binlog_name);
 
 extern int blr_file_init(ROUTER_INSTANCE*);
 extern int blr_write_binlog_record(ROUTER_INSTANCE*,
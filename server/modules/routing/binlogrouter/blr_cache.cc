@@ -36,15 +36,319 @@
 #include <maxscale/dcb.h>
 
 #include <maxscale/log.h>
+#include <maxscale/alloc.h>
 
+namespace
+{
+
+/**
+ * Calculate the key of a binlog record. Different records may have the same
+ * key, so a record found using the key must still be compared.
+ */
+uint64_t blr_cache_key(const char* binlog_name,
+                       const MARIADB_GTID_ELEMS* gtid_elms,
+                       unsigned long pos)
+{
+    uint64_t key = 14695981039346656037ULL;
+
+    for (const char* ptr = binlog_name; *ptr; ptr++)
+    {
+        key ^= (uint8_t)*ptr;
+        key *= 1099511628211ULL;
+    }
+
+    key ^= ((uint64_t)gtid_elms->domain_id << 32) | gtid_elms->server_id;
+    key *= 1099511628211ULL;
+
+    return key ^ (pos * 0x9e3779b97f4a7c15ULL);
+}
+
+bool blr_cache_record_matches(const BLCACHE_RECORD* record,
+                              const BLFILE* file,
+                              unsigned long pos)
+{
+    return record->event
+           && record->position == pos
+           && record->gtid_elms.domain_id == file->gtid_elms.domain_id
+           && record->gtid_elms.server_id == file->gtid_elms.server_id
+           && strcmp(record->binlog_name, file->binlog_name) == 0;
+}
 
 /**
- * Initialise the cache for this instanceof the binlog router. As a side
- * effect also determine the binlog file to read and the position to read
- * from.
+ * Release the event of a record, leaving an empty slot in the ring
+ */
+void blr_cache_release(BLCACHE* cache, int slot)
+{
+    BLCACHE_RECORD* record = &cache->records[slot];
+
+    if (record->event)
+    {
+        auto it = cache->index.find(blr_cache_key(record->binlog_name,
+                                                  &record->gtid_elms,
+                                                  record->position));
+
+        if (it != cache->index.end() && it->second == slot)
+        {
+            cache->index.erase(it);
+        }
+
+        cache->size -= record->hdr.event_size;
+        MXS_FREE(record->event);
+        record->event = NULL;
+    }
+}
+
+/**
+ * Evict the oldest record of the ring
+ */
+bool blr_cache_evict_oldest(ROUTER_INSTANCE* router)
+{
+    BLCACHE* cache = router->event_cache;
+
+    if (cache->cnt == 0)
+    {
+        return false;
+    }
+
+    int oldest = (cache->current - cache->cnt + cache->capacity) % cache->capacity;
+
+    if (cache->records[oldest].event)
+    {
+        router->stats.n_cacheevictions++;
+    }
+
+    blr_cache_release(cache, oldest);
+    cache->cnt--;
+
+    return true;
+}
+}
+
+
+
+/**
+ * Initialise the cache for this instance of the binlog router.
+ *
+ * The cache holds the events most recently read from the binlog files by
+ * the slaves in catchup mode, so that only the first of several slaves
+ * reading the same part of a binlog file has to read it from the disk.
+ * The cache is disabled if the event_cache_size parameter is 0.
  *
  * @param   router      The router instance
  */
 void blr_init_cache(ROUTER_INSTANCE* router)
 {
+    if (router->event_cache_size == 0)
+    {
+        return;
+    }
+
+    BLCACHE* cache = new(std::nothrow) BLCACHE;
+    BLCACHE_RECORD* records =
+        static_cast<BLCACHE_RECORD*>(MXS_CALLOC(BLR_CACHE_MAX_RECORDS, sizeof(BLCACHE_RECORD)));
+
+    if (!cache || !records)
+    {
+        delete cache;
+        MXS_FREE(records);
+        MXS_ERROR("%s: Failed to allocate the binlog event cache, "
+                  "events will always be read from the binlog files.",
+                  router->service->name);
+        return;
+    }
+
+    cache->records = records;
+    cache->capacity = BLR_CACHE_MAX_RECORDS;
+    cache->current = 0;
+    cache->cnt = 0;
+    cache->size = 0;
+    cache->max_size = router->event_cache_size;
+    pthread_mutex_init(&cache->lock, NULL);
+
+    router->event_cache = cache;
+}
+
+/**
+ * Free the cache of the router instance
+ *
+ * @param   router      The router instance
+ */
+void blr_free_cache(ROUTER_INSTANCE* router)
+{
+    BLCACHE* cache = router->event_cache;
+
+    if (cache)
+    {
+        for (int i = 0; i < cache->capacity; i++)
+        {
+            MXS_FREE(cache->records[i].event);
+        }
+
+        pthread_mutex_destroy(&cache->lock);
+        MXS_FREE(cache->records);
+        delete cache;
+        router->event_cache = NULL;
+    }
+}
+
+/**
+ * Get an event from the cache
+ *
+ * @param router    The router instance
+ * @param file      The binlog file being read
+ * @param pos       Position of the event in the file
+ * @param hdr       Binlog header to populate if the event is found
+ * @return          A copy of the cached event or NULL if it was not cached
+ */
+GWBUF* blr_cache_get(ROUTER_INSTANCE* router,
+                     const BLFILE* file,
+                     unsigned long pos,
+                     REP_HEADER* hdr)
+{
+    BLCACHE* cache = router->event_cache;
+    GWBUF* rval = NULL;
+
+    if (cache)
+    {
+        pthread_mutex_lock(&cache->lock);
+
+        auto it = cache->index.find(blr_cache_key(file->binlog_name, &file->gtid_elms, pos));
+
+        if (it != cache->index.end()
+            && blr_cache_record_matches(&cache->records[it->second], file, pos))
+        {
+            const BLCACHE_RECORD* record = &cache->records[it->second];
+
+            /**
+             * GWBUFs are owned by the worker that allocated them, so the
+             * slave gets a copy of the event instead of a clone of a
+             * buffer that is shared with the other workers.
+             */
+            if ((rval = gwbuf_alloc_and_load(record->hdr.event_size, record->event)))
+            {
+                *hdr = record->hdr;
+            }
+        }
+
+        if (rval)
+        {
+            router->stats.n_cachehits++;
+        }
+        else
+        {
+            router->stats.n_cachemisses++;
+        }
+
+        pthread_mutex_unlock(&cache->lock);
+    }
+
+    return rval;
+}
+
+/**
+ * Add an event read from a binlog file to the cache
+ *
+ * Events larger than an eighth of the cache are not cached so that
+ * a single large event does not flush the whole cache.
+ *
+ * @param router    The router instance
+ * @param file      The binlog file the event was read from
+ * @param pos       Position of the event in the file
+ * @param hdr       The header of the event
+ * @param event     The event, as it was read from the file
+ */
+void blr_cache_put(ROUTER_INSTANCE* router,
+                   const BLFILE* file,
+                   unsigned long pos,
+                   const REP_HEADER* hdr,
+                   GWBUF* event)
+{
+    BLCACHE* cache = router->event_cache;
+
+    if (!cache
+        || hdr->event_size > cache->max_size / 8
+        || GWBUF_LENGTH(event) != hdr->event_size)
+    {
+        return;
+    }
+
+    uint8_t* data = static_cast<uint8_t*>(MXS_MALLOC(hdr->event_size));
+
+    if (!data)
+    {
+        return;
+    }
+
+    memcpy(data, GWBUF_DATA(event), hdr->event_size);
+
+    uint64_t key = blr_cache_key(file->binlog_name, &file->gtid_elms, pos);
+
+    pthread_mutex_lock(&cache->lock);
+
+    auto it = cache->index.find(key);
+
+    if (it != cache->index.end()
+        && blr_cache_record_matches(&cache->records[it->second], file, pos))
+    {
+        /* Another slave added the event while this one was reading it */
+        pthread_mutex_unlock(&cache->lock);
+        MXS_FREE(data);
+        return;
+    }
+
+    while (cache->cnt == cache->capacity
+           || cache->size + hdr->event_size > cache->max_size)
+    {
+        if (!blr_cache_evict_oldest(router))
+        {
+            break;
+        }
+    }
+
+    int slot = cache->current;
+    BLCACHE_RECORD* record = &cache->records[slot];
+
+    strcpy(record->binlog_name, file->binlog_name);
+    record->gtid_elms = file->gtid_elms;
+    record->position = pos;
+    record->event = data;
+    record->hdr = *hdr;
+
+    cache->index[key] = slot;
+    cache->size += hdr->event_size;
+    cache->current = (cache->current + 1) % cache->capacity;
+    cache->cnt++;
+
+    pthread_mutex_unlock(&cache->lock);
+}
+
+/**
+ * Remove all cached events of a binlog file
+ *
+ * This must be called whenever a binlog file is (re)created, as the events
+ * of a file that was removed must not be returned for a new file that
+ * happens to have the same name.
+ *
+ * @param router        The router instance
+ * @param binlog_name   The name of the binlog file
+ */
+void blr_cache_invalidate(ROUTER_INSTANCE* router, const char* binlog_name)
+{
+    BLCACHE* cache = router->event_cache;
+
+    if (cache)
+    {
+        pthread_mutex_lock(&cache->lock);
+
+        for (int i = 0; i < cache->capacity; i++)
+        {
+            if (cache->records[i].event
+                && strcmp(cache->records[i].binlog_name, binlog_name) == 0)
+            {
+                blr_cache_release(cache, i);
+            }
+        }
+
+        pthread_mutex_unlock(&cache->lock);
+    }
 }
@@ -541,6 +541,9 @@ static int blr_file_create(ROUTER_INSTANCE* router, char* orig_file)
             router->last_written = BINLOG_MAGIC_SIZE;
             pthread_mutex_unlock(&router->binlog_lock);
 
+            /* Drop the cached events of an earlier file with the same name */
+            blr_cache_invalidate(router, new_binlog);
+
             created = 1;
 
             /**
@@ -1090,6 +1093,21 @@ GWBUF* blr_read_binlog(ROUTER_INSTANCE* router,
     pthread_mutex_unlock(&file->lock);
     pthread_mutex_unlock(&router->binlog_lock);
 
+    /**
+     * Events of encrypted binlog files are not cached as the cached data
+     * would have to be decrypted by each slave anyway.
+     */
+    bool use_cache = enc_ctx == NULL && !router->encryption.enabled;
+
+    /* Check whether another slave has recently read the event */
+    if (use_cache && (result = blr_cache_get(router, file, pos, hdr)) != NULL)
+    {
+        /* set OK indicator */
+        hdr->ok = SLAVE_POS_READ_OK;
+
+        return result;
+    }
+
     /* Read the header information from the file */
     if ((n = pread(file->fd,
                    hdbuf,
@@ -1394,6 +1412,10 @@ GWBUF* blr_read_binlog(ROUTER_INSTANCE* router,
         /* Set the decrypted event as result */
         result = decrypted_event;
     }
+    else if (use_cache)
+    {
+        blr_cache_put(router, file, pos, hdr, result);
+    }
 
     /* set OK indicator */
     hdr->ok = SLAVE_POS_READ_OK;
@@ -343,6 +343,17 @@ void RWSplit::diagnostics(DCB* dcb)
     dcb_printf(dcb,
                "\tNumber of replayed transactions:        %" PRIu64 "\n",
                stats().n_trx_replay);
+    dcb_printf(dcb,
+               "\tSession commands in histories:          %" PRId64 " (%" PRId64 " bytes)\n",
+               stats().sescmd_history_length,
+               stats().sescmd_history_bytes);
+    dcb_printf(dcb,
+               "\tSession commands replaced in histories: %" PRIu64 "\n",
+               stats().n_sescmd_collapsed);
+    dcb_printf(dcb,
+               "\tSession command history replays:        %" PRIu64 " (%" PRIu64 "ms average)\n",
+               stats().n_sescmd_replays,
+               stats().n_sescmd_replays ? stats().sescmd_replay_ms / stats().n_sescmd_replays : 0);
 
     if (*weightby)
     {
@@ -403,6 +414,14 @@ json_t* RWSplit::diagnostics_json() const
     json_object_set_new(rval, "rw_transactions", json_integer(stats().n_rw_trx));
     json_object_set_new(rval, "ro_transactions", json_integer(stats().n_ro_trx));
     json_object_set_new(rval, "replayed_transactions", json_integer(stats().n_trx_replay));
+    json_object_set_new(rval, "sescmd_history_length", json_integer(stats().sescmd_history_length));
+    json_object_set_new(rval, "sescmd_history_bytes", json_integer(stats().sescmd_history_bytes));
+    json_object_set_new(rval, "replaced_session_commands", json_integer(stats().n_sescmd_collapsed));
+    json_object_set_new(rval, "sescmd_history_replays", json_integer(stats().n_sescmd_replays));
+    json_object_set_new(rval,
+                        "avg_sescmd_replay_ms",
+                        json_integer(stats().n_sescmd_replays ?
+                                     stats().sescmd_replay_ms / stats().n_sescmd_replays : 0));
 
     const char* weightby = serviceGetWeightingParameter(service());
 
@@ -242,6 +242,11 @@ struct Stats
     uint64_t n_trx_replay = 0;      /**< Number of replayed transactions */
     uint64_t n_ro_trx = 0;          /**< Read-only transaction count */
     uint64_t n_rw_trx = 0;          /**< Read-write transaction count */
+    uint64_t n_sescmd_collapsed = 0;        /**< Session commands replaced in histories */
+    int64_t  sescmd_history_length = 0;     /**< Session commands stored in histories */
+    int64_t  sescmd_history_bytes = 0;      /**< Size of the stored session commands */
+    uint64_t n_sescmd_replays = 0;          /**< Histories replayed on new connections */
+    uint64_t sescmd_replay_ms = 0;          /**< Total time spent replaying histories */
 };
 
 using maxscale::ServerStats;
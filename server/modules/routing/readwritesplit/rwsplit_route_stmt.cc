@@ -79,14 +79,15 @@ bool RWSplitSession::prepare_target(SRWBackend& target, route_target_t route_tar
     {
         mxb_assert(target->can_connect() && can_recover_servers());
         mxb_assert(!TARGET_IS_MASTER(route_target) || m_config.master_reconnection);
-        rval = target->connect(m_client->session, &m_sescmd_list);
+        rval = target->connect(m_client->session, &m_sescmd_history.commands());
         MXS_INFO("Connected to '%s'", target->name());
 
         if (rval && target->is_waiting_result())
         {
-            mxb_assert_message(!m_sescmd_list.empty() && target->has_session_commands(),
+            mxb_assert_message(!m_sescmd_history.empty() && target->has_session_commands(),
                                "Session command list must not be empty and target "
                                "should have unfinished session commands.");
+            m_sescmd_history.start_replay(target.get());
             m_expected_responses++;
         }
     }
@@ -356,30 +357,6 @@ bool RWSplitSession::route_single_stmt(GWBUF* querybuf)
     return succp;
 }
 
-/**
- * Compress session command history
- *
- * This function removes data duplication by sharing buffers between session
- * commands that have identical data. Only one copy of the actual data is stored
- * for each unique session command.
- *
- * @param sescmd Executed session command
- */
-void RWSplitSession::compress_history(mxs::SSessionCommand& sescmd)
-{
-    auto eq = [&](mxs::SSessionCommand& scmd) {
-            return scmd->eq(*sescmd);
-        };
-
-    auto first = std::find_if(m_sescmd_list.begin(), m_sescmd_list.end(), eq);
-
-    if (first != m_sescmd_list.end())
-    {
-        // Duplicate command, use a reference of the old command instead of duplicating it
-        sescmd->mark_as_duplicate(**first);
-    }
-}
-
 void RWSplitSession::continue_large_session_write(GWBUF* querybuf, uint32_t type)
 {
     for (auto it = m_backends.begin(); it != m_backends.end(); it++)
@@ -517,7 +494,7 @@ bool RWSplitSession::route_session_write(GWBUF* querybuf, uint8_t command, uint3
         }
     }
 
-    if (m_config.max_sescmd_history > 0 && m_sescmd_list.size() > m_config.max_sescmd_history)
+    if (m_config.max_sescmd_history > 0 && m_sescmd_history.size() > m_config.max_sescmd_history)
     {
         static bool warn_history_exceeded = true;
         if (warn_history_exceeded)
@@ -536,15 +513,15 @@ bool RWSplitSession::route_session_write(GWBUF* querybuf, uint8_t command, uint3
 
         m_config.disable_sescmd_history = true;
         m_config.max_sescmd_history = 0;
-        m_sescmd_list.clear();
+        m_sescmd_history.clear();
     }
 
-    if (m_config.prune_sescmd_history && !m_sescmd_list.empty()
-        && m_sescmd_list.size() + 1 > m_config.max_sescmd_history)
+    if (m_config.prune_sescmd_history && !m_sescmd_history.empty()
+        && m_sescmd_history.size() + 1 > m_config.max_sescmd_history)
     {
         // Close to the history limit, remove the oldest command
-        prune_to_position(m_sescmd_list.front()->get_position());
-        m_sescmd_list.pop_front();
+        prune_to_position(m_sescmd_history.front()->get_position());
+        m_sescmd_history.pop_front();
     }
 
     if (m_config.disable_sescmd_history)
@@ -553,8 +530,18 @@ bool RWSplitSession::route_session_write(GWBUF* querybuf, uint8_t command, uint3
     }
     else
     {
-        compress_history(sescmd);
-        m_sescmd_list.push_back(sescmd);
+        // A closed prepared statement is removed from the history along with the close
+        if (command != MXS_COM_STMT_CLOSE || !m_sescmd_history.close_ps(m_qc.current_route_info().stmt_id()))
+        {
+            m_sescmd_history.add(sescmd, querybuf);
+        }
+
+        // Responses to commands that were replaced in the history are no longer needed once
+        // all servers have executed them
+        for (uint64_t pos : m_sescmd_history.take_obsolete(lowest_pos))
+        {
+            m_sescmd_responses.erase(pos);
+        }
     }
 
     if (nsucc)
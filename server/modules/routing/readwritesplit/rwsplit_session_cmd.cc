@@ -92,6 +92,7 @@ void RWSplitSession::process_sescmd_response(SRWBackend& backend, GWBUF** ppPack
         uint8_t command = backend->next_session_command()->get_command();
         mxs::SSessionCommand sescmd = backend->next_session_command();
         uint64_t id = backend->complete_session_command();
+        m_sescmd_history.command_completed(backend.get(), id);
         MXS_PS_RESPONSE resp = {};
         bool discard = true;
 
@@ -115,6 +116,7 @@ void RWSplitSession::process_sescmd_response(SRWBackend& backend, GWBUF** ppPack
                 /** Store the master's response so that the slave responses can
                  * be compared to it */
                 m_sescmd_responses[id] = cmd;
+                m_sescmd_history.complete(id, cmd);
 
                 if (cmd == MYSQL_REPLY_ERR)
                 {
@@ -167,21 +169,24 @@ void RWSplitSession::process_sescmd_response(SRWBackend& backend, GWBUF** ppPack
         {
             mxb_assert_message(m_slave_responses.empty(), "All responses should've been processed");
             // This is the last session command to finish that resets the session state, reset the history
-            MXS_INFO("Resetting session command history (length: %lu)", m_sescmd_list.size());
+            MXS_INFO("Resetting session command history (length: %lu)", m_sescmd_history.size());
 
             /**
              * Since new connections need to perform the COM_CHANGE_USER, pop it off the list along
              * with the expected response to it.
              */
-            SSessionCommand latest = m_sescmd_list.back();
+            SSessionCommand latest = m_sescmd_history.back();
             cmd = m_sescmd_responses[latest->get_position()];
 
-            m_sescmd_list.clear();
+            m_sescmd_history.clear();
             m_sescmd_responses.clear();
 
-            // Push the response back as the first executed session command
-            m_sescmd_list.push_back(latest);
-            m_sescmd_responses[latest->get_position()] = cmd;
+            // Push the command and the response back as the first executed session command. The
+            // history is indexed by position, so the command gets the position that matches the counters.
+            GWBUF* buffer = latest->deep_copy_buffer();
+            SSessionCommand first(new SessionCommand(buffer, 1));
+            m_sescmd_history.add(first, buffer);
+            m_sescmd_responses[1] = cmd;
 
             // Adjust counters to match the number of stored session commands
             m_recv_sescmd = 1;
@@ -36,6 +36,7 @@ RWSplitSession::RWSplitSession(RWSplit* instance,
     , m_expected_responses(0)
     , m_query_queue(NULL)
     , m_router(instance)
+    , m_sescmd_history(instance->stats())
     , m_sent_sescmd(0)
     , m_recv_sescmd(0)
     , m_gtid_pos("")
@@ -1107,12 +1108,31 @@ bool RWSplitSession::handle_error_new_connection(DCB* backend_dcb, GWBUF* errmsg
     }
     else
     {
+        std::unordered_set<RWBackend*> in_use;
+
+        for (const auto& a : m_backends)
+        {
+            if (a->in_use())
+            {
+                in_use.insert(a.get());
+            }
+        }
+
         succp = m_router->select_connect_backend_servers(ses,
                                                          m_backends,
                                                          m_current_master,
-                                                         &m_sescmd_list,
+                                                         &m_sescmd_history.commands(),
                                                          &m_expected_responses,
                                                          connection_type::SLAVE);
+
+        for (const auto& a : m_backends)
+        {
+            // The new connections replay the session command history
+            if (a->in_use() && !in_use.count(a.get()) && a->has_session_commands())
+            {
+                m_sescmd_history.start_replay(a.get());
+            }
+        }
     }
 
     return succp;
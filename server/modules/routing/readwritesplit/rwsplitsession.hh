@@ -13,6 +13,7 @@
 #pragma once
 
 #include "readwritesplit.hh"
+#include "sescmd_history.hh"
 #include "trx.hh"
 
 #include <string>
@@ -144,7 +145,7 @@ public:
                                                  * query */
     GWBUF*                  m_query_queue;      /**< Queued commands waiting to be executed */
     RWSplit*                m_router;           /**< The router instance */
-    mxs::SessionCommandList m_sescmd_list;      /**< List of executed session commands */
+    SescmdHistory           m_sescmd_history;   /**< History of executed session commands */
     ResponseMap             m_sescmd_responses; /**< Response to each session command */
     SlaveResponseList       m_slave_responses;  /**< Slaves that replied before the master */
     uint64_t                m_sent_sescmd;      /**< ID of the last sent session command*/
@@ -180,7 +181,6 @@ private:
                    const mxs::SRWBackend& master);
 
     void process_sescmd_response(mxs::SRWBackend& backend, GWBUF** ppPacket);
-    void compress_history(mxs::SSessionCommand& sescmd);
 
     void prune_to_position(uint64_t pos);
     bool route_session_write(GWBUF* querybuf, uint8_t command, uint32_t type);
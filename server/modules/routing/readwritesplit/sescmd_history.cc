@@ -0,0 +1,539 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+#include "readwritesplit.hh"
+#include "sescmd_history.hh"
+
+#include <ctype.h>
+#include <algorithm>
+
+#include <maxbase/atomic.hh>
+#include <maxscale/modutil.hh>
+#include <maxscale/protocol/mysql.h>
+
+namespace
+{
+
+/**
+ * A minimal tokenizer for SET and USE statements
+ *
+ * Anything that is not needed for recognizing plain assignments of literal
+ * values, e.g. comments, expressions and double quoted strings, makes the
+ * statement invalid.
+ */
+class Tokenizer
+{
+public:
+    enum Type
+    {
+        WORD,       // Keyword or identifier, lowercased
+        NUMBER,
+        STRING,     // Single quoted string of printable ASCII characters
+        USERVAR,    // @name, the name is lowercased
+        SYSVAR,     // @@[session.|local.]name, the name is lowercased
+        SYMBOL,     // One of "=", ",", ";" and "-"
+        END,
+        INVALID
+    };
+
+    Tokenizer(const std::string& sql)
+        : m_it(sql.begin())
+        , m_end(sql.end())
+    {
+    }
+
+    Type next(std::string* value)
+    {
+        while (m_it != m_end && isspace((unsigned char)*m_it))
+        {
+            ++m_it;
+        }
+
+        value->clear();
+        Type rval = INVALID;
+
+        if (m_it == m_end)
+        {
+            rval = END;
+        }
+        else if (is_word_char(*m_it) && !isdigit((unsigned char)*m_it))
+        {
+            rval = word(value) ? WORD : INVALID;
+        }
+        else if (isdigit((unsigned char)*m_it))
+        {
+            rval = number(value) ? NUMBER : INVALID;
+        }
+        else if (*m_it == '\'')
+        {
+            rval = string(value) ? STRING : INVALID;
+        }
+        else if (*m_it == '`')
+        {
+            rval = quoted_word(value) ? WORD : INVALID;
+        }
+        else if (*m_it == '@')
+        {
+            rval = variable(value);
+        }
+        else if (*m_it == '=' || *m_it == ',' || *m_it == ';' || *m_it == '-')
+        {
+            *value = *m_it++;
+            rval = SYMBOL;
+        }
+        else if (*m_it == ':' && m_it + 1 != m_end && *(m_it + 1) == '=')
+        {
+            m_it += 2;
+            *value = "=";
+            rval = SYMBOL;
+        }
+
+        return rval;
+    }
+
+private:
+    static bool is_word_char(char c)
+    {
+        return isalnum((unsigned char)c) || c == '_' || c == '$';
+    }
+
+    bool word(std::string* value)
+    {
+        while (m_it != m_end && is_word_char(*m_it))
+        {
+            *value += tolower((unsigned char)*m_it++);
+        }
+
+        return !value->empty();
+    }
+
+    bool quoted_word(std::string* value)
+    {
+        ++m_it;
+
+        while (m_it != m_end && *m_it != '`')
+        {
+            *value += tolower((unsigned char)*m_it++);
+        }
+
+        return m_it != m_end && *m_it++ == '`' && !value->empty();
+    }
+
+    bool number(std::string* value)
+    {
+        while (m_it != m_end && (isdigit((unsigned char)*m_it) || *m_it == '.'))
+        {
+            *value += *m_it++;
+        }
+
+        // Hexadecimal and binary literals or identifiers that start with a digit
+        return m_it == m_end || !is_word_char(*m_it);
+    }
+
+    bool string(std::string* value)
+    {
+        ++m_it;
+
+        // Backslashes and non-ASCII characters could be interpreted differently
+        // depending on the SQL mode and the character set
+        while (m_it != m_end && *m_it != '\'' && *m_it != '\\' && isprint((unsigned char)*m_it))
+        {
+            *value += *m_it++;
+        }
+
+        bool rval = m_it != m_end && *m_it++ == '\'';
+
+        // A doubled quote inside the string
+        return rval && (m_it == m_end || *m_it != '\'');
+    }
+
+    Type variable(std::string* value)
+    {
+        Type rval = INVALID;
+        ++m_it;
+
+        if (m_it != m_end && *m_it == '@')
+        {
+            ++m_it;
+
+            if (word(value))
+            {
+                rval = SYSVAR;
+
+                if (m_it != m_end && *m_it == '.')
+                {
+                    ++m_it;
+                    std::string scope = *value;
+                    value->clear();
+
+                    if ((scope != "session" && scope != "local") || !word(value))
+                    {
+                        rval = INVALID;
+                    }
+                }
+            }
+        }
+        else if (word(value))
+        {
+            rval = USERVAR;
+        }
+
+        return rval;
+    }
+
+    std::string::const_iterator m_it;
+    std::string::const_iterator m_end;
+};
+
+/**
+ * Parse a literal value
+ */
+bool parse_value(Tokenizer& tokenizer)
+{
+    std::string value;
+    Tokenizer::Type type = tokenizer.next(&value);
+
+    if (type == Tokenizer::SYMBOL && value == "-")
+    {
+        type = tokenizer.next(&value);
+        return type == Tokenizer::NUMBER;
+    }
+
+    return type == Tokenizer::WORD || type == Tokenizer::NUMBER || type == Tokenizer::STRING;
+}
+
+/**
+ * Parse the assignments of a SET statement
+ *
+ * @param tokenizer Tokenizer positioned after the SET keyword
+ * @param variables The assigned variables
+ *
+ * @return True if the statement only assigns literal values to session or user variables
+ */
+bool parse_assignments(Tokenizer& tokenizer, std::set<std::string>* variables)
+{
+    bool rval = false;
+    bool more = true;
+
+    while (more)
+    {
+        more = false;
+        std::string token;
+        Tokenizer::Type type = tokenizer.next(&token);
+
+        if (type == Tokenizer::WORD && (token == "session" || token == "local"))
+        {
+            type = tokenizer.next(&token);
+        }
+
+        bool ok = false;
+        bool names = type == Tokenizer::WORD && token == "names";
+
+        if (names)
+        {
+            ok = parse_value(tokenizer);
+            variables->insert("names");
+        }
+        else if (type == Tokenizer::WORD && (token == "character" || token == "charset"))
+        {
+            ok = (token == "charset" || (tokenizer.next(&token) == Tokenizer::WORD && token == "set"))
+                && parse_value(tokenizer);
+            variables->insert("character set");
+        }
+        else if ((type == Tokenizer::WORD
+                  // Statements that look like assignments but are not plain session variables
+                  && token != "global" && token != "password" && token != "role"
+                  && token != "statement" && token != "transaction" && token != "default")
+                 || type == Tokenizer::SYSVAR
+                 || type == Tokenizer::USERVAR)
+        {
+            variables->insert(type == Tokenizer::USERVAR ? "@" + token : token);
+            std::string eq;
+            ok = tokenizer.next(&eq) == Tokenizer::SYMBOL && eq == "=" && parse_value(tokenizer);
+        }
+
+        if (ok)
+        {
+            type = tokenizer.next(&token);
+
+            if (type == Tokenizer::WORD && token == "collate" && names)
+            {
+                ok = parse_value(tokenizer);
+                type = tokenizer.next(&token);
+            }
+
+            if (ok && type == Tokenizer::SYMBOL && token == ",")
+            {
+                more = true;
+            }
+            else if (ok && type == Tokenizer::SYMBOL && token == ";")
+            {
+                rval = tokenizer.next(&token) == Tokenizer::END;
+            }
+            else if (ok && type == Tokenizer::END)
+            {
+                rval = true;
+            }
+        }
+    }
+
+    return rval;
+}
+
+/**
+ * Calculate a hash of the contents of a buffer
+ */
+uint64_t content_hash(GWBUF* buffer)
+{
+    // 64-bit FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (GWBUF* b = buffer; b; b = b->next)
+    {
+        for (uint8_t* p = GWBUF_DATA(b); p < GWBUF_DATA(b) + GWBUF_LENGTH(b); p++)
+        {
+            hash ^= *p;
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    return hash;
+}
+}
+
+// static
+std::string SescmdHistory::assigned_state(GWBUF* buffer)
+{
+    std::string rval;
+    uint8_t cmd = mxs_mysql_get_command(buffer);
+
+    if (cmd == MXS_COM_INIT_DB)
+    {
+        rval = "USE";
+    }
+    else if (cmd == MXS_COM_QUERY && gwbuf_length(buffer) < MYSQL_HEADER_LEN + GW_MYSQL_MAX_PACKET_LEN)
+    {
+        // Only complete statements are parsed, the start of a large one could look like an assignment
+        std::string sql = mxs::extract_sql(buffer);
+        Tokenizer tokenizer(sql);
+        std::string token;
+
+        if (tokenizer.next(&token) == Tokenizer::WORD)
+        {
+            std::set<std::string> variables;
+
+            if (token == "set" && parse_assignments(tokenizer, &variables))
+            {
+                for (const auto& var : variables)
+                {
+                    rval += rval.empty() ? var : "," + var;
+                }
+            }
+            else if (token == "use" && tokenizer.next(&token) == Tokenizer::WORD)
+            {
+                Tokenizer::Type type = tokenizer.next(&token);
+
+                if (type == Tokenizer::END
+                    || (type == Tokenizer::SYMBOL && token == ";" && tokenizer.next(&token) == Tokenizer::END))
+                {
+                    rval = "USE";
+                }
+            }
+        }
+    }
+
+    return rval;
+}
+
+SescmdHistory::SescmdHistory(Stats& stats)
+    : m_stats(stats)
+{
+}
+
+SescmdHistory::~SescmdHistory()
+{
+    clear();
+}
+
+void SescmdHistory::add(mxs::SSessionCommand& sescmd, GWBUF* buffer)
+{
+    // The buffer is freed if the command turns out to be a duplicate
+    Entry entry;
+    entry.hash = content_hash(buffer);
+    entry.state = assigned_state(buffer);
+    entry.bytes = gwbuf_length(buffer);
+
+    auto range = m_hashes.equal_range(entry.hash);
+
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const mxs::SSessionCommand& other = *m_entries[it->second].it;
+
+        if (other->eq(*sescmd))
+        {
+            // Duplicate command, use a reference of the old command instead of duplicating it
+            sescmd->mark_as_duplicate(*other);
+            break;
+        }
+    }
+
+    insert(sescmd, entry);
+}
+
+void SescmdHistory::insert(const mxs::SSessionCommand& sescmd, Entry entry)
+{
+    uint64_t pos = sescmd->get_position();
+    entry.it = m_commands.insert(m_commands.end(), sescmd);
+
+    if (entry.state.empty())
+    {
+        m_barriers.insert(pos);
+    }
+
+    m_hashes.emplace(entry.hash, pos);
+    m_bytes += entry.bytes;
+    mxb::atomic::add(&m_stats.sescmd_history_length, 1, mxb::atomic::RELAXED);
+    mxb::atomic::add(&m_stats.sescmd_history_bytes, entry.bytes, mxb::atomic::RELAXED);
+    m_entries.emplace(pos, std::move(entry));
+}
+
+void SescmdHistory::complete(uint64_t pos, uint8_t response)
+{
+    auto it = m_entries.find(pos);
+
+    if (it != m_entries.end() && !it->second.state.empty() && response == MYSQL_REPLY_OK)
+    {
+        auto state = m_state.find(it->second.state);
+
+        if (state != m_state.end())
+        {
+            uint64_t prev = state->second;
+            auto barrier = m_barriers.upper_bound(prev);
+
+            // The commands between the two could not have depended on the previous assignment
+            if (barrier == m_barriers.end() || *barrier > pos)
+            {
+                MXS_INFO("Session command %lu replaces command %lu in the history", pos, prev);
+                remove(prev);
+                m_obsolete.push_back(prev);
+                mxb::atomic::add(&m_stats.n_sescmd_collapsed, 1, mxb::atomic::RELAXED);
+            }
+        }
+
+        m_state[it->second.state] = pos;
+    }
+}
+
+bool SescmdHistory::close_ps(uint64_t pos)
+{
+    bool rval = m_entries.count(pos) && (*m_entries[pos].it)->get_command() == MXS_COM_STMT_PREPARE;
+
+    if (rval)
+    {
+        remove(pos);
+        m_obsolete.push_back(pos);
+        mxb::atomic::add(&m_stats.n_sescmd_collapsed, 1, mxb::atomic::RELAXED);
+    }
+
+    return rval;
+}
+
+void SescmdHistory::remove(uint64_t pos)
+{
+    auto it = m_entries.find(pos);
+
+    if (it != m_entries.end())
+    {
+        Entry& entry = it->second;
+        auto range = m_hashes.equal_range(entry.hash);
+
+        for (auto h = range.first; h != range.second; ++h)
+        {
+            if (h->second == pos)
+            {
+                m_hashes.erase(h);
+                break;
+            }
+        }
+
+        auto state = m_state.find(entry.state);
+
+        if (state != m_state.end() && state->second == pos)
+        {
+            m_state.erase(state);
+        }
+
+        m_barriers.erase(pos);
+        m_bytes -= entry.bytes;
+        mxb::atomic::add(&m_stats.sescmd_history_length, -1, mxb::atomic::RELAXED);
+        mxb::atomic::add(&m_stats.sescmd_history_bytes, -(int64_t)entry.bytes, mxb::atomic::RELAXED);
+        m_commands.erase(entry.it);
+        m_entries.erase(it);
+    }
+}
+
+void SescmdHistory::pop_front()
+{
+    remove(m_commands.front()->get_position());
+}
+
+void SescmdHistory::clear()
+{
+    mxb::atomic::add(&m_stats.sescmd_history_length, -(int64_t)m_commands.size(), mxb::atomic::RELAXED);
+    mxb::atomic::add(&m_stats.sescmd_history_bytes, -(int64_t)m_bytes, mxb::atomic::RELAXED);
+    m_commands.clear();
+    m_entries.clear();
+    m_hashes.clear();
+    m_state.clear();
+    m_barriers.clear();
+    m_obsolete.clear();
+    m_bytes = 0;
+}
+
+std::vector<uint64_t> SescmdHistory::take_obsolete(uint64_t lowest_pos)
+{
+    std::vector<uint64_t> rval;
+    auto it = std::partition(m_obsolete.begin(), m_obsolete.end(), [&](uint64_t pos) {
+                                 return pos >= lowest_pos;
+                             });
+    rval.assign(it, m_obsolete.end());
+    m_obsolete.erase(it, m_obsolete.end());
+    return rval;
+}
+
+void SescmdHistory::start_replay(const mxs::RWBackend* backend)
+{
+    if (!m_commands.empty())
+    {
+        m_replays[backend] = {m_commands.back()->get_position(), Clock::now()};
+    }
+}
+
+void SescmdHistory::command_completed(const mxs::RWBackend* backend, uint64_t pos)
+{
+    if (!m_replays.empty())
+    {
+        auto it = m_replays.find(backend);
+
+        if (it != m_replays.end() && pos >= it->second.end)
+        {
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - it->second.start);
+            mxb::atomic::add(&m_stats.n_sescmd_replays, 1, mxb::atomic::RELAXED);
+            mxb::atomic::add(&m_stats.sescmd_replay_ms, ms.count(), mxb::atomic::RELAXED);
+            MXS_INFO("Replayed the session command history on '%s' in %ldms",
+                     backend->name(),
+                     (long)ms.count());
+            m_replays.erase(it);
+        }
+    }
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+#pragma once
+
+#include <maxscale/ccdefs.hh>
+
+#include <chrono>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <maxscale/buffer.h>
+#include <maxscale/session_command.hh>
+#include <maxscale/protocol/rwbackend.hh>
+
+struct Stats;
+
+/**
+ * The session command history of a readwritesplit session
+ *
+ * The history is replayed on servers that are connected after the session has
+ * started. Instead of storing every executed command, the history is kept as a
+ * model of the current session state: a command that assigns literal values to
+ * session variables, or changes the default database, replaces the previous
+ * command that assigned the same variables once it has succeeded. A closed
+ * binary protocol prepared statement is removed from the history. The other
+ * commands are stored in the order they were executed and identical commands
+ * share the same buffer.
+ *
+ * A command is only replaced if none of the commands executed between the two
+ * could have depended on it, i.e. they all are literal assignments.
+ */
+class SescmdHistory
+{
+public:
+    SescmdHistory(const SescmdHistory&) = delete;
+    SescmdHistory& operator=(const SescmdHistory&) = delete;
+
+    /**
+     * @param stats Router statistics where the history size and replay times are added
+     */
+    SescmdHistory(Stats& stats);
+    ~SescmdHistory();
+
+    /**
+     * Add an executed session command
+     *
+     * @param sescmd The session command
+     * @param buffer The buffer of the command, owned by @c sescmd
+     */
+    void add(mxs::SSessionCommand& sescmd, GWBUF* buffer);
+
+    /**
+     * Process the response of the master to a session command
+     *
+     * If the command succeeded, earlier commands that it makes obsolete are
+     * removed from the history.
+     *
+     * @param pos      Position of the command
+     * @param response The response command byte
+     */
+    void complete(uint64_t pos, uint8_t response);
+
+    /**
+     * Remove a binary protocol prepared statement from the history
+     *
+     * @param pos Position of the COM_STMT_PREPARE, i.e. the internal ID of the statement
+     *
+     * @return True if the statement was in the history. If so, the
+     *         COM_STMT_CLOSE that closes it does not need to be stored.
+     */
+    bool close_ps(uint64_t pos);
+
+    /**
+     * Remove the oldest command
+     */
+    void pop_front();
+
+    /**
+     * Remove all commands
+     */
+    void clear();
+
+    /**
+     * Get the positions of removed commands whose responses are no longer needed
+     *
+     * @param lowest_pos The lowest position that a server has not yet completed
+     *
+     * @return The positions below @c lowest_pos that were removed from the history
+     */
+    std::vector<uint64_t> take_obsolete(uint64_t lowest_pos);
+
+    /**
+     * Start timing the replay of the history on a server
+     *
+     * @param backend The server that was connected with the history
+     */
+    void start_replay(const mxs::RWBackend* backend);
+
+    /**
+     * Called when a server completes a session command
+     *
+     * @param backend The server
+     * @param pos     Position of the completed command
+     */
+    void command_completed(const mxs::RWBackend* backend, uint64_t pos);
+
+    /**
+     * @return The commands that are replayed on new connections
+     */
+    mxs::SessionCommandList& commands()
+    {
+        return m_commands;
+    }
+
+    size_t size() const
+    {
+        return m_commands.size();
+    }
+
+    bool empty() const
+    {
+        return m_commands.empty();
+    }
+
+    const mxs::SSessionCommand& front() const
+    {
+        return m_commands.front();
+    }
+
+    const mxs::SSessionCommand& back() const
+    {
+        return m_commands.back();
+    }
+
+    /**
+     * Find the session state that a command assigns
+     *
+     * @param buffer Buffer containing a complete command
+     *
+     * @return The variables assigned by the command, or an empty string if the
+     *         command is not a plain assignment of literal values. The default
+     *         database is reported as "USE".
+     */
+    static std::string assigned_state(GWBUF* buffer);
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry
+    {
+        mxs::SessionCommandList::iterator it;
+        uint64_t                          hash;
+        std::string                       state;    /**< Assigned state, empty for others */
+        size_t                            bytes;
+    };
+
+    struct Replay
+    {
+        uint64_t          end;      /**< Position of the last replayed command */
+        Clock::time_point start;
+    };
+
+    void insert(const mxs::SSessionCommand& sescmd, Entry entry);
+    void remove(uint64_t pos);
+
+    Stats&                                         m_stats;
+    mxs::SessionCommandList                        m_commands;
+    std::unordered_map<uint64_t, Entry>            m_entries;   /**< Commands by position */
+    std::unordered_multimap<uint64_t, uint64_t>    m_hashes;    /**< Command positions by content hash */
+    std::unordered_map<std::string, uint64_t>      m_state;     /**< Latest successful assignments */
+    std::set<uint64_t>                             m_barriers;  /**< Commands that are not assignments */
+    std::vector<uint64_t>                          m_obsolete;
+    std::unordered_map<const mxs::RWBackend*, Replay> m_replays;
+    size_t                                         m_bytes = 0;
+};
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2018 MariaDB Corporation Ab
+ *
+ * Use of this software is governed by the Business Source License included
+ * in the LICENSE.TXT file and at www.mariadb.com/bsl11.
+ *
+ * Change Date: 2022-01-01
+ *
+ * On the date above, in accordance with the Business Source License, use
+ * of this software will be governed by version 2 or later of the General
+ * Public License.
+ */
+
+/**
+ * Tests the detection of plain assignments and the collapsing of the
+ * session command history.
+ */
+
+// To ensure that the asserts are checked also when building in non-debug mode.
+#if !defined (SS_DEBUG)
+#define SS_DEBUG
+#endif
+
+#include "../readwritesplit.hh"
+#include "../sescmd_history.hh"
+
+#include <string.h>
+
+#include <maxbase/assert.h>
+#include <maxscale/log.h>
+#include <maxscale/modutil.h>
+
+using namespace std;
+
+namespace
+{
+
+/**
+ * Create a command packet with a string payload
+ */
+GWBUF* create_command(uint8_t cmd, const char* payload)
+{
+    size_t len = strlen(payload) + 1;
+    GWBUF* buffer = gwbuf_alloc(MYSQL_HEADER_LEN + len);
+    uint8_t* data = GWBUF_DATA(buffer);
+    data[0] = len;
+    data[1] = len >> 8;
+    data[2] = len >> 16;
+    data[3] = 0;
+    data[4] = cmd;
+    memcpy(data + 5, payload, len - 1);
+    return buffer;
+}
+
+string assigned(const char* sql)
+{
+    GWBUF* buffer = modutil_create_query(sql);
+    string rval = SescmdHistory::assigned_state(buffer);
+    gwbuf_free(buffer);
+    return rval;
+}
+
+/**
+ * Add a command to the history the way the router does
+ */
+void add(SescmdHistory& history, GWBUF* buffer, uint64_t pos)
+{
+    mxs::SSessionCommand sescmd(new mxs::SessionCommand(buffer, pos));
+    history.add(sescmd, buffer);
+}
+
+bool has_command(SescmdHistory& history, uint64_t pos)
+{
+    bool rval = false;
+
+    for (const auto& cmd : history.commands())
+    {
+        if (cmd->get_position() == pos)
+        {
+            rval = true;
+        }
+    }
+
+    return rval;
+}
+
+void test_assigned_state()
+{
+
+    mxb_assert_message(assigned("SET @a = 1") == "@a", "user variable assignment");
+    mxb_assert_message(assigned("set @A := 'x';") == "@a", "assignment with := and a semicolon");
+    mxb_assert_message(assigned("SET autocommit=1, @b=-2") == "@b,autocommit", "multiple assignments");
+    mxb_assert_message(assigned("SET SESSION sql_mode='ANSI'") == "sql_mode", "SESSION scope");
+    mxb_assert_message(assigned("SET @@session.sql_mode='ANSI'") == "sql_mode", "@@session. prefix");
+    mxb_assert_message(assigned("SET NAMES utf8 COLLATE utf8_bin") == "names", "SET NAMES");
+    mxb_assert_message(assigned("SET CHARACTER SET latin1") == "character set", "SET CHARACTER SET");
+    mxb_assert_message(assigned("USE `test`") == "USE", "USE with a quoted name");
+
+    GWBUF* buffer = create_command(MXS_COM_INIT_DB, "test");
+    mxb_assert_message(SescmdHistory::assigned_state(buffer) == "USE", "COM_INIT_DB");
+    gwbuf_free(buffer);
+
+    mxb_assert_message(assigned("SET @a = 1 /* comment */").empty(), "comment is rejected");
+    mxb_assert_message(assigned("/* comment */ SET @a = 1").empty(), "leading comment is rejected");
+    mxb_assert_message(assigned("SET @a = 1 -- comment").empty(), "line comment is rejected");
+    mxb_assert_message(assigned("SET @a = 1 # comment").empty(), "hash comment is rejected");
+    mxb_assert_message(assigned("SET @a = @b").empty(), "variable as a value is rejected");
+    mxb_assert_message(assigned("SET @a = 1 + 1").empty(), "expression is rejected");
+    mxb_assert_message(assigned("SET @a = (SELECT 1)").empty(), "subquery is rejected");
+    mxb_assert_message(assigned("SET @a = NOW()").empty(), "function call is rejected");
+    mxb_assert_message(assigned("SET GLOBAL max_connections = 10").empty(), "GLOBAL scope is rejected");
+    mxb_assert_message(assigned("SET @@global.max_connections = 10").empty(), "@@global. prefix is rejected");
+    mxb_assert_message(assigned("SET @a = 'a\\'b'").empty(), "backslash in a string is rejected");
+    mxb_assert_message(assigned("SET @a = 'it''s'").empty(), "doubled quote in a string is rejected");
+    mxb_assert_message(assigned("SET @a = 0x10").empty(), "hexadecimal literal is rejected");
+    mxb_assert_message(assigned("SET PASSWORD = 'secret'").empty(), "SET PASSWORD is rejected");
+    mxb_assert_message(assigned("SET TRANSACTION READ ONLY").empty(), "SET TRANSACTION is rejected");
+    mxb_assert_message(assigned("SET @a = 1; SELECT 1").empty(), "multi-statement is rejected");
+    mxb_assert_message(assigned("SELECT 1").empty(), "SELECT is not an assignment");
+    mxb_assert_message(assigned("USE test; DROP TABLE t1").empty(), "USE with another statement is rejected");
+}
+
+void test_complete()
+{
+    Stats stats;
+    SescmdHistory history(stats);
+
+    add(history, modutil_create_query("SET @a = 1"), 1);
+    history.complete(1, MYSQL_REPLY_OK);
+    add(history, modutil_create_query("SET @a = 2"), 2);
+    history.complete(2, MYSQL_REPLY_OK);
+
+    mxb_assert_message(history.size() == 1, "assignment replaces the previous one");
+    mxb_assert_message(has_command(history, 2) && !has_command(history, 1), "the latest assignment is kept");
+    mxb_assert_message(stats.n_sescmd_collapsed == 1, "collapsed command is counted");
+    mxb_assert_message(stats.sescmd_history_length == 1, "history length is updated");
+
+    add(history, modutil_create_query("SET @b = 1"), 3);
+    history.complete(3, MYSQL_REPLY_OK);
+    add(history, modutil_create_query("SET @a = 3"), 4);
+    history.complete(4, MYSQL_REPLY_OK);
+
+    mxb_assert_message(history.size() == 2, "assignment of another variable is not a barrier");
+    mxb_assert_message(has_command(history, 3) && has_command(history, 4),
+                       "the unrelated assignment is kept");
+
+    add(history, modutil_create_query("SELECT @a INTO @c"), 5);
+    history.complete(5, MYSQL_REPLY_OK);
+    add(history, modutil_create_query("SET @a = 4"), 6);
+    history.complete(6, MYSQL_REPLY_OK);
+
+    mxb_assert_message(history.size() == 4, "assignment is not replaced across a barrier");
+    mxb_assert_message(has_command(history, 4), "the assignment before the barrier is kept");
+
+    add(history, modutil_create_query("SET @a = 5"), 7);
+    history.complete(7, MYSQL_REPLY_ERR);
+
+    mxb_assert_message(history.size() == 5, "failed assignment does not replace anything");
+    mxb_assert_message(has_command(history, 6), "the assignment before the failed one is kept");
+
+    add(history, modutil_create_query("SET @a = 6"), 8);
+    history.complete(8, MYSQL_REPLY_OK);
+
+    mxb_assert_message(!has_command(history, 6), "successful assignment replaces the last successful one");
+    mxb_assert_message(has_command(history, 7), "the failed assignment stays in the history");
+
+    mxb_assert_message(history.take_obsolete(2).size() == 1,
+                       "only obsolete commands below the limit are taken");
+    mxb_assert_message(history.take_obsolete(100).size() == 2, "the rest of the obsolete commands are taken");
+    mxb_assert_message(history.take_obsolete(100).empty(), "obsolete commands are only taken once");
+
+    history.clear();
+    mxb_assert_message(stats.sescmd_history_length == 0, "history length is zero after clearing");
+    mxb_assert_message(stats.sescmd_history_bytes == 0, "history size is zero after clearing");
+}
+
+void test_close_ps()
+{
+    Stats stats;
+    SescmdHistory history(stats);
+
+    add(history, create_command(MXS_COM_STMT_PREPARE, "SELECT ?"), 1);
+    add(history, modutil_create_query("SELECT 1"), 2);
+
+    mxb_assert_message(!history.close_ps(2), "a query is not a prepared statement");
+    mxb_assert_message(!history.close_ps(3), "an unknown statement is not closed");
+    mxb_assert_message(history.close_ps(1), "a prepared statement is closed");
+    mxb_assert_message(history.size() == 1 && !has_command(history, 1), "the closed statement is removed");
+    mxb_assert_message(!history.close_ps(1), "a statement is only closed once");
+    mxb_assert_message(history.take_obsolete(100).size() == 1, "the closed statement is obsolete");
+}
+}
+
+int main(int argc, char** argv)
+{
+    mxs_log_init(NULL, NULL, MXS_LOG_TARGET_STDOUT);
+
+    test_assigned_state();
+    test_complete();
+    test_close_ps();
+
+    mxs_log_finish();
+    return 0;
+}